@@ -13,8 +13,13 @@ layout(location = 5) out vec3		o_coordw;
 
 void main()
 {
+#ifdef BATCHED
+	uint id = gl_InstanceIndex & 0xffffff;
+	o_mat_id = gl_InstanceIndex >> 24;
+#else
 	uint id = gl_InstanceIndex & 0xffff;
 	o_mat_id = gl_InstanceIndex >> 16;
+#endif
 	o_uv = i_uv;
 
 #ifdef ARMATURE
@@ -34,6 +39,15 @@ void main()
 		o_normal = normalize(normal_mat * i_nor);
 		o_tangent = normalize(normal_mat * i_tan);
 	#endif
+#elif defined(BATCHED)
+	mat4 mat = batch_instance.mats[id];
+	vec3 world_pos = vec3(mat * vec4(i_pos, 1.0));
+	#ifndef DEPTH_ONLY
+		o_color = 0xffffffff;
+		mat3 normal_mat = transpose(inverse(mat3(mat)));
+		o_normal = normalize(normal_mat * i_nor);
+		o_tangent = normalize(normal_mat * i_tan);
+	#endif
 #else
 	vec3 world_pos = vec3(instance.meshes[id].mat * vec4(i_pos, 1.0));
 	#ifndef DEPTH_ONLY
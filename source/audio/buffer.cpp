@@ -1,3 +1,4 @@
+#include "../foundation/pack.h"
 #include "buffer_private.h"
 
 #include <stb_vorbis.c>
@@ -28,7 +29,7 @@ namespace flame
 					}
 				}
 
-				if (!std::filesystem::exists(filename))
+				if (!vfs_exists(filename))
 				{
 					wprintf(L"cannot find audio: %s\n", _filename.c_str());
 					return nullptr;
@@ -83,6 +84,11 @@ namespace flame
 					std::string pcm_data;
 
 					auto file = _wfopen(filename.c_str(), L"rb");
+					if (!file)
+					{
+						wprintf(L"cannot open audio (wav files are only read from disk): %s\n", _filename.c_str());
+						return nullptr;
+					}
 					fread(&header, 1, sizeof(WAV_HEADER), file);
 					if (strncmp(header.szRIFF, "RIFF", 4) == 0 && strncmp(header.szWAVE, "WAVE", 4) == 0)
 					{
@@ -200,7 +206,8 @@ namespace flame
 				}
 				else if (ext == L".ogg")
 				{
-					auto file_content = get_file_content(filename);
+					std::string file_content;
+					vfs_read(filename, file_content);
 					int channel, sample_rate; short* ogg_data;
 					auto samples = stb_vorbis_decode_memory((uchar*)file_content.data(), file_content.size(), &channel, &sample_rate, &ogg_data);
 					auto ret = new BufferPrivate;
@@ -126,18 +126,14 @@ namespace flame
 
 		BitmapPtr operator()(const std::filesystem::path& filename, int req_ch) override
 		{
-			if (!std::filesystem::exists(filename))
-				return nullptr;
-
-			auto file = _wfopen(filename.c_str(), L"rb");
-			if (!file)
+			std::string content;
+			if (!vfs_read(filename, content))
 				return nullptr;
 
 			int cx, cy, chs;
-			auto data = stbi_load_from_file(file, &cx, &cy, &chs, req_ch);
+			auto data = stbi_load_from_memory((uchar*)content.data(), content.size(), &cx, &cy, &chs, req_ch);
 			if (!data)
 				return nullptr;
-			fclose(file);
 			if (req_ch) chs = req_ch;
 			auto ret = Bitmap::create(uvec2(cx, cy), chs, 8, data);
 			stbi_image_free(data);
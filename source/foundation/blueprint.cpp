@@ -1,8 +1,10 @@
 #include "../xml.h"
 #include "typeinfo_serialize.h"
+#include "pack.h"
 #include "sheet_private.h"
 #include "system_private.h"
 #include "blueprint_private.h"
+#include "profiler.h"
 
 namespace flame
 {
@@ -434,18 +436,12 @@ namespace flame
 		v.type = type;
 		v.data = v.type->create();
 
+		// no node uses the new variable yet and instances keep the data of the others, so no group needs to be built again
 		auto frame = frames;
 		if (group)
-		{
 			group->variable_changed_frame = frame;
-			group->structure_changed_frame = frame;
-		}
 		else
-		{
 			variable_changed_frame = frame;
-			for (auto& g : groups)
-				g->structure_changed_frame = frame;
-		}
 		dirty_frame = frame;
 
 		return v.data;
@@ -2910,13 +2906,13 @@ namespace flame
 	void BlueprintPrivate::load(const std::filesystem::path& path, bool load_typeinfos)
 	{
 		filename = Path::get(path);
-		if (!std::filesystem::exists(filename))
+		if (!vfs_exists(filename))
 			return;
 
 		pugi::xml_document doc;
 		pugi::xml_node doc_root;
 
-		if (!doc.load_file(filename.c_str()) || (doc_root = doc.first_child()).name() != std::string("blueprint"))
+		if (!vfs_load_xml(doc, filename) || (doc_root = doc.first_child()).name() != std::string("blueprint"))
 		{
 			wprintf(L"blueprint does not exist or wrong format: %s\n", path.c_str());
 			return;
@@ -3598,7 +3594,7 @@ namespace flame
 				}
 			}
 
-			if (!std::filesystem::exists(filename))
+			if (!vfs_exists(filename))
 			{
 				wprintf(L"cannot found blueprint: %s", _filename.c_str());
 				return nullptr;
@@ -3816,23 +3812,34 @@ namespace flame
 
 	void BlueprintInstancePrivate::build()
 	{
+		FLAME_PROFILE_ZONE("Blueprint Build");
 		auto frame = frames;
+
+		// only the groups that are rebuilt lose their nodes, the others keep running as they are
 		std::map<uint, std::list<BlueprintExecutingBlock>>	old_ececuting_stacks;
 		std::map<uint, uint>								old_ececuting_node_id;
 		for (auto& g : groups)
 		{
+			auto src_g = blueprint->find_group(g.first);
+			if (src_g && src_g->structure_changed_frame <= g.second.structure_updated_frame)
+				continue;
 			old_ececuting_stacks[g.first] = g.second.executing_stack;
 			g.second.executing_stack.clear();
 			auto executing_node = g.second.executing_node();
 			old_ececuting_node_id[g.first] = executing_node ? executing_node->object_id : 0;
 		}
 
-		// create data for variables
-		if (blueprint->variable_changed_frame > variable_updated_frame)
-		{
+		// variables that keep their name and type keep their data (and the pointers that nodes hold to it), new ones get the default value
+		auto update_variables = [](const std::vector<BlueprintVariable>& src, std::unordered_map<uint, BlueprintAttribute>& dst) {
 			std::unordered_map<uint, BlueprintAttribute> new_variables;
-			for (auto& v : blueprint->variables)
+			for (auto& v : src)
 			{
+				if (auto it = dst.find(v.name_hash); it != dst.end() && it->second.type == v.type)
+				{
+					new_variables.emplace(v.name_hash, it->second);
+					dst.erase(it);
+					continue;
+				}
 				BlueprintAttribute attr;
 				attr.type = v.type;
 				attr.data = v.type->create();
@@ -3842,15 +3849,21 @@ namespace flame
 					attr.type->copy(attr.data, v.data);
 				new_variables.emplace(v.name_hash, attr);
 			}
-			for (auto& pair : variables)
+			for (auto& pair : dst)
 				pair.second.type->destroy(pair.second.data);
-			variables.clear();
-			variables = std::move(new_variables);
+			dst = std::move(new_variables);
+		};
 
+		// create data for variables
+		if (blueprint->variable_changed_frame > variable_updated_frame)
+		{
+			update_variables(blueprint->variables, variables);
 			variable_updated_frame = frame;
 		}
 
-		auto create_group_structure = [&](BlueprintGroupPtr src_g, BlueprintInstanceGroup& g, std::map<uint, BlueprintInstanceGroup::Data>& slots_data) {
+		// old_slots_data is the slot data of the last build, the data of unlinked inputs is taken from it instead of created again
+		auto create_group_structure = [&](BlueprintGroupPtr src_g, BlueprintInstanceGroup& g, std::map<uint, BlueprintInstanceGroup::Data>& slots_data,
+			std::map<uint, BlueprintInstanceGroup::Data>* old_slots_data) {
 			g.execution_type = BlueprintExecutionFunction;
 			g.trigger_message = src_g->trigger_message.empty() ? 0 : sh(src_g->trigger_message.c_str());
 			// we dont register the group here, maybe some 'static' blueprints need this functionality in later development
@@ -3865,26 +3878,25 @@ namespace flame
 			// create data for group variables
 			if (src_g->variable_changed_frame > g.variable_updated_frame)
 			{
-				std::unordered_map<uint, BlueprintAttribute> new_variables;
-				for (auto& v : src_g->variables)
-				{
-					BlueprintAttribute attr;
-					attr.type = v.type;
-					attr.data = v.type->create();
-					if (is_pointer(attr.type->tag))
-						memset(attr.data, 0, sizeof(voidptr));
-					else
-						attr.type->copy(attr.data, v.data);
-					new_variables.emplace(v.name_hash, attr);
-				}
-				for (auto& pair : g.variables)
-					pair.second.type->destroy(pair.second.data);
-				g.variables.clear();
-				g.variables = std::move(new_variables);
-
+				update_variables(src_g->variables, g.variables);
 				g.variable_updated_frame = frame;
 			}
 
+			// links by the block their from node is in and by their to slot, so nodes and slots dont scan all links of the group
+			std::unordered_map<BlueprintNodePtr, std::vector<BlueprintLinkPtr>> block_links;
+			std::unordered_map<BlueprintSlotPtr, std::vector<BlueprintLinkPtr>> slot_links;
+			for (auto& l : src_g->links)
+			{
+				block_links[l->from_slot->node->parent].push_back((BlueprintLinkPtr)l.get());
+				slot_links[l->to_slot].push_back((BlueprintLinkPtr)l.get());
+			}
+			static const std::vector<BlueprintLinkPtr> no_links;
+			auto links_of = [](const auto& map, auto key)->const std::vector<BlueprintLinkPtr>& {
+				if (auto it = map.find(key); it != map.end())
+					return it->second;
+				return no_links;
+			};
+
 			std::function<void(BlueprintNodePtr, BlueprintInstanceNode&)> create_node;
 			create_node = [&](BlueprintNodePtr block, BlueprintInstanceNode& o) {
 				std::vector<BlueprintInstanceNode> rest_nodes;
@@ -3898,26 +3910,24 @@ namespace flame
 						g.execution_type = BlueprintExecutionCoroutine;
 					create_node(n, c);
 				}
+				auto& links = links_of(block_links, block);
 				std::function<void(BlueprintInstanceNode&)> process_node;
 				process_node = [&](BlueprintInstanceNode& n) {
 					BlueprintInstanceNode* unsatisfied_upstream = nullptr;
-					for (auto& l : src_g->links)
+					for (auto l : links)
 					{
 						auto from_node = l->from_slot->node;
 						auto to_node = l->to_slot->node;
-						if (from_node->parent == block)
+						// if the link's to_node is the node or to_node is inside the node, then the link counts
+						if (to_node == n.original || n.original->contains(to_node->parent))
 						{
-							// if the link's to_node is the node or to_node is inside the node, then the link counts
-							if (to_node == n.original || n.original->contains(to_node->parent))
+							// if the link's from node still not add, then not ok
+							if (auto it = std::find_if(rest_nodes.begin(), rest_nodes.end(), [&](const auto& i) {
+								return i.object_id == from_node->object_id;
+								}); it != rest_nodes.end())
 							{
-								// if the link's from node still not add, then not ok
-								if (auto it = std::find_if(rest_nodes.begin(), rest_nodes.end(), [&](const auto& i) {
-									return i.object_id == from_node->object_id;
-									}); it != rest_nodes.end())
-								{
-									unsatisfied_upstream = &(*it);
-									break; // one link is not satisfied, break
-								}
+								unsatisfied_upstream = &(*it);
+								break; // one link is not satisfied, break
 							}
 						}
 					}
@@ -3958,37 +3968,34 @@ namespace flame
 			create_slots_data = [&](BlueprintInstanceNode& node) {
 				auto process_linked_input_slot = [&](BlueprintSlotPtr input) {
 					auto linked = false;
-					for (auto& l : src_g->links)
+					for (auto l : links_of(slot_links, input))
 					{
-						if (l->to_slot == input)
+						if (auto it = slots_data.find(l->from_slot->object_id); it != slots_data.end())
 						{
-							if (auto it = slots_data.find(l->from_slot->object_id); it != slots_data.end())
+							if ((it->second.attribute.type->tag == TagE || it->second.attribute.type->tag == TagD || it->second.attribute.type->tag == TagU)
+								&& (input->type == TypeInfo::get<voidptr>() || input->type->tag == TagPU))
 							{
-								if ((it->second.attribute.type->tag == TagE || it->second.attribute.type->tag == TagD || it->second.attribute.type->tag == TagU)
-									&& (input->type == TypeInfo::get<voidptr>() || input->type->tag == TagPU))
-								{
-									BlueprintInstanceGroup::Data data;
-									data.changed_frame = it->second.changed_frame;
-									data.attribute.type = input->type;
-									data.attribute.data = input->type->create();
-									auto ptr = it->second.attribute.data;
-									memcpy((voidptr*)data.attribute.data, &ptr, sizeof(voidptr));
-									slots_data.emplace(input->object_id, data);
+								BlueprintInstanceGroup::Data data;
+								data.changed_frame = it->second.changed_frame;
+								data.attribute.type = input->type;
+								data.attribute.data = input->type->create();
+								auto ptr = it->second.attribute.data;
+								memcpy((voidptr*)data.attribute.data, &ptr, sizeof(voidptr));
+								slots_data.emplace(input->object_id, data);
 
-									node.inputs.push_back(data.attribute);
-								}
-								else
-								{
-									BlueprintAttribute attr;
-									attr.type = it->second.attribute.type;
-									attr.data = it->second.attribute.data;
-									node.inputs.push_back(attr);
-								}
+								node.inputs.push_back(data.attribute);
 							}
 							else
-								assert(0);
-							linked = true;
+							{
+								BlueprintAttribute attr;
+								attr.type = it->second.attribute.type;
+								attr.data = it->second.attribute.data;
+								node.inputs.push_back(attr);
+							}
 						}
+						else
+							assert(0);
+						linked = true;
 					}
 
 					return linked;
@@ -4001,6 +4008,28 @@ namespace flame
 						data.attribute.type = TypeInfo::get<uint>();
 					else
 						data.attribute.type = input->type;
+					if (old_slots_data && data.attribute.type && data.attribute.type != TypeInfo::get<voidptr>() && !is_pointer(data.attribute.type->tag))
+					{
+						if (auto it = old_slots_data->find(input->object_id); it != old_slots_data->end() &&
+							it->second.own_data && it->second.attribute.type == data.attribute.type && it->second.attribute.data)
+						{
+							data.attribute.data = it->second.attribute.data;
+							data.changed_frame = it->second.changed_frame;
+							it->second.attribute.data = nullptr;
+							if (input->data_changed_frame > data.changed_frame && input->data)
+							{
+								if (is_string_hash)
+									*(uint*)data.attribute.data = sh((*(std::string*)input->data).c_str());
+								else
+									data.attribute.type->copy(data.attribute.data, input->data);
+								data.changed_frame = input->data_changed_frame;
+							}
+							slots_data.emplace(input->object_id, data);
+
+							node.inputs.push_back(data.attribute);
+							return;
+						}
+					}
 					if (data.attribute.type)
 					{
 						data.attribute.data = data.attribute.type->create();
@@ -4544,19 +4573,20 @@ namespace flame
 				it++;
 		}
 
-		// update existing groups
+		// update existing groups, only the ones whose structure changed are built again
 		for (auto& g : groups)
 		{
 			auto src_g = blueprint->find_group(g.first);
 
 			if (src_g->structure_changed_frame > g.second.structure_updated_frame)
 			{
+				auto t0 = performance_counter();
 				std::map<uint, BlueprintInstanceGroup::Data> new_slot_datas;
 				g.second.root_node.children.clear();
-				create_group_structure(src_g, g.second, new_slot_datas);
+				create_group_structure(src_g, g.second, new_slot_datas, &g.second.slot_datas);
 				for (auto& d : new_slot_datas)
 				{
-					if (auto it = g.second.slot_datas.find(d.first); it != g.second.slot_datas.end())
+					if (auto it = g.second.slot_datas.find(d.first); it != g.second.slot_datas.end() && it->second.attribute.data)
 					{
 						if (it->second.attribute.type == d.second.attribute.type && it->second.changed_frame > d.second.changed_frame)
 						{
@@ -4577,33 +4607,45 @@ namespace flame
 				g.second.slot_datas = std::move(new_slot_datas);
 				g.second.structure_updated_frame = frame;
 				g.second.data_updated_frame = frame;
+				g.second.build_time = float(performance_counter() - t0) / performance_frequency() * 1000.f;
 			}
-			else if (src_g->data_changed_frame > g.second.data_updated_frame)
+			else
 			{
-				for (auto& n : src_g->nodes)
+				if (src_g->variable_changed_frame > g.second.variable_updated_frame)
 				{
-					for (auto& i : n->inputs)
+					update_variables(src_g->variables, g.second.variables);
+					g.second.variable_updated_frame = frame;
+				}
+				if (src_g->data_changed_frame > g.second.data_updated_frame)
+				{
+					for (auto& n : src_g->nodes)
 					{
-						if (auto it = g.second.slot_datas.find(i->object_id); it != g.second.slot_datas.end())
+						for (auto& i : n->inputs)
 						{
-							if (i->data_changed_frame > it->second.changed_frame)
+							// only the inputs that changed since the last update are looked up
+							if (i->data_changed_frame < g.second.data_updated_frame)
+								continue;
+							if (auto it = g.second.slot_datas.find(i->object_id); it != g.second.slot_datas.end())
 							{
-								auto& arg = it->second.attribute;
-								if (i->type == arg.type)
+								if (i->data_changed_frame > it->second.changed_frame)
 								{
-									if (!is_pointer(arg.type->tag))
-										i->type->copy(arg.data, i->data);
+									auto& arg = it->second.attribute;
+									if (i->type == arg.type)
+									{
+										if (!is_pointer(arg.type->tag))
+											i->type->copy(arg.data, i->data);
+									}
+									else if (i->type == TypeInfo::get<std::string>() && arg.type == TypeInfo::get<uint>())
+										*(uint*)arg.data = sh((*(std::string*)i->data).c_str());
+									else
+										assert(0);
+									it->second.changed_frame = i->data_changed_frame;
 								}
-								else if (i->type == TypeInfo::get<std::string>() && arg.type == TypeInfo::get<uint>())
-									*(uint*)arg.data = sh((*(std::string*)i->data).c_str());
-								else
-									assert(0);
-								it->second.changed_frame = i->data_changed_frame;
 							}
 						}
 					}
+					g.second.data_updated_frame = frame;
 				}
-				g.second.data_updated_frame = frame;
 			}
 		}
 
@@ -4626,9 +4668,11 @@ namespace flame
 			g.instance = this;
 			g.original = src_g.get();
 			g.name = src_g->name_hash;
-			create_group_structure(src_g.get(), g, g.slot_datas);
+			auto t0 = performance_counter();
+			create_group_structure(src_g.get(), g, g.slot_datas, nullptr);
 			g.structure_updated_frame = frame;
 			g.data_updated_frame = frame;
+			g.build_time = float(performance_counter() - t0) / performance_frequency() * 1000.f;
 		}
 
 		for (auto& g : groups)
@@ -4708,6 +4752,7 @@ namespace flame
 
 	void BlueprintInstancePrivate::run(BlueprintInstanceGroup* group)
 	{
+		FLAME_PROFILE_ZONE("Blueprint Run");
 		while (!group->executing_stack.empty())
 		{
 			if (auto debugger = BlueprintDebugger::current(); debugger && debugger->debugging)
@@ -4833,6 +4878,7 @@ namespace flame
 
 	void BlueprintInstancePrivate::call(BlueprintInstanceGroup* group, void** inputs, void** outputs)
 	{
+		FLAME_PROFILE_ZONE("Blueprint Call");
 		assert(group->instance == this);
 
 		if (auto obj = group->input_node; obj)
@@ -740,6 +740,7 @@ namespace flame
 		uint											structure_updated_frame = 0;
 		uint											data_updated_frame = 0;
 		float											wait_time = 0.f;
+		float											build_time = 0.f; // ms, of the last time the structure was built
 
 		inline BlueprintAttribute get_variable(uint name)
 		{
@@ -528,7 +528,7 @@ namespace flame
 			},
 			[](uint inputs_count, BlueprintAttribute* inputs, uint outputs_count, BlueprintAttribute* outputs) {
 				auto sht = *(SheetPtr*)inputs[0].data;
-				*(uint*)outputs[0].data = sht ? sht->rows.size() : 0;
+				*(uint*)outputs[0].data = sht ? sht->rows_count : 0;
 			}
 		);
 
@@ -563,16 +563,7 @@ namespace flame
 					if (column_idx != -1)
 					{
 						if (type == sht->columns[column_idx].type)
-						{
-							for (auto i = 0; i < sht->rows.size(); i++)
-							{
-								if (type->compare(sht->rows[i].datas[column_idx], inputs[2].data))
-								{
-									*(int*)outputs[0].data = i;
-									break;
-								}
-							}
-						}
+							*(int*)outputs[0].data = sht->find_row(column_idx, inputs[2].data);
 						else
 							*(int*)outputs[0].data = -1;
 					}
@@ -617,6 +608,122 @@ namespace flame
 			}
 		);
 
+		library->add_template("Find Range In Sheet", "", BlueprintNodeFlagEnableTemplate,
+			{
+				{
+					.name = "Sheet",
+					.allowed_types = { TypeInfo::get<SheetPtr>() }
+				},
+				{
+					.name = "Name_hash",
+					.allowed_types = { TypeInfo::get<std::string>() }
+				},
+				{
+					.name = "Min",
+					.allowed_types = { TypeInfo::get<float>() }
+				},
+				{
+					.name = "Max",
+					.allowed_types = { TypeInfo::get<float>() }
+				}
+			},
+			{
+				{
+					.name = "First",
+					.allowed_types = { TypeInfo::get<uint>() }
+				},
+				{
+					.name = "Count",
+					.allowed_types = { TypeInfo::get<uint>() }
+				}
+			},
+			[](uint inputs_count, BlueprintAttribute* inputs, uint outputs_count, BlueprintAttribute* outputs) {
+				auto sht = *(SheetPtr*)inputs[0].data;
+				*(uint*)outputs[0].data = 0;
+				*(uint*)outputs[1].data = 0;
+				if (sht)
+				{
+					auto column_idx = sht->find_column(*(uint*)inputs[1].data);
+					if (column_idx != -1 && inputs[2].type == sht->columns[column_idx].type)
+						*(uint*)outputs[1].data = sht->find_range(column_idx, inputs[2].data, inputs[3].data, *(uint*)outputs[0].data);
+				}
+			},
+			nullptr,
+			nullptr,
+			[](BlueprintNodeStructureChangeInfo& info) {
+				if (info.reason == BlueprintNodeTemplateChanged)
+				{
+					auto type = info.template_string.empty() ? TypeInfo::get<float>() : blueprint_type_from_template_str(info.template_string);
+					if (!type)
+						return false;
+
+					info.new_inputs.resize(4);
+					info.new_inputs[0] = {
+						.name = "Sheet",
+						.allowed_types = { TypeInfo::get<SheetPtr>() }
+					};
+					info.new_inputs[1] = {
+						.name = "Name_hash",
+						.allowed_types = { TypeInfo::get<std::string>() }
+					};
+					info.new_inputs[2] = {
+						.name = "Min",
+						.allowed_types = { type }
+					};
+					info.new_inputs[3] = {
+						.name = "Max",
+						.allowed_types = { type }
+					};
+					info.new_outputs.resize(2);
+					info.new_outputs[0] = {
+						.name = "First",
+						.allowed_types = { TypeInfo::get<uint>() }
+					};
+					info.new_outputs[1] = {
+						.name = "Count",
+						.allowed_types = { TypeInfo::get<uint>() }
+					};
+					return true;
+				}
+				else if (info.reason == BlueprintNodeInputTypesChanged)
+					return true;
+				return false;
+			}
+		);
+
+		library->add_template("Sheet Sorted Row", "", BlueprintNodeFlagNone,
+			{
+				{
+					.name = "Sheet",
+					.allowed_types = { TypeInfo::get<SheetPtr>() }
+				},
+				{
+					.name = "Name_hash",
+					.allowed_types = { TypeInfo::get<std::string>() }
+				},
+				{
+					.name = "Position",
+					.allowed_types = { TypeInfo::get<uint>() }
+				}
+			},
+			{
+				{
+					.name = "Row",
+					.allowed_types = { TypeInfo::get<int>() }
+				}
+			},
+			[](uint inputs_count, BlueprintAttribute* inputs, uint outputs_count, BlueprintAttribute* outputs) {
+				auto sht = *(SheetPtr*)inputs[0].data;
+				if (sht)
+				{
+					auto column_idx = sht->find_column(*(uint*)inputs[1].data);
+					*(int*)outputs[0].data = column_idx != -1 ? sht->get_sorted_row(column_idx, *(uint*)inputs[2].data) : -1;
+				}
+				else
+					*(int*)outputs[0].data = -1;
+			}
+		);
+
 		library->add_template("Get SHT V", "", BlueprintNodeFlagEnableTemplate,
 			{
 				{
@@ -641,7 +748,7 @@ namespace flame
 			[](uint inputs_count, BlueprintAttribute* inputs, uint outputs_count, BlueprintAttribute* outputs) {
 				if (auto sht = *(SheetPtr*)inputs[0].data; sht)
 				{
-					if (auto row_idx = *(uint*)inputs[1].data; row_idx < sht->rows.size())
+					if (auto row_idx = *(uint*)inputs[1].data; row_idx < sht->rows_count)
 					{
 						for (auto i = 0; i < outputs_count; i++)
 						{
@@ -652,9 +759,9 @@ namespace flame
 								if (ctype == type ||
 									(type == TypeInfo::get<uint>() && ctype == TypeInfo::get<int>()) ||
 									(type == TypeInfo::get<int>() && ctype == TypeInfo::get<uint>()))
-									type->copy(outputs[i].data, sht->rows[row_idx].datas[column_idx]);
+									type->copy(outputs[i].data, sht->get_data(row_idx, column_idx));
 								else if (ctype == TypeInfo::get<StrAndHash>() && type == TypeInfo::get<uint>())
-									*(uint*)outputs[i].data = (*(StrAndHash*)(sht->rows[row_idx].datas[column_idx])).h;
+									*(uint*)outputs[i].data = (*(StrAndHash*)sht->get_data(row_idx, column_idx)).h;
 								else
 									type->create(outputs[i].data);
 							}
@@ -767,18 +874,18 @@ namespace flame
 				auto sht = *(SheetPtr*)inputs[0].data;
 				if (sht)
 				{
-					if (auto row_idx = *(uint*)inputs[1].data; row_idx < sht->rows.size())
+					if (auto row_idx = *(uint*)inputs[1].data; row_idx < sht->rows_count)
 					{
-						for (auto i = 1; i < inputs_count; i += 2)
+						for (auto i = 1; i + 2 < inputs_count; i += 2)
 						{
-							auto type = outputs[i].type;
+							auto type = inputs[i + 2].type;
 							if (auto column_idx = sht->find_column(*(uint*)inputs[i + 1].data); column_idx != -1)
 							{
 								auto ctype = sht->columns[column_idx].type;
 								if (ctype == type ||
 									(type == TypeInfo::get<uint>() && ctype == TypeInfo::get<int>()) ||
 									(type == TypeInfo::get<int>() && ctype == TypeInfo::get<uint>()))
-									type->copy(sht->rows[row_idx].datas[column_idx], inputs[i + 2].data);
+									sht->set_data(row_idx, column_idx, inputs[i + 2].data);
 							}
 						}
 					}
@@ -865,9 +972,8 @@ namespace flame
 				auto ins = *(BlueprintInstancePtr*)inputs[2].data;
 				if (sht && ins)
 				{
-					if (row_idx < sht->rows.size())
+					if (row_idx < sht->rows_count)
 					{
-						auto& row = sht->rows[row_idx];
 						for (auto i = 0; i < sht->columns.size(); i++)
 						{
 							auto& column = sht->columns[i];
@@ -875,7 +981,7 @@ namespace flame
 							if (it != ins->variables.end())
 							{
 								if (it->second.type == column.type)
-									column.type->copy(it->second.data, row.datas[i]);
+									column.type->copy(it->second.data, sht->get_data(row_idx, i));
 							}
 						}
 					}
@@ -1,11 +1,14 @@
 #include "foundation_private.h"
 #include "typeinfo_private.h"
 #include "typeinfo_serialize.h"
+#include "pack.h"
 #include "system_private.h"
 #include "window_private.h"
 #include "blueprint_private.h"
 #include "blueprint_library/library.h"
 #include "application.h"
+#include "profiler.h"
+#include "frame_arena.h"
 
 #include <exprtk.hpp>
 
@@ -19,7 +22,11 @@ namespace flame
 		auto it = assets.find(path);
 		if (it == assets.end())
 			it = assets.emplace(std::make_pair(path, Asset())).first; 
-		it->second.lwt = std::filesystem::exists(path) ? std::filesystem::last_write_time(path) : std::filesystem::file_time_type::min();
+		// packed files never change, loose files take one stat
+		std::error_code ec;
+		it->second.lwt = vfs_in_pack(path) ? std::filesystem::file_time_type::min() : std::filesystem::last_write_time(path, ec);
+		if (ec)
+			it->second.lwt = std::filesystem::file_time_type::min();
 		it->second.ref++;
 		return it->second;
 	}
@@ -85,11 +92,13 @@ namespace flame
 		}
 	}exprtk_to_str;
 
-	struct ExpressionPrivate : Expression
+	// the parsed and compiled form of an expression, shared by all the instances that have the same text and symbols
+	//  exprtk binds variables by reference, so an instance copies its values into the slots right before evaluating
+	struct CompiledExpression
 	{
-		struct Convertion
+		struct Global
 		{
-			float v;
+			float* slot;
 			DataType type;
 			void* p;
 		};
@@ -98,7 +107,33 @@ namespace flame
 		exprtk::expression<float> expression;
 		std::string return_value;
 		exprtk_output_t output_function;
-		std::list<Convertion> convertions;
+		std::deque<float> slots; // variables and consts of the instance in the order they were set, then the globals
+		std::vector<Global> globals; // data found by find_data, e.g. 'foo' or 'foo.bar'
+		bool ok = false;
+		std::mutex mtx; // the slots are shared, an evaluation holds them from filling to the value
+	};
+
+	// key: expression string and symbols layout
+	//  expressions are compiled and evaluated in jobs too, so the cache is guarded
+	//  one that has a name find_data could not find is not cached, a later compile may find it
+	//  the instances share the entries, when the cache is full the ones no instance holds are dropped
+	static std::unordered_map<std::string, std::shared_ptr<CompiledExpression>> compiled_expressions;
+	static std::mutex compiled_expressions_mtx;
+	const auto compiled_expressions_max = 1024U;
+
+	struct ExpressionPrivate : Expression
+	{
+		struct Local
+		{
+			std::string name;
+			float* p; // null for consts
+			float v; // the const value, or the last seen value of the variable
+		};
+
+		std::vector<Local> locals;
+		std::vector<std::pair<std::string, std::string>> const_strings;
+		std::shared_ptr<CompiledExpression> compiled;
+		std::vector<float> global_values;
 
 		ExpressionPrivate(const std::string& expression_string);
 
@@ -109,145 +144,252 @@ namespace flame
 		bool update_bindings() override;
 		float get_value() override;
 		std::string get_string_value() override;
+		void get_values(uint count, const float* variables, uint stride, float* out) override;
+
+		void fill_slots();
 	};
 
 	ExpressionPrivate::ExpressionPrivate(const std::string& _expression_string)
 	{
 		expression_string = _expression_string;
-
-		auto addr_str = str((uint64)&return_value);
-		symbols.create_stringvar("return_value", addr_str);
-		output_function.return_value = &return_value;
-		symbols.add_function("output", output_function);
-		symbols.add_function("to_str", exprtk_to_str);
 	}
 
 	void ExpressionPrivate::set_const_value(const std::string& name, float value)
 	{
-		symbols.add_constant(name, value);
+		locals.push_back({ name, nullptr, value });
 	}
 
 	void ExpressionPrivate::set_variable(const std::string& name, float* variable)
 	{
-		symbols.add_variable(name, *variable);
+		locals.push_back({ name, variable, *variable });
+	}
+
+	void ExpressionPrivate::set_const_string(const std::string& name, const std::string& value)
+	{
+		const_strings.emplace_back(name, value);
 	}
 
 	bool ExpressionPrivate::compile()
 	{
-		exprtk::symbol_table<float> unknown_symbols;
-		expression.register_symbol_table(unknown_symbols);
-		expression.register_symbol_table(symbols);
+		// consts are part of the layout only by name, their values are copied in like variables
+		auto key = expression_string;
+		key += '\n';
+		for (auto& l : locals)
+		{
+			key += l.p ? "v:" : "c:";
+			key += l.name;
+			key += ';';
+		}
+		for (auto& s : const_strings)
+		{
+			key += "s:";
+			key += s.first;
+			key += '=';
+			key += s.second;
+			key += ';';
+		}
 
-		exprtk::parser<float> parser;
-		parser.enable_unknown_symbol_resolver();
-		auto ok = parser.compile(expression_string, expression);
-		if (ok)
+		std::lock_guard<std::mutex> lock(compiled_expressions_mtx);
+		if (auto it = compiled_expressions.find(key); it != compiled_expressions.end())
+			compiled = it->second;
+		else
 		{
-			std::vector<std::string> variable_list;
-			unknown_symbols.get_variable_list(variable_list);
-			unknown_symbols.clear();
-			for (auto& var_name : variable_list)
+			auto c = std::make_shared<CompiledExpression>();
+			auto all_found = true;
+			auto& symbols = c->symbols;
+			auto& expression = c->expression;
+
+			auto addr_str = str((uint64)&c->return_value);
+			symbols.create_stringvar("return_value", addr_str);
+			c->output_function.return_value = &c->return_value;
+			symbols.add_function("output", c->output_function);
+			symbols.add_function("to_str", exprtk_to_str);
+			for (auto& l : locals)
+			{
+				c->slots.push_back(l.v);
+				symbols.add_variable(l.name, c->slots.back());
+			}
+			for (auto& s : const_strings)
+				symbols.create_stringvar(s.first, s.second);
+
+			exprtk::symbol_table<float> unknown_symbols;
+			expression.register_symbol_table(unknown_symbols);
+			expression.register_symbol_table(symbols);
+
+			exprtk::parser<float> parser;
+			parser.enable_unknown_symbol_resolver();
+			auto ok = parser.compile(expression_string, expression);
+			if (ok)
 			{
-				auto chain = SUS::split(var_name, '.');
-				auto di = find_data(sh(chain[0].data()));
-				if (di)
+				std::vector<std::string> variable_list;
+				unknown_symbols.get_variable_list(variable_list);
+				unknown_symbols.clear();
+				for (auto& var_name : variable_list)
 				{
-					auto bind_data = [&](void* address, TypeInfo_Data* ti) {
-						if (ti->data_type == DataFloat)
+					auto chain = SUS::split(var_name, '.');
+					auto di = find_data(sh(chain[0].data()));
+					if (!di)
+						all_found = false;
+					else
+					{
+						auto bind_data = [&](void* address, TypeInfo_Data* ti) {
+							if (ti->data_type == DataFloat)
+							{
+								auto& v = c->slots.emplace_back(0.f);
+								symbols.add_variable(var_name, v);
+								auto& g = c->globals.emplace_back();
+								g.slot = &v;
+								g.type = ti->data_type;
+								g.p = address;
+							}
+						};
+
+						switch (di->type->tag)
+						{
+						case TagD:
 						{
-							auto& c = convertions.emplace_back();
-							symbols.add_variable(var_name, c.v);
-							c.type = ti->data_type;
-							c.p = address;
+							auto ti = (TypeInfo_Data*)di->type;
+							bind_data(di->address(), ti);
 						}
-					};
-
-					switch (di->type->tag)
-					{
-					case TagD:
-					{
-						auto ti = (TypeInfo_Data*)di->type;
-						bind_data(di->address(), ti);
-					}
-						break;
-					case TagU:
-					{
-						if (auto ui = di->type->retrive_ui(); ui)
+							break;
+						case TagU:
 						{
-							chain.erase(chain.begin());
-							voidptr obj = di->address();
-							if (auto attr = ui->find_attribute(chain, obj); attr)
+							if (auto ui = di->type->retrive_ui(); ui)
 							{
-								if (attr->type->tag == TagD)
+								chain.erase(chain.begin());
+								voidptr obj = di->address();
+								if (auto attr = ui->find_attribute(chain, obj); attr)
 								{
-									auto ti = (TypeInfo_Data*)attr->type;
-									bind_data((char*)obj + attr->var_off(), ti);
+									if (attr->type->tag == TagD)
+									{
+										auto ti = (TypeInfo_Data*)attr->type;
+										bind_data((char*)obj + attr->var_off(), ti);
+									}
 								}
 							}
 						}
+							break;
+						}
 					}
-						break;
-					}
+
 				}
 
+				ok = parser.compile(expression_string, expression);
 			}
+			c->ok = ok;
 
-			ok = parser.compile(expression_string, expression);
+			compiled = c;
+			if (ok && all_found)
+			{
+				if (compiled_expressions.size() >= compiled_expressions_max)
+				{
+					std::erase_if(compiled_expressions, [](const auto& i) {
+						return i.second.use_count() == 1;
+					});
+				}
+				compiled_expressions[key] = std::move(c);
+			}
 		}
-		return ok;
-	}
 
-	void ExpressionPrivate::set_const_string(const std::string& name, const std::string& value)
-	{
-		symbols.create_stringvar(name, value);
+		global_values.assign(compiled->globals.size(), 0.f);
+		return compiled->ok;
 	}
 
 	bool ExpressionPrivate::update_bindings()
 	{
+		if (!compiled)
+			return false;
 		auto changed = false;
-		for (auto& c : convertions)
+		for (auto& l : locals)
 		{
-			switch (c.type)
+			if (l.p && l.v != *l.p)
 			{
-			case DataInt:
-			{
-				auto v = (float)*(int*)c.p;
-				if (c.v != v)
-				{
-					c.v = v;
-					changed = true;
-				}
+				l.v = *l.p;
+				changed = true;
 			}
+		}
+		for (auto i = 0; i < global_values.size(); i++)
+		{
+			auto& g = compiled->globals[i];
+			auto v = 0.f;
+			switch (g.type)
+			{
+			case DataInt:
+				v = (float)*(int*)g.p;
 				break;
 			case DataFloat:
-			{
-				auto v = *(float*)c.p;
-				if (c.v != v)
-				{
-					c.v = *(float*)c.p;
-					changed = true;
-				}
-			}
+				v = *(float*)g.p;
 				break;
 			}
+			if (global_values[i] != v)
+			{
+				global_values[i] = v;
+				changed = true;
+			}
 		}
 		return changed;
 	}
 
+	void ExpressionPrivate::fill_slots()
+	{
+		auto& slots = compiled->slots;
+		for (auto i = 0; i < locals.size(); i++)
+		{
+			auto& l = locals[i];
+			slots[i] = l.p ? *l.p : l.v;
+		}
+		for (auto i = 0; i < global_values.size(); i++)
+			*compiled->globals[i].slot = global_values[i];
+	}
+
 	float ExpressionPrivate::get_value()
 	{
-		return expression.value();
+		if (!compiled || !compiled->ok)
+			return 0.f;
+		std::lock_guard<std::mutex> lock(compiled->mtx);
+		fill_slots();
+		return compiled->expression.value();
 	}
 
 	std::string ExpressionPrivate::get_string_value()
 	{
+		if (!compiled || !compiled->ok)
+			return "";
+		std::lock_guard<std::mutex> lock(compiled->mtx);
+		fill_slots();
+		auto& return_value = compiled->return_value;
 		return_value.clear();
-		auto float_ret = expression.value();
+		auto float_ret = compiled->expression.value();
 		if (!return_value.empty())
 			return return_value;
 		return str(float_ret);
 	}
 
+	void ExpressionPrivate::get_values(uint count, const float* variables, uint stride, float* out)
+	{
+		if (!compiled || !compiled->ok)
+		{
+			std::fill(out, out + count, 0.f);
+			return;
+		}
+		std::lock_guard<std::mutex> lock(compiled->mtx);
+		fill_slots();
+		std::vector<float*> dsts;
+		for (auto i = 0; i < locals.size(); i++)
+		{
+			if (locals[i].p)
+				dsts.push_back(&compiled->slots[i]);
+		}
+		auto& expression = compiled->expression;
+		for (auto r = 0; r < count; r++)
+		{
+			auto row = variables + r * stride;
+			for (auto j = 0; j < dsts.size(); j++)
+				*dsts[j] = row[j];
+			out[r] = expression.value();
+		}
+	}
+
 	Expression* Expression::create(const std::string& expression_string)
 	{
 		return new ExpressionPrivate(expression_string);
@@ -259,12 +401,12 @@ namespace flame
 		pugi::xml_node doc_root;
 
 		auto filename = Path::get(_filename);
-		if (!std::filesystem::exists(filename))
+		if (!vfs_exists(filename))
 		{
 			wprintf(L"preset does not exist: %s\n", _filename.c_str());
 			return nullptr;
 		}
-		if (!doc.load_file(filename.c_str()) || (doc_root = doc.first_child()).name() != std::string("preset"))
+		if (!vfs_load_xml(doc, filename) || (doc_root = doc.first_child()).name() != std::string("preset"))
 		{
 			wprintf(L"preset is wrong format: %s\n", _filename.c_str());
 			return nullptr;
@@ -363,9 +505,13 @@ namespace flame
 			return 1;
 
 		last_time = performance_counter();
+		profiler_set_thread_name("Main");
 
 		for (;;)
 		{
+			profiler_new_frame();
+			frame_arena_new_frame();
+
 			MSG msg;
 			while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE))
 			{
@@ -393,10 +539,13 @@ namespace flame
 
 			process_events();
 
-			if (!callback())
 			{
-				app_exiting = true;
-				return 0;
+				FLAME_PROFILE_ZONE("Frame Callback");
+				if (!callback())
+				{
+					app_exiting = true;
+					return 0;
+				}
 			}
 
 			for (auto w : windows)
@@ -464,6 +613,9 @@ namespace flame
 
 	void process_events()
 	{
+		FLAME_PROFILE_ZONE("Events");
+		process_main_thread_jobs();
+
 		static std::vector<Event*> _events;
 		std::lock_guard<std::recursive_mutex> lock(event_mtx);
 		_events.resize(events.size());
@@ -493,6 +645,421 @@ namespace flame
 		}
 	}
 
+	struct Job
+	{
+		std::function<void()>	callback;
+		JobFlags				flags = JobFlagNone;
+		std::atomic<int>		unfinished = 1; // the dependencies that are not done, and one until it is submitted
+		std::atomic<int>		ref = 2; // the creator and the scheduler
+		std::atomic<bool>		done = false;
+		std::mutex				mtx;
+		std::vector<Job*>		dependents;
+	};
+
+	struct JobWorker
+	{
+		std::mutex			mtx;
+		std::deque<Job*>	jobs; // the owner takes from the back, thieves take from the front
+		std::atomic<uint64>	busy_ticks = 0;
+		std::atomic<uint>	jobs_count = 0;
+		std::atomic<uint>	steals_count = 0;
+	};
+
+	static const auto main_thread_id = std::this_thread::get_id();
+	static thread_local uint job_worker_index = 0; // 0 is for the threads that are not workers
+	static thread_local uint job_depth = 0; // the jobs that are running on this thread, nested by waits
+
+	struct JobScheduler
+	{
+		uint										workers_count = 0;
+		std::atomic<uint>							workers_limit = 0;
+		std::unique_ptr<JobWorker[]>				workers; // workers_count + 1, the first one is the queue of the threads that are not workers
+		std::atomic<int>							queued = 0;
+		std::mutex									sleep_mtx;
+		std::condition_variable						sleep_cv;
+		std::mutex									main_mtx;
+		std::deque<Job*>							main_jobs;
+		uint64										stats_begin = 0;
+
+		JobScheduler()
+		{
+			workers_count = max((int)std::thread::hardware_concurrency() - 1, 1);
+			workers_limit = workers_count;
+			workers.reset(new JobWorker[workers_count + 1]);
+			stats_begin = performance_counter();
+			for (auto i = 1; i <= workers_count; i++)
+			{
+				std::thread([this, i]() {
+					job_worker_index = i;
+					profiler_set_thread_name("Worker " + str(i));
+					for (;;)
+					{
+						if (i <= workers_limit)
+						{
+							if (auto job = take(i); job)
+							{
+								frame_arena_sync();
+								run(job, i);
+								continue;
+							}
+						}
+						std::unique_lock<std::mutex> lock(sleep_mtx);
+						sleep_cv.wait(lock, [this, i]() { return queued > 0 && i <= workers_limit; });
+					}
+				}).detach();
+			}
+		}
+
+		void push(Job* job)
+		{
+			if (job->flags & JobFlagMainThread)
+			{
+				std::lock_guard<std::mutex> lock(main_mtx);
+				main_jobs.push_back(job);
+				return;
+			}
+			auto& w = workers[job_worker_index];
+			{
+				std::lock_guard<std::mutex> lock(w.mtx);
+				w.jobs.push_back(job);
+			}
+			queued++;
+			// taking the lock orders the push before a worker that is about to sleep checks queued
+			{
+				std::lock_guard<std::mutex> lock(sleep_mtx);
+			}
+			// one wakeup could go to a worker above the limit, which goes back to sleep and loses it
+			if (workers_limit < workers_count)
+				sleep_cv.notify_all();
+			else
+				sleep_cv.notify_one();
+		}
+
+		Job* take(uint idx)
+		{
+			Job* ret = nullptr;
+			{
+				auto& w = workers[idx];
+				std::lock_guard<std::mutex> lock(w.mtx);
+				if (!w.jobs.empty())
+				{
+					if (idx == 0)
+					{
+						ret = w.jobs.front();
+						w.jobs.pop_front();
+					}
+					else
+					{
+						ret = w.jobs.back();
+						w.jobs.pop_back();
+					}
+				}
+			}
+			if (!ret)
+			{
+				// steal the oldest job of another queue, starting from the next one so the thieves spread out
+				auto n = workers_count + 1;
+				for (auto i = 1; i < n && !ret; i++)
+				{
+					auto& w = workers[(idx + i) % n];
+					std::lock_guard<std::mutex> lock(w.mtx);
+					if (!w.jobs.empty())
+					{
+						ret = w.jobs.front();
+						w.jobs.pop_front();
+						workers[idx].steals_count++;
+					}
+				}
+			}
+			if (ret)
+				queued--;
+			return ret;
+		}
+
+		Job* take_main()
+		{
+			std::lock_guard<std::mutex> lock(main_mtx);
+			if (main_jobs.empty())
+				return nullptr;
+			auto ret = main_jobs.front();
+			main_jobs.pop_front();
+			return ret;
+		}
+
+		void run(Job* job, uint idx)
+		{
+			auto t0 = performance_counter();
+			job_depth++;
+			{
+				FLAME_PROFILE_ZONE("Job");
+				job->callback();
+			}
+			job_depth--;
+			auto& w = workers[idx];
+			// a job that waits runs other jobs inside, count the time only once
+			if (job_depth == 0)
+				w.busy_ticks += performance_counter() - t0;
+			w.jobs_count++;
+
+			std::vector<Job*> dependents;
+			{
+				std::lock_guard<std::mutex> lock(job->mtx);
+				job->done = true;
+				dependents.swap(job->dependents);
+			}
+			for (auto d : dependents)
+			{
+				if (--d->unfinished == 0)
+					push(d);
+				release_job(d);
+			}
+			release_job(job);
+		}
+
+		// runs one job that is ready, returns false if there is none
+		bool help()
+		{
+			if (std::this_thread::get_id() == main_thread_id)
+			{
+				if (auto job = take_main(); job)
+				{
+					run(job, 0);
+					return true;
+				}
+			}
+			if (job_worker_index == 0 || job_worker_index <= workers_limit)
+			{
+				if (auto job = take(job_worker_index); job)
+				{
+					run(job, job_worker_index);
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	static JobScheduler& get_job_scheduler()
+	{
+		// never destroyed, the workers are detached and end with the process
+		static auto scheduler = new JobScheduler;
+		return *scheduler;
+	}
+
+	Job* create_job(const std::function<void()>& callback, JobFlags flags)
+	{
+		auto job = new Job;
+		job->callback = callback;
+		job->flags = flags;
+		return job;
+	}
+
+	void add_job_dependency(Job* job, Job* dependency)
+	{
+		std::lock_guard<std::mutex> lock(dependency->mtx);
+		if (dependency->done)
+			return;
+		job->unfinished++;
+		job->ref++;
+		dependency->dependents.push_back(job);
+	}
+
+	void submit_job(Job* job)
+	{
+		if (--job->unfinished == 0)
+			get_job_scheduler().push(job);
+	}
+
+	void wait_job(Job* job)
+	{
+		auto& scheduler = get_job_scheduler();
+		while (!job->done)
+		{
+			if (!scheduler.help())
+				std::this_thread::yield();
+		}
+	}
+
+	bool is_job_done(Job* job)
+	{
+		return job->done;
+	}
+
+	void release_job(Job* job)
+	{
+		if (--job->ref == 0)
+			delete job;
+	}
+
+	void process_main_thread_jobs()
+	{
+		auto& scheduler = get_job_scheduler();
+		// only the jobs that are ready now, the ones they make ready run in the next call
+		size_t n;
+		{
+			std::lock_guard<std::mutex> lock(scheduler.main_mtx);
+			n = scheduler.main_jobs.size();
+		}
+		for (; n > 0; n--)
+		{
+			auto job = scheduler.take_main();
+			if (!job)
+				break;
+			scheduler.run(job, 0);
+		}
+	}
+
+	uint job_workers_count()
+	{
+		return get_job_scheduler().workers_count;
+	}
+
+	void set_job_workers_limit(uint n)
+	{
+		auto& scheduler = get_job_scheduler();
+		scheduler.workers_limit = min(n, scheduler.workers_count);
+		{
+			std::lock_guard<std::mutex> lock(scheduler.sleep_mtx);
+		}
+		scheduler.sleep_cv.notify_all();
+	}
+
+	std::vector<JobWorkerStats> get_job_stats(bool reset)
+	{
+		auto& scheduler = get_job_scheduler();
+		auto now = performance_counter();
+		auto elapsed = max(now - scheduler.stats_begin, 1ULL);
+		std::vector<JobWorkerStats> ret(scheduler.workers_count + 1);
+		for (auto i = 0; i <= scheduler.workers_count; i++)
+		{
+			auto& w = scheduler.workers[i];
+			auto& s = ret[i];
+			s.busy_ticks = reset ? w.busy_ticks.exchange(0) : w.busy_ticks.load();
+			s.jobs_count = reset ? w.jobs_count.exchange(0) : w.jobs_count.load();
+			s.steals_count = reset ? w.steals_count.exchange(0) : w.steals_count.load();
+			s.utilization = (float)((double)s.busy_ticks / elapsed);
+		}
+		if (reset)
+			scheduler.stats_begin = now;
+		return ret;
+	}
+
+	void parallel_for(uint count, const std::function<void(uint, uint)>& callback, uint grain)
+	{
+		if (count == 0)
+			return;
+		grain = max(grain, 1U);
+		auto& scheduler = get_job_scheduler();
+		auto n_ranges = min((count + grain - 1) / grain, scheduler.workers_limit + 1);
+		if (n_ranges <= 1)
+		{
+			auto t0 = performance_counter();
+			callback(0, count);
+			if (job_depth == 0)
+				scheduler.workers[job_worker_index].busy_ticks += performance_counter() - t0;
+			return;
+		}
+
+		// the ranges are handed out by a counter, so a job that starts late finds nothing left instead of holding up the others
+		auto range_size = (count + n_ranges - 1) / n_ranges;
+		std::atomic<uint> next = 0;
+		auto work = [&]() {
+			for (;;)
+			{
+				auto i = next++;
+				if (i >= n_ranges)
+					break;
+				auto begin = i * range_size;
+				auto end = min(begin + range_size, count);
+				if (begin < end)
+					callback(begin, end);
+			}
+		};
+
+		std::vector<Job*> jobs(n_ranges - 1);
+		for (auto& j : jobs)
+		{
+			j = create_job(work);
+			submit_job(j);
+		}
+		auto t0 = performance_counter();
+		work();
+		if (job_depth == 0)
+			scheduler.workers[job_worker_index].busy_ticks += performance_counter() - t0;
+		// the jobs reference this stack frame, so wait until all of them have run
+		for (auto j : jobs)
+		{
+			wait_job(j);
+			release_job(j);
+		}
+	}
+
+	void radix_sort(uint64* keys, uint64* temp, uint count)
+	{
+		if (count < 2)
+			return;
+
+		auto and_all = ~0ULL;
+		auto or_all = 0ULL;
+		for (auto i = 0; i < count; i++)
+		{
+			and_all &= keys[i];
+			or_all |= keys[i];
+		}
+		auto diff = and_all ^ or_all;
+		if (diff == 0)
+			return;
+
+		// fixed blocks, so that the histogram and the scatter of one block see the same items
+		auto block_size = max(4096U, (count + 63) / 64);
+		auto n_blocks = (count + block_size - 1) / block_size;
+		std::vector<uint> offsets(n_blocks * 256);
+		auto src = keys;
+		auto dst = temp;
+		for (auto shift = 0; shift < 64; shift += 8)
+		{
+			if (((diff >> shift) & 0xff) == 0)
+				continue;
+
+			std::fill(offsets.begin(), offsets.end(), 0);
+			parallel_for(n_blocks, [&](uint begin, uint end) {
+				for (auto b = begin; b < end; b++)
+				{
+					auto h = offsets.data() + b * 256;
+					auto i1 = min((b + 1) * block_size, count);
+					for (auto i = b * block_size; i < i1; i++)
+						h[(src[i] >> shift) & 0xff]++;
+				}
+			}, 1);
+
+			auto sum = 0U;
+			for (auto d = 0; d < 256; d++)
+			{
+				for (auto b = 0; b < n_blocks; b++)
+				{
+					auto& o = offsets[b * 256 + d];
+					auto n = o;
+					o = sum;
+					sum += n;
+				}
+			}
+
+			parallel_for(n_blocks, [&](uint begin, uint end) {
+				for (auto b = begin; b < end; b++)
+				{
+					auto o = offsets.data() + b * 256;
+					auto i1 = min((b + 1) * block_size, count);
+					for (auto i = b * block_size; i < i1; i++)
+						dst[o[(src[i] >> shift) & 0xff]++] = src[i];
+				}
+			}, 1);
+
+			std::swap(src, dst);
+		}
+		if (src != keys)
+			memcpy(keys, src, count * sizeof(uint64));
+	}
+
 	struct _Initializer
 	{
 		_Initializer()
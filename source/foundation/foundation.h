@@ -6,6 +6,8 @@
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 #ifdef FLAME_FOUNDATION_MODULE
 
@@ -34,6 +36,7 @@ namespace flame
 	FLAME_FOUNDATION_TYPE(BlueprintInstance);
 	FLAME_FOUNDATION_TYPE(BlueprintDebugger);
 	FLAME_FOUNDATION_TYPE(Sheet);
+	FLAME_FOUNDATION_TYPE(Pack);
 
 	struct TypeInfo;
 	struct VariableInfo;
@@ -200,6 +203,11 @@ namespace flame
 	template<typename T>
 	concept basic_foundation_type = is_one_of_t<T>(basic_foundation_types());
 
+	// virtual file system, files in mounted packs (see pack.h) are found first, then loose files
+	FLAME_FOUNDATION_API bool vfs_exists(const std::filesystem::path& filename);
+	FLAME_FOUNDATION_API bool vfs_read(const std::filesystem::path& filename, std::string& content);
+	FLAME_FOUNDATION_API bool vfs_in_pack(const std::filesystem::path& filename);
+
 	struct Path
 	{
 		FLAME_FOUNDATION_API static std::map<std::wstring, std::filesystem::path> roots;
@@ -254,8 +262,8 @@ namespace flame
 		inline static bool exists(const std::filesystem::path& path)
 		{
 			if (auto pos = path.native().find('#'); pos != std::wstring::npos)
-				return std::filesystem::exists(path.native().substr(0, pos));
-			return std::filesystem::exists(path);
+				return vfs_exists(path.native().substr(0, pos));
+			return vfs_exists(path);
 		}
 
 		inline static std::filesystem::path combine(const std::filesystem::path& base, const std::filesystem::path& path)
@@ -458,6 +466,8 @@ namespace flame
 		virtual bool update_bindings() = 0;
 		virtual float get_value() = 0;
 		virtual std::string get_string_value() = 0;
+		// evaluate once per row, row r holds the values of the variables (in the order they were set) at variables + r * stride
+		virtual void get_values(uint count, const float* variables, uint stride, float* out) = 0;
 
 		FLAME_FOUNDATION_API static Expression* create(const std::string& expression_string);
 	};
@@ -478,4 +488,44 @@ namespace flame
 	FLAME_FOUNDATION_API void remove_event(void* ev);
 	FLAME_FOUNDATION_API void clear_events();
 	FLAME_FOUNDATION_API void process_events();
+
+	enum JobFlags
+	{
+		JobFlagNone = 0,
+		JobFlagMainThread = 1 << 0 // runs only on the main thread, in process_events or while the main thread waits
+	};
+
+	struct Job;
+
+	struct JobWorkerStats
+	{
+		uint64	busy_ticks = 0; // performance_counter ticks spent running jobs
+		uint	jobs_count = 0;
+		uint	steals_count = 0;
+		float	utilization = 0.f; // busy_ticks over the ticks since the last reset
+	};
+
+	// jobs run on one worker thread per core, each worker has its own deque and steals from the others when it runs dry
+	//  a job runs after all the jobs it depends on are done, so a job that depends on others is their continuation
+	//  create it, add its dependencies, submit it, then wait or release it, it is freed when it is done and released
+	FLAME_FOUNDATION_API Job* create_job(const std::function<void()>& callback, JobFlags flags = JobFlagNone);
+	// only before the job is submitted
+	FLAME_FOUNDATION_API void add_job_dependency(Job* job, Job* dependency);
+	FLAME_FOUNDATION_API void submit_job(Job* job);
+	// runs other jobs until the job is done, so it can be called inside a job
+	FLAME_FOUNDATION_API void wait_job(Job* job);
+	FLAME_FOUNDATION_API bool is_job_done(Job* job);
+	FLAME_FOUNDATION_API void release_job(Job* job);
+	// runs the main thread jobs that are ready, process_events calls it every frame
+	FLAME_FOUNDATION_API void process_main_thread_jobs();
+	FLAME_FOUNDATION_API uint job_workers_count();
+	// only the first n workers take jobs, all of them by default
+	FLAME_FOUNDATION_API void set_job_workers_limit(uint n);
+	// index 0 is the threads that are not workers (the main thread), the others are the workers
+	FLAME_FOUNDATION_API std::vector<JobWorkerStats> get_job_stats(bool reset = false);
+
+	// split [0, count) into ranges of at least grain items and run them as jobs, the calling thread also takes part and it returns when all ranges are done
+	FLAME_FOUNDATION_API void parallel_for(uint count, const std::function<void(uint /*begin*/, uint /*end*/)>& callback, uint grain = 64);
+	// sort 64-bit keys ascending with a parallel LSD radix sort, temp must have room for count keys, the bytes that are the same in all keys are skipped
+	FLAME_FOUNDATION_API void radix_sort(uint64* keys, uint64* temp, uint count);
 }
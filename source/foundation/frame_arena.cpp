@@ -0,0 +1,90 @@
+#include "frame_arena.h"
+
+namespace flame
+{
+	const auto FrameArenaChunkSize = 256U * 1024U;
+
+	static std::mutex frame_arena_mtx;
+	static std::vector<std::unique_ptr<FrameArena>> frame_arenas; // never removed
+	static std::atomic<uint64> frame_arena_frame = 0;
+
+	FrameArena* frame_arena_register_thread()
+	{
+		static thread_local FrameArena* arena = nullptr;
+		if (!arena)
+		{
+			std::lock_guard<std::mutex> lock(frame_arena_mtx);
+			arena = new FrameArena;
+			arena->frame = frame_arena_frame;
+			frame_arenas.emplace_back(arena);
+		}
+		return arena;
+	}
+
+	static char* new_chunk(FrameArena* arena, uint64 size)
+	{
+		auto& c = arena->chunks.emplace_back();
+		c.data = (char*)malloc(size);
+		c.size = size;
+		arena->top = c.data;
+		arena->end = c.data + size;
+		arena->heap_allocations.store(arena->heap_allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		arena->reserved_bytes.store(arena->reserved_bytes.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+		return c.data;
+	}
+
+	void* frame_arena_grow(FrameArena* arena, uint64 size, uint64 align)
+	{
+		if (!arena->chunks.empty())
+			arena->used += arena->top - arena->chunks.back().data;
+		auto p = new_chunk(arena, max((uint64)FrameArenaChunkSize, size + align));
+		return (char*)(((uint64)p + align - 1) & ~(align - 1));
+	}
+
+	static void reset(FrameArena* arena)
+	{
+		arena->frame = frame_arena_frame;
+		if (arena->chunks.empty())
+			return;
+		if (arena->chunks.size() > 1)
+		{
+			// the frame did not fit, make one chunk that does
+			auto size = arena->used + (arena->top - arena->chunks.back().data);
+			size = max(size, arena->chunks.back().size);
+			for (auto& c : arena->chunks)
+				free(c.data);
+			arena->chunks.clear();
+			arena->reserved_bytes.store(0, std::memory_order_relaxed);
+			new_chunk(arena, size + size / 2);
+		}
+		arena->top = arena->chunks.back().data;
+		arena->used = 0;
+	}
+
+	void frame_arena_new_frame()
+	{
+		frame_arena_frame++;
+		reset(frame_arena());
+	}
+
+	void frame_arena_sync()
+	{
+		auto arena = frame_arena();
+		if (arena->frame != frame_arena_frame)
+			reset(arena);
+	}
+
+	FrameArenaStats get_frame_arena_stats()
+	{
+		FrameArenaStats ret;
+		std::lock_guard<std::mutex> lock(frame_arena_mtx);
+		for (auto& a : frame_arenas)
+		{
+			ret.allocations += a->allocations.load(std::memory_order_relaxed);
+			ret.allocated_bytes += a->allocated_bytes.load(std::memory_order_relaxed);
+			ret.heap_allocations += a->heap_allocations.load(std::memory_order_relaxed);
+			ret.reserved_bytes += a->reserved_bytes.load(std::memory_order_relaxed);
+		}
+		return ret;
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "foundation.h"
+
+namespace flame
+{
+	// a linear allocator for the data that lives no longer than a frame, each thread has its own so allocating takes no lock
+	//  it is reset when the next frame begins, when it runs out of space a new chunk is taken from the heap
+	//  and at the reset the chunks are merged into one that fits them all, so after a few frames it takes nothing from the heap
+	struct FrameArena
+	{
+		struct Chunk
+		{
+			char*	data;
+			uint64	size;
+		};
+
+		char*				top = nullptr;
+		char*				end = nullptr;
+		std::vector<Chunk>	chunks; // the last one is the one in use
+		uint64				frame = 0; // the frame it was reset at
+		uint64				used = 0; // the bytes of the full chunks of this frame
+		// only the owner thread writes them
+		std::atomic<uint64>	allocations = 0;
+		std::atomic<uint64>	allocated_bytes = 0;
+		std::atomic<uint64>	heap_allocations = 0;
+		std::atomic<uint64>	reserved_bytes = 0;
+	};
+
+	struct FrameArenaStats
+	{
+		uint64 allocations = 0; // of all threads since the start
+		uint64 allocated_bytes = 0;
+		uint64 heap_allocations = 0; // the chunks the arenas took from the heap
+		uint64 reserved_bytes = 0; // the chunks the arenas hold now
+	};
+
+	// the one of the calling thread, created at the first call
+	FLAME_FOUNDATION_API FrameArena* frame_arena_register_thread();
+	// takes a new chunk that fits the size
+	FLAME_FOUNDATION_API void* frame_arena_grow(FrameArena* arena, uint64 size, uint64 align);
+	// run() calls it at the beginning of every frame, it resets the arena of the calling thread
+	FLAME_FOUNDATION_API void frame_arena_new_frame();
+	// resets the arena of the calling thread if a new frame began, the job workers call it between jobs, other threads must call it themselves
+	FLAME_FOUNDATION_API void frame_arena_sync();
+	FLAME_FOUNDATION_API FrameArenaStats get_frame_arena_stats();
+
+	inline FrameArena* frame_arena()
+	{
+		// cached in every module, the arena is shared
+		static thread_local FrameArena* arena = nullptr;
+		if (!arena)
+			arena = frame_arena_register_thread();
+		return arena;
+	}
+
+	inline void* frame_alloc(uint64 size, uint64 align = 16)
+	{
+		auto arena = frame_arena();
+		auto p = (char*)(((uint64)arena->top + align - 1) & ~(align - 1));
+		if (!arena->top || p + size > arena->end)
+			p = (char*)frame_arena_grow(arena, size, align);
+		arena->top = p + size;
+		arena->allocations.store(arena->allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		arena->allocated_bytes.store(arena->allocated_bytes.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+		return p;
+	}
+
+	// only the last allocation of the thread is given back, so a scoped container returns its memory, the others are freed by the reset
+	inline void frame_free(void* _p, uint64 size)
+	{
+		auto arena = frame_arena();
+		auto p = (char*)_p;
+		if (arena->top && p + size == arena->top && p >= arena->chunks.back().data)
+			arena->top = p;
+	}
+
+	// the memory comes from the frame arena of the thread that allocates, the containers must not live into the next frame
+	template<typename T>
+	struct FrameAllocator
+	{
+		typedef T value_type;
+
+		FrameAllocator() = default;
+		template<typename U>
+		FrameAllocator(const FrameAllocator<U>&) {}
+
+		T* allocate(size_t n)
+		{
+			return (T*)frame_alloc(n * sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+		}
+
+		void deallocate(T* p, size_t n)
+		{
+			frame_free(p, n * sizeof(T));
+		}
+
+		template<typename U>
+		bool operator==(const FrameAllocator<U>&) const { return true; }
+		template<typename U>
+		bool operator!=(const FrameAllocator<U>&) const { return false; }
+	};
+
+	template<typename T>
+	using FrameVector = std::vector<T, FrameAllocator<T>>;
+	template<typename T>
+	using FrameDeque = std::deque<T, FrameAllocator<T>>;
+}
@@ -0,0 +1,467 @@
+#include "system_private.h"
+#include "pack_private.h"
+
+namespace flame
+{
+	std::vector<std::unique_ptr<PackT>> mounted_packs;
+
+	// lz4 block format, greedy matching with a single hash table, good enough for packing offline
+	static std::string lz4_compress(const char* src, uint size)
+	{
+		const auto HashBits = 16;
+		const auto MinMatch = 4U;
+		std::string dst;
+		dst.reserve(size + size / 255 + 16);
+		std::vector<int> table(1 << HashBits, -1);
+		auto read32 = [&](uint p) {
+			uint v;
+			memcpy(&v, src + p, 4);
+			return v;
+		};
+		auto put_length = [&](uint len) {
+			while (len >= 255)
+			{
+				dst += (char)255;
+				len -= 255;
+			}
+			dst += (char)len;
+		};
+
+		auto anchor = 0U;
+		auto p = 0U;
+		// the last match must start 12 bytes before the end and the last 5 bytes are always literals
+		auto match_limit = size > 12 ? size - 12 : 0;
+		auto end_limit = size > 5 ? size - 5 : 0;
+		while (p < match_limit)
+		{
+			auto v = read32(p);
+			auto h = (v * 2654435761U) >> (32 - HashBits);
+			auto ref = table[h];
+			table[h] = p;
+			if (ref < 0 || p - ref > 65535 || read32(ref) != v)
+			{
+				p++;
+				continue;
+			}
+			auto len = MinMatch;
+			while (p + len < end_limit && src[ref + len] == src[p + len])
+				len++;
+
+			auto lit = p - anchor;
+			auto token_pos = dst.size();
+			dst += (char)0;
+			if (lit >= 15)
+				put_length(lit - 15);
+			dst.append(src + anchor, lit);
+			auto off = p - ref;
+			dst += (char)(off & 0xff);
+			dst += (char)(off >> 8);
+			auto ml = len - MinMatch;
+			if (ml >= 15)
+				put_length(ml - 15);
+			dst[token_pos] = (char)((min(lit, 15U) << 4) | min(ml, 15U));
+
+			p += len;
+			anchor = p;
+		}
+		auto lit = size - anchor;
+		dst += (char)(min(lit, 15U) << 4);
+		if (lit >= 15)
+			put_length(lit - 15);
+		dst.append(src + anchor, lit);
+		return dst;
+	}
+
+	static bool lz4_decompress(const char* src, uint64 src_size, char* dst, uint64 dst_size)
+	{
+		auto ip = (const uchar*)src;
+		auto iend = ip + src_size;
+		auto op = (uchar*)dst;
+		auto oend = op + dst_size;
+		auto get_length = [&](uint64& len) {
+			uchar b;
+			do
+			{
+				if (ip >= iend)
+					return false;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+			return true;
+		};
+		while (ip < iend)
+		{
+			auto token = *ip++;
+			uint64 lit = token >> 4;
+			if (lit == 15 && !get_length(lit))
+				return false;
+			if (lit > iend - ip || lit > oend - op)
+				return false;
+			memcpy(op, ip, lit);
+			ip += lit;
+			op += lit;
+			if (ip == iend)
+				break; // the last sequence has no match
+			if (iend - ip < 2)
+				return false;
+			uint64 off = ip[0] | (ip[1] << 8);
+			ip += 2;
+			if (off == 0 || off > op - (uchar*)dst)
+				return false;
+			uint64 ml = token & 15;
+			if (ml == 15 && !get_length(ml))
+				return false;
+			ml += 4;
+			if (ml > oend - op)
+				return false;
+			// may overlap, copy byte by byte
+			auto m = op - off;
+			for (auto i = 0; i < ml; i++)
+				op[i] = m[i];
+			op += ml;
+		}
+		return op == oend;
+	}
+
+	static std::wstring vfs_key(const std::filesystem::path& path)
+	{
+		auto ret = path.lexically_normal().generic_wstring();
+		SUS::to_lower(ret);
+		return ret;
+	}
+
+	PackPrivate::~PackPrivate()
+	{
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file)
+			CloseHandle(file);
+	}
+
+	const PackEntry* PackPrivate::find(const std::filesystem::path& path)
+	{
+		auto key = vfs_key(path);
+		if (!key.starts_with(mount_prefix))
+			return nullptr;
+		auto name = w2s(key.substr(mount_prefix.size()));
+		auto hash = pack_name_hash(name);
+		auto end = entries + header.entries_count;
+		auto it = std::lower_bound(entries, end, hash, [](const PackEntry& e, uint64 h) {
+			return e.hash < h;
+		});
+		for (; it != end && it->hash == hash; it++)
+		{
+			if (get_name(it) == name)
+				return it;
+		}
+		return nullptr;
+	}
+
+	std::string_view PackPrivate::get_name(const PackEntry* entry)
+	{
+		return std::string_view(data + header.names_offset + entry->name_offset, entry->name_length);
+	}
+
+	std::string_view PackPrivate::get_view(const PackEntry* entry)
+	{
+		if (entry->stored_size != entry->size)
+			return std::string_view();
+		return std::string_view(data + entry->offset, entry->size);
+	}
+
+	bool PackPrivate::read(const PackEntry* entry, std::string& content)
+	{
+		if (entry->stored_size == entry->size)
+		{
+			content.assign(data + entry->offset, entry->size);
+			return true;
+		}
+		content.resize(entry->size);
+		if (!lz4_decompress(data + entry->offset, entry->stored_size, content.data(), entry->size))
+		{
+			printf("pack: corrupted entry: %s\n", std::string(get_name(entry)).c_str());
+			content.clear();
+			return false;
+		}
+		return true;
+	}
+
+	bool vfs_in_pack(const std::filesystem::path& filename)
+	{
+		if (mounted_packs.empty() || !filename.is_absolute())
+			return false;
+		for (auto it = mounted_packs.rbegin(); it != mounted_packs.rend(); it++)
+		{
+			if ((*it)->find(filename))
+				return true;
+		}
+		return false;
+	}
+
+	bool vfs_exists(const std::filesystem::path& filename)
+	{
+		if (vfs_in_pack(filename))
+			return true;
+		return std::filesystem::exists(filename);
+	}
+
+	bool vfs_read(const std::filesystem::path& filename, std::string& content)
+	{
+		if (!mounted_packs.empty() && filename.is_absolute())
+		{
+			for (auto it = mounted_packs.rbegin(); it != mounted_packs.rend(); it++)
+			{
+				if (auto e = (*it)->find(filename); e)
+					return (*it)->read(e, content);
+			}
+		}
+
+		std::ifstream file(filename, std::ios::binary);
+		if (!file.good())
+			return false;
+		file.seekg(0, std::ios::end);
+		auto length = (uint64)file.tellg();
+		file.seekg(0, std::ios::beg);
+		content.resize(length);
+		file.read(content.data(), length);
+		return true;
+	}
+
+	MappedFilePrivate::~MappedFilePrivate()
+	{
+		if (mapping)
+		{
+			UnmapViewOfFile(data.data());
+			CloseHandle(mapping);
+		}
+		if (file)
+			CloseHandle(file);
+	}
+
+	MappedFile* vfs_map(const std::filesystem::path& filename)
+	{
+		if (!mounted_packs.empty() && filename.is_absolute())
+		{
+			for (auto it = mounted_packs.rbegin(); it != mounted_packs.rend(); it++)
+			{
+				if (auto e = (*it)->find(filename); e)
+				{
+					auto ret = new MappedFilePrivate;
+					ret->data = (*it)->get_view(e);
+					if (ret->data.empty() && e->size > 0)
+					{
+						if (!(*it)->read(e, ret->content))
+						{
+							delete ret;
+							return nullptr;
+						}
+						ret->data = ret->content;
+					}
+					return ret;
+				}
+			}
+		}
+
+		auto file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return nullptr;
+		auto ret = new MappedFilePrivate;
+		ret->file = file;
+		LARGE_INTEGER file_size;
+		GetFileSizeEx(file, &file_size);
+		if (file_size.QuadPart == 0)
+			return ret;
+		ret->mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		auto data = ret->mapping ? (const char*)MapViewOfFile(ret->mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!data)
+		{
+			if (ret->mapping)
+			{
+				CloseHandle(ret->mapping);
+				ret->mapping = nullptr;
+			}
+			delete ret;
+			return nullptr;
+		}
+		ret->data = std::string_view(data, file_size.QuadPart);
+		return ret;
+	}
+
+	struct PackCreate : Pack::Create
+	{
+		bool operator()(const std::filesystem::path& dst, const std::filesystem::path& src_dir, bool compress, uint alignment) override
+		{
+			if (!std::filesystem::is_directory(src_dir))
+			{
+				wprintf(L"pack: source directory does not exist: %s\n", src_dir.c_str());
+				return false;
+			}
+			alignment = max(alignment, 1U);
+
+			struct Item
+			{
+				std::string name;
+				uint64 hash;
+				uint64 size;
+				std::string content;
+			};
+			std::vector<Item> items;
+			auto dst_key = vfs_key(std::filesystem::absolute(dst));
+			for (auto& it : std::filesystem::recursive_directory_iterator(src_dir))
+			{
+				if (!it.is_regular_file())
+					continue;
+				auto& path = it.path();
+				if (vfs_key(std::filesystem::absolute(path)) == dst_key)
+					continue;
+				auto& item = items.emplace_back();
+				item.name = pack_name(path.lexically_relative(src_dir));
+				item.hash = pack_name_hash(item.name);
+				vfs_read(path, item.content);
+				item.size = item.content.size();
+			}
+			if (compress)
+			{
+				parallel_for(items.size(), [&](uint begin, uint end) {
+					for (auto i = begin; i < end; i++)
+					{
+						auto& item = items[i];
+						if (item.size < 64)
+							continue;
+						auto packed = lz4_compress(item.content.data(), item.size);
+						if (packed.size() < item.size - item.size / 8)
+							item.content = std::move(packed);
+					}
+				}, 1);
+			}
+			std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+				return a.hash < b.hash;
+			});
+
+			auto align = [&](uint64 v) {
+				return (v + alignment - 1) / alignment * alignment;
+			};
+			PackHeader header;
+			memcpy(header.magic, "FPAK", 4);
+			header.version = 1;
+			header.entries_count = items.size();
+			header.alignment = alignment;
+			header.names_offset = sizeof(PackHeader) + sizeof(PackEntry) * items.size();
+			header.names_size = 0;
+			std::vector<PackEntry> entries(items.size());
+			for (auto i = 0; i < items.size(); i++)
+			{
+				auto& e = entries[i];
+				e.hash = items[i].hash;
+				e.size = items[i].size;
+				e.stored_size = items[i].content.size();
+				e.name_offset = header.names_size;
+				e.name_length = items[i].name.size();
+				header.names_size += e.name_length;
+			}
+			auto offset = align(header.names_offset + header.names_size);
+			for (auto& e : entries)
+			{
+				e.offset = offset;
+				offset = align(offset + e.stored_size);
+			}
+
+			std::ofstream file(dst, std::ios::binary);
+			if (!file.good())
+			{
+				wprintf(L"pack: cannot write: %s\n", dst.c_str());
+				return false;
+			}
+			file.write((char*)&header, sizeof(PackHeader));
+			file.write((char*)entries.data(), sizeof(PackEntry) * entries.size());
+			for (auto& item : items)
+				file.write(item.name.data(), item.name.size());
+			auto pos = header.names_offset + header.names_size;
+			std::string padding(alignment, 0);
+			for (auto i = 0; i < items.size(); i++)
+			{
+				file.write(padding.data(), entries[i].offset - pos);
+				file.write(items[i].content.data(), items[i].content.size());
+				pos = entries[i].offset + entries[i].stored_size;
+			}
+			file.close();
+			return true;
+		}
+	}Pack_create;
+	Pack::Create& Pack::create = Pack_create;
+
+	struct PackMount : Pack::Mount
+	{
+		PackPtr operator()(const std::filesystem::path& filename, const std::filesystem::path& mount_path) override
+		{
+			auto file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				wprintf(L"pack: cannot open: %s\n", filename.c_str());
+				return nullptr;
+			}
+
+			auto ret = new PackPrivate;
+			ret->file = file;
+			ret->filename = filename;
+			LARGE_INTEGER file_size;
+			GetFileSizeEx(file, &file_size);
+			ret->size = file_size.QuadPart;
+			if (ret->size >= sizeof(PackHeader))
+			{
+				ret->mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (ret->mapping)
+					ret->data = (const char*)MapViewOfFile(ret->mapping, FILE_MAP_READ, 0, 0, 0);
+			}
+			if (!ret->data)
+			{
+				wprintf(L"pack: cannot map: %s\n", filename.c_str());
+				delete ret;
+				return nullptr;
+			}
+
+			memcpy(&ret->header, ret->data, sizeof(PackHeader));
+			auto& header = ret->header;
+			if (memcmp(header.magic, "FPAK", 4) != 0 || header.version != 1 ||
+				sizeof(PackHeader) + sizeof(PackEntry) * (uint64)header.entries_count > header.names_offset ||
+				header.names_offset + header.names_size > ret->size)
+			{
+				wprintf(L"pack: wrong format: %s\n", filename.c_str());
+				delete ret;
+				return nullptr;
+			}
+			ret->entries = (const PackEntry*)(ret->data + sizeof(PackHeader));
+			for (auto i = 0; i < header.entries_count; i++)
+			{
+				auto& e = ret->entries[i];
+				if (e.offset + e.stored_size > ret->size || e.name_offset + e.name_length > header.names_size)
+				{
+					wprintf(L"pack: wrong format: %s\n", filename.c_str());
+					delete ret;
+					return nullptr;
+				}
+			}
+
+			ret->mount_path = std::filesystem::absolute(mount_path);
+			ret->mount_prefix = vfs_key(ret->mount_path);
+			if (!ret->mount_prefix.ends_with(L'/'))
+				ret->mount_prefix += L'/';
+			mounted_packs.emplace_back(ret);
+			return ret;
+		}
+	}Pack_mount;
+	Pack::Mount& Pack::mount = Pack_mount;
+
+	struct PackUnmount : Pack::Unmount
+	{
+		void operator()(PackPtr pack) override
+		{
+			std::erase_if(mounted_packs, [&](const auto& p) {
+				return p.get() == pack;
+			});
+		}
+	}Pack_unmount;
+	Pack::Unmount& Pack::unmount = Pack_unmount;
+}
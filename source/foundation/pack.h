@@ -0,0 +1,111 @@
+#pragma once
+
+#include "../xml.h"
+#include "foundation.h"
+
+namespace flame
+{
+	// a pack is a single file that holds many asset files, it is mapped into memory and mounted on a directory,
+	//  then the files in it are found by the paths they would have as loose files (see vfs_exists and vfs_read)
+	// layout: PackHeader, PackEntry x entries_count (sorted by hash), names, then the data of the entries
+	struct PackHeader
+	{
+		char magic[4];
+		uint version;
+		uint entries_count;
+		uint alignment; // every entry's data starts at a multiple of this
+		uint64 names_offset;
+		uint64 names_size;
+	};
+
+	struct PackEntry
+	{
+		uint64 hash; // of the name, see pack_name_hash
+		uint64 offset;
+		uint64 size;
+		uint64 stored_size; // smaller than size when lz4 compressed
+		uint name_offset;
+		uint name_length;
+	};
+
+	// names are relative to the mount directory, lower case and separated by '/'
+	inline std::string pack_name(const std::filesystem::path& relative_path)
+	{
+		auto ret = relative_path.generic_string();
+		SUS::to_lower(ret);
+		return ret;
+	}
+
+	// 64-bit FNV-1a, so thousands of entries do not collide in practice (names are still compared)
+	inline uint64 pack_name_hash(std::string_view name)
+	{
+		auto ret = 14695981039346656037ULL;
+		for (auto ch : name)
+		{
+			ret ^= (uchar)ch;
+			ret *= 1099511628211ULL;
+		}
+		return ret;
+	}
+
+	struct Pack
+	{
+		std::filesystem::path filename;
+		std::filesystem::path mount_path; // absolute
+		PackHeader header;
+		const PackEntry* entries = nullptr;
+
+		virtual ~Pack() {}
+
+		// path is absolute, returns null if it is not under mount_path or not in the pack
+		virtual const PackEntry* find(const std::filesystem::path& path) = 0;
+		virtual std::string_view get_name(const PackEntry* entry) = 0;
+		// the mapped bytes of an uncompressed entry, empty for compressed ones
+		virtual std::string_view get_view(const PackEntry* entry) = 0;
+		virtual bool read(const PackEntry* entry, std::string& content) = 0;
+
+		struct Create
+		{
+			// pack all files under src_dir into dst, entries that shrink less than 1/8 are stored uncompressed
+			virtual bool operator()(const std::filesystem::path& dst, const std::filesystem::path& src_dir, bool compress = true, uint alignment = 16) = 0;
+		};
+		FLAME_FOUNDATION_API static Create& create;
+
+		struct Mount
+		{
+			virtual PackPtr operator()(const std::filesystem::path& filename, const std::filesystem::path& mount_path) = 0;
+		};
+		// later mounted packs take priority
+		FLAME_FOUNDATION_API static Mount& mount;
+
+		struct Unmount
+		{
+			virtual void operator()(PackPtr pack) = 0;
+		};
+		FLAME_FOUNDATION_API static Unmount& unmount;
+	};
+
+	// a read-only view of a whole file, it is a view into the pack if the file is stored uncompressed in one,
+	//  or a mapping of the loose file, compressed packed files are decompressed into memory
+	//  a view into a pack is only valid while the pack is mounted
+	struct MappedFile
+	{
+		std::string_view data;
+
+		virtual ~MappedFile() {}
+	};
+
+	FLAME_FOUNDATION_API MappedFile* vfs_map(const std::filesystem::path& filename);
+
+	inline pugi::xml_parse_result vfs_load_xml(pugi::xml_document& doc, const std::filesystem::path& filename)
+	{
+		std::string content;
+		if (!vfs_read(filename, content))
+		{
+			pugi::xml_parse_result ret;
+			ret.status = pugi::status_file_not_found;
+			return ret;
+		}
+		return doc.load_buffer(content.data(), content.size());
+	}
+}
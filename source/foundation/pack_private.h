@@ -0,0 +1,33 @@
+#pragma once
+
+#include "pack.h"
+
+namespace flame
+{
+	struct PackPrivate : Pack
+	{
+		void* file = nullptr;
+		void* mapping = nullptr;
+		const char* data = nullptr;
+		uint64 size = 0;
+		std::wstring mount_prefix; // lower case and generic, ends with '/'
+
+		~PackPrivate();
+
+		const PackEntry* find(const std::filesystem::path& path) override;
+		std::string_view get_name(const PackEntry* entry) override;
+		std::string_view get_view(const PackEntry* entry) override;
+		bool read(const PackEntry* entry, std::string& content) override;
+	};
+
+	struct MappedFilePrivate : MappedFile
+	{
+		void* file = nullptr;
+		void* mapping = nullptr;
+		std::string content; // for compressed packed files
+
+		~MappedFilePrivate();
+	};
+
+	extern std::vector<std::unique_ptr<PackT>> mounted_packs;
+}
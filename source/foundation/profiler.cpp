@@ -0,0 +1,161 @@
+#include "profiler.h"
+#include "system.h"
+
+namespace flame
+{
+	bool profiler_enabled = false;
+
+	const auto ProfilerZonesPerThread = 1U << 15;
+	const auto ProfilerFramesCount = 256U;
+
+	static std::mutex profiler_mtx;
+	static std::vector<std::unique_ptr<ProfilerThread>> profiler_threads; // never removed, ids are their indices
+	static uint64 profiler_frames[ProfilerFramesCount]; // the ticks the frames begin at
+	static uint64 profiler_frames_count = 0;
+	// a pair of time points to convert ticks to time
+	static const uint64 profiler_calibration_ticks = profiler_ticks();
+	static const uint64 profiler_calibration_counter = performance_counter();
+
+	ProfilerThread* profiler_register_thread()
+	{
+		static thread_local ProfilerThread* thread = nullptr;
+		if (!thread)
+		{
+			std::lock_guard<std::mutex> lock(profiler_mtx);
+			thread = new ProfilerThread;
+			thread->id = profiler_threads.size();
+			thread->name = "Thread " + str(thread->id);
+			thread->zones.resize(ProfilerZonesPerThread);
+			thread->mask = ProfilerZonesPerThread - 1;
+			profiler_threads.emplace_back(thread);
+		}
+		return thread;
+	}
+
+	void profiler_set_thread_name(const std::string& name)
+	{
+		auto thread = profiler_register_thread();
+		std::lock_guard<std::mutex> lock(profiler_mtx);
+		thread->name = name;
+	}
+
+	void profiler_new_frame()
+	{
+		std::lock_guard<std::mutex> lock(profiler_mtx);
+		profiler_frames[profiler_frames_count % ProfilerFramesCount] = profiler_ticks();
+		profiler_frames_count++;
+	}
+
+	ProfilerCapture profiler_capture(uint frames_count)
+	{
+		ProfilerCapture ret;
+		std::lock_guard<std::mutex> lock(profiler_mtx);
+
+		// the current frame is not done
+		auto done_frames = profiler_frames_count > 0 ? profiler_frames_count - 1 : 0;
+		frames_count = min(frames_count, (uint)min(done_frames, (uint64)ProfilerFramesCount - 1));
+		if (frames_count > 0)
+		{
+			ret.begin = profiler_frames[(profiler_frames_count - 1 - frames_count) % ProfilerFramesCount];
+			ret.end = profiler_frames[(profiler_frames_count - 1) % ProfilerFramesCount];
+		}
+		else
+		{
+			ret.begin = 0;
+			ret.end = ~0ULL;
+		}
+		auto ticks = profiler_ticks();
+		auto us = (double)(performance_counter() - profiler_calibration_counter) / performance_frequency() * 1000000.0;
+		ret.ticks_per_us = us > 0.0 ? (ticks - profiler_calibration_ticks) / us : 1.0;
+
+		for (auto& t : profiler_threads)
+		{
+			auto& dst = ret.threads.emplace_back();
+			dst.id = t->id;
+			dst.name = t->name;
+
+			// the owner thread keeps writing while we read, the zones it overwrites meanwhile are dropped
+			auto written = t->written.load(std::memory_order_acquire);
+			auto first = written > ProfilerZonesPerThread ? written - ProfilerZonesPerThread : 0;
+			std::vector<ProfilerZone> zones;
+			zones.reserve(written - first);
+			for (auto i = first; i < written; i++)
+				zones.push_back(t->zones[i & t->mask]);
+			auto written_after = t->written.load(std::memory_order_acquire);
+			if (written_after > ProfilerZonesPerThread && written_after - ProfilerZonesPerThread > first)
+				zones.erase(zones.begin(), zones.begin() + min(written_after - ProfilerZonesPerThread - first, (uint64)zones.size()));
+
+			for (auto& z : zones)
+			{
+				if (z.begin >= ret.begin && z.end <= ret.end)
+					dst.zones.push_back(z);
+			}
+			// zones are written when they end, so the children come before their parents
+			std::sort(dst.zones.begin(), dst.zones.end(), [](const auto& a, const auto& b) {
+				return a.begin != b.begin ? a.begin < b.begin : a.depth < b.depth;
+			});
+		}
+		if (frames_count == 0)
+		{
+			ret.begin = ~0ULL;
+			ret.end = 0;
+			for (auto& t : ret.threads)
+			{
+				for (auto& z : t.zones)
+				{
+					ret.begin = min(ret.begin, z.begin);
+					ret.end = max(ret.end, z.end);
+				}
+			}
+			if (ret.begin > ret.end)
+				ret.begin = ret.end = 0;
+		}
+		return ret;
+	}
+
+	bool profiler_export_chrome_trace(const ProfilerCapture& capture, const std::filesystem::path& filename)
+	{
+		std::ofstream file(filename);
+		if (!file.good())
+		{
+			printf("profiler: cannot write %s\n", filename.string().c_str());
+			return false;
+		}
+
+		auto escape = [](std::string_view s) {
+			std::string ret;
+			for (auto ch : s)
+			{
+				if (ch == '"' || ch == '\\')
+					ret += '\\';
+				ret += ch;
+			}
+			return ret;
+		};
+		auto first = true;
+		auto separator = [&]() {
+			if (!first)
+				file << ",\n";
+			first = false;
+		};
+		char buf[64];
+		file << "{\"traceEvents\":[\n";
+		for (auto& t : capture.threads)
+		{
+			if (t.zones.empty())
+				continue;
+			separator();
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t.id << ",\"args\":{\"name\":\"" << escape(t.name) << "\"}}";
+			for (auto& z : t.zones)
+			{
+				separator();
+				file << "{\"name\":\"" << escape(z.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << t.id;
+				snprintf(buf, sizeof(buf), ",\"ts\":%.3f,\"dur\":%.3f}", (z.begin - capture.begin) / capture.ticks_per_us, (z.end - z.begin) / capture.ticks_per_us);
+				file << buf;
+			}
+		}
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		file.close();
+		return true;
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "foundation.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace flame
+{
+	// a span of cpu time on one thread, the name must live as long as the captures (a string literal)
+	struct ProfilerZone
+	{
+		const char*	name;
+		uint64		begin; // profiler_ticks
+		uint64		end;
+		uint		depth;
+	};
+
+	// each thread writes its zones to its own ring buffer so recording takes no lock, the oldest zones are overwritten
+	struct ProfilerThread
+	{
+		uint						id;
+		std::string					name;
+		std::vector<ProfilerZone>	zones; // the size is a power of two
+		uint64						mask;
+		std::atomic<uint64>			written = 0;
+		uint						depth = 0;
+	};
+
+	struct ProfilerCapture
+	{
+		struct Thread
+		{
+			uint						id;
+			std::string					name;
+			std::vector<ProfilerZone>	zones; // sorted by begin
+		};
+
+		uint64				begin = 0;
+		uint64				end = 0;
+		double				ticks_per_us = 1.0;
+		std::vector<Thread>	threads;
+	};
+
+	// zones are recorded only when it is on, and only if USE_PROFILER is defined, otherwise the zones are compiled out
+	FLAME_FOUNDATION_API extern bool profiler_enabled;
+
+	// the one of the calling thread, created at the first call
+	FLAME_FOUNDATION_API ProfilerThread* profiler_register_thread();
+	FLAME_FOUNDATION_API void profiler_set_thread_name(const std::string& name);
+	// run() calls it at the beginning of every frame
+	FLAME_FOUNDATION_API void profiler_new_frame();
+	// the zones of all threads in the last frames_count frames that are done, or all zones in the buffers if frames_count is 0
+	FLAME_FOUNDATION_API ProfilerCapture profiler_capture(uint frames_count = 1);
+	// the trace event format, chrome://tracing and Perfetto read it
+	FLAME_FOUNDATION_API bool profiler_export_chrome_trace(const ProfilerCapture& capture, const std::filesystem::path& filename);
+
+	inline uint64 profiler_ticks()
+	{
+		return __rdtsc();
+	}
+
+	inline ProfilerThread* profiler_thread()
+	{
+		// cached in every module, the thread object is shared
+		static thread_local ProfilerThread* thread = nullptr;
+		if (!thread)
+			thread = profiler_register_thread();
+		return thread;
+	}
+
+	struct ProfilerScope
+	{
+		ProfilerThread* thread = nullptr;
+		const char* name;
+		uint64 begin;
+
+		inline ProfilerScope(const char* _name)
+		{
+			if (!profiler_enabled)
+				return;
+			thread = profiler_thread();
+			name = _name;
+			thread->depth++;
+			begin = profiler_ticks();
+		}
+
+		inline ~ProfilerScope()
+		{
+			if (!thread)
+				return;
+			auto end = profiler_ticks();
+			auto idx = thread->written.load(std::memory_order_relaxed);
+			auto& z = thread->zones[idx & thread->mask];
+			z.name = name;
+			z.begin = begin;
+			z.end = end;
+			z.depth = --thread->depth;
+			thread->written.store(idx + 1, std::memory_order_release);
+		}
+	};
+}
+
+#ifdef USE_PROFILER
+#define FLAME_PROFILER_CONCAT_(a, b) a##b
+#define FLAME_PROFILER_CONCAT(a, b) FLAME_PROFILER_CONCAT_(a, b)
+#define FLAME_PROFILE_ZONE(name) flame::ProfilerScope FLAME_PROFILER_CONCAT(_profiler_scope_, __LINE__)(name)
+#else
+#define FLAME_PROFILE_ZONE(name)
+#endif
@@ -1,5 +1,6 @@
 #include "../xml.h"
 #include "typeinfo_private.h"
+#include "pack.h"
 #include "sheet_private.h"
 
 namespace flame
@@ -7,14 +8,145 @@ namespace flame
 	std::vector<std::unique_ptr<SheetT>> loaded_sheets;
 	std::map<uint, SheetPtr> named_sheets;
 
+	// the order the sorted indices use, numbers and strings by their values, other pod types by their bytes
+	static int compare_values(TypeInfo* type, const void* a, const void* b)
+	{
+		auto cmp = [](const auto& x, const auto& y) {
+			return x < y ? -1 : (y < x ? 1 : 0);
+		};
+		if (type == TypeInfo::get<int>())
+			return cmp(*(int*)a, *(int*)b);
+		if (type == TypeInfo::get<uint>())
+			return cmp(*(uint*)a, *(uint*)b);
+		if (type == TypeInfo::get<float>())
+		{
+			// nan is after all numbers and equals itself, or the sort has no strict weak order
+			auto x = *(float*)a, y = *(float*)b;
+			auto x_nan = x != x, y_nan = y != y;
+			if (x_nan || y_nan)
+				return x_nan == y_nan ? 0 : (x_nan ? 1 : -1);
+			return cmp(x, y);
+		}
+		if (type == TypeInfo::get<int64>())
+			return cmp(*(int64*)a, *(int64*)b);
+		if (type == TypeInfo::get<uint64>())
+			return cmp(*(uint64*)a, *(uint64*)b);
+		if (type == TypeInfo::get<short>())
+			return cmp(*(short*)a, *(short*)b);
+		if (type == TypeInfo::get<ushort>())
+			return cmp(*(ushort*)a, *(ushort*)b);
+		if (type == TypeInfo::get<char>())
+			return cmp(*(char*)a, *(char*)b);
+		if (type == TypeInfo::get<uchar>())
+			return cmp(*(uchar*)a, *(uchar*)b);
+		if (type == TypeInfo::get<std::string>())
+			return cmp(*(std::string*)a, *(std::string*)b);
+		if (type == TypeInfo::get<StrAndHash>())
+			return cmp(((StrAndHash*)a)->s, ((StrAndHash*)b)->s);
+		if (type == TypeInfo::get<std::wstring>())
+			return cmp(*(std::wstring*)a, *(std::wstring*)b);
+		if (type == TypeInfo::get<std::filesystem::path>())
+			return cmp(*(std::filesystem::path*)a, *(std::filesystem::path*)b);
+		if (type->pod)
+			return memcmp(a, b, type->size);
+		return cmp(type->serialize(a), type->serialize(b));
+	}
+
+	// values that compare equal must have the same hash
+	static uint64 hash_value(TypeInfo* type, const void* p)
+	{
+		if (type == TypeInfo::get<std::string>())
+			return std::hash<std::string>()(*(std::string*)p);
+		if (type == TypeInfo::get<StrAndHash>())
+			return std::hash<std::string>()(((StrAndHash*)p)->s);
+		if (type == TypeInfo::get<float>())
+		{
+			auto v = *(float*)p;
+			if (v != v)
+				return 1; // all nans are equal
+			return v == 0.f ? 0 : std::hash<float>()(v); // -0 equals 0
+		}
+		if (type->pod)
+		{
+			auto ret = 14695981039346656037ULL;
+			for (auto i = 0; i < type->size; i++)
+			{
+				ret ^= ((uchar*)p)[i];
+				ret *= 1099511628211ULL;
+			}
+			return ret;
+		}
+		return std::hash<std::string>()(type->serialize(p));
+	}
+
+	static TypeInfo* type_from_str(const std::string& str)
+	{
+		auto sp = SUS::to_string_vector(SUS::split(str, '@'));
+		if (sp.size() != 2)
+			return nullptr;
+		TypeTag tag;
+		TypeInfo::unserialize_t(sp[0], tag);
+		return TypeInfo::get(tag, sp[1]);
+	}
+
+	static std::string type_to_str(TypeInfo* ti)
+	{
+		return TypeInfo::serialize_t(ti->tag) + '@' + ti->name;
+	}
+
+	static void init_cell(const Sheet::Column& column, void* p)
+	{
+		column.type->create(p);
+		if (!column.default_value.empty())
+			column.type->unserialize(column.default_value, p);
+	}
+
+	// moves the first count cells of a column into a new buffer that holds capacity cells
+	static void reallocate_column(Sheet::Column& column, uint count, uint capacity)
+	{
+		auto type = column.type;
+		std::vector<char> new_data(capacity * type->size);
+		if (type->pod)
+		{
+			if (count > 0)
+				memcpy(new_data.data(), column.data.data(), count * type->size);
+		}
+		else
+		{
+			for (auto i = 0; i < count; i++)
+			{
+				auto dst = new_data.data() + i * type->size;
+				auto src = column.data.data() + i * type->size;
+				type->create(dst);
+				type->copy(dst, src);
+				type->destroy(src, false);
+			}
+		}
+		column.data = std::move(new_data);
+	}
+
+	static void destroy_cells(Sheet::Column& column, uint count)
+	{
+		if (column.type->pod)
+			return;
+		for (auto i = 0; i < count; i++)
+			column.type->destroy(column.data.data() + i * column.type->size, false);
+	}
+
+	SheetPrivate::~SheetPrivate()
+	{
+		for (auto& c : columns)
+			destroy_cells(c, rows_count);
+	}
+
 	void SheetPrivate::clear_rows() 
 	{
-		for (auto& r : rows)
+		for (auto& c : columns)
 		{
-			for (auto i = 0; i < columns.size(); i++)
-				columns[i].type->destroy(r.datas[i]);
+			destroy_cells(c, rows_count);
+			c.index_dirty = true;
 		}
-		rows.clear();
+		rows_count = 0;
 	}
 
 	void SheetPrivate::insert_column(const std::string& name, TypeInfo* type, int idx, const std::string& default_value)
@@ -33,16 +165,13 @@ namespace flame
 		column.name_hash = sh(name.c_str());
 		column.type = type;
 		column.default_value = default_value;
-		columns.insert(columns.begin() + idx, column);
-		columns_map[column.name_hash] = idx;
-
-		for (auto& r : rows)
-		{
-			auto data = type->create();
-			r.datas.insert(r.datas.begin() + idx, data);
-			if (!default_value.empty())
-				type->unserialize(default_value, r.datas[idx]);
-		}
+		column.data.resize(rows_capacity * type->size);
+		for (auto i = 0; i < rows_count; i++)
+			init_cell(column, column.data.data() + i * type->size);
+		columns.insert(columns.begin() + idx, std::move(column));
+		columns_map.clear();
+		for (auto i = 0; i < columns.size(); i++)
+			columns_map[columns[i].name_hash] = i;
 	}
 
 	void SheetPrivate::alter_column(uint idx, const std::string& new_name, TypeInfo* new_type, const std::string& default_value)
@@ -65,15 +194,14 @@ namespace flame
 		}
 		if (column.type != new_type)
 		{
-			for (auto& r : rows)
-			{
-				column.type->destroy(r.datas[idx]);
-				r.datas[idx] = new_type->create();
-				if (!default_value.empty())
-					new_type->unserialize(default_value, r.datas[idx]);
-			}
+			destroy_cells(column, rows_count);
 			column.type = new_type;
 			column.default_value = default_value;
+			column.data.clear();
+			column.data.resize(rows_capacity * new_type->size);
+			for (auto i = 0; i < rows_count; i++)
+				init_cell(column, column.data.data() + i * new_type->size);
+			column.index_dirty = true;
 		}
 	}
 
@@ -91,14 +219,6 @@ namespace flame
 			columns_map.clear();
 			for (auto i = 0; i < columns.size(); i++)
 				columns_map[columns[i].name_hash] = i;
-
-			for (auto& r : rows)
-			{
-				if (target_column_index < new_index)
-					std::rotate(r.datas.begin() + target_column_index, r.datas.begin() + target_column_index + 1, r.datas.begin() + new_index + 1);
-				else
-					std::rotate(r.datas.begin() + new_index, r.datas.begin() + target_column_index, r.datas.begin() + target_column_index + 1);
-			}
 		}
 	}
 
@@ -106,52 +226,297 @@ namespace flame
 	{
 		assert(idx < columns.size());
 
-		auto type = columns[idx].type;
+		destroy_cells(columns[idx], rows_count);
 		columns.erase(columns.begin() + idx);
 		columns_map.clear();
 		for (auto i = 0; i < columns.size(); i++)
 			columns_map[columns[i].name_hash] = i;
-		for (auto& r : rows)
-		{
-			type->destroy(r.datas[idx]);
-			r.datas.erase(r.datas.begin() + idx);
-		}
+	}
+
+	void SheetPrivate::set_column_index(uint idx, SheetIndexType type)
+	{
+		assert(idx < columns.size());
+
+		auto& column = columns[idx];
+		if (column.index_type == type)
+			return;
+		column.index_type = type;
+		column.index_dirty = true;
+		column.hash_heads.clear();
+		column.hash_nexts.clear();
+		column.sorted_rows.clear();
+	}
+
+	void SheetPrivate::reserve_rows(uint n)
+	{
+		if (n <= rows_capacity)
+			return;
+		for (auto& c : columns)
+			reallocate_column(c, rows_count, n);
+		rows_capacity = n;
 	}
 
 	void SheetPrivate::insert_row(int idx)
 	{
 		if (idx < 0)
-			idx = rows.size() + (idx + 1);
-		Row row;
-		row.datas.resize(columns.size());
-		for (auto i = 0; i < columns.size(); i++)
+			idx = rows_count + (idx + 1);
+		assert(idx <= rows_count);
+		if (rows_count == rows_capacity)
+			reserve_rows(max(rows_capacity * 2, 16U));
+
+		for (auto& c : columns)
 		{
-			auto& column = columns[i];
-			row.datas[i] = column.type->create();
-			if (!column.default_value.empty())
-				column.type->unserialize(column.default_value, row.datas[i]);
+			auto type = c.type;
+			auto size = type->size;
+			auto p = c.data.data() + idx * size;
+			if (type->pod)
+				memmove(p + size, p, (rows_count - idx) * size);
+			else
+			{
+				type->create(c.data.data() + rows_count * size);
+				for (auto i = rows_count; i > idx; i--)
+					type->copy(c.data.data() + i * size, c.data.data() + (i - 1) * size);
+				type->destroy(p, false);
+			}
+			init_cell(c, p);
+			c.index_dirty = true;
 		}
-		rows.insert(rows.begin() + idx, row);
+		rows_count++;
 	}
 
 	void SheetPrivate::remove_row(uint idx)
 	{
-		assert(idx < rows.size());
+		assert(idx < rows_count);
 
-		auto& row = rows[idx];
-		for (auto i = 0; i < columns.size(); i++)
-			columns[i].type->destroy(row.datas[i]);
+		for (auto& c : columns)
+		{
+			auto type = c.type;
+			auto size = type->size;
+			if (type->pod)
+				memmove(c.data.data() + idx * size, c.data.data() + (idx + 1) * size, (rows_count - idx - 1) * size);
+			else
+			{
+				for (auto i = idx; i + 1 < rows_count; i++)
+					type->copy(c.data.data() + i * size, c.data.data() + (i + 1) * size);
+				type->destroy(c.data.data() + (rows_count - 1) * size, false);
+			}
+			c.index_dirty = true;
+		}
+		rows_count--;
+	}
+
+	void SheetPrivate::swap_rows(uint idx0, uint idx1)
+	{
+		assert(idx0 < rows_count && idx1 < rows_count);
+		if (idx0 == idx1)
+			return;
 
-		rows.erase(rows.begin() + idx);
+		for (auto& c : columns)
+		{
+			auto type = c.type;
+			auto p0 = c.data.data() + idx0 * type->size;
+			auto p1 = c.data.data() + idx1 * type->size;
+			if (type->pod)
+				std::swap_ranges(p0, p0 + type->size, p1);
+			else
+			{
+				auto temp = type->create();
+				type->copy(temp, p0);
+				type->copy(p0, p1);
+				type->copy(p1, temp);
+				type->destroy(temp);
+			}
+			c.index_dirty = true;
+		}
 	}
 
-	void SheetPrivate::save(const std::filesystem::path& path)
+	void SheetPrivate::update_index(uint column)
 	{
-		pugi::xml_document doc;
+		auto& c = columns[column];
+		if (!c.index_dirty)
+			return;
+		c.index_dirty = false;
+		c.hash_heads.clear();
+		c.hash_nexts.clear();
+		c.sorted_rows.clear();
 
-		auto write_ti = [&](TypeInfo* ti, pugi::xml_attribute a) {
-			a.set_value((TypeInfo::serialize_t(ti->tag) + '@' + ti->name).c_str());
-		};
+		auto type = c.type;
+		switch (c.index_type)
+		{
+		case SheetIndexHash:
+			c.hash_heads.reserve(rows_count);
+			c.hash_nexts.assign(rows_count, -1);
+			// walk backwards so every chain is in row order
+			for (int i = (int)rows_count - 1; i >= 0; i--)
+			{
+				auto [it, inserted] = c.hash_heads.emplace(hash_value(type, get_data(i, column)), i);
+				if (!inserted)
+				{
+					c.hash_nexts[i] = it->second;
+					it->second = i;
+				}
+			}
+			break;
+		case SheetIndexSorted:
+			c.sorted_rows.resize(rows_count);
+			for (auto i = 0; i < rows_count; i++)
+				c.sorted_rows[i] = i;
+			std::stable_sort(c.sorted_rows.begin(), c.sorted_rows.end(), [&](uint a, uint b) {
+				return compare_values(type, get_data(a, column), get_data(b, column)) < 0;
+			});
+			break;
+		}
+	}
+
+	int SheetPrivate::find_row(uint column, const void* value)
+	{
+		if (column >= columns.size())
+			return -1;
+
+		auto& c = columns[column];
+		auto type = c.type;
+		update_index(column);
+		switch (c.index_type)
+		{
+		case SheetIndexHash:
+			if (auto it = c.hash_heads.find(hash_value(type, value)); it != c.hash_heads.end())
+			{
+				for (int i = it->second; i != -1; i = c.hash_nexts[i])
+				{
+					if (compare_values(type, get_data(i, column), value) == 0)
+						return i;
+				}
+			}
+			return -1;
+		case SheetIndexSorted:
+		{
+			auto it = std::lower_bound(c.sorted_rows.begin(), c.sorted_rows.end(), value, [&](uint r, const void* v) {
+				return compare_values(type, get_data(r, column), v) < 0;
+			});
+			if (it != c.sorted_rows.end() && compare_values(type, get_data(*it, column), value) == 0)
+				return *it;
+			return -1;
+		}
+		}
+		for (auto i = 0; i < rows_count; i++)
+		{
+			if (compare_values(type, get_data(i, column), value) == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	uint SheetPrivate::find_range(uint column, const void* min, const void* max, uint& first)
+	{
+		first = 0;
+		if (column >= columns.size())
+			return 0;
+
+		auto& c = columns[column];
+		if (c.index_type != SheetIndexSorted)
+		{
+			printf("sheet find range: column %s has no sorted index\n", c.name.c_str());
+			return 0;
+		}
+		auto type = c.type;
+		update_index(column);
+		auto beg = std::lower_bound(c.sorted_rows.begin(), c.sorted_rows.end(), min, [&](uint r, const void* v) {
+			return compare_values(type, get_data(r, column), v) < 0;
+		});
+		auto end = std::upper_bound(beg, c.sorted_rows.end(), max, [&](const void* v, uint r) {
+			return compare_values(type, v, get_data(r, column)) < 0;
+		});
+		first = beg - c.sorted_rows.begin();
+		return end - beg;
+	}
+
+	int SheetPrivate::get_sorted_row(uint column, uint position)
+	{
+		if (column >= columns.size() || columns[column].index_type != SheetIndexSorted)
+			return -1;
+		update_index(column);
+		auto& sorted_rows = columns[column].sorted_rows;
+		return position < sorted_rows.size() ? sorted_rows[position] : -1;
+	}
+
+	void SheetPrivate::save(const std::filesystem::path& path, bool binary)
+	{
+		if (!path.empty())
+			filename = path;
+
+		if (binary)
+		{
+			std::string data;
+			auto append = [&](const void* src, uint64 size) {
+				data.resize((data.size() + 15) & ~15ULL);
+				auto off = data.size();
+				data.append((const char*)src, size);
+				return off;
+			};
+			std::string names;
+			auto add_name = [&](const std::string& str, uint& offset, uint& length) {
+				offset = names.size();
+				length = str.size();
+				names += str;
+			};
+
+			SheetBinaryHeader header;
+			memset(&header, 0, sizeof(header));
+			memcpy(header.magic, "fsheetb", 7);
+			header.version = 1;
+			header.columns_count = columns.size();
+			header.rows_count = rows_count;
+			data.resize(sizeof(SheetBinaryHeader));
+			add_name(name, header.name_offset, header.name_length);
+
+			std::vector<SheetBinaryColumn> column_headers(columns.size());
+			header.columns_offset = append(column_headers.data(), sizeof(SheetBinaryColumn) * column_headers.size());
+			for (auto i = 0; i < columns.size(); i++)
+			{
+				auto& c = columns[i];
+				auto& ch = column_headers[i];
+				memset(&ch, 0, sizeof(ch));
+				add_name(c.name, ch.name_offset, ch.name_length);
+				add_name(type_to_str(c.type), ch.type_offset, ch.type_length);
+				add_name(c.default_value, ch.default_value_offset, ch.default_value_length);
+				ch.width = c.width;
+				ch.index_type = c.index_type;
+				if (c.type->pod)
+				{
+					ch.data_size = (uint64)c.type->size * rows_count;
+					ch.data_offset = append(c.data.data(), ch.data_size);
+				}
+				else
+				{
+					std::string cells;
+					for (auto j = 0; j < rows_count; j++)
+					{
+						auto str = c.type->serialize(get_data(j, i));
+						uint len = str.size();
+						cells.append((char*)&len, sizeof(uint));
+						cells += str;
+					}
+					ch.data_size = cells.size();
+					ch.data_offset = append(cells.data(), cells.size());
+				}
+				if (c.index_type == SheetIndexSorted)
+				{
+					update_index(i);
+					ch.sorted_rows_offset = append(c.sorted_rows.data(), sizeof(uint) * c.sorted_rows.size());
+				}
+			}
+			header.names_size = names.size();
+			header.names_offset = append(names.data(), names.size());
+
+			memcpy(data.data(), &header, sizeof(header));
+			memcpy(data.data() + header.columns_offset, column_headers.data(), sizeof(SheetBinaryColumn) * column_headers.size());
+			std::ofstream dst(filename, std::ios::binary);
+			dst.write(data.data(), data.size());
+			dst.close();
+			return;
+		}
+
+		pugi::xml_document doc;
 
 		auto doc_root = doc.append_child("sheet");
 		doc_root.append_attribute("name").set_value(name.c_str());
@@ -159,25 +524,113 @@ namespace flame
 		for (auto& c : columns)
 		{
 			auto n_column = n_columns.append_child("column");
-			write_ti(c.type, n_column.append_attribute("type"));
+			n_column.append_attribute("type").set_value(type_to_str(c.type).c_str());
 			n_column.append_attribute("name").set_value(c.name.c_str());
 			if (!c.default_value.empty())
 				n_column.append_attribute("default_value").set_value(c.default_value.c_str());
 			n_column.append_attribute("width").set_value(c.width);
+			if (c.index_type != SheetIndexNone)
+				n_column.append_attribute("index").set_value(c.index_type == SheetIndexHash ? "hash" : "sorted");
 		}
 		auto n_rows = doc_root.append_child("rows");
-		for (auto& r : rows)
+		for (auto i = 0; i < rows_count; i++)
 		{
 			auto n_row = n_rows.append_child("row");
-			for (auto i = 0; i < columns.size(); i++)
-				n_row.append_attribute(columns[i].name.c_str()).set_value(columns[i].type->serialize(r.datas[i]).c_str());
+			for (auto j = 0; j < columns.size(); j++)
+				n_row.append_attribute(columns[j].name.c_str()).set_value(columns[j].type->serialize(get_data(i, j)).c_str());
 		}
 
-		if (!path.empty())
-			filename = path;
 		doc.save_file(filename.c_str());
 	}
 
+	bool SheetPrivate::load_binary(std::string_view data)
+	{
+		auto in_range = [&](uint64 offset, uint64 size) {
+			return offset + size <= data.size();
+		};
+		if (data.size() < sizeof(SheetBinaryHeader))
+			return false;
+		auto& header = *(SheetBinaryHeader*)data.data();
+		if (header.version != 1 ||
+			!in_range(header.columns_offset, sizeof(SheetBinaryColumn) * (uint64)header.columns_count) ||
+			!in_range(header.names_offset, header.names_size))
+			return false;
+
+		auto names = data.data() + header.names_offset;
+		auto get_name = [&](uint offset, uint length) {
+			if ((uint64)offset + length > header.names_size)
+				return std::string();
+			return std::string(names + offset, length);
+		};
+		name = get_name(header.name_offset, header.name_length);
+		name_hash = sh(name.c_str());
+		auto column_headers = (SheetBinaryColumn*)(data.data() + header.columns_offset);
+		for (auto i = 0; i < header.columns_count; i++)
+		{
+			auto& ch = column_headers[i];
+			auto type = type_from_str(get_name(ch.type_offset, ch.type_length));
+			if (!type || !in_range(ch.data_offset, ch.data_size) || 
+				(type->pod && ch.data_size != (uint64)type->size * header.rows_count) ||
+				(ch.sorted_rows_offset && !in_range(ch.sorted_rows_offset, sizeof(uint) * (uint64)header.rows_count)))
+				return false;
+			insert_column(get_name(ch.name_offset, ch.name_length), type, -1, get_name(ch.default_value_offset, ch.default_value_length));
+			if (columns.size() != i + 1)
+				return false;
+			auto& c = columns.back();
+			c.width = ch.width;
+			c.index_type = (SheetIndexType)ch.index_type;
+		}
+
+		reserve_rows(header.rows_count);
+		for (auto i = 0; i < columns.size(); i++)
+		{
+			auto& c = columns[i];
+			auto& ch = column_headers[i];
+			if (c.type->pod)
+				memcpy(c.data.data(), data.data() + ch.data_offset, ch.data_size);
+			else
+			{
+				for (auto j = 0; j < header.rows_count; j++)
+					c.type->create(c.data.data() + j * c.type->size);
+			}
+		}
+		rows_count = header.rows_count;
+		for (auto i = 0; i < columns.size(); i++)
+		{
+			auto& c = columns[i];
+			auto& ch = column_headers[i];
+			if (!c.type->pod)
+			{
+				auto p = data.data() + ch.data_offset;
+				auto end = p + ch.data_size;
+				for (auto j = 0; j < rows_count; j++)
+				{
+					uint len;
+					if (end - p < (int64)sizeof(uint))
+						return false;
+					memcpy(&len, p, sizeof(uint));
+					p += sizeof(uint);
+					if (end - p < (int64)len)
+						return false;
+					c.type->unserialize(std::string(p, len), get_data(j, i));
+					p += len;
+				}
+			}
+			if (c.index_type == SheetIndexSorted && ch.sorted_rows_offset)
+			{
+				auto sorted_rows = (uint*)(data.data() + ch.sorted_rows_offset);
+				c.sorted_rows.assign(sorted_rows, sorted_rows + rows_count);
+				c.index_dirty = false;
+				for (auto r : c.sorted_rows)
+				{
+					if (r >= rows_count)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
 	struct SheetCreate : Sheet::Create
 	{
 		SheetPtr operator()() override
@@ -204,51 +657,75 @@ namespace flame
 				}
 			}
 
-			if (!std::filesystem::exists(filename))
+			if (!vfs_exists(filename))
 			{
 				wprintf(L"cannot found sheet: %s\n", _filename.c_str());
 				return nullptr;
 			}
 
-			auto ret = new SheetPrivate;
-
-			pugi::xml_document doc;
-			pugi::xml_node doc_root;
-
-			if (!doc.load_file(filename.c_str()) || (doc_root = doc.first_child()).name() != std::string("sheet"))
+			std::unique_ptr<MappedFile> mapped(vfs_map(filename));
+			if (!mapped)
 			{
 				wprintf(L"sheet does not exist or wrong format: %s\n", _filename.c_str());
 				return nullptr;
 			}
+			auto content = mapped->data;
 
-			auto read_ti = [&](pugi::xml_attribute a) {
-				auto sp = SUS::to_string_vector(SUS::split(a.value(), '@'));
-				TypeTag tag;
-				TypeInfo::unserialize_t(sp[0], tag);
-				return TypeInfo::get(tag, sp[1]);
-			};
-
-			if (auto a = doc_root.attribute("name"); a)
-			{
-				ret->name = a.value();
-				ret->name_hash = sh(ret->name.c_str());
-			}
+			auto ret = new SheetPrivate;
 
-			for (auto n_column : doc_root.child("columns"))
+			if (content.size() >= 7 && strncmp(content.data(), "fsheetb", 7) == 0)
 			{
-				ret->insert_column(n_column.attribute("name").value(),
-					read_ti(n_column.attribute("type")), -1, n_column.attribute("default_value").value());
-				if (auto a = n_column.attribute("width"); a)
-					ret->columns.back().width = a.as_float();
+				if (!ret->load_binary(content))
+				{
+					wprintf(L"sheet format is incorrect: %s\n", _filename.c_str());
+					delete ret;
+					return nullptr;
+				}
 			}
-			for (auto n_row : doc_root.child("rows"))
+			else
 			{
-				ret->insert_row();
-				auto& row = ret->rows.back();
-				for (auto i = 0; i < ret->columns.size(); i++)
+				pugi::xml_document doc;
+				pugi::xml_node doc_root;
+
+				if (!doc.load_buffer(content.data(), content.size()) || (doc_root = doc.first_child()).name() != std::string("sheet"))
+				{
+					wprintf(L"sheet does not exist or wrong format: %s\n", _filename.c_str());
+					delete ret;
+					return nullptr;
+				}
+
+				if (auto a = doc_root.attribute("name"); a)
+				{
+					ret->name = a.value();
+					ret->name_hash = sh(ret->name.c_str());
+				}
+
+				for (auto n_column : doc_root.child("columns"))
+				{
+					auto type = type_from_str(n_column.attribute("type").value());
+					if (!type)
+					{
+						printf("sheet: unknown type %s of column %s\n", n_column.attribute("type").value(), n_column.attribute("name").value());
+						continue;
+					}
+					ret->insert_column(n_column.attribute("name").value(), type, -1, n_column.attribute("default_value").value());
+					if (auto a = n_column.attribute("width"); a)
+						ret->columns.back().width = a.as_float();
+					if (auto a = n_column.attribute("index"); a)
+						ret->columns.back().index_type = a.value() == std::string("hash") ? SheetIndexHash : SheetIndexSorted;
+				}
+				auto n_rows = doc_root.child("rows");
+				ret->reserve_rows(std::distance(n_rows.begin(), n_rows.end()));
+				for (auto n_row : n_rows)
 				{
-					auto& column = ret->columns[i];
-					column.type->unserialize(n_row.attribute(column.name.c_str()).value(), row.datas[i]);
+					ret->insert_row();
+					auto row = ret->rows_count - 1;
+					for (auto i = 0; i < ret->columns.size(); i++)
+					{
+						auto& column = ret->columns[i];
+						if (auto a = n_row.attribute(column.name.c_str()); a)
+							column.type->unserialize(a.value(), ret->get_data(row, i));
+					}
 				}
 			}
 
@@ -4,6 +4,13 @@
 
 namespace flame
 {
+	enum SheetIndexType
+	{
+		SheetIndexNone,
+		SheetIndexHash, // O(1) point lookups
+		SheetIndexSorted // O(log n) point and range lookups
+	};
+
 	// Reflect
 	struct Sheet
 	{
@@ -14,15 +21,29 @@ namespace flame
 			TypeInfo* type;
 			std::string default_value;
 			float width = 200.f;
-		};
+			SheetIndexType index_type = SheetIndexNone;
 
-		struct Row
-		{
-			std::vector<void*> datas;
+			// the cells of all rows, one after another, rows_capacity * type->size bytes, the first rows_count are constructed
+			std::vector<char> data;
+
+			// indices are rebuilt on the next query after the column changed
+			bool index_dirty = true;
+			std::unordered_map<uint64, uint> hash_heads; // hash of a value -> first row that has it
+			std::vector<int> hash_nexts; // next row that has the same hash, -1 ends the chain
+			std::vector<uint> sorted_rows; // rows in ascending order of their values
+
+			// the cells are objects living in data, a copy of the bytes would share (or dangle) their buffers, so columns only move
+			//  the move is noexcept so growing the columns moves them too
+			Column() = default;
+			Column(const Column&) = delete;
+			Column& operator=(const Column&) = delete;
+			Column(Column&&) noexcept = default;
+			Column& operator=(Column&&) noexcept = default;
 		};
 
 		std::vector<Column>				columns;
-		std::vector<Row>				rows;
+		uint							rows_count = 0;
+		uint							rows_capacity = 0;
 		std::unordered_map<uint, uint>	columns_map;
 
 		std::filesystem::path			filename;
@@ -31,6 +52,8 @@ namespace flame
 		bool							is_static = false;
 		uint							ref = 0;
 
+		virtual ~Sheet() {}
+
 		inline int find_column(uint name) const
 		{
 			auto it = columns_map.find(name);
@@ -39,15 +62,47 @@ namespace flame
 			return it->second;
 		}
 
+		inline void* get_data(uint row, uint column) const
+		{
+			auto& c = columns[column];
+			return (void*)(c.data.data() + row * c.type->size);
+		}
+
+		// call this after writing to the cells of a column through get_data
+		inline void mark_column_changed(uint column)
+		{
+			columns[column].index_dirty = true;
+		}
+
+		inline void set_data(uint row, uint column, const void* src)
+		{
+			columns[column].type->copy(get_data(row, column), src);
+			columns[column].index_dirty = true;
+		}
+
 		virtual void clear_rows() = 0;
 		virtual void insert_column(const std::string& name, TypeInfo* type, int idx = -1, const std::string& default_value = "") = 0;
 		virtual void alter_column(uint idx, const std::string& new_name, TypeInfo* new_type, const std::string& new_default_value = "") = 0;
 		virtual void reorder_columns(uint target_column_index, int new_index) = 0;
 		virtual void remove_column(uint idx) = 0;
+		virtual void set_column_index(uint idx, SheetIndexType type) = 0;
 		virtual void insert_row(int idx = -1) = 0;
 		virtual void remove_row(uint idx) = 0;
+		virtual void swap_rows(uint idx0, uint idx1) = 0;
+		// make room for n rows, so inserting up to n rows at the end does not move the cells
+		virtual void reserve_rows(uint n) = 0;
+
+		// the first row whose value in the column equals value (which is of the column's type), -1 if none
+		//  O(1) with a hash index, O(log n) with a sorted index, otherwise it scans the column
+		virtual int find_row(uint column, const void* value) = 0;
+		// rows with min <= value <= max, they are the sorted rows of the column from 'first', returns the count
+		//  the column needs a sorted index
+		virtual uint find_range(uint column, const void* min, const void* max, uint& first) = 0;
+		// the row at a position of the column's sorted order, -1 if out of range or the column has no sorted index
+		virtual int get_sorted_row(uint column, uint position) = 0;
 
-		virtual void save(const std::filesystem::path& path = L"") = 0;
+		// binary sheets store the cells column by column and are loaded without parsing
+		virtual void save(const std::filesystem::path& path = L"", bool binary = false) = 0;
 
 		struct Create
 		{
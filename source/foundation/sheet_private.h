@@ -2,16 +2,57 @@
 
 namespace flame
 {
+	// the binary sheet format ("fsheetb"), all offsets are from the start of the file and aligned to 16
+	//  cells of pod columns are stored as they are in memory, other cells are stored as a uint length and their serialized string
+	struct SheetBinaryHeader
+	{
+		char magic[8];
+		uint version;
+		uint columns_count;
+		uint rows_count;
+		uint names_size;
+		uint name_offset; // of the sheet
+		uint name_length;
+		uint64 columns_offset; // SheetBinaryColumn x columns_count
+		uint64 names_offset;
+	};
+
+	struct SheetBinaryColumn
+	{
+		uint name_offset;
+		uint name_length;
+		uint type_offset; // "tag@name" as in the xml format
+		uint type_length;
+		uint default_value_offset;
+		uint default_value_length;
+		float width;
+		uint index_type;
+		uint64 data_offset;
+		uint64 data_size;
+		uint64 sorted_rows_offset; // uint x rows_count for sorted indices, so they are not sorted again, 0 if not stored
+	};
+
 	struct SheetPrivate : Sheet
 	{
+		~SheetPrivate();
+
 		void clear_rows() override;
 		void insert_column(const std::string& name, TypeInfo* type, int idx = -1, const std::string& default_value = "") override;
 		void alter_column(uint idx, const std::string& new_name, TypeInfo* new_type, const std::string& default_value) override;
 		void reorder_columns(uint target_column_index, int new_index) override;
 		void remove_column(uint idx) override;
+		void set_column_index(uint idx, SheetIndexType type) override;
 		void insert_row(int idx = -1) override;
 		void remove_row(uint idx) override;
+		void swap_rows(uint idx0, uint idx1) override;
+		void reserve_rows(uint n) override;
+
+		void update_index(uint column);
+		int find_row(uint column, const void* value) override;
+		uint find_range(uint column, const void* min, const void* max, uint& first) override;
+		int get_sorted_row(uint column, uint position) override;
 
-		void save(const std::filesystem::path& path) override;
+		void save(const std::filesystem::path& path, bool binary) override;
+		bool load_binary(std::string_view data);
 	};
 }
@@ -264,24 +264,65 @@ namespace flame
 					auto levels = *(uint*)inputs[1].data;
 					auto& out_control_mesh = *(ControlMesh*)outputs[0].data;
 					if (pcontrol_mesh)
+						pcontrol_mesh->subdivide(out_control_mesh, levels);
+				}
+			);
+
+			library->add_template("Loop Subdivide Control Mesh", "", BlueprintNodeFlagNone,
+				{
 					{
-						if (levels == 0)
-						{
-							out_control_mesh.vertices = pcontrol_mesh->vertices;
-							out_control_mesh.faces = pcontrol_mesh->faces;
-						}
-						else
-						{
-							auto& current_level = *pcontrol_mesh;
-							ControlMesh next_level;
-							for (auto i = 0; i < levels; i++)
-							{
-								current_level.subdivide_CatmullClark(next_level);
-								current_level = next_level;
-							}
-							out_control_mesh = std::move(current_level);
-							out_control_mesh.color = pcontrol_mesh->color;
-						}
+						.name = "Mesh",
+						.allowed_types = { TypeInfo::get<ControlMesh*>() }
+					},
+					{
+						.name = "Levels",
+						.allowed_types = { TypeInfo::get<uint>() },
+						.default_value = "1"
+					}
+				},
+				{
+					{
+						.name = "Mesh",
+						.allowed_types = { TypeInfo::get<ControlMesh>() }
+					}
+				},
+				[](uint inputs_count, BlueprintAttribute* inputs, uint outputs_count, BlueprintAttribute* outputs) {
+					auto pcontrol_mesh = *(ControlMesh**)inputs[0].data;
+					auto levels = *(uint*)inputs[1].data;
+					auto& out_control_mesh = *(ControlMesh*)outputs[0].data;
+					if (pcontrol_mesh)
+						pcontrol_mesh->subdivide(out_control_mesh, levels, true);
+				}
+			);
+
+			library->add_template("Decimate Control Mesh", "", BlueprintNodeFlagNone,
+				{
+					{
+						.name = "Mesh",
+						.allowed_types = { TypeInfo::get<ControlMesh*>() }
+					},
+					{
+						.name = "Ratio",
+						.allowed_types = { TypeInfo::get<float>() },
+						.default_value = "0.5"
+					}
+				},
+				{
+					{
+						.name = "Mesh",
+						.allowed_types = { TypeInfo::get<ControlMesh>() }
+					}
+				},
+				[](uint inputs_count, BlueprintAttribute* inputs, uint outputs_count, BlueprintAttribute* outputs) {
+					auto pcontrol_mesh = *(ControlMesh**)inputs[0].data;
+					auto ratio = *(float*)inputs[1].data;
+					auto& out_control_mesh = *(ControlMesh*)outputs[0].data;
+					if (pcontrol_mesh)
+					{
+						out_control_mesh.vertices = pcontrol_mesh->vertices;
+						out_control_mesh.faces = pcontrol_mesh->faces;
+						out_control_mesh.decimate(ratio);
+						out_control_mesh.color = pcontrol_mesh->color;
 					}
 				}
 			);
@@ -119,6 +119,14 @@ namespace flame
 			}
 		}Buffer_create;
 		Buffer::Create& Buffer::create = Buffer_create;
+
+		std::vector<std::unique_ptr<BufferPrivate>> buffers_to_release;
+
+		void Buffer::release_after_frame(BufferPtr buf)
+		{
+			if (buf)
+				buffers_to_release.emplace_back(buf);
+		}
 	}
 }
 
@@ -28,6 +28,9 @@ namespace flame
 				virtual BufferPtr operator()(uint size, BufferUsageFlags usage, MemoryPropertyFlags mem_prop) = 0;
 			};
 			FLAME_GRAPHICS_API static Create& create;
+
+			// for a buffer that the frame being recorded may use, it is destroyed after the frame is done on the gpu
+			FLAME_GRAPHICS_API static void release_after_frame(BufferPtr buf);
 		};
 	}
 }
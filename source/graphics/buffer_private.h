@@ -26,6 +26,7 @@ namespace flame
 		};
 
 		extern std::vector<BufferPtr> buffers;
+		extern std::vector<std::unique_ptr<BufferPrivate>> buffers_to_release; // the windows take them when they submit
 	}
 }
 
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "../foundation/typeinfo.h"
+#include "../foundation/frame_arena.h"
 #include "command.h"
 #include "buffer.h"
 #include "shader.h"
 
+#include <bit>
+
 namespace flame
 {
 	namespace graphics
@@ -70,69 +73,349 @@ namespace flame
 			}
 		};
 
+		// a two-level segregated fit (TLSF) allocator of ranges in [0, capacity), allocation and release are O(1)
+		//  free ranges are kept in lists by size classes, the first level is the power of two of the size and the second level
+		//  splits it into 16 steps, the bitmaps of non-empty lists find a suitable list in a few bit scans
+		//  allocated ranges can be slid towards the start by defragment, the moves are reported to the owner
 		struct SparseRanges
 		{
-			uint capacity;
-			std::vector<std::pair<uint, uint>> free_spaces;
+			static const uint SLLog2 = 4;
+			static const uint SLCount = 1 << SLLog2;
+			static const uint FLCount = 32 - SLLog2 + 1;
+
+			struct Block
+			{
+				uint offset;
+				uint size;
+				int prev_phys = -1;
+				int next_phys = -1;
+				int prev_free = -1;
+				int next_free = -1;
+				bool free = true;
+			};
+
+			struct Move
+			{
+				uint src;
+				uint dst;
+				uint size;
+			};
+
+			uint capacity = 0;
+			uint used = 0;
+			uint fl_bitmap = 0;
+			uint sl_bitmaps[FLCount];
+			int heads[FLCount][SLCount];
+			std::vector<Block> blocks;
+			std::vector<int> unused_blocks; // indices of blocks that can be reused
+			std::unordered_map<uint, int> allocated; // offset -> block
+			int first_block = -1;
+			int last_block = -1;
 
 			void init(uint _capacity)
 			{
 				capacity = _capacity;
-				free_spaces.clear();
-				free_spaces.emplace_back(0, capacity);
+				used = 0;
+				fl_bitmap = 0;
+				memset(sl_bitmaps, 0, sizeof(sl_bitmaps));
+				for (auto& l : heads)
+				{
+					for (auto& h : l)
+						h = -1;
+				}
+				blocks.clear();
+				unused_blocks.clear();
+				allocated.clear();
+				first_block = last_block = -1;
+				if (capacity > 0)
+				{
+					first_block = last_block = new_block(0, capacity);
+					insert_free(first_block);
+				}
 			}
 
-			inline int get_free_space(uint size)
+			static inline void mapping(uint size, uint& fl, uint& sl)
 			{
-				for (uint i = 0; i < free_spaces.size(); ++i)
+				if (size < SLCount)
 				{
-					auto& fs = free_spaces[i];
-					if (fs.second >= size)
-					{
-						auto ret = fs.first;
-						fs.first += size;
-						fs.second -= size;
-						if (fs.second == 0)
-							free_spaces.erase(free_spaces.begin() + i);
-						return ret;
-					}
+					fl = 0;
+					sl = size;
+				}
+				else
+				{
+					auto m = std::bit_width(size) - 1;
+					fl = m - SLLog2 + 1;
+					sl = (size >> (m - SLLog2)) - SLCount;
 				}
-				return -1;
 			}
 
-			inline void releases_space(uint off, uint size)
+			inline int new_block(uint offset, uint size)
+			{
+				int id;
+				if (!unused_blocks.empty())
+				{
+					id = unused_blocks.back();
+					unused_blocks.pop_back();
+					blocks[id] = Block();
+				}
+				else
+				{
+					id = blocks.size();
+					blocks.emplace_back();
+				}
+				auto& b = blocks[id];
+				b.offset = offset;
+				b.size = size;
+				return id;
+			}
+
+			inline void insert_free(int id)
 			{
-				for (uint i = 0; i < free_spaces.size(); ++i)
+				auto& b = blocks[id];
+				uint fl, sl;
+				mapping(b.size, fl, sl);
+				b.free = true;
+				b.prev_free = -1;
+				b.next_free = heads[fl][sl];
+				if (b.next_free != -1)
+					blocks[b.next_free].prev_free = id;
+				heads[fl][sl] = id;
+				fl_bitmap |= 1U << fl;
+				sl_bitmaps[fl] |= 1U << sl;
+			}
+
+			inline void remove_free(int id)
+			{
+				auto& b = blocks[id];
+				uint fl, sl;
+				mapping(b.size, fl, sl);
+				if (b.prev_free != -1)
+					blocks[b.prev_free].next_free = b.next_free;
+				else
 				{
-					auto& fs = free_spaces[i];
-					if (fs.first + fs.second == off)
+					heads[fl][sl] = b.next_free;
+					if (b.next_free == -1)
 					{
-						fs.second += size;
-						if (i + 1 < free_spaces.size() && fs.first + fs.second == free_spaces[i + 1].first)
-						{
-							fs.second += free_spaces[i + 1].second;
-							free_spaces.erase(free_spaces.begin() + i + 1);
-						}
-						return;
+						sl_bitmaps[fl] &= ~(1U << sl);
+						if (!sl_bitmaps[fl])
+							fl_bitmap &= ~(1U << fl);
 					}
-					if (off + size == fs.first)
+				}
+				if (b.next_free != -1)
+					blocks[b.next_free].prev_free = b.prev_free;
+				b.free = false;
+			}
+
+			// merge b into a, a is right before b
+			inline void merge_phys(int a, int b)
+			{
+				auto& ba = blocks[a];
+				auto& bb = blocks[b];
+				ba.size += bb.size;
+				ba.next_phys = bb.next_phys;
+				if (bb.next_phys != -1)
+					blocks[bb.next_phys].prev_phys = a;
+				else
+					last_block = a;
+				unused_blocks.push_back(b);
+			}
+
+			inline int find_free(uint size)
+			{
+				// round up to the next list, then all blocks in the found list are big enough
+				auto rounded = size;
+				if (size >= SLCount)
+				{
+					auto r = (1U << (std::bit_width(size) - 1 - SLLog2)) - 1;
+					if (size + r > size)
+						rounded = size + r;
+				}
+				uint fl, sl;
+				mapping(rounded, fl, sl);
+				if (fl < FLCount)
+				{
+					auto sl_map = sl_bitmaps[fl] & (~0U << sl);
+					if (!sl_map)
 					{
-						fs.first -= size;
-						fs.second += size;
-						if (i > 0 && free_spaces[i - 1].first + free_spaces[i - 1].second == fs.first)
+						auto fl_map = fl + 1 < 32 ? fl_bitmap & (~0U << (fl + 1)) : 0;
+						if (fl_map)
 						{
-							free_spaces[i - 1].second += fs.second;
-							free_spaces.erase(free_spaces.begin() + i);
+							fl = std::countr_zero(fl_map);
+							sl_map = sl_bitmaps[fl];
 						}
-						return;
 					}
-					if (off < fs.first)
+					if (sl_map)
+						return heads[fl][std::countr_zero(sl_map)];
+				}
+				// the rounding skips the list of the size itself, it may still have a block that fits
+				//  only a few are looked at so it stays O(1), if they are all too small the owner grows
+				mapping(size, fl, sl);
+				auto n = 0;
+				for (auto id = heads[fl][sl]; id != -1 && n < 8; id = blocks[id].next_free, n++)
+				{
+					if (blocks[id].size >= size)
+						return id;
+				}
+				return -1;
+			}
+
+			inline int get_free_space(uint size)
+			{
+				if (size == 0)
+					return -1;
+				auto id = find_free(size);
+				if (id == -1)
+					return -1;
+				remove_free(id);
+				if (blocks[id].size > size)
+				{
+					auto rest = new_block(blocks[id].offset + size, blocks[id].size - size);
+					auto& b = blocks[id]; // after new_block, it may reallocate blocks
+					auto& br = blocks[rest];
+					b.size = size;
+					br.prev_phys = id;
+					br.next_phys = b.next_phys;
+					if (b.next_phys != -1)
+						blocks[b.next_phys].prev_phys = rest;
+					else
+						last_block = rest;
+					b.next_phys = rest;
+					insert_free(rest);
+				}
+				auto off = blocks[id].offset;
+				allocated[off] = id;
+				used += size;
+				return off;
+			}
+
+			inline void releases_space(uint off, uint size)
+			{
+				auto it = allocated.find(off);
+				if (it == allocated.end())
+				{
+					printf("SparseRanges: release a range that is not allocated: %d\n", off);
+					return;
+				}
+				auto id = it->second;
+				allocated.erase(it);
+				assert(blocks[id].size == size);
+				used -= blocks[id].size;
+
+				if (auto next = blocks[id].next_phys; next != -1 && blocks[next].free)
+				{
+					remove_free(next);
+					merge_phys(id, next);
+				}
+				if (auto prev = blocks[id].prev_phys; prev != -1 && blocks[prev].free)
+				{
+					remove_free(prev);
+					merge_phys(prev, id);
+					id = prev;
+				}
+				insert_free(id);
+			}
+
+			// extend to a bigger capacity, allocated ranges stay where they are
+			void grow(uint new_capacity)
+			{
+				if (new_capacity <= capacity)
+					return;
+				auto extra = new_capacity - capacity;
+				capacity = new_capacity;
+				if (last_block != -1 && blocks[last_block].free)
+				{
+					remove_free(last_block);
+					blocks[last_block].size += extra;
+					insert_free(last_block);
+				}
+				else
+				{
+					auto id = new_block(capacity - extra, extra);
+					blocks[id].prev_phys = last_block;
+					if (last_block != -1)
+						blocks[last_block].next_phys = id;
+					else
+						first_block = id;
+					last_block = id;
+					insert_free(id);
+				}
+			}
+
+			uint largest_free_space() const
+			{
+				if (!fl_bitmap)
+					return 0;
+				auto fl = std::bit_width(fl_bitmap) - 1;
+				auto sl = std::bit_width(sl_bitmaps[fl]) - 1;
+				auto ret = 0U;
+				for (auto id = heads[fl][sl]; id != -1; id = blocks[id].next_free)
+					ret = max(ret, blocks[id].size);
+				return ret;
+			}
+
+			// 0 when all free space is in one range, close to 1 when it is scattered in small pieces
+			float fragmentation() const
+			{
+				auto free_space = capacity - used;
+				if (free_space == 0)
+					return 0.f;
+				return 1.f - (float)largest_free_space() / free_space;
+			}
+
+			// slide allocated ranges towards the start into the free range before them, until about max_size is moved,
+			//  the free space then gathers at the end. the owner must move the data and patch the offsets by the moves
+			//  returns true when there is nothing left to move
+			bool defragment(uint max_size, std::vector<Move>& moves)
+			{
+				auto id = first_block;
+				while (id != -1 && !blocks[id].free)
+					id = blocks[id].next_phys;
+				auto moved = 0U;
+				while (id != -1)
+				{
+					auto u = blocks[id].next_phys;
+					if (u == -1)
+						return true;
+					if (moved > 0 && moved + blocks[u].size > max_size)
+						return false;
+
+					// swap the free block f and the allocated block u after it
+					auto f = id;
+					remove_free(f);
+					auto& bf = blocks[f];
+					auto& bu = blocks[u];
+					auto& m = moves.emplace_back();
+					m.src = bu.offset;
+					m.dst = bf.offset;
+					m.size = bu.size;
+					allocated.erase(bu.offset);
+					bu.offset = bf.offset;
+					bf.offset = bu.offset + bu.size;
+					allocated[bu.offset] = u;
+
+					auto prev = bf.prev_phys;
+					auto next = bu.next_phys;
+					bu.prev_phys = prev;
+					bu.next_phys = f;
+					bf.prev_phys = u;
+					bf.next_phys = next;
+					if (prev != -1)
+						blocks[prev].next_phys = u;
+					else
+						first_block = u;
+					if (next != -1)
+						blocks[next].prev_phys = f;
+					else
+						last_block = f;
+					if (next != -1 && blocks[next].free)
 					{
-						free_spaces.insert(free_spaces.begin() + i, { off, size });
-						return;
+						remove_free(next);
+						merge_phys(f, next);
 					}
+					insert_free(f);
+					moved += m.size;
 				}
-				free_spaces.emplace_back(off, size);
+				return true;
 			}
 		};
 
@@ -162,6 +445,70 @@ namespace flame
 			return PipelineStageAllCommand;
 		}
 
+		// the members of a udt resolved once from their hashes, hot loops then write at base + offset instead of
+		//  looking up variables by hash through VirtualObject::child
+		struct UdtWriter
+		{
+			struct Member
+			{
+				int offset = -1; // -1 if the udt has no such member
+				uint size = 0;
+				uint stride = 0; // of the items if the member is an array
+				UdtInfo* ui = nullptr; // of the member or its items if it is a udt
+			};
+
+			uint size = 0;
+			std::vector<Member> members;
+
+			void init(UdtInfo* ui, std::initializer_list<uint> hashes)
+			{
+				size = ui->size;
+				members.clear();
+				for (auto h : hashes)
+				{
+					auto& m = members.emplace_back();
+					if (auto vi = ui->find_variable(h); vi)
+					{
+						m.offset = vi->offset;
+						m.size = vi->type->size;
+						if (is_in(vi->type->tag, TagA_Beg, TagA_End))
+							m.stride = ((TypeInfo_Array*)vi->type)->stride;
+						m.ui = vi->type->retrive_ui();
+					}
+				}
+			}
+
+			inline bool has(uint idx) const
+			{
+				return members[idx].offset != -1;
+			}
+
+			template<class T>
+			inline T& as(void* base, uint idx) const
+			{
+				return *(T*)((char*)base + members[idx].offset);
+			}
+
+			// the item of an array member
+			inline char* item(void* base, uint idx, uint i) const
+			{
+				auto& m = members[idx];
+				return (char*)base + m.offset + i * m.stride;
+			}
+		};
+
+		// copy a packed stream into the items of an interleaved buffer, the fixed size copies compile to plain vector moves
+		template<class T>
+		inline void write_stream(void* dst, uint stride, const T* src, uint count)
+		{
+			auto p = (char*)dst;
+			for (auto i = 0; i < count; i++)
+			{
+				memcpy(p, src + i, sizeof(T));
+				p += stride;
+			}
+		}
+
 		struct VirtualObjectWithDirtyRegions : VirtualObject
 		{
 			std::vector<std::pair<uint, uint>>	dirty_regions;
@@ -207,6 +554,23 @@ namespace flame
 				mark_dirty(vo);
 				return vo;
 			}
+
+			// get a member resolved by a writer and mark it dirty
+			template<class T>
+			T& mark_dirty_w(const UdtWriter& w, uint idx)
+			{
+				auto& m = w.members[idx];
+				mark_dirty(m.offset, m.size);
+				return w.as<T>(data, idx);
+			}
+
+			// get an array item resolved by a writer and mark it dirty
+			char* mark_dirty_wi(const UdtWriter& w, uint idx, uint i)
+			{
+				auto p = w.item(data, idx, i);
+				mark_dirty(uint(p - data), w.members[idx].stride);
+				return p;
+			}
 		};
 
 		struct StorageBuffer : VirtualObjectWithDirtyRegions
@@ -241,7 +605,7 @@ namespace flame
 			{
 				if (dirty_regions.empty())
 					return;
-				std::vector<BufferCopy> copies;
+				FrameVector<BufferCopy> copies;
 				for (auto& r : dirty_regions)
 				{
 					BufferCopy cpy;
@@ -260,7 +624,7 @@ namespace flame
 			{
 				if (dirty_regions.empty())
 					return;
-				std::vector<BufferCopy> copies;
+				FrameVector<BufferCopy> copies;
 				for (auto& r : dirty_regions)
 				{
 					BufferCopy cpy;
@@ -279,6 +643,7 @@ namespace flame
 			uint 								capacity;
 			std::unique_ptr<BufferT>			buf;
 			std::unique_ptr<BufferT>			stag;
+			UdtInfo*							ui = nullptr;
 			TypeInfo*							item_type;
 			SparseRanges						sparse_ranges;
 			std::vector<std::pair<uint, uint>>	dirty_regions;
@@ -288,8 +653,9 @@ namespace flame
 				sparse_ranges.init(capacity);
 			}
 
-			void create(UdtInfo* ui, uint _capacity)
+			void create(UdtInfo* _ui, uint _capacity)
 			{
+				ui = _ui;
 				capacity = _capacity;
 				buf.reset(Buffer::create(capacity * ui->size, BufferUsageTransferDst | BufferUsageVertex, MemoryPropertyDevice));
 				stag.reset(Buffer::create(buf->size, BufferUsageTransferSrc, MemoryPropertyHost | MemoryPropertyCoherent));
@@ -329,9 +695,58 @@ namespace flame
 				return *(T*)(data + idx * item_type->size);
 			}
 
+			// recreate the buffers with a bigger capacity, allocated offsets stay valid
+			//  the frame being recorded may already use the old ones, they are released after it is done
+			void grow(uint new_capacity)
+			{
+				Queue::get()->wait_idle();
+
+				auto item_size = item_type->size;
+				std::unique_ptr<BufferT> new_stag(Buffer::create(new_capacity * item_size, BufferUsageTransferSrc, MemoryPropertyHost | MemoryPropertyCoherent));
+				new_stag->map();
+				memcpy(new_stag->mapped, stag->mapped, capacity * item_size);
+				Buffer::release_after_frame(buf.release());
+				Buffer::release_after_frame(stag.release());
+				buf.reset(Buffer::create(new_capacity * item_size, BufferUsageTransferDst | BufferUsageVertex, MemoryPropertyDevice));
+				stag = std::move(new_stag);
+
+				if (ui)
+					VirtualObject::type = TypeInfo::get(TagAU, std::format("{}[{}]", ui->name, new_capacity), *ui->db);
+				else
+					VirtualObject::type = TypeInfo::get(TagAD, std::format("Dummy_{}[{}]", item_size, new_capacity));
+				VirtualObject::data = (char*)stag->mapped;
+				item_type = VirtualObject::type->get_wrapped();
+
+				// the new device buffer gets all the old content
+				dirty_regions.clear();
+				dirty_regions.emplace_back(0, capacity * item_size);
+				sparse_ranges.grow(new_capacity);
+				capacity = new_capacity;
+			}
+
+			// compact a part of the buffer, see SparseRanges::defragment, the data is moved in the staging buffer and then uploaded
+			bool defragment(uint max_size, std::vector<SparseRanges::Move>& moves)
+			{
+				auto beg = moves.size();
+				auto done = sparse_ranges.defragment(max_size, moves);
+				auto item_size = item_type->size;
+				for (auto i = beg; i < moves.size(); i++)
+				{
+					auto& m = moves[i];
+					memmove(data + m.dst * item_size, data + m.src * item_size, m.size * item_size);
+					dirty_regions.emplace_back(m.dst * item_size, m.size * item_size);
+				}
+				return done;
+			}
+
 			int add(const void* src, uint size)
 			{
 				int off = sparse_ranges.get_free_space(size);
+				if (off == -1 && size > 0)
+				{
+					grow(max(capacity * 2, capacity + size));
+					off = sparse_ranges.get_free_space(size);
+				}
 				if (off != -1)
 				{
 					uint data_off = off * item_type->size;
@@ -351,8 +766,6 @@ namespace flame
 					}
 					dirty_regions.emplace_back(data_off, data_size);
 				}
-				else
-					printf("Vertex buffer add: exceeded capacity\n");
 				return off;
 			}
 
@@ -365,7 +778,7 @@ namespace flame
 			{
 				if (dirty_regions.empty())
 					return;
-				std::vector<BufferCopy> copies;
+				FrameVector<BufferCopy> copies;
 				for (auto& r : dirty_regions)
 				{
 					BufferCopy cpy;
@@ -405,9 +818,48 @@ namespace flame
 				reset();
 			}
 
+			// see VertexBuffer::grow
+			void grow(uint new_capacity)
+			{
+				Queue::get()->wait_idle();
+
+				std::unique_ptr<BufferT> new_stag(Buffer::create(new_capacity * sizeof(T), BufferUsageTransferSrc, MemoryPropertyHost | MemoryPropertyCoherent));
+				new_stag->map();
+				memcpy(new_stag->mapped, stag->mapped, capacity * sizeof(T));
+				Buffer::release_after_frame(buf.release());
+				Buffer::release_after_frame(stag.release());
+				buf.reset(Buffer::create(new_capacity * sizeof(T), BufferUsageTransferDst | BufferUsageIndex, MemoryPropertyDevice));
+				stag = std::move(new_stag);
+
+				dirty_regions.clear();
+				dirty_regions.emplace_back(0, capacity * sizeof(T));
+				sparse_ranges.grow(new_capacity);
+				capacity = new_capacity;
+			}
+
+			// see VertexBuffer::defragment
+			bool defragment(uint max_size, std::vector<SparseRanges::Move>& moves)
+			{
+				auto beg = moves.size();
+				auto done = sparse_ranges.defragment(max_size, moves);
+				auto data = (char*)stag->mapped;
+				for (auto i = beg; i < moves.size(); i++)
+				{
+					auto& m = moves[i];
+					memmove(data + m.dst * sizeof(T), data + m.src * sizeof(T), m.size * sizeof(T));
+					dirty_regions.emplace_back(m.dst * sizeof(T), m.size * sizeof(T));
+				}
+				return done;
+			}
+
 			int add(const T* src, uint size)
 			{
 				int off = sparse_ranges.get_free_space(size);
+				if (off == -1 && size > 0)
+				{
+					grow(max(capacity * 2, capacity + size));
+					off = sparse_ranges.get_free_space(size);
+				}
 				if (off != -1)
 				{
 					uint data_off = off * sizeof(T);
@@ -439,7 +891,7 @@ namespace flame
 			{
 				if (dirty_regions.empty())
 					return;
-				std::vector<BufferCopy> copies;
+				FrameVector<BufferCopy> copies;
 				for (auto& r : dirty_regions)
 				{
 					BufferCopy cpy;
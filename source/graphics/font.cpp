@@ -1,5 +1,6 @@
 #include "../json.h"
 #include "../foundation/bitmap.h"
+#include "../foundation/pack.h"
 #include "device_private.h"
 #include "buffer_private.h"
 #include "command_private.h"
@@ -246,7 +247,7 @@ namespace flame
 				for (auto& _fn : _font_names)
 				{
 					auto fn = Path::get(_fn);
-					if (std::filesystem::exists(fn))
+					if (vfs_exists(fn))
 						font_names.push_back(fn);
 					else
 						wprintf(L"cannot find font: %s\n", _fn.c_str());
@@ -281,7 +282,7 @@ namespace flame
 					{
 						font = new Font;
 						font->filename = fn;
-						font->content = get_file_content(fn);
+						vfs_read(fn, font->content);
 						font->stbtt_info = new stbtt_fontinfo;
 						if (stbtt_InitFont(font->stbtt_info, (uchar*)font->content.data(), stbtt_GetFontOffsetForIndex((uchar*)font->content.data(), 0)))
 						{
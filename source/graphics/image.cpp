@@ -744,7 +744,7 @@ namespace flame
 					}
 				}
 
-				if (!std::filesystem::exists(filename))
+				if (!vfs_exists(filename))
 				{
 					wprintf(L"cannot find image: %s\n", _filename.c_str());
 					return nullptr;
@@ -912,6 +912,75 @@ namespace flame
 		}Image_get_config;
 		Image::GetConfig& Image::get_config = Image_get_config;
 
+		struct ImageLoadPixels : Image::LoadPixels
+		{
+			bool operator()(const std::filesystem::path& _filename, Format& format, uvec3& extent, std::vector<uchar>& data) override
+			{
+				auto filename = Path::get(_filename);
+				auto ext = filename.extension();
+				// through the vfs, so the volumes in a pack can be meshed too
+				if (!vfs_exists(filename))
+				{
+					wprintf(L"cannot find image: %s\n", _filename.c_str());
+					return false;
+				}
+
+				if (ext == L".ktx" || ext == L".dds")
+				{
+					std::string content;
+					if (!vfs_read(filename, content))
+					{
+						wprintf(L"cannot load image: %s\n", _filename.c_str());
+						return false;
+					}
+					auto gli_texture = gli::load(content.data(), content.size());
+					if (gli_texture.empty())
+					{
+						wprintf(L"cannot load image: %s\n", _filename.c_str());
+						return false;
+					}
+
+					switch (gli_texture.format())
+					{
+					case gli::FORMAT_R8_UNORM_PACK8:
+						format = Format_R8_UNORM;
+						break;
+					case gli::FORMAT_RGBA8_UNORM_PACK8:
+						format = Format_R8G8B8A8_UNORM;
+						break;
+					case gli::FORMAT_R32_SFLOAT_PACK32:
+						format = Format_R32_SFLOAT;
+						break;
+					default:
+						wprintf(L"cannot load pixels of %s: format not supported\n", _filename.c_str());
+						return false;
+					}
+					extent = gli_texture.extent(0);
+					auto size = gli_texture.size(0);
+					data.resize(size);
+					memcpy(data.data(), gli_texture.data(0, 0, 0), size);
+					return true;
+				}
+
+				std::unique_ptr<Bitmap> bmp(Bitmap::create(filename));
+				if (!bmp)
+				{
+					wprintf(L"cannot load image: %s\n", _filename.c_str());
+					return false;
+				}
+				if (bmp->chs == 3)
+					bmp->change_format(4);
+				format = get_image_format(bmp->chs, bmp->bpp);
+				extent = uvec3(bmp->extent, 1);
+				auto line_size = bmp->extent.x * bmp->bpp / 8;
+				data.resize(line_size * bmp->extent.y);
+				for (auto y = 0; y < bmp->extent.y; y++)
+					memcpy(data.data() + y * line_size, bmp->data + y * bmp->pitch, line_size);
+				return true;
+			}
+		}Image_load_pixels;
+		Image::LoadPixels& Image::load_pixels = Image_load_pixels;
+
 		struct ImageRelease : Image::Release
 		{
 			void operator()(ImagePtr image) override
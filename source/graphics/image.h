@@ -166,6 +166,14 @@ namespace flame
 			};
 			FLAME_GRAPHICS_API static GetConfig& get_config;
 
+			struct LoadPixels
+			{
+				// reads the first level of an image file into memory without creating an image, so it works without a device
+				//  .ktx and .dds must be uncompressed R8, RGBA8 or R32 float, 3d images come with all their slices
+				virtual bool operator()(const std::filesystem::path& filename, Format& format, uvec3& extent, std::vector<uchar>& data) = 0;
+			};
+			FLAME_GRAPHICS_API static LoadPixels& load_pixels;
+
 			struct Release
 			{
 				virtual void operator()(ImagePtr image) = 0;
@@ -2,6 +2,7 @@
 #include "../foundation/typeinfo.h"
 #include "../foundation/typeinfo_serialize.h"
 #include "../foundation/blueprint.h"
+#include "../foundation/pack.h"
 #include "image_private.h"
 #include "material_private.h"
 
@@ -553,7 +554,7 @@ namespace flame
 
 				pugi::xml_document doc;
 				pugi::xml_node doc_root;
-				if (!doc.load_file(filename.c_str()) || (doc_root = doc.first_child()).name() != std::string("material"))
+				if (!vfs_load_xml(doc, filename) || (doc_root = doc.first_child()).name() != std::string("material"))
 				{
 					printf("material does not exist or wrong format: %s\n", _filename.string().c_str());
 					return nullptr;
@@ -22,8 +22,14 @@ namespace flame
 {
 	namespace graphics
 	{
+		// not in the fmodb format, which is a plain serialization of the model
+		static const char* packed_only_mesh_fields[] = { "meshlets", "meshlet_vertices", "meshlet_triangles", "lods", "lod_indices", "packed_vertices", "packed_armature" };
+
 		void ModelPrivate::save(const std::filesystem::path& filename, bool binary)
 		{
+			for (auto& m : meshes)
+				m.unpack();
+
 			if (binary)
 			{
 				std::ofstream dst(filename, std::ios::binary);
@@ -32,6 +38,8 @@ namespace flame
 				SerializeBinarySpec spec;
 				spec.excludes.emplace_back(th<graphics::Model>(), "filename"_h);
 				spec.excludes.emplace_back(th<graphics::Model>(), "ref"_h);
+				for (auto name : packed_only_mesh_fields)
+					spec.excludes.emplace_back(th<graphics::Mesh>(), sh(name));
 
 				serialize_binary(this, dst, spec);
 				dst.close();
@@ -87,6 +95,191 @@ namespace flame
 			}
 		}
 
+		void ModelPrivate::save_packed(const std::filesystem::path& filename)
+		{
+			std::string data;
+			auto append = [&](const void* src, uint64 size) {
+				data.resize((data.size() + 15) & ~15ULL);
+				auto off = data.size();
+				data.append((const char*)src, size);
+				return off;
+			};
+
+			PackedModelHeader header;
+			memset(&header, 0, sizeof(header));
+			memcpy(header.magic, "fmodp", 5);
+			header.version = 2;
+			header.meshes_count = meshes.size();
+			header.bones_count = bones.size();
+			header.bounds = bounds;
+			data.resize(sizeof(PackedModelHeader));
+
+			std::vector<PackedMeshHeader> mesh_headers(meshes.size());
+			header.meshes_offset = append(mesh_headers.data(), sizeof(PackedMeshHeader) * mesh_headers.size());
+			for (auto i = 0; i < meshes.size(); i++)
+			{
+				auto& m = meshes[i];
+				m.unpack();
+				auto& mh = mesh_headers[i];
+				memset(&mh, 0, sizeof(mh));
+				auto n = (uint)m.positions.size();
+				mh.vertices_count = n;
+				mh.indices_count = m.indices.size();
+				mh.armature = m.bone_ids.empty() ? 0 : 1;
+				mh.bounds = m.bounds;
+
+				auto fill = [&](PackedVertex& v, uint i) {
+					v.pos = m.positions[i];
+					v.uv = m.uvs.empty() ? vec2(0.f) : m.uvs[i];
+					v.nor = m.normals.empty() ? vec3(0.f) : m.normals[i];
+					v.tan = m.tangents.empty() ? vec3(0.f) : m.tangents[i];
+				};
+				if (!mh.armature)
+				{
+					std::vector<PackedVertex> vertices(n);
+					for (auto j = 0; j < n; j++)
+						fill(vertices[j], j);
+					mh.vertices_offset = append(vertices.data(), sizeof(PackedVertex) * n);
+				}
+				else
+				{
+					std::vector<PackedVertexArm> vertices(n);
+					for (auto j = 0; j < n; j++)
+					{
+						fill(vertices[j], j);
+						vertices[j].bids = m.bone_ids[j];
+						vertices[j].bwgts = m.bone_weights.empty() ? vec4(0.f) : m.bone_weights[j];
+					}
+					mh.vertices_offset = append(vertices.data(), sizeof(PackedVertexArm) * n);
+				}
+				mh.indices_offset = append(m.indices.data(), sizeof(uint) * m.indices.size());
+
+				mh.meshlets_count = m.meshlets.size();
+				mh.meshlet_vertices_count = m.meshlet_vertices.size();
+				mh.meshlet_triangles_size = m.meshlet_triangles.size();
+				mh.meshlets_offset = append(m.meshlets.data(), sizeof(Meshlet) * m.meshlets.size());
+				mh.meshlet_vertices_offset = append(m.meshlet_vertices.data(), sizeof(uint) * m.meshlet_vertices.size());
+				mh.meshlet_triangles_offset = append(m.meshlet_triangles.data(), m.meshlet_triangles.size());
+
+				mh.lods_count = m.lods.size();
+				mh.lod_indices_count = m.lod_indices.size();
+				mh.lods_offset = append(m.lods.data(), sizeof(MeshLod) * m.lods.size());
+				mh.lod_indices_offset = append(m.lod_indices.data(), sizeof(uint) * m.lod_indices.size());
+			}
+			memcpy(data.data() + header.meshes_offset, mesh_headers.data(), sizeof(PackedMeshHeader) * mesh_headers.size());
+
+			std::vector<PackedBone> packed_bones(bones.size());
+			std::string names;
+			for (auto i = 0; i < bones.size(); i++)
+			{
+				auto& b = packed_bones[i];
+				b.name_offset = names.size();
+				b.name_length = bones[i].name.size();
+				b.offset_matrix = bones[i].offset_matrix;
+				names += bones[i].name;
+			}
+			header.bones_offset = append(packed_bones.data(), sizeof(PackedBone) * packed_bones.size());
+			header.names_offset = append(names.data(), names.size());
+			header.names_size = names.size();
+			memcpy(data.data(), &header, sizeof(header));
+
+			std::ofstream dst(filename, std::ios::binary);
+			dst.write(data.data(), data.size());
+			dst.close();
+		}
+
+		bool ModelPrivate::load_packed(std::string_view data)
+		{
+			auto in_range = [&](uint64 offset, uint64 size) {
+				return offset + size <= data.size();
+			};
+			if (data.size() < sizeof(PackedModelHeader))
+				return false;
+			auto& header = *(PackedModelHeader*)data.data();
+			if (header.version != 1 && header.version != 2)
+				return false;
+			auto mesh_header_size = header.version == 1 ? sizeof(PackedMeshHeaderV1) : sizeof(PackedMeshHeader);
+			if (!in_range(header.meshes_offset, mesh_header_size * (uint64)header.meshes_count) ||
+				!in_range(header.bones_offset, sizeof(PackedBone) * (uint64)header.bones_count) ||
+				!in_range(header.names_offset, header.names_size))
+				return false;
+			bounds = header.bounds;
+
+			// version 1 files are read as they are, their meshes have no lods
+			std::vector<PackedMeshHeader> mesh_headers(header.meshes_count);
+			if (header.version == 1)
+			{
+				auto src = (PackedMeshHeaderV1*)(data.data() + header.meshes_offset);
+				for (auto i = 0; i < header.meshes_count; i++)
+				{
+					auto& h1 = src[i];
+					auto& mh = mesh_headers[i];
+					memset(&mh, 0, sizeof(mh));
+					mh.vertices_count = h1.vertices_count;
+					mh.indices_count = h1.indices_count;
+					mh.armature = h1.armature;
+					mh.meshlets_count = h1.meshlets_count;
+					mh.meshlet_vertices_count = h1.meshlet_vertices_count;
+					mh.meshlet_triangles_size = h1.meshlet_triangles_size;
+					mh.bounds = h1.bounds;
+					mh.vertices_offset = h1.vertices_offset;
+					mh.indices_offset = h1.indices_offset;
+					mh.meshlets_offset = h1.meshlets_offset;
+					mh.meshlet_vertices_offset = h1.meshlet_vertices_offset;
+					mh.meshlet_triangles_offset = h1.meshlet_triangles_offset;
+				}
+			}
+			else
+				memcpy(mesh_headers.data(), data.data() + header.meshes_offset, sizeof(PackedMeshHeader) * header.meshes_count);
+			meshes.resize(header.meshes_count);
+			for (auto i = 0; i < header.meshes_count; i++)
+			{
+				auto& mh = mesh_headers[i];
+				auto stride = mh.armature ? sizeof(PackedVertexArm) : sizeof(PackedVertex);
+				if (!in_range(mh.vertices_offset, stride * mh.vertices_count) ||
+					!in_range(mh.indices_offset, sizeof(uint) * mh.indices_count) ||
+					!in_range(mh.meshlets_offset, sizeof(Meshlet) * mh.meshlets_count) ||
+					!in_range(mh.meshlet_vertices_offset, sizeof(uint) * mh.meshlet_vertices_count) ||
+					!in_range(mh.meshlet_triangles_offset, mh.meshlet_triangles_size) ||
+					!in_range(mh.lods_offset, sizeof(MeshLod) * mh.lods_count) ||
+					!in_range(mh.lod_indices_offset, sizeof(uint) * mh.lod_indices_count))
+					return false;
+
+				auto& m = meshes[i];
+				m.model = this;
+				m.bounds = mh.bounds;
+				m.packed_vertices = data.data() + mh.vertices_offset;
+				m.packed_armature = mh.armature != 0;
+				m.positions.resize(mh.vertices_count);
+				for (auto j = 0; j < mh.vertices_count; j++)
+					m.positions[j] = ((PackedVertex*)((char*)m.packed_vertices + j * stride))->pos;
+				auto indices = (uint*)(data.data() + mh.indices_offset);
+				m.indices.assign(indices, indices + mh.indices_count);
+				auto meshlets = (Meshlet*)(data.data() + mh.meshlets_offset);
+				m.meshlets.assign(meshlets, meshlets + mh.meshlets_count);
+				auto meshlet_vertices = (uint*)(data.data() + mh.meshlet_vertices_offset);
+				m.meshlet_vertices.assign(meshlet_vertices, meshlet_vertices + mh.meshlet_vertices_count);
+				auto meshlet_triangles = (uchar*)(data.data() + mh.meshlet_triangles_offset);
+				m.meshlet_triangles.assign(meshlet_triangles, meshlet_triangles + mh.meshlet_triangles_size);
+				auto lods = (MeshLod*)(data.data() + mh.lods_offset);
+				m.lods.assign(lods, lods + mh.lods_count);
+				auto lod_indices = (uint*)(data.data() + mh.lod_indices_offset);
+				m.lod_indices.assign(lod_indices, lod_indices + mh.lod_indices_count);
+			}
+
+			auto packed_bones = (PackedBone*)(data.data() + header.bones_offset);
+			bones.resize(header.bones_count);
+			for (auto i = 0; i < header.bones_count; i++)
+			{
+				auto& b = packed_bones[i];
+				if (b.name_offset + b.name_length > header.names_size)
+					return false;
+				bones[i].name = std::string(data.data() + header.names_offset + b.name_offset, b.name_length);
+				bones[i].offset_matrix = b.offset_matrix;
+			}
+			return true;
+		}
+
 		std::filesystem::path find_file(const std::filesystem::path& dir, const std::filesystem::path& name)
 		{
 			if (std::filesystem::exists(name))
@@ -316,28 +509,62 @@ namespace flame
 					}
 				}
 
-				std::ifstream file(filename, std::ios::binary);
-				if (!file.good())
+				// map through the vfs, the model may be in a pack
+				std::unique_ptr<MappedFile> mapped(vfs_map(filename));
+				if (!mapped)
 				{
 					wprintf(L"cannot find model: %s\n", _filename.c_str());
 					return nullptr;
 				}
+				auto content = mapped->data;
 
 				auto ret = new ModelPrivate();
 				ret->filename = filename;
 
-				if (char buf[5]; file.read(buf, 5).good() && strncmp(buf, "fmodb", 5) == 0)
+				if (content.size() >= 5 && strncmp(content.data(), "fmodp", 5) == 0)
+				{
+					if (!ret->load_packed(content))
+					{
+						wprintf(L"model format is incorrect: %s\n", _filename.c_str());
+						delete ret;
+						return nullptr;
+					}
+					ret->mapped = std::move(mapped);
+				}
+				else if (content.size() >= 5 && strncmp(content.data(), "fmodb", 5) == 0)
 				{
 					UnserializeBinarySpec spec;
 					spec.excludes.emplace_back(th<graphics::Model>(), "filename"_h);
 					spec.excludes.emplace_back(th<graphics::Model>(), "ref"_h);
-
-					unserialize_binary(file, ret, spec);
+					for (auto name : packed_only_mesh_fields)
+						spec.excludes.emplace_back(th<graphics::Mesh>(), sh(name));
+
+					// a truncated or broken file must not read past the mapping, the rest reads as zeros and the model is dropped
+					auto p = content.data() + 5;
+					auto end = content.data() + content.size();
+					auto ok = true;
+					unserialize_binary([&](void* dst, uint size) {
+						if (!ok || size > end - p)
+						{
+							ok = false;
+							memset(dst, 0, size);
+							return;
+						}
+						memcpy(dst, p, size);
+						p += size;
+					}, ret, spec);
+					if (!ok)
+					{
+						wprintf(L"model format is incorrect: %s\n", _filename.c_str());
+						delete ret;
+						return nullptr;
+					}
 				}
 				else
 				{
-					file.close();
-					file.open(filename); // reopen with text mode
+					auto text = std::string(content);
+					std::erase(text, '\r'); // was read in binary mode
+					std::istringstream file(text);
 
 					LineReader src(file);
 					src.read_block("model:");
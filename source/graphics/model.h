@@ -12,6 +12,42 @@ namespace flame
 			mat4 offset_matrix;
 		};
 
+		// interleaved as 'flame\shaders\mesh\mesh.vi', the packed model format stores vertices like this
+		struct PackedVertex
+		{
+			vec3 pos;
+			vec2 uv;
+			vec3 nor;
+			vec3 tan;
+		};
+
+		struct PackedVertexArm : PackedVertex
+		{
+			ivec4 bids;
+			vec4 bwgts;
+		};
+
+		// a small cluster of triangles with bounds for culling, see build_meshlets
+		struct Meshlet
+		{
+			uint vertex_offset; // into Mesh::meshlet_vertices
+			uint triangle_offset; // into Mesh::meshlet_triangles, 3 local indices per triangle
+			uint vertex_count;
+			uint triangle_count;
+			vec3 center;
+			float radius;
+			vec3 cone_axis;
+			float cone_cutoff; // all triangles face away when dot(normalize(center - eye), cone_axis) >= cone_cutoff, 1 for never
+		};
+
+		// a simplified version of a mesh, it uses the same vertices, see build_mesh_lods
+		struct MeshLod
+		{
+			uint index_offset; // into Mesh::lod_indices
+			uint index_count;
+			float error; // in object space, about how far the surface moved
+		};
+
 		struct Mesh
 		{
 			ModelPtr model = nullptr;
@@ -27,6 +63,52 @@ namespace flame
 
 			AABB bounds;
 
+			std::vector<Meshlet>	meshlets;
+			std::vector<uint>		meshlet_vertices;
+			std::vector<uchar>		meshlet_triangles;
+
+			std::vector<MeshLod>	lods; // from fine to coarse, not including the mesh itself
+			std::vector<uint>		lod_indices;
+
+			// set when loaded from the packed format, it points into the mapped file of the model
+			//  positions and indices are always filled, the other attributes stay in here until unpack()
+			const void* packed_vertices = nullptr;
+			bool packed_armature = false;
+
+			Mesh() = default;
+			Mesh(Mesh&&) = default;
+			Mesh& operator=(Mesh&&) = default;
+			// a copy may outlive the mapped file, so it takes the attributes out of the packed vertices
+			Mesh(const Mesh& oth)
+			{
+				*this = oth;
+			}
+
+			Mesh& operator=(const Mesh& oth)
+			{
+				if (this == &oth)
+					return *this;
+				model = oth.model;
+				positions = oth.positions;
+				uvs = oth.uvs;
+				normals = oth.normals;
+				tangents = oth.tangents;
+				colors = oth.colors;
+				bone_ids = oth.bone_ids;
+				bone_weights = oth.bone_weights;
+				indices = oth.indices;
+				bounds = oth.bounds;
+				meshlets = oth.meshlets;
+				meshlet_vertices = oth.meshlet_vertices;
+				meshlet_triangles = oth.meshlet_triangles;
+				lods = oth.lods;
+				lod_indices = oth.lod_indices;
+				packed_vertices = oth.packed_vertices;
+				packed_armature = oth.packed_armature;
+				unpack();
+				return *this;
+			}
+
 			inline void reset()
 			{
 				positions.clear();
@@ -39,10 +121,63 @@ namespace flame
 				indices.clear();
 
 				bounds.reset();
+
+				meshlets.clear();
+				meshlet_vertices.clear();
+				meshlet_triangles.clear();
+				lods.clear();
+				lod_indices.clear();
+				packed_vertices = nullptr;
+				packed_armature = false;
+			}
+
+			// screen_scale is the fraction of the screen height one unit of object space takes, at where the mesh is
+			//  return the coarsest level that the error is under threshold (fraction of the screen height), 0 is the mesh itself
+			inline uint select_lod(float screen_scale, float threshold) const
+			{
+				auto ret = 0U;
+				for (auto i = 0; i < lods.size(); i++)
+				{
+					if (lods[i].error * screen_scale > threshold)
+						break;
+					ret = i + 1;
+				}
+				return ret;
+			}
+
+			inline void unpack()
+			{
+				if (!packed_vertices)
+					return;
+				auto n = positions.size();
+				auto stride = packed_armature ? sizeof(PackedVertexArm) : sizeof(PackedVertex);
+				uvs.resize(n);
+				normals.resize(n);
+				tangents.resize(n);
+				if (packed_armature)
+				{
+					bone_ids.resize(n);
+					bone_weights.resize(n);
+				}
+				for (auto i = 0; i < n; i++)
+				{
+					auto& v = *(PackedVertexArm*)((char*)packed_vertices + i * stride);
+					uvs[i] = v.uv;
+					normals[i] = v.nor;
+					tangents[i] = v.tan;
+					if (packed_armature)
+					{
+						bone_ids[i] = v.bids;
+						bone_weights[i] = v.bwgts;
+					}
+				}
+				packed_vertices = nullptr;
 			}
 
 			inline void add_vertices(uint n, vec3* _positions, vec3* _uvs, vec3* _normals)
 			{
+				// the packed vertices only cover the old positions
+				unpack();
 				auto b = positions.size();
 				positions.resize(b + n);
 				for (auto i = 0; i < n; i++)
@@ -103,6 +238,8 @@ namespace flame
 			};
 
 			virtual void save(const std::filesystem::path& filename, bool binary = false) = 0;
+			// gpu-ready format, vertices are interleaved and aligned so they are uploaded with one copy after mapping the file
+			virtual void save_packed(const std::filesystem::path& filename) = 0;
 
 			struct Create
 			{
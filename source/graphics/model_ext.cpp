@@ -1,3 +1,4 @@
+#include "model_private.h"
 #include "model_ext.h"
 
 namespace flame
@@ -87,639 +88,319 @@ namespace flame
 			bottom_face.normal = vec3(0.f, -1.f, 0.f);
 		}
 		
-		void ControlMesh::subdivide_CatmullClark(ControlMesh& oth)
+		void ControlMeshTopology::build(const ControlMesh& mesh)
 		{
-			oth.reset();
-
-			std::unordered_map<uint, uint> vertices_adjacent_face_count;
-			std::unordered_map<std::pair<uint, uint>, uint, uint_pair_hasher> faces_adjacent;
-			for (auto i = 0; i < faces.size(); i++)
-			{
-				auto& f = faces[i];
-
-				for (auto j = 0; j < f.corners.size(); j++)
+			auto n_faces = (uint)mesh.faces.size();
+			auto n_verts = (uint)mesh.vertices.size();
+			face_offsets.resize(n_faces + 1);
+			face_offsets[0] = 0;
+			for (auto i = 0; i < n_faces; i++)
+				face_offsets[i + 1] = face_offsets[i] + mesh.faces[i].corners.size();
+			auto n_hes = face_offsets[n_faces];
+			he_face.resize(n_hes);
+			he_vertex.resize(n_hes);
+			parallel_for(n_faces, [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
 				{
-					uint v0 = f.corners[j].vertex_id;
-					uint v1 = f.corners[j + 1 < f.corners.size() ? j + 1 : 0].vertex_id;
-					vertices_adjacent_face_count[v0]++;
-					faces_adjacent[{v1, v0}] = i;
+					auto& f = mesh.faces[i];
+					for (auto j = 0; j < f.corners.size(); j++)
+					{
+						he_face[face_offsets[i] + j] = i;
+						he_vertex[face_offsets[i] + j] = f.corners[j].vertex_id;
+					}
 				}
-			}
-
-			std::vector<vec3> face_points(faces.size());
-
-			for (auto i = 0; i < faces.size(); i++)
+			}, 1024);
+
+			vertex_offsets.assign(n_verts + 1, 0);
+			for (auto v : he_vertex)
+				vertex_offsets[v + 1]++;
+			for (auto i = 0; i < n_verts; i++)
+				vertex_offsets[i + 1] += vertex_offsets[i];
+			vertex_hes.resize(n_hes);
 			{
-				auto& f = faces[i];
-
-				vec3 face_point(0.f);
-				for (auto& c : f.corners)
-					face_point += vertices[c.vertex_id];
-				face_point *= 1.f / (float)f.corners.size();
-				face_points[i] = face_point;
+				std::vector<uint> fill(vertex_offsets.begin(), vertex_offsets.end() - 1);
+				for (auto h = 0; h < n_hes; h++)
+					vertex_hes[fill[he_vertex[h]]++] = h;
 			}
 
-			std::unordered_map<std::pair<uint, uint>, vec3, uint_pair_hasher> edge_points;
+			// the twin of a->b is the one of the half edges going out of b that ends at a
+			he_twin.resize(n_hes);
+			parallel_for(n_hes, [&](uint begin, uint end) {
+				for (auto h = begin; h < end; h++)
+				{
+					auto a = he_vertex[h], b = dest(h);
+					he_twin[h] = -1;
+					for (auto i = vertex_offsets[b]; i < vertex_offsets[b + 1]; i++)
+					{
+						if (dest(vertex_hes[i]) == a)
+						{
+							he_twin[h] = vertex_hes[i];
+							break;
+						}
+					}
+				}
+			}, 4096);
 
-			for (auto i = 0; i < faces.size(); i++)
+			he_edge.resize(n_hes);
+			edge_he.clear();
+			for (auto h = 0; h < n_hes; h++)
 			{
-				auto& f = faces[i];
-				if (f.corners.size() > 4)
-					continue;
-
-				if (f.corners.size() == 3)
-				{
-					uint v0 = f.corners[0].vertex_id;
-					uint v1 = f.corners[1].vertex_id;
-					uint v2 = f.corners[2].vertex_id;
-
-					auto k01 = std::make_pair(v0, v1);
-					auto k12 = std::make_pair(v1, v2);
-					auto k20 = std::make_pair(v2, v0);
-					auto k10 = std::make_pair(v1, v0);
-					auto k21 = std::make_pair(v2, v1);
-					auto k02 = std::make_pair(v0, v2);
-
-					uint adjacent_f01 = faces_adjacent[k01];
-					vec3 edge_point_01 = (face_points[i] + face_points[adjacent_f01] +
-						vertices[v0] + vertices[v1]) * 0.25f;
-					edge_points[k01] = edge_point_01;
-					edge_points[k10] = edge_point_01;
-
-					uint adjacent_f12 = faces_adjacent[k12];
-					vec3 edge_point_12 = (face_points[i] + face_points[adjacent_f12] +
-						vertices[v1] + vertices[v2]) * 0.25f;
-					edge_points[k12] = edge_point_12;
-					edge_points[k21] = edge_point_12;
-
-					uint adjacent_f20 = faces_adjacent[k20];
-					vec3 edge_point_20 = (face_points[i] + face_points[adjacent_f20] +
-						vertices[v2] + vertices[v0]) * 0.25f;
-					edge_points[k20] = edge_point_20;
-					edge_points[k02] = edge_point_20;
-
-				}
-				else if (f.corners.size() == 4)
-				{
-					uint v0 = f.corners[0].vertex_id;
-					uint v1 = f.corners[1].vertex_id;
-					uint v2 = f.corners[2].vertex_id;
-					uint v3 = f.corners[3].vertex_id;
-
-					auto k01 = std::make_pair(v0, v1);
-					auto k12 = std::make_pair(v1, v2);
-					auto k23 = std::make_pair(v2, v3);
-					auto k30 = std::make_pair(v3, v0);
-					auto k03 = std::make_pair(v0, v3);
-					auto k32 = std::make_pair(v3, v2);
-					auto k21 = std::make_pair(v2, v1);
-					auto k10 = std::make_pair(v1, v0);
-
-					uint adjacent_f03 = faces_adjacent[k30];
-					vec3 edge_point_03 = (face_points[i] + face_points[adjacent_f03] +
-						vertices[v0] + vertices[v3]) * 0.25f;
-					edge_points[k30] = edge_point_03;
-					edge_points[k03] = edge_point_03;
-
-					uint adjacent_f32 = faces_adjacent[k23];
-					vec3 edge_point_32 = (face_points[i] + face_points[adjacent_f32] +
-						vertices[v3] + vertices[v2]) * 0.25f;
-					edge_points[k23] = edge_point_32;
-					edge_points[k32] = edge_point_32;
-
-					uint adjacent_f21 = faces_adjacent[k12];
-					vec3 edge_point_21 = (face_points[i] + face_points[adjacent_f21] +
-						vertices[v2] + vertices[v1]) * 0.25f;
-					edge_points[k12] = edge_point_21;
-					edge_points[k21] = edge_point_21;
-
-					uint adjacent_f10 = faces_adjacent[k01];
-					vec3 edge_point_10 = (face_points[i] + face_points[adjacent_f10] +
-						vertices[v1] + vertices[v0]) * 0.25f;
-					edge_points[k01] = edge_point_10;
-					edge_points[k10] = edge_point_10;
+				if (he_twin[h] == -1 || (int)h < he_twin[h])
+				{
+					he_edge[h] = edge_he.size();
+					edge_he.push_back(h);
 				}
 			}
+			parallel_for(n_hes, [&](uint begin, uint end) {
+				for (auto h = begin; h < end; h++)
+				{
+					if (he_twin[h] != -1 && he_twin[h] < (int)h)
+						he_edge[h] = he_edge[he_twin[h]];
+				}
+			}, 4096);
+		}
 
-			int vertex_size = vertices.size();
-			std::vector<vec3> vertex_points(vertex_size);
-			for (auto& v : vertex_points) v = vec3(0.f);
-
-			for (auto i = 0; i < faces.size(); i++)
+		// the neighbors of a vertex along border edges, there are two if it is on a smooth border
+		static uint get_border_neighbors(const ControlMeshTopology& topo, uint v, uint* out)
+		{
+			auto n = 0U;
+			for (auto i = topo.vertex_offsets[v]; i < topo.vertex_offsets[v + 1]; i++)
 			{
-				auto& f = faces[i];
-				if (f.corners.size() > 4)
-					continue;
-
-				if (f.corners.size() == 3)
+				auto h = topo.vertex_hes[i];
+				if (topo.he_twin[h] == -1)
 				{
-					uint v0 = f.corners[0].vertex_id;
-					uint v1 = f.corners[1].vertex_id;
-					uint v2 = f.corners[2].vertex_id;
-
-					uint n0 = vertices_adjacent_face_count[v0];
-					uint n1 = vertices_adjacent_face_count[v1];
-					uint n2 = vertices_adjacent_face_count[v2];
-
-					vertex_points[v0] += face_points[i] / (float)n0;
-					vertex_points[v0] += (vertices[v0] + vertices[v1]) * 0.5f / (float)n0;
-					vertex_points[v0] += (vertices[v2] + vertices[v0]) * 0.5f / (float)n0;
-
-					vertex_points[v1] += face_points[i] / (float)n1;
-					vertex_points[v1] += (vertices[v0] + vertices[v1]) * 0.5f / (float)n1;
-					vertex_points[v1] += (vertices[v1] + vertices[v2]) * 0.5f / (float)n1;
-
-					vertex_points[v2] += face_points[i] / (float)n2;
-					vertex_points[v2] += (vertices[v1] + vertices[v2]) * 0.5f / (float)n2;
-					vertex_points[v2] += (vertices[v2] + vertices[v0]) * 0.5f / (float)n2;
+					if (n < 2)
+						out[n] = topo.dest(h);
+					n++;
 				}
-				else if (f.corners.size() == 4)
+				auto p = topo.prev(h);
+				if (topo.he_twin[p] == -1)
 				{
-					uint v0 = f.corners[0].vertex_id;
-					uint v1 = f.corners[1].vertex_id;
-					uint v2 = f.corners[2].vertex_id;
-					uint v3 = f.corners[3].vertex_id;
-
-					uint n0 = vertices_adjacent_face_count[v0];
-					uint n1 = vertices_adjacent_face_count[v1];
-					uint n2 = vertices_adjacent_face_count[v2];
-					uint n3 = vertices_adjacent_face_count[v3];
-
-					vertex_points[v0] += face_points[i] / (float)n0;
-					vertex_points[v0] += (vertices[v0] + vertices[v1]) * 0.5f / (float)n0;
-					vertex_points[v0] += (vertices[v3] + vertices[v0]) * 0.5f / (float)n0;
-
-					vertex_points[v1] += face_points[i] / (float)n1;
-					vertex_points[v1] += (vertices[v0] + vertices[v1]) * 0.5f / (float)n1;
-					vertex_points[v1] += (vertices[v1] + vertices[v2]) * 0.5f / (float)n1;
-
-					vertex_points[v2] += face_points[i] / (float)n2;
-					vertex_points[v2] += (vertices[v1] + vertices[v2]) * 0.5f / (float)n2;
-					vertex_points[v2] += (vertices[v2] + vertices[v3]) * 0.5f / (float)n2;
-
-					vertex_points[v3] += face_points[i] / (float)n3;
-					vertex_points[v3] += (vertices[v3] + vertices[v0]) * 0.5f / (float)n3;
-					vertex_points[v3] += (vertices[v2] + vertices[v3]) * 0.5f / (float)n3;
+					if (n < 2)
+						out[n] = topo.he_vertex[p];
+					n++;
 				}
 			}
-			for (auto i = 0; i < vertex_size; i++)
-			{
-				uint n = vertices_adjacent_face_count[i];
-				vertex_points[i] = (vertex_points[i] + (float)(n - 3) * vertices[i]) / (float)n;
-			}
-
-			uint vertex_idx = 0;
-
-			std::vector<vec3> new_vertices;
-			std::vector<Face> new_faces;
-			std::unordered_map<std::pair<uint, uint>, uint, uint_pair_hasher> process_vertex;
-
-			for (auto i = 0; i < faces.size(); i++)
-			{
-				auto& f = faces[i];
-				if (f.corners.size() > 4)
-					continue;
-
-				auto idx_f = vertex_idx;
-				vertex_idx++;
-				new_vertices.emplace_back(face_points[i]);
-
-				if (f.corners.size() == 3)
-				{
-
-					//Triangle
-					//2
-					//|\
-					//| \
-					//|  \
-					//0---1
-
-					//3 Quads
-					//       2
-					//      / \
-					//     /   \
-					//    /     \
-					//  e20     e12
-					//  /    f    \
-					// /           \
-					///             \ 
-					//0-----e01-----1\
-
-					uint v0 = f.corners[0].vertex_id;
-					uint v1 = f.corners[1].vertex_id;
-					uint v2 = f.corners[2].vertex_id;
-
-					auto e01 = std::make_pair(v0, v1);
-					auto e12 = std::make_pair(v1, v2);
-					auto e20 = std::make_pair(v2, v0);
-					auto e10 = std::make_pair(v1, v0);
-					auto e21 = std::make_pair(v2, v1);
-					auto e02 = std::make_pair(v0, v2);
-
-					//check edge vertex
-					uint idx_e01;
-					uint idx_e12;
-					uint idx_e20;
-
-					if (process_vertex.find(e01) != process_vertex.end() || process_vertex.find(e10) != process_vertex.end())
-					{
-						if (process_vertex.find(e01) != process_vertex.end())
-							idx_e01 = process_vertex[e01];
-						else
-							idx_e01 = process_vertex[e10];
-					}
-					else
-					{
-						idx_e01 = vertex_idx;
-
-						auto e10 = std::make_pair(v1, v0);
-
-						process_vertex[e01] = vertex_idx;
-
-						if (edge_points.find(e01) != edge_points.end())
-							new_vertices.emplace_back(edge_points[e01]);
-						else
-							new_vertices.emplace_back(edge_points[e10]);
-
-						++vertex_idx;
-					}
-
-					if (process_vertex.find(e12) != process_vertex.end() || process_vertex.find(e21) != process_vertex.end())
-					{
-						if (process_vertex.find(e12) != process_vertex.end())
-							idx_e12 = process_vertex[e12];
-						else
-							idx_e12 = process_vertex[e21];
-					}
-					else
-					{
-						idx_e12 = vertex_idx;
-
-						auto e21 = std::make_pair(v2, v1);
-
-						process_vertex[e12] = vertex_idx;
-
-						if (edge_points.find(e12) != edge_points.end())
-							new_vertices.emplace_back(edge_points[e12]);
-						else
-							new_vertices.emplace_back(edge_points[e21]);
-						++vertex_idx;
-					}
-
-					if (process_vertex.find(e20) != process_vertex.end() || process_vertex.find(e02) != process_vertex.end())
-					{
-						if (process_vertex.find(e20) != process_vertex.end())
-							idx_e20 = process_vertex[e20];
-						else
-							idx_e20 = process_vertex[e02];
-					}
-					else
-					{
-						idx_e20 = vertex_idx;
-
-						auto e02 = std::make_pair(v0, v2);
-
-						process_vertex[e20] = vertex_idx;
-
-						if (edge_points.find(e20) != edge_points.end())
-							new_vertices.emplace_back(edge_points[e20]);
-						else
-							new_vertices.emplace_back(edge_points[e02]);
-						++vertex_idx;
-					}
-
-					//check point vertex
-					uint idx_v0;
-					uint idx_v1;
-					uint idx_v2;
+			return n;
+		}
 
-					auto p0 = std::make_pair(v0, 0xffffffff);
-					auto p1 = std::make_pair(v1, 0xffffffff);
-					auto p2 = std::make_pair(v2, 0xffffffff);
+		static vec3 get_face_normal(const ControlMesh::Face& f, const std::vector<vec3>& vertices)
+		{
+			vec3 n;
+			if (f.corners.size() == 4)
+				n = cross(vertices[f.corners[2].vertex_id] - vertices[f.corners[0].vertex_id], vertices[f.corners[3].vertex_id] - vertices[f.corners[1].vertex_id]);
+			else
+				n = cross(vertices[f.corners[1].vertex_id] - vertices[f.corners[0].vertex_id], vertices[f.corners[2].vertex_id] - vertices[f.corners[0].vertex_id]);
+			auto l = length(n);
+			return l > 0.f ? n / l : vec3(0.f, 1.f, 0.f);
+		}
 
-					if (process_vertex.find(p0) != process_vertex.end())
-						idx_v0 = process_vertex[p0];
-					else
-					{
-						new_vertices.emplace_back(vertex_points[v0]);
-						process_vertex[p0] = vertex_idx;
-						idx_v0 = vertex_idx++;
-					}
+		void ControlMesh::subdivide_CatmullClark(ControlMesh& oth)
+		{
+			ControlMeshTopology topo;
+			topo.build(*this);
+			auto n_verts = (uint)vertices.size();
+			auto n_edges = (uint)topo.edge_he.size();
+			auto n_faces = (uint)faces.size();
 
-					if (process_vertex.find(p1) != process_vertex.end())
-						idx_v1 = process_vertex[p1];
-					else
-					{
-						new_vertices.emplace_back(vertex_points[v1]);
-						process_vertex[p1] = vertex_idx;
-						idx_v1 = vertex_idx++;
-					}
+			// new vertices are the vertex points, then the edge points, then the face points
+			oth.reset();
+			oth.color = color;
+			oth.vertices.resize(n_verts + n_edges + n_faces);
+			auto vertex_points = oth.vertices.data();
+			auto edge_points = vertex_points + n_verts;
+			auto face_points = edge_points + n_edges;
 
-					if (process_vertex.find(p2) != process_vertex.end())
-						idx_v2 = process_vertex[p2];
-					else
-					{
-						new_vertices.emplace_back(vertex_points[v2]);
-						process_vertex[p2] = vertex_idx;
-						idx_v2 = vertex_idx++;
-					}
+			parallel_for(n_faces, [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+				{
+					auto& f = faces[i];
+					auto p = vec3(0.f);
+					for (auto& c : f.corners)
+						p += vertices[c.vertex_id];
+					face_points[i] = p / (float)f.corners.size();
+				}
+			}, 1024);
 
-					//       2
-					//      / \
-					//     /   \
-					//    /     \
-					//  e20     e12
-					//  /    f    \
-					// /           \
-					///             \ 
-					//0-----e01-----1\
-					//Final Add Quads
-
-					auto uv_v0 = f.corners[0].uv;
-					auto uv_v1 = f.corners[0].uv;
-					auto uv_v2 = f.corners[0].uv;
-
-					auto uv_e01 = (uv_v0 + uv_v1) * 0.5f;
-					auto uv_e12 = (uv_v1 + uv_v2) * 0.5f;
-					auto uv_e20 = (uv_v2 + uv_v0) * 0.5f;
-
-					auto uv_f = (uv_v0 + uv_v1 + uv_v2) * (1.f / 3.f);
-
-					Face quad1;
-					quad1.corners.resize(4);
-					quad1.corners[0] = { .vertex_id = idx_f, .uv = uv_f };
-					quad1.corners[1] = { .vertex_id = idx_e20, .uv = uv_e20 };
-					quad1.corners[2] = { .vertex_id = idx_v0, .uv = uv_v0 };
-					quad1.corners[3] = { .vertex_id = idx_e01, .uv = uv_e01 };
-					quad1.normal = normalize(cross(new_vertices[idx_f] - new_vertices[idx_e01],
-						new_vertices[idx_e20] - new_vertices[idx_f]));
-
-					Face quad2;
-					quad2.corners.resize(4);
-					quad2.corners[0] = { .vertex_id = idx_f, .uv = uv_f };
-					quad2.corners[1] = { .vertex_id = idx_e01, .uv = uv_e01 };
-					quad2.corners[2] = { .vertex_id = idx_v1, .uv = uv_v1 };
-					quad2.corners[3] = { .vertex_id = idx_e12, .uv = uv_e12 };
-					quad2.normal = normalize(cross(new_vertices[idx_f] - new_vertices[idx_e12],
-						new_vertices[idx_e01] - new_vertices[idx_f]));
-
-					Face quad3;
-					quad3.corners.resize(4);
-					quad3.corners[0] = { .vertex_id = idx_f, .uv = uv_f };
-					quad3.corners[1] = { .vertex_id = idx_e12, .uv = uv_e12 };
-					quad3.corners[2] = { .vertex_id = idx_v2, .uv = uv_v2 };
-					quad3.corners[3] = { .vertex_id = idx_e20, .uv = uv_e20 };
-					quad3.normal = normalize(cross(new_vertices[idx_f] - new_vertices[idx_e20],
-						new_vertices[idx_e12] - new_vertices[idx_f]));
-
-					new_faces.emplace_back(quad1);
-					new_faces.emplace_back(quad2);
-					new_faces.emplace_back(quad3);
-				}
-				else if (f.corners.size() == 4)
-				{
-					//Quad
-					//3           2  
-					//
-					//
-					//
-					//0           1
-
-					//4 quads
-
-					//3    e23    2  
-					//
-					//e30  f     e12
-					//
-					//0   e01     1
-
-					uint v0 = f.corners[0].vertex_id;
-					uint v1 = f.corners[1].vertex_id;
-					uint v2 = f.corners[2].vertex_id;
-					uint v3 = f.corners[3].vertex_id;
-
-					auto e01 = std::make_pair(v0, v1);
-					auto e12 = std::make_pair(v1, v2);
-					auto e23 = std::make_pair(v2, v3);
-					auto e30 = std::make_pair(v3, v0);
-					auto e10 = std::make_pair(v1, v0);
-					auto e21 = std::make_pair(v2, v1);
-					auto e32 = std::make_pair(v3, v2);
-					auto e03 = std::make_pair(v0, v3);
-
-					//check edge vertex
-					uint idx_e01;
-					uint idx_e12;
-					uint idx_e23;
-					uint idx_e30;
-
-					if (process_vertex.find(e01) != process_vertex.end() || process_vertex.find(e10) != process_vertex.end())
-					{
-						if (process_vertex.find(e01) != process_vertex.end())
-							idx_e01 = process_vertex[e01];
-						else
-							idx_e01 = process_vertex[e10];
-					}
+			parallel_for(n_edges, [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+				{
+					auto h = topo.edge_he[i];
+					auto t = topo.he_twin[h];
+					auto sum = vertices[topo.he_vertex[h]] + vertices[topo.dest(h)];
+					if (t == -1)
+						edge_points[i] = sum * 0.5f;
 					else
-					{
-						idx_e01 = vertex_idx;
-
-						auto e10 = std::make_pair(v1, v0);
-
-						process_vertex[e01] = vertex_idx;
-
-						if (edge_points.find(e01) != edge_points.end())
-							new_vertices.emplace_back(edge_points[e01]);
-						else
-							new_vertices.emplace_back(edge_points[e10]);
-
-						++vertex_idx;
-					}
+						edge_points[i] = (sum + face_points[topo.he_face[h]] + face_points[topo.he_face[t]]) * 0.25f;
+				}
+			}, 1024);
 
-					if (process_vertex.find(e12) != process_vertex.end() || process_vertex.find(e21) != process_vertex.end())
-					{
-						if (process_vertex.find(e12) != process_vertex.end())
-							idx_e12 = process_vertex[e12];
-						else
-							idx_e12 = process_vertex[e21];
-					}
+			parallel_for(n_verts, [&](uint begin, uint end) {
+				for (auto v = begin; v < end; v++)
+				{
+					auto& p = vertices[v];
+					auto n = topo.vertex_offsets[v + 1] - topo.vertex_offsets[v];
+					uint border_neighbors[2];
+					auto n_border = get_border_neighbors(topo, v, border_neighbors);
+					if (n == 0 || (n_border > 0 && n_border != 2))
+						vertex_points[v] = p; // isolated or a corner
+					else if (n_border == 2)
+						vertex_points[v] = (vertices[border_neighbors[0]] + p * 6.f + vertices[border_neighbors[1]]) * 0.125f;
 					else
 					{
-						idx_e12 = vertex_idx;
-
-						auto e21 = std::make_pair(v2, v1);
-
-						process_vertex[e12] = vertex_idx;
-
-						if (edge_points.find(e12) != edge_points.end())
-							new_vertices.emplace_back(edge_points[e12]);
-						else
-							new_vertices.emplace_back(edge_points[e21]);
-						++vertex_idx;
+						auto F = vec3(0.f);
+						auto R = vec3(0.f);
+						for (auto i = topo.vertex_offsets[v]; i < topo.vertex_offsets[v + 1]; i++)
+						{
+							auto h = topo.vertex_hes[i];
+							F += face_points[topo.he_face[h]];
+							R += (p + vertices[topo.dest(h)]) * 0.5f;
+						}
+						F /= (float)n;
+						R /= (float)n;
+						vertex_points[v] = (F + R * 2.f + p * (float)(n - 3)) / (float)n;
 					}
+				}
+			}, 1024);
 
-					if (process_vertex.find(e23) != process_vertex.end() || process_vertex.find(e32) != process_vertex.end())
+			// a quad for each corner: the corner, the edge point after it, the face point, the edge point before it
+			oth.faces.resize(topo.he_face.size());
+			parallel_for(n_faces, [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+				{
+					auto& f = faces[i];
+					auto n = (uint)f.corners.size();
+					auto off = topo.face_offsets[i];
+					auto uv_f = vec2(0.f);
+					for (auto& c : f.corners)
+						uv_f += c.uv;
+					uv_f /= (float)n;
+					for (auto j = 0; j < n; j++)
 					{
-						if (process_vertex.find(e23) != process_vertex.end())
-							idx_e23 = process_vertex[e23];
-						else
-							idx_e23 = process_vertex[e32];
-					}
-					else
-					{
-						idx_e23 = vertex_idx;
-
-						auto e32 = std::make_pair(v3, v2);
-
-						process_vertex[e23] = vertex_idx;
-
-						if (edge_points.find(e23) != edge_points.end())
-							new_vertices.emplace_back(edge_points[e23]);
-						else
-							new_vertices.emplace_back(edge_points[e32]);
-
-						++vertex_idx;
+						auto& c = f.corners[j];
+						auto& c_next = f.corners[j + 1 < n ? j + 1 : 0];
+						auto& c_prev = f.corners[j > 0 ? j - 1 : n - 1];
+						auto& q = oth.faces[off + j];
+						q.corners.resize(4);
+						q.corners[0] = { .vertex_id = c.vertex_id, .uv = c.uv };
+						q.corners[1] = { .vertex_id = n_verts + topo.he_edge[off + j], .uv = (c.uv + c_next.uv) * 0.5f };
+						q.corners[2] = { .vertex_id = n_verts + n_edges + i, .uv = uv_f };
+						q.corners[3] = { .vertex_id = n_verts + topo.he_edge[topo.prev(off + j)], .uv = (c_prev.uv + c.uv) * 0.5f };
+						q.normal = get_face_normal(q, oth.vertices);
 					}
+				}
+			}, 256);
+		}
 
-					if (process_vertex.find(e30) != process_vertex.end() || process_vertex.find(e03) != process_vertex.end())
-					{
-						if (process_vertex.find(e30) != process_vertex.end())
-							idx_e30 = process_vertex[e30];
-						else
-							idx_e30 = process_vertex[e03];
-					}
-					else
+		void ControlMesh::subdivide_Loop(ControlMesh& oth)
+		{
+			// loop subdivision is for triangles, other faces are split into fans first
+			if (std::any_of(faces.begin(), faces.end(), [](const Face& f) { return f.corners.size() != 3; }))
+			{
+				ControlMesh triangulated;
+				triangulated.vertices = vertices;
+				triangulated.color = color;
+				for (auto& f : faces)
+				{
+					for (auto i = 1; i + 1 < f.corners.size(); i++)
 					{
-						idx_e30 = vertex_idx;
-
-						auto e03 = std::make_pair(v0, v3);
-
-						process_vertex[e30] = vertex_idx;
-
-						if (edge_points.find(e30) != edge_points.end())
-							new_vertices.emplace_back(edge_points[e30]);
-						else
-							new_vertices.emplace_back(edge_points[e03]);
-						++vertex_idx;
+						auto& t = triangulated.faces.emplace_back();
+						t.corners = { f.corners[0], f.corners[i], f.corners[i + 1] };
+						t.normal = f.normal;
 					}
+				}
+				triangulated.subdivide_Loop(oth);
+				return;
+			}
 
-					//check point vertex
-					uint idx_v0;
-					uint idx_v1;
-					uint idx_v2;
-					uint idx_v3;
-
-					auto p0 = std::make_pair(v0, 0xffffffff);
-					auto p1 = std::make_pair(v1, 0xffffffff);
-					auto p2 = std::make_pair(v2, 0xffffffff);
-					auto p3 = std::make_pair(v3, 0xffffffff);
-
-					if (process_vertex.find(p0) != process_vertex.end())
-						idx_v0 = process_vertex[p0];
-					else
-					{
-						new_vertices.emplace_back(vertex_points[v0]);
-						process_vertex[p0] = vertex_idx;
-						idx_v0 = vertex_idx++;
-					}
+			ControlMeshTopology topo;
+			topo.build(*this);
+			auto n_verts = (uint)vertices.size();
+			auto n_edges = (uint)topo.edge_he.size();
+			auto n_faces = (uint)faces.size();
 
-					if (process_vertex.find(p1) != process_vertex.end())
-						idx_v1 = process_vertex[p1];
-					else
-					{
-						new_vertices.emplace_back(vertex_points[v1]);
-						process_vertex[p1] = vertex_idx;
-						idx_v1 = vertex_idx++;
-					}
+			// new vertices are the vertex points, then the edge points
+			oth.reset();
+			oth.color = color;
+			oth.vertices.resize(n_verts + n_edges);
+			auto vertex_points = oth.vertices.data();
+			auto edge_points = vertex_points + n_verts;
 
-					if (process_vertex.find(p2) != process_vertex.end())
-						idx_v2 = process_vertex[p2];
+			parallel_for(n_edges, [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+				{
+					auto h = topo.edge_he[i];
+					auto t = topo.he_twin[h];
+					auto sum = vertices[topo.he_vertex[h]] + vertices[topo.dest(h)];
+					if (t == -1)
+						edge_points[i] = sum * 0.5f;
 					else
-					{
-						new_vertices.emplace_back(vertex_points[v2]);
-						process_vertex[p2] = vertex_idx;
-						idx_v2 = vertex_idx++;
-					}
+						edge_points[i] = sum * 0.375f + (vertices[topo.he_vertex[topo.prev(h)]] + vertices[topo.he_vertex[topo.prev(t)]]) * 0.125f;
+				}
+			}, 1024);
 
-					if (process_vertex.find(p3) != process_vertex.end())
-						idx_v3 = process_vertex[p3];
+			parallel_for(n_verts, [&](uint begin, uint end) {
+				for (auto v = begin; v < end; v++)
+				{
+					auto& p = vertices[v];
+					auto n = topo.vertex_offsets[v + 1] - topo.vertex_offsets[v];
+					uint border_neighbors[2];
+					auto n_border = get_border_neighbors(topo, v, border_neighbors);
+					if (n == 0 || (n_border > 0 && n_border != 2))
+						vertex_points[v] = p;
+					else if (n_border == 2)
+						vertex_points[v] = (vertices[border_neighbors[0]] + p * 6.f + vertices[border_neighbors[1]]) * 0.125f;
 					else
 					{
-						new_vertices.emplace_back(vertex_points[v3]);
-						process_vertex[p3] = vertex_idx;
-						idx_v3 = vertex_idx++;
+						auto sum = vec3(0.f);
+						for (auto i = topo.vertex_offsets[v]; i < topo.vertex_offsets[v + 1]; i++)
+							sum += vertices[topo.dest(topo.vertex_hes[i])];
+						auto beta = n == 3 ? 3.f / 16.f : 3.f / (8.f * n);
+						vertex_points[v] = p * (1.f - n * beta) + sum * beta;
 					}
-
-					//3    e23    2  
-					//
-					//e30  f     e12
-					//
-					//0   e01     1
-					//Final Add Quads
-
-					auto uv_v0 = f.corners[0].uv;
-					auto uv_v1 = f.corners[0].uv;
-					auto uv_v2 = f.corners[0].uv;
-					auto uv_v3 = f.corners[0].uv;
-
-					auto uv_e01 = (uv_v0 + uv_v1) * 0.5f;
-					auto uv_e12 = (uv_v1 + uv_v2) * 0.5f;
-					auto uv_e23 = (uv_v2 + uv_v3) * 0.5f;
-					auto uv_e30 = (uv_v3 + uv_v0) * 0.5f;
-
-					auto uv_f = (uv_v0 + uv_v1 + uv_v2 + uv_v3) * 0.25f;
-
-					Face quad1;
-					quad1.corners.resize(4);
-					quad1.corners[0] = { .vertex_id = idx_f, .uv = uv_f };
-					quad1.corners[1] = { .vertex_id = idx_e01, .uv = uv_e01 };
-					quad1.corners[2] = { .vertex_id = idx_v0, .uv = uv_v0 };
-					quad1.corners[3] = { .vertex_id = idx_e30, .uv = uv_e30 };
-					quad1.normal = normalize(cross(new_vertices[idx_f] - new_vertices[idx_e30],
-						new_vertices[idx_f] - new_vertices[idx_e01]));
-
-					Face quad2;
-					quad2.corners.resize(4);
-					quad2.corners[0] = { .vertex_id = idx_f, .uv = uv_f };
-					quad2.corners[1] = { .vertex_id = idx_e12, .uv = uv_e12 };
-					quad2.corners[2] = { .vertex_id = idx_v1, .uv = uv_v1 };
-					quad2.corners[3] = { .vertex_id = idx_e01, .uv = uv_e01 };
-					quad2.normal = normalize(cross(new_vertices[idx_f] - new_vertices[idx_e01],
-						new_vertices[idx_f] - new_vertices[idx_e12]));
-
-					Face quad3;
-					quad3.corners.resize(4);
-					quad3.corners[0] = { .vertex_id = idx_f, .uv = uv_f };
-					quad3.corners[1] = { .vertex_id = idx_e23, .uv = uv_e23 };
-					quad3.corners[2] = { .vertex_id = idx_v2, .uv = uv_v2 };
-					quad3.corners[3] = { .vertex_id = idx_e12, .uv = uv_e12 };
-					quad3.normal = normalize(cross(new_vertices[idx_f] - new_vertices[idx_e12],
-						new_vertices[idx_f] - new_vertices[idx_e23]));
-
-					Face quad4;
-					quad4.corners.resize(4);
-					quad4.corners[0] = { .vertex_id = idx_f, .uv = uv_f };
-					quad4.corners[1] = { .vertex_id = idx_e30, .uv = uv_e30 };
-					quad4.corners[2] = { .vertex_id = idx_v3, .uv = uv_v3 };
-					quad4.corners[3] = { .vertex_id = idx_e23, .uv = uv_e23 };
-					quad4.normal = normalize(cross(new_vertices[idx_f] - new_vertices[idx_e23],
-						new_vertices[idx_f] - new_vertices[idx_e30]));
-
-					new_faces.emplace_back(quad1);
-					new_faces.emplace_back(quad2);
-					new_faces.emplace_back(quad3);
-					new_faces.emplace_back(quad4);
 				}
-			}
+			}, 1024);
 
-			oth.vertices = std::move(new_vertices);
-			oth.faces = std::move(new_faces);
-			oth.color = color;
+			// each triangle becomes the three at its corners and the one in the middle
+			oth.faces.resize(n_faces * 4);
+			parallel_for(n_faces, [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+				{
+					auto& f = faces[i];
+					auto off = topo.face_offsets[i];
+					Corner c0 = f.corners[0], c1 = f.corners[1], c2 = f.corners[2];
+					Corner e0 = { .vertex_id = n_verts + topo.he_edge[off + 0], .uv = (c0.uv + c1.uv) * 0.5f };
+					Corner e1 = { .vertex_id = n_verts + topo.he_edge[off + 1], .uv = (c1.uv + c2.uv) * 0.5f };
+					Corner e2 = { .vertex_id = n_verts + topo.he_edge[off + 2], .uv = (c2.uv + c0.uv) * 0.5f };
+					oth.faces[i * 4 + 0].corners = { c0, e0, e2 };
+					oth.faces[i * 4 + 1].corners = { e0, c1, e1 };
+					oth.faces[i * 4 + 2].corners = { e2, e1, c2 };
+					oth.faces[i * 4 + 3].corners = { e0, e1, e2 };
+					for (auto k = 0; k < 4; k++)
+						oth.faces[i * 4 + k].normal = get_face_normal(oth.faces[i * 4 + k], oth.vertices);
+				}
+			}, 256);
 		}
 
-		void ControlMesh::subdivide_Loop(ControlMesh& oth)
+		void ControlMesh::subdivide(ControlMesh& oth, uint levels, bool loop)
 		{
-
+			if (levels == 0)
+			{
+				oth = *this;
+				return;
+			}
+			ControlMesh temp;
+			auto src = this;
+			for (auto i = 0; i < levels; i++)
+			{
+				// ping pong between oth and temp so the last level lands in oth
+				auto& dst = (levels - i) % 2 == 1 ? oth : temp;
+				if (loop)
+					src->subdivide_Loop(dst);
+				else
+					src->subdivide_CatmullClark(dst);
+				src = &dst;
+			}
 		}
 
 		void ControlMesh::loop_cut(ControlMesh& oth, const std::vector<Plane>& planes)
@@ -838,7 +519,62 @@ namespace flame
 
 		void ControlMesh::decimate(float ratio)
 		{
+			// a vertex for each distinct (vertex, uv) so uv seams are seen by simplify_mesh
+			Mesh mesh;
+			std::vector<uint> vertex_ids;
+			std::vector<std::vector<std::pair<vec2, uint>>> vertex_uvs(vertices.size());
+			auto get_vertex = [&](const Corner& c) {
+				for (auto& i : vertex_uvs[c.vertex_id])
+				{
+					if (i.first == c.uv)
+						return i.second;
+				}
+				auto id = (uint)mesh.positions.size();
+				mesh.positions.push_back(vertices[c.vertex_id]);
+				mesh.uvs.push_back(c.uv);
+				vertex_ids.push_back(c.vertex_id);
+				vertex_uvs[c.vertex_id].emplace_back(c.uv, id);
+				return id;
+			};
+			for (auto& f : faces)
+			{
+				auto v0 = get_vertex(f.corners[0]);
+				for (auto i = 1; i + 1 < f.corners.size(); i++)
+				{
+					mesh.indices.push_back(v0);
+					mesh.indices.push_back(get_vertex(f.corners[i]));
+					mesh.indices.push_back(get_vertex(f.corners[i + 1]));
+				}
+			}
 
+			std::vector<uint> indices;
+			simplify_mesh(mesh, indices, (uint)(mesh.indices.size() * clamp(ratio, 0.f, 1.f)) / 3 * 3);
+
+			// only keep the vertices still in use
+			std::vector<int> new_ids(vertices.size(), -1);
+			std::vector<vec3> new_vertices;
+			faces.clear();
+			for (auto i = 0; i < indices.size(); i += 3)
+			{
+				auto& f = faces.emplace_back();
+				f.corners.resize(3);
+				for (auto k = 0; k < 3; k++)
+				{
+					auto v = indices[i + k];
+					auto& id = new_ids[vertex_ids[v]];
+					if (id == -1)
+					{
+						id = new_vertices.size();
+						new_vertices.push_back(mesh.positions[v]);
+					}
+					f.corners[k] = { .vertex_id = (uint)id, .uv = mesh.uvs[v] };
+				}
+				auto n = cross(new_vertices[f.corners[1].vertex_id] - new_vertices[f.corners[0].vertex_id],
+					new_vertices[f.corners[2].vertex_id] - new_vertices[f.corners[0].vertex_id]);
+				auto l = length(n);
+				f.normal = l > 0.f ? n / l : vec3(0.f, 1.f, 0.f);
+			}
+			vertices = std::move(new_vertices);
 		}
 
 		void ControlMesh::displace(ControlMesh& oth, Texture* ptexture)
@@ -890,5 +626,828 @@ namespace flame
 					oth.vertices[f.corners[2].vertex_id] - oth.vertices[f.corners[1].vertex_id]));
 			}
 		}
+
+		// Forsyth's linear-speed vertex cache optimization
+		static void optimize_vertex_cache(std::vector<uint>& indices, uint vertices_count)
+		{
+			const auto CacheSize = 32;
+			const auto CacheDecayPower = 1.5f;
+			const auto LastTriScore = 0.75f;
+			const auto ValenceBoostScale = 2.f;
+			const auto ValenceBoostPower = 0.5f;
+
+			auto tris_count = (uint)indices.size() / 3;
+			std::vector<uint> valence(vertices_count, 0); // triangles not emitted yet
+			for (auto i : indices)
+				valence[i]++;
+			std::vector<uint> adj_offsets(vertices_count + 1, 0);
+			for (auto v = 0; v < vertices_count; v++)
+				adj_offsets[v + 1] = adj_offsets[v] + valence[v];
+			std::vector<uint> adj(indices.size());
+			{
+				std::vector<uint> fill(vertices_count, 0);
+				for (auto t = 0; t < tris_count; t++)
+				{
+					for (auto k = 0; k < 3; k++)
+					{
+						auto v = indices[t * 3 + k];
+						adj[adj_offsets[v] + fill[v]++] = t;
+					}
+				}
+			}
+
+			std::vector<int> cache_pos(vertices_count, -1);
+			auto vertex_score = [&](uint v) {
+				if (valence[v] == 0)
+					return -1.f;
+				auto ret = 0.f;
+				auto p = cache_pos[v];
+				if (p >= 0)
+					ret = p < 3 ? LastTriScore : pow(1.f - (p - 3) / float(CacheSize - 3), CacheDecayPower);
+				ret += ValenceBoostScale * pow((float)valence[v], -ValenceBoostPower);
+				return ret;
+			};
+			std::vector<float> vscores(vertices_count);
+			for (auto v = 0; v < vertices_count; v++)
+				vscores[v] = vertex_score(v);
+			std::vector<float> tscores(tris_count);
+			std::vector<bool> emitted(tris_count, false);
+			auto best = -1;
+			auto best_score = -1.f;
+			for (auto t = 0; t < tris_count; t++)
+			{
+				tscores[t] = vscores[indices[t * 3 + 0]] + vscores[indices[t * 3 + 1]] + vscores[indices[t * 3 + 2]];
+				if (tscores[t] > best_score)
+				{
+					best_score = tscores[t];
+					best = t;
+				}
+			}
+
+			std::vector<uint> out;
+			out.reserve(indices.size());
+			std::vector<uint> cache, new_cache;
+			auto next_scan = 0U;
+			while (out.size() < indices.size())
+			{
+				if (best < 0)
+				{
+					// nothing connected to the cache is left, take any remaining triangle
+					while (emitted[next_scan])
+						next_scan++;
+					best = next_scan;
+				}
+				emitted[best] = true;
+				uint tv[3] = { indices[best * 3 + 0], indices[best * 3 + 1], indices[best * 3 + 2] };
+				for (auto k = 0; k < 3; k++)
+				{
+					auto v = tv[k];
+					out.push_back(v);
+					// remove the triangle from the remaining ones of the vertex
+					auto beg = adj.begin() + adj_offsets[v];
+					auto it = std::find(beg, beg + valence[v], (uint)best);
+					if (it != beg + valence[v])
+					{
+						std::iter_swap(it, beg + valence[v] - 1);
+						valence[v]--;
+					}
+				}
+
+				new_cache.clear();
+				for (auto k = 0; k < 3; k++)
+				{
+					if (std::find(new_cache.begin(), new_cache.end(), tv[k]) == new_cache.end())
+						new_cache.push_back(tv[k]);
+				}
+				for (auto v : cache)
+				{
+					if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end())
+						new_cache.push_back(v);
+				}
+				for (auto i = 0; i < new_cache.size(); i++)
+					cache_pos[new_cache[i]] = i < CacheSize ? i : -1;
+				for (auto v : new_cache)
+					vscores[v] = vertex_score(v);
+				if (new_cache.size() > CacheSize)
+					new_cache.resize(CacheSize);
+				std::swap(cache, new_cache);
+
+				best = -1;
+				best_score = -1.f;
+				for (auto v : new_cache) // the old cache, includes the vertices that just dropped out
+				{
+					for (auto i = 0; i < valence[v]; i++)
+					{
+						auto t = adj[adj_offsets[v] + i];
+						tscores[t] = vscores[indices[t * 3 + 0]] + vscores[indices[t * 3 + 1]] + vscores[indices[t * 3 + 2]];
+					}
+				}
+				for (auto v : cache)
+				{
+					for (auto i = 0; i < valence[v]; i++)
+					{
+						auto t = adj[adj_offsets[v] + i];
+						tscores[t] = vscores[indices[t * 3 + 0]] + vscores[indices[t * 3 + 1]] + vscores[indices[t * 3 + 2]];
+						if (tscores[t] > best_score)
+						{
+							best_score = tscores[t];
+							best = t;
+						}
+					}
+				}
+			}
+			indices = std::move(out);
+		}
+
+		// cut the triangles into clusters where the cache is still doing well, then draw the clusters that face outwards first
+		static void optimize_overdraw(std::vector<uint>& indices, const std::vector<vec3>& positions, float threshold)
+		{
+			const auto CacheSize = 16U;
+			const auto MinClusterSize = 16U;
+			auto tris_count = (uint)indices.size() / 3;
+			if (tris_count <= MinClusterSize)
+				return;
+
+			std::vector<uint> fifo(CacheSize);
+			auto head = 0U;
+			auto fetch = [&](uint v) {
+				if (std::find(fifo.begin(), fifo.end(), v) != fifo.end())
+					return 0U;
+				fifo[head] = v;
+				head = (head + 1) % CacheSize;
+				return 1U;
+			};
+			auto reset_cache = [&]() {
+				std::fill(fifo.begin(), fifo.end(), 0xffffffff);
+				head = 0;
+			};
+
+			reset_cache();
+			auto total_misses = 0U;
+			for (auto i = 0; i < tris_count * 3; i++)
+				total_misses += fetch(indices[i]);
+			auto limit = threshold * total_misses / tris_count;
+
+			// the clusters are drawn in any order later, so each one is measured from a cold cache
+			std::vector<std::pair<uint, uint>> clusters; // first triangle, triangles count
+			auto first = 0U;
+			auto cluster_misses = 0U;
+			reset_cache();
+			for (auto t = 0; t < tris_count; t++)
+			{
+				for (auto k = 0; k < 3; k++)
+					cluster_misses += fetch(indices[t * 3 + k]);
+				auto n = t - first + 1;
+				if (n >= MinClusterSize && cluster_misses <= limit * n)
+				{
+					clusters.emplace_back(first, n);
+					first = t + 1;
+					cluster_misses = 0;
+					reset_cache();
+				}
+			}
+			if (first < tris_count)
+				clusters.emplace_back(first, tris_count - first);
+			if (clusters.size() < 2)
+				return;
+
+			auto mesh_center = vec3(0.f);
+			for (auto i : indices)
+				mesh_center += positions[i];
+			mesh_center /= (float)indices.size();
+
+			std::vector<std::pair<float, uint>> sorted(clusters.size());
+			for (auto c = 0; c < clusters.size(); c++)
+			{
+				auto center = vec3(0.f);
+				auto normal = vec3(0.f);
+				auto area = 0.f;
+				for (auto t = clusters[c].first; t < clusters[c].first + clusters[c].second; t++)
+				{
+					auto& p0 = positions[indices[t * 3 + 0]];
+					auto& p1 = positions[indices[t * 3 + 1]];
+					auto& p2 = positions[indices[t * 3 + 2]];
+					auto n = cross(p1 - p0, p2 - p0); // area weighted
+					auto a = length(n);
+					center += (p0 + p1 + p2) * a;
+					normal += n;
+					area += a;
+				}
+				auto l = length(normal);
+				if (area > 0.f && l > 0.f)
+					sorted[c] = { dot(center / (3.f * area) - mesh_center, normal / l), c };
+				else
+					sorted[c] = { 0.f, c };
+			}
+			std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+				return a.first > b.first;
+			});
+
+			std::vector<uint> out;
+			out.reserve(indices.size());
+			for (auto& s : sorted)
+			{
+				auto& c = clusters[s.second];
+				out.insert(out.end(), indices.begin() + c.first * 3, indices.begin() + (c.first + c.second) * 3);
+			}
+			indices = std::move(out);
+		}
+
+		template<typename T>
+		static void remap_vertices(std::vector<T>& vec, const std::vector<uint>& new_to_old)
+		{
+			if (vec.empty())
+				return;
+			std::vector<T> out(new_to_old.size());
+			for (auto i = 0; i < new_to_old.size(); i++)
+				out[i] = vec[new_to_old[i]];
+			vec = std::move(out);
+		}
+
+		void optimize_mesh(Mesh& mesh, float overdraw_threshold)
+		{
+			if (mesh.indices.size() < 3)
+				return;
+			mesh.unpack();
+			optimize_vertex_cache(mesh.indices, mesh.positions.size());
+			if (overdraw_threshold >= 1.f)
+				optimize_overdraw(mesh.indices, mesh.positions, overdraw_threshold);
+
+			// vertex fetch, unreferenced vertices are dropped
+			std::vector<int> old_to_new(mesh.positions.size(), -1);
+			std::vector<uint> new_to_old;
+			new_to_old.reserve(mesh.positions.size());
+			for (auto& i : mesh.indices)
+			{
+				if (old_to_new[i] == -1)
+				{
+					old_to_new[i] = new_to_old.size();
+					new_to_old.push_back(i);
+				}
+				i = old_to_new[i];
+			}
+			remap_vertices(mesh.positions, new_to_old);
+			remap_vertices(mesh.uvs, new_to_old);
+			remap_vertices(mesh.normals, new_to_old);
+			remap_vertices(mesh.tangents, new_to_old);
+			remap_vertices(mesh.colors, new_to_old);
+			remap_vertices(mesh.bone_ids, new_to_old);
+			remap_vertices(mesh.bone_weights, new_to_old);
+			// the meshlets refer to the old order
+			mesh.meshlets.clear();
+			mesh.meshlet_vertices.clear();
+			mesh.meshlet_triangles.clear();
+		}
+
+		float get_mesh_acmr(const Mesh& mesh, uint cache_size)
+		{
+			auto tris_count = mesh.indices.size() / 3;
+			if (tris_count == 0)
+				return 0.f;
+			std::vector<uint> fifo(cache_size, 0xffffffff);
+			auto head = 0U;
+			auto misses = 0U;
+			for (auto i = 0; i < tris_count * 3; i++)
+			{
+				auto v = mesh.indices[i];
+				if (std::find(fifo.begin(), fifo.end(), v) == fifo.end())
+				{
+					fifo[head] = v;
+					head = (head + 1) % cache_size;
+					misses++;
+				}
+			}
+			return (float)misses / tris_count;
+		}
+
+		void build_meshlets(Mesh& mesh, uint max_vertices, uint max_triangles)
+		{
+			max_vertices = clamp(max_vertices, 3U, 256U); // local indices are bytes
+			max_triangles = max(max_triangles, 1U);
+			mesh.meshlets.clear();
+			mesh.meshlet_vertices.clear();
+			mesh.meshlet_triangles.clear();
+
+			std::vector<int> local(mesh.positions.size(), -1);
+			Meshlet current;
+			memset(&current, 0, sizeof(current));
+			auto finish = [&]() {
+				if (current.triangle_count == 0)
+					return;
+
+				AABB bounds;
+				for (auto i = 0; i < current.vertex_count; i++)
+				{
+					auto v = mesh.meshlet_vertices[current.vertex_offset + i];
+					bounds.expand(mesh.positions[v]);
+					local[v] = -1;
+				}
+				current.center = bounds.center();
+				current.radius = 0.f;
+				for (auto i = 0; i < current.vertex_count; i++)
+					current.radius = max(current.radius, distance(current.center, mesh.positions[mesh.meshlet_vertices[current.vertex_offset + i]]));
+
+				std::vector<vec3> normals;
+				auto axis = vec3(0.f);
+				for (auto t = 0; t < current.triangle_count; t++)
+				{
+					auto tri = mesh.meshlet_triangles.data() + current.triangle_offset + t * 3;
+					auto& a = mesh.positions[mesh.meshlet_vertices[current.vertex_offset + tri[0]]];
+					auto& b = mesh.positions[mesh.meshlet_vertices[current.vertex_offset + tri[1]]];
+					auto& c = mesh.positions[mesh.meshlet_vertices[current.vertex_offset + tri[2]]];
+					auto n = cross(b - a, c - a);
+					auto l = length(n);
+					if (l > 1e-12f)
+					{
+						normals.push_back(n / l);
+						axis += normals.back();
+					}
+				}
+				current.cone_axis = vec3(0.f);
+				current.cone_cutoff = 1.f;
+				if (auto l = length(axis); l > 1e-6f)
+				{
+					axis /= l;
+					auto min_dp = 1.f;
+					for (auto& n : normals)
+						min_dp = min(min_dp, dot(axis, n));
+					current.cone_axis = axis;
+					// the normals spread too wide to ever be all back facing
+					if (min_dp > 0.1f)
+						current.cone_cutoff = sqrt(1.f - min_dp * min_dp);
+				}
+
+				mesh.meshlets.push_back(current);
+				current.vertex_offset = mesh.meshlet_vertices.size();
+				current.triangle_offset = mesh.meshlet_triangles.size();
+				current.vertex_count = 0;
+				current.triangle_count = 0;
+			};
+
+			for (auto t = 0; t + 2 < mesh.indices.size(); t += 3)
+			{
+				uint tv[3] = { mesh.indices[t + 0], mesh.indices[t + 1], mesh.indices[t + 2] };
+				auto new_vertices = 0U;
+				for (auto k = 0; k < 3; k++)
+				{
+					if (local[tv[k]] == -1 && (k == 0 || tv[k] != tv[0]) && (k < 2 || tv[k] != tv[1]))
+						new_vertices++;
+				}
+				if (current.vertex_count + new_vertices > max_vertices || current.triangle_count + 1 > max_triangles)
+					finish();
+				for (auto k = 0; k < 3; k++)
+				{
+					auto v = tv[k];
+					if (local[v] == -1)
+					{
+						local[v] = current.vertex_count++;
+						mesh.meshlet_vertices.push_back(v);
+					}
+					mesh.meshlet_triangles.push_back(local[v]);
+				}
+				current.triangle_count++;
+			}
+			finish();
+		}
+
+		// symmetric 4x4 matrix of the sum of squared distances to planes, w is the total weight so errors are averages
+		struct Quadric
+		{
+			double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+			double w = 0;
+
+			void add_plane(const vec3& n, float d, float weight)
+			{
+				xx += weight * n.x * n.x; xy += weight * n.x * n.y; xz += weight * n.x * n.z; xw += weight * n.x * d;
+				yy += weight * n.y * n.y; yz += weight * n.y * n.z; yw += weight * n.y * d;
+				zz += weight * n.z * n.z; zw += weight * n.z * d;
+				ww += weight * d * d;
+				w += weight;
+			}
+
+			void add(const Quadric& o)
+			{
+				xx += o.xx; xy += o.xy; xz += o.xz; xw += o.xw;
+				yy += o.yy; yz += o.yz; yw += o.yw;
+				zz += o.zz; zw += o.zw;
+				ww += o.ww;
+				w += o.w;
+			}
+
+			double error(const vec3& p) const
+			{
+				double x = p.x, y = p.y, z = p.z;
+				auto e = xx * x * x + 2 * xy * x * y + 2 * xz * x * z + 2 * xw * x +
+					yy * y * y + 2 * yz * y * z + 2 * yw * y +
+					zz * z * z + 2 * zw * z + ww;
+				return w > 0 ? abs(e) / w : 0;
+			}
+		};
+
+		float simplify_mesh(const Mesh& mesh, std::vector<uint>& dst, uint target_index_count, float target_error)
+		{
+			auto& positions = mesh.positions;
+			auto nv = (uint)positions.size();
+			dst = mesh.indices;
+			dst.resize(dst.size() / 3 * 3);
+			if (dst.size() <= target_index_count || nv == 0)
+				return 0.f;
+
+			// weld the vertices by position, the vertices at one position are its wedges, they differ in the other attributes
+			std::vector<uint> reps(nv), next_wedge(nv);
+			{
+				std::vector<uint> order(nv);
+				std::iota(order.begin(), order.end(), 0);
+				std::sort(order.begin(), order.end(), [&](uint a, uint b) {
+					return memcmp(&positions[a], &positions[b], sizeof(vec3)) < 0;
+				});
+				for (auto i = 0; i < nv; )
+				{
+					auto j = i + 1;
+					while (j < nv && positions[order[j]] == positions[order[i]])
+						j++;
+					for (auto k = i; k < j; k++)
+					{
+						reps[order[k]] = order[i];
+						next_wedge[order[k]] = order[k + 1 < j ? k + 1 : i];
+					}
+					i = j;
+				}
+			}
+
+			std::vector<Quadric> quadrics(nv);
+			std::vector<uint> vmap(nv), rmap(nv);
+			std::iota(vmap.begin(), vmap.end(), 0);
+			std::iota(rmap.begin(), rmap.end(), 0);
+			std::vector<uint> vt_offsets, vt_list;
+			std::vector<uchar> borders, seams, locked;
+			auto max_error = 0.0;
+			auto target_error2 = (double)target_error * target_error;
+
+			// half edges are found through the triangles around their first vertex, no hashing
+			auto has_rep_edge = [&](uint ra, uint rb) {
+				for (auto i = vt_offsets[ra]; i < vt_offsets[ra + 1]; i++)
+				{
+					auto tri = dst.data() + vt_list[i] * 3;
+					for (auto k = 0; k < 3; k++)
+					{
+						if (reps[tri[k]] == ra && reps[tri[(k + 1) % 3]] == rb)
+							return true;
+					}
+				}
+				return false;
+			};
+			auto has_vtx_edge = [&](uint a, uint b) {
+				auto ra = reps[a];
+				for (auto i = vt_offsets[ra]; i < vt_offsets[ra + 1]; i++)
+				{
+					auto tri = dst.data() + vt_list[i] * 3;
+					for (auto k = 0; k < 3; k++)
+					{
+						if (tri[k] == a && tri[(k + 1) % 3] == b)
+							return true;
+					}
+				}
+				return false;
+			};
+			auto is_border_edge = [&](uint ra, uint rb) {
+				return !has_rep_edge(ra, rb) || !has_rep_edge(rb, ra);
+			};
+
+			// the adjacency of this round
+			auto build_adjacency = [&]() {
+				auto n_tris = (uint)dst.size() / 3;
+				vt_offsets.assign(nv + 1, 0);
+				for (auto v : dst)
+					vt_offsets[reps[v] + 1]++;
+				for (auto i = 0; i < nv; i++)
+					vt_offsets[i + 1] += vt_offsets[i];
+				vt_list.resize(dst.size());
+				std::vector<uint> fill(vt_offsets.begin(), vt_offsets.end() - 1);
+				for (auto t = 0; t < n_tris; t++)
+				{
+					for (auto k = 0; k < 3; k++)
+						vt_list[fill[reps[dst[t * 3 + k]]]++] = t;
+				}
+
+				// border edges have no opposite half edge, seam edges have one only when welded
+				borders.assign(nv, 0);
+				seams.assign(nv, 0);
+				for (auto t = 0; t < n_tris; t++)
+				{
+					for (auto k = 0; k < 3; k++)
+					{
+						auto a = dst[t * 3 + k], b = dst[t * 3 + (k + 1) % 3];
+						auto ra = reps[a], rb = reps[b];
+						if (!has_rep_edge(rb, ra))
+						{
+							borders[ra]++;
+							borders[rb]++;
+						}
+						else if (!has_vtx_edge(b, a))
+						{
+							seams[ra]++;
+							seams[rb]++;
+						}
+					}
+				}
+				// corners of borders or seams cannot move, seam edges are counted from both sides
+				locked.assign(nv, 0);
+				for (auto i = 0; i < nv; i++)
+				{
+					if (borders[i] > 2 || seams[i] > 4 || (borders[i] && seams[i]))
+						locked[i] = 1;
+				}
+			};
+
+			build_adjacency();
+			for (auto t = 0; t < dst.size(); t += 3)
+			{
+				auto& p0 = positions[dst[t + 0]];
+				auto& p1 = positions[dst[t + 1]];
+				auto& p2 = positions[dst[t + 2]];
+				auto n = cross(p1 - p0, p2 - p0);
+				auto l = length(n);
+				if (l < 1e-12f)
+					continue;
+				n /= l;
+				auto area = l * 0.5f;
+				for (auto k = 0; k < 3; k++)
+					quadrics[reps[dst[t + k]]].add_plane(n, -dot(n, p0), area);
+
+				// planes through the border and seam edges and perpendicular to the triangle, to keep their shape
+				for (auto k = 0; k < 3; k++)
+				{
+					auto a = dst[t + k], b = dst[t + (k + 1) % 3];
+					auto ra = reps[a], rb = reps[b];
+					if (has_rep_edge(rb, ra) && has_vtx_edge(b, a))
+						continue;
+					auto e = positions[b] - positions[a];
+					auto el = length(e);
+					if (el < 1e-12f)
+						continue;
+					auto pn = normalize(cross(e, n));
+					auto weight = el * el * 2.f;
+					quadrics[ra].add_plane(pn, -dot(pn, positions[a]), weight);
+					quadrics[rb].add_plane(pn, -dot(pn, positions[a]), weight);
+				}
+			}
+
+			struct Collapse
+			{
+				double cost;
+				uint from;
+				uint to;
+			};
+			std::vector<Collapse> collapses;
+			std::vector<uchar> touched(nv, 0);
+			std::vector<uint> u_neighbors, v_neighbors;
+
+			while (dst.size() > target_index_count)
+			{
+				// candidates are the edges, each in its cheaper allowed direction
+				collapses.clear();
+				for (auto i = 0; i < dst.size(); i++)
+				{
+					auto a = reps[dst[i]], b = reps[dst[i % 3 == 2 ? i - 2 : i + 1]];
+					if (a > b && has_rep_edge(b, a))
+						continue;
+					auto allowed = [&](uint u, uint v) {
+						if (locked[u])
+							return false;
+						if (borders[u])
+							return borders[v] && is_border_edge(u, v);
+						if (seams[u])
+							return seams[v] != 0;
+						return true;
+					};
+					Collapse c;
+					c.cost = std::numeric_limits<double>::max();
+					if (allowed(a, b))
+					{
+						auto q = quadrics[a];
+						q.add(quadrics[b]);
+						c = { q.error(positions[b]), a, b };
+					}
+					if (allowed(b, a))
+					{
+						auto q = quadrics[a];
+						q.add(quadrics[b]);
+						if (auto cost = q.error(positions[a]); cost < c.cost)
+							c = { cost, b, a };
+					}
+					if (c.cost <= target_error2)
+						collapses.push_back(c);
+				}
+				std::sort(collapses.begin(), collapses.end(), [](const auto& a, const auto& b) {
+					return a.cost < b.cost;
+				});
+
+				// each collapse removes about two triangles, a vertex moves at most once in a round
+				auto tris_to_remove = (uint)(dst.size() - target_index_count + 2) / 3;
+				auto removed = 0U;
+				std::fill(touched.begin(), touched.end(), 0);
+				for (auto& c : collapses)
+				{
+					if (removed >= tris_to_remove)
+						break;
+					auto u = c.from, v = c.to;
+					if (touched[u] || touched[v])
+						continue;
+
+					auto ok = true;
+					auto shared_tris = 0U;
+					u_neighbors.clear();
+					v_neighbors.clear();
+					for (auto i = vt_offsets[u]; i < vt_offsets[u + 1] && ok; i++)
+					{
+						auto t = vt_list[i];
+						uint r[3];
+						for (auto k = 0; k < 3; k++)
+						{
+							r[k] = rmap[reps[dst[t * 3 + k]]];
+							if (r[k] != u)
+								u_neighbors.push_back(r[k]);
+						}
+						if (r[0] == r[1] || r[1] == r[2] || r[2] == r[0])
+							continue;
+						if (r[0] == v || r[1] == v || r[2] == v)
+						{
+							shared_tris++;
+							continue;
+						}
+						// the triangle must not flip or become a sliver after u moves to v
+						vec3 ps[3];
+						for (auto k = 0; k < 3; k++)
+							ps[k] = positions[r[k]];
+						auto n0 = cross(ps[1] - ps[0], ps[2] - ps[0]);
+						for (auto k = 0; k < 3; k++)
+						{
+							if (r[k] == u)
+								ps[k] = positions[v];
+						}
+						auto n1 = cross(ps[1] - ps[0], ps[2] - ps[0]);
+						if (dot(n0, n1) <= 0.25f * length(n0) * length(n1))
+							ok = false;
+					}
+					if (!ok)
+						continue;
+					for (auto i = vt_offsets[v]; i < vt_offsets[v + 1]; i++)
+					{
+						auto t = vt_list[i];
+						for (auto k = 0; k < 3; k++)
+						{
+							auto r = rmap[reps[dst[t * 3 + k]]];
+							if (r != v)
+								v_neighbors.push_back(r);
+						}
+					}
+					// the link condition: the vertices next to both u and v are exactly the ones of the triangles on the edge
+					std::sort(u_neighbors.begin(), u_neighbors.end());
+					u_neighbors.erase(std::unique(u_neighbors.begin(), u_neighbors.end()), u_neighbors.end());
+					std::sort(v_neighbors.begin(), v_neighbors.end());
+					v_neighbors.erase(std::unique(v_neighbors.begin(), v_neighbors.end()), v_neighbors.end());
+					auto common = 0U;
+					for (auto i = 0, j = 0; i < u_neighbors.size() && j < v_neighbors.size(); )
+					{
+						if (u_neighbors[i] < v_neighbors[j])
+							i++;
+						else if (u_neighbors[i] > v_neighbors[j])
+							j++;
+						else
+						{
+							if (u_neighbors[i] != v)
+								common++;
+							i++;
+							j++;
+						}
+					}
+					if (shared_tris == 0 || common != shared_tris)
+						continue;
+
+					// every wedge of u goes to the wedge of v it shares a triangle with, if one has none the uvs would tear
+					auto w = u;
+					do
+					{
+						auto target = -1;
+						auto used = false;
+						for (auto i = vt_offsets[u]; i < vt_offsets[u + 1] && target == -1; i++)
+						{
+							auto t = vt_list[i];
+							auto has_w = false;
+							auto v_wedge = -1;
+							for (auto k = 0; k < 3; k++)
+							{
+								auto x = dst[t * 3 + k];
+								if (x == w)
+									has_w = true;
+								else if (rmap[reps[x]] == v)
+									v_wedge = vmap[x];
+							}
+							if (has_w)
+							{
+								used = true;
+								target = v_wedge;
+							}
+						}
+						if (used && target == -1)
+						{
+							ok = false;
+							break;
+						}
+						w = next_wedge[w];
+					} while (w != u);
+					if (!ok)
+						continue;
+					w = u;
+					do
+					{
+						for (auto i = vt_offsets[u]; i < vt_offsets[u + 1]; i++)
+						{
+							auto t = vt_list[i];
+							auto has_w = false;
+							auto v_wedge = -1;
+							for (auto k = 0; k < 3; k++)
+							{
+								auto x = dst[t * 3 + k];
+								if (x == w)
+									has_w = true;
+								else if (rmap[reps[x]] == v)
+									v_wedge = vmap[x];
+							}
+							if (has_w && v_wedge != -1)
+							{
+								vmap[w] = v_wedge;
+								break;
+							}
+						}
+						w = next_wedge[w];
+					} while (w != u);
+
+					rmap[u] = v;
+					quadrics[v].add(quadrics[u]);
+					touched[u] = touched[v] = 1;
+					removed += shared_tris;
+					max_error = max(max_error, c.cost);
+				}
+				if (removed == 0)
+					break;
+
+				// apply the collapses and drop the degenerate triangles
+				auto n = 0U;
+				for (auto t = 0; t < dst.size(); t += 3)
+				{
+					auto a = vmap[dst[t + 0]], b = vmap[dst[t + 1]], c = vmap[dst[t + 2]];
+					if (reps[a] == reps[b] || reps[b] == reps[c] || reps[c] == reps[a])
+						continue;
+					dst[n++] = a;
+					dst[n++] = b;
+					dst[n++] = c;
+				}
+				dst.resize(n);
+				build_adjacency();
+			}
+
+			return (float)sqrt(max_error);
+		}
+
+		void build_mesh_lods(Mesh& mesh, uint levels, float ratio)
+		{
+			mesh.lods.clear();
+			mesh.lod_indices.clear();
+
+			std::vector<uint> indices;
+			auto last_count = (uint)mesh.indices.size();
+			Mesh source;
+			source.positions = mesh.positions;
+			for (auto i = 0; i < levels; i++)
+			{
+				// simplify from the previous level, so each level is cheaper than the last
+				source.indices = i == 0 ? mesh.indices : std::vector<uint>(mesh.lod_indices.end() - last_count, mesh.lod_indices.end());
+				auto target = (uint)(last_count * ratio) / 3 * 3;
+				auto error = simplify_mesh(source, indices, target);
+				// stop when it cannot get much smaller
+				if (indices.empty() || indices.size() > last_count * 0.9f)
+					break;
+
+				optimize_vertex_cache(indices, mesh.positions.size());
+
+				auto& lod = mesh.lods.emplace_back();
+				lod.index_offset = mesh.lod_indices.size();
+				lod.index_count = indices.size();
+				// errors add up since each level is simplified from the last
+				lod.error = error + (mesh.lods.size() > 1 ? mesh.lods[mesh.lods.size() - 2].error : 0.f);
+				mesh.lod_indices.insert(mesh.lod_indices.end(), indices.begin(), indices.end());
+				last_count = indices.size();
+			}
+		}
+
+		void build_model_lods(ModelPtr model, uint levels, float ratio)
+		{
+			parallel_for((uint)model->meshes.size(), [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+					build_mesh_lods(model->meshes[i], levels, ratio);
+			}, 1);
+		}
 	}
 }
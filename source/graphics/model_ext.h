@@ -8,6 +8,41 @@ namespace flame
 {
 	namespace graphics
 	{
+		struct ControlMesh;
+
+		// half edge adjacency of a control mesh, the half edges of a face are contiguous and in corner order,
+		//  so the half edge of corner j of face f is face_offsets[f] + j, it goes from that corner to the next
+		struct ControlMeshTopology
+		{
+			std::vector<uint> face_offsets; // faces count + 1
+			std::vector<uint> he_face;
+			std::vector<uint> he_vertex; // the vertex it starts from
+			std::vector<int> he_twin; // -1 on borders
+			std::vector<uint> he_edge;
+			std::vector<uint> edge_he; // the first half edge of each edge
+			std::vector<uint> vertex_offsets; // vertices count + 1, into vertex_hes
+			std::vector<uint> vertex_hes; // the half edges going out of each vertex
+
+			inline uint next(uint h) const
+			{
+				auto f = he_face[h];
+				return h + 1 == face_offsets[f + 1] ? face_offsets[f] : h + 1;
+			}
+
+			inline uint prev(uint h) const
+			{
+				auto f = he_face[h];
+				return h == face_offsets[f] ? face_offsets[f + 1] - 1 : h - 1;
+			}
+
+			inline uint dest(uint h) const
+			{
+				return he_vertex[next(h)];
+			}
+
+			FLAME_GRAPHICS_API void build(const ControlMesh& mesh);
+		};
+
 		struct ControlMesh
 		{
 			struct Corner
@@ -35,10 +70,15 @@ namespace flame
 			void init_as_cube(const vec3& extent);
 			void init_as_cone(float radius, float depth, uint vertices_number);
 
-			void subdivide_CatmullClark(ControlMesh& oth);
-			void subdivide_Loop(ControlMesh& oth);
+			// every pass of the subdivisions runs in parallel over faces, edges or vertices, the adjacency comes from ControlMeshTopology
+			//  borders are kept as cubic b-splines
+			FLAME_GRAPHICS_API void subdivide_CatmullClark(ControlMesh& oth);
+			// faces that are not triangles are split into fans first
+			FLAME_GRAPHICS_API void subdivide_Loop(ControlMesh& oth);
+			FLAME_GRAPHICS_API void subdivide(ControlMesh& oth, uint levels, bool loop = false);
 			void loop_cut(ControlMesh& oth, const std::vector<Plane>& planes);
-			void decimate(float ratio);
+			// keep about ratio of the triangles, faces become triangles
+			FLAME_GRAPHICS_API void decimate(float ratio);
 
 			void displace(ControlMesh& oth, Texture* ptexture);
 
@@ -75,8 +115,26 @@ namespace flame
 			}
 		};
 
+		// reorder the triangles for the post-transform vertex cache, then reorder clusters of them from outside in to cut overdraw,
+		//  clusters are only cut where the cache misses stay under overdraw_threshold times the average, at last reorder the vertices by first use
+		FLAME_GRAPHICS_API void optimize_mesh(Mesh& mesh, float overdraw_threshold = 1.05f);
+		// average cache misses per triangle of a fifo cache, about 0.6 is good for regular meshes and 3 is the worst
+		FLAME_GRAPHICS_API float get_mesh_acmr(const Mesh& mesh, uint cache_size = 16);
+		// split the triangles (in their current order) into meshlets and compute their bounding spheres and normal cones
+		FLAME_GRAPHICS_API void build_meshlets(Mesh& mesh, uint max_vertices = 64, uint max_triangles = 124);
+
+		// quadric error edge collapse until the indices are under target_index_count or the error would pass target_error,
+		//  vertices are only moved onto their neighbors so the result uses the vertices of the mesh, uv seams and borders only collapse along themselves
+		//  returns the error in object space
+		FLAME_GRAPHICS_API float simplify_mesh(const Mesh& mesh, std::vector<uint>& dst_indices, uint target_index_count, float target_error = std::numeric_limits<float>::max());
+		// each level has about ratio of the triangles of the last one, stops early if a level cannot get smaller
+		FLAME_GRAPHICS_API void build_mesh_lods(Mesh& mesh, uint levels = 4, float ratio = 0.5f);
+		// the meshes are done in parallel
+		FLAME_GRAPHICS_API void build_model_lods(ModelPtr model, uint levels = 4, float ratio = 0.5f);
+
 		inline void mesh_add_cube(Mesh& mesh, const vec3& extent, const vec3& center, const mat3& rotation)
 		{
+			mesh.unpack();
 			mesh.positions.push_back(rotation * vec3(-0.5f, +0.5f, +0.5f) * extent + center);
 			mesh.positions.push_back(rotation * vec3(+0.5f, +0.5f, +0.5f) * extent + center);
 			mesh.positions.push_back(rotation * vec3(+0.5f, -0.5f, +0.5f) * extent + center);
@@ -146,6 +204,7 @@ namespace flame
 
 		inline void mesh_add_sphere(Mesh& mesh, float radius, uint horiSubdiv, uint vertSubdiv, const vec3& center, const mat3& rotation)
 		{
+			mesh.unpack();
 			std::vector<std::vector<int>> staging_indices;
 			staging_indices.resize(horiSubdiv + 1);
 
@@ -222,6 +281,7 @@ namespace flame
 
 		inline void mesh_add_cylinder(Mesh& mesh, float radius, float height, uint subdiv, const vec3& center)
 		{
+			mesh.unpack();
 			auto hf_height = height * 0.5f;
 			// top cap
 			auto top_center = vec3(0.f, +hf_height, 0.f);
@@ -1,14 +1,77 @@
 #pragma once
 
+#include "../foundation/pack.h"
 #include "model.h"
 
 namespace flame
 {
 	namespace graphics
 	{
+		// the packed model format ("fmodp"), all offsets are from the start of the file and aligned to 16
+		struct PackedModelHeader
+		{
+			char magic[8];
+			uint version;
+			uint meshes_count;
+			uint bones_count;
+			uint names_size;
+			AABB bounds;
+			uint64 meshes_offset; // PackedMeshHeader x meshes_count
+			uint64 bones_offset; // PackedBone x bones_count
+			uint64 names_offset;
+		};
+
+		struct PackedMeshHeader
+		{
+			uint vertices_count;
+			uint indices_count;
+			uint armature; // PackedVertexArm instead of PackedVertex
+			uint meshlets_count;
+			uint meshlet_vertices_count;
+			uint meshlet_triangles_size;
+			uint lods_count;
+			uint lod_indices_count;
+			AABB bounds;
+			uint64 vertices_offset;
+			uint64 indices_offset;
+			uint64 meshlets_offset;
+			uint64 meshlet_vertices_offset;
+			uint64 meshlet_triangles_offset;
+			uint64 lods_offset;
+			uint64 lod_indices_offset;
+		};
+
+		// version 1, before the lods
+		struct PackedMeshHeaderV1
+		{
+			uint vertices_count;
+			uint indices_count;
+			uint armature;
+			uint meshlets_count;
+			uint meshlet_vertices_count;
+			uint meshlet_triangles_size;
+			AABB bounds;
+			uint64 vertices_offset;
+			uint64 indices_offset;
+			uint64 meshlets_offset;
+			uint64 meshlet_vertices_offset;
+			uint64 meshlet_triangles_offset;
+		};
+
+		struct PackedBone
+		{
+			uint name_offset;
+			uint name_length;
+			mat4 offset_matrix;
+		};
+
 		struct ModelPrivate : Model
 		{
+			std::unique_ptr<MappedFile> mapped; // packed vertices of the meshes point into it
+
 			void save(const std::filesystem::path& filename, bool binary) override;
+			void save_packed(const std::filesystem::path& filename) override;
+			bool load_packed(std::string_view data);
 		};
 	}
 }
@@ -190,6 +190,7 @@ namespace flame
 			}
 
 			finished_fence->wait();
+			released_buffers.clear();
 			commandbuffer->calc_executed_time();
 			//printf("%lfms\n", (double)commandbuffer->last_executed_time / (double)1000000);
 
@@ -205,6 +206,9 @@ namespace flame
 
 			auto queue = graphics::Queue::get();
 			queue->submit1(commandbuffer.get(), swapchain->image_avalible.get(), finished_semaphore.get(), finished_fence.get());
+			for (auto& b : buffers_to_release)
+				released_buffers.push_back(std::move(b));
+			buffers_to_release.clear();
 			queue->present(swapchain.get(), finished_semaphore.get());
 
 			dirty = false;
@@ -24,6 +24,7 @@ namespace flame
 			std::unique_ptr<CommandBufferPrivate> commandbuffer;
 			std::unique_ptr<FencePrivate> finished_fence;
 			std::unique_ptr<SemaphorePrivate> finished_semaphore;
+			std::vector<std::unique_ptr<BufferPrivate>> released_buffers; // by the last submitted frame, destroyed when its fence signals
 
 			WindowPrivate(NativeWindowPtr native);
 			~WindowPrivate();
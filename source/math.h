@@ -523,6 +523,22 @@ namespace flame
 			else if (center.y > b.z) d += square(center.y - b.z);
 			return square(radius) > d;
 		}
+
+		// slab test, the ray is origin + dir * t, out_t is the entering t (0 if the origin is inside)
+		bool intersects_ray(const vec3& origin, const vec3& inv_dir, float max_t = 10000.f, float* out_t = nullptr) const
+		{
+			auto t0 = (a - origin) * inv_dir;
+			auto t1 = (b - origin) * inv_dir;
+			auto tmin = min(t0, t1);
+			auto tmax = max(t0, t1);
+			auto t_enter = max(max(tmin.x, tmin.y), max(tmin.z, 0.f));
+			auto t_exit = min(min(tmax.x, tmax.y), min(tmax.z, max_t));
+			if (t_enter > t_exit)
+				return false;
+			if (out_t)
+				*out_t = t_enter;
+			return true;
+		}
 	};
 
 	struct Plane
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "../foundation/foundation.h"
+#include "../graphics/animation.h"
+
+#include <immintrin.h>
+
+namespace flame
+{
+	// local transforms of the bones of an armature, positions and rotations are in separate arrays so they are blended with SSE
+	struct LocalPose
+	{
+		std::vector<vec4> positions; // w is unused
+		std::vector<quat> rotations;
+		std::vector<uchar> animated; // bones that have a track, only they are written to the nodes
+
+		void resize(uint n)
+		{
+			positions.assign(n, vec4(0.f));
+			rotations.assign(n, quat(1.f, 0.f, 0.f, 0.f));
+			animated.assign(n, 0);
+		}
+	};
+
+	// an animation prepared for sampling, the keys of a track are in separate time and value arrays and tracks are bound to bone indices
+	//  all armatures of one model share it
+	struct AnimationClip
+	{
+		struct Track
+		{
+			uint bone_idx;
+			std::vector<float> position_times;
+			std::vector<vec3> positions;
+			std::vector<float> rotation_times;
+			std::vector<quat> rotations;
+		};
+
+		float duration = 0.f;
+		uint bones_count = 0;
+		std::vector<Track> tracks;
+
+		void build(const graphics::Animation& animation, const std::vector<std::string>& bone_names)
+		{
+			duration = animation.duration;
+			bones_count = bone_names.size();
+			tracks.clear();
+
+			auto find_bone = [&](std::string_view name) {
+				for (auto i = 0; i < bone_names.size(); i++)
+				{
+					if (bone_names[i] == name)
+						return i;
+					auto sp = SUS::split(bone_names[i], ':');
+					if (sp.size() == 2 && sp[1] == name)
+						return i;
+				}
+				return -1;
+			};
+			for (auto& ch : animation.channels)
+			{
+				auto id = find_bone(ch.node_name);
+				if (id == -1)
+				{
+					auto sp = SUS::split(ch.node_name, ':');
+					if (sp.size() == 2)
+						id = find_bone(sp[1]);
+				}
+				if (id == -1)
+					continue;
+
+				auto& t = tracks.emplace_back();
+				t.bone_idx = id;
+				for (auto& k : ch.position_keys)
+				{
+					t.position_times.push_back(k.t);
+					t.positions.push_back(k.p);
+				}
+				// loop back to the first key at the end
+				if (!t.positions.empty() && t.position_times.back() < duration)
+				{
+					t.position_times.push_back(duration);
+					t.positions.push_back(t.positions.front());
+				}
+				for (auto& k : ch.rotation_keys)
+				{
+					t.rotation_times.push_back(k.t);
+					t.rotations.push_back(k.q);
+				}
+				if (!t.rotations.empty() && t.rotation_times.back() < duration)
+				{
+					t.rotation_times.push_back(duration);
+					t.rotations.push_back(t.rotations.front());
+				}
+			}
+		}
+	};
+
+	// the last keys used by the tracks of a clip, two per track (position and rotation)
+	struct AnimationCursor
+	{
+		std::vector<uint> keys;
+	};
+
+	// the key k that times[k] <= t < times[k + 1] (clamped to both ends)
+	//  time mostly moves forward a little, so the cursor and the next key are tried before a binary search
+	inline uint find_key(const std::vector<float>& times, float t, uint cursor)
+	{
+		auto n = (uint)times.size();
+		if (cursor < n && times[cursor] <= t)
+		{
+			if (cursor + 1 >= n || t < times[cursor + 1])
+				return cursor;
+			if (cursor + 2 >= n || t < times[cursor + 2])
+				return cursor + 1;
+		}
+		return max((int)(std::upper_bound(times.begin(), times.end(), t) - times.begin()) - 1, 0);
+	}
+
+	inline void sample_clip(const AnimationClip& clip, float time, AnimationCursor& cursor, LocalPose& pose)
+	{
+		if (pose.positions.size() != clip.bones_count)
+			pose.resize(clip.bones_count);
+		cursor.keys.resize(clip.tracks.size() * 2, 0);
+
+		auto factor = [&](const std::vector<float>& times, uint k) {
+			if (k + 1 >= times.size() || time <= times[k])
+				return 0.f;
+			return min((time - times[k]) / (times[k + 1] - times[k]), 1.f);
+		};
+		for (auto i = 0; i < clip.tracks.size(); i++)
+		{
+			auto& t = clip.tracks[i];
+			if (!t.positions.empty())
+			{
+				auto k = find_key(t.position_times, time, cursor.keys[i * 2 + 0]);
+				cursor.keys[i * 2 + 0] = k;
+				auto f = factor(t.position_times, k);
+				pose.positions[t.bone_idx] = vec4(f > 0.f ? mix(t.positions[k], t.positions[k + 1], f) : t.positions[k], 0.f);
+			}
+			if (!t.rotations.empty())
+			{
+				auto k = find_key(t.rotation_times, time, cursor.keys[i * 2 + 1]);
+				cursor.keys[i * 2 + 1] = k;
+				auto f = factor(t.rotation_times, k);
+				pose.rotations[t.bone_idx] = f > 0.f ? slerp(t.rotations[k], t.rotations[k + 1], f) : t.rotations[k];
+			}
+			pose.animated[t.bone_idx] = 1;
+		}
+	}
+
+	// dst = mix(a, b, t) for the bones that b animates, the others are copied from a
+	//  rotations are nlerped along the shorter arc, dst can be a
+	inline void blend_poses(const LocalPose& a, const LocalPose& b, float t, LocalPose& dst)
+	{
+		auto n = (uint)b.positions.size();
+		assert(a.positions.size() == n);
+		if (&dst != &a)
+			dst = a;
+
+		auto t4 = _mm_set1_ps(t);
+		auto sign_mask = _mm_set1_ps(-0.f);
+		for (auto i = 0; i < n; i++)
+		{
+			if (!b.animated[i])
+				continue;
+
+			auto pa = _mm_loadu_ps(&a.positions[i].x);
+			auto pb = _mm_loadu_ps(&b.positions[i].x);
+			_mm_storeu_ps(&dst.positions[i].x, _mm_add_ps(pa, _mm_mul_ps(_mm_sub_ps(pb, pa), t4)));
+
+			auto qa = _mm_loadu_ps(&a.rotations[i].x);
+			auto qb = _mm_loadu_ps(&b.rotations[i].x);
+			auto d = _mm_mul_ps(qa, qb);
+			d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+			d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+			// flip b to the same hemisphere as a
+			qb = _mm_xor_ps(qb, _mm_and_ps(d, sign_mask));
+			auto q = _mm_add_ps(qa, _mm_mul_ps(_mm_sub_ps(qb, qa), t4));
+			auto l = _mm_mul_ps(q, q);
+			l = _mm_add_ps(l, _mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 0, 3, 2)));
+			l = _mm_add_ps(l, _mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 3, 0, 1)));
+			_mm_storeu_ps(&dst.rotations[i].x, _mm_div_ps(q, _mm_sqrt_ps(l)));
+			dst.animated[i] = 1;
+		}
+	}
+
+	// poses of clips sampled at quantized times, instances that play the same clip at about the same time share one
+	//  entries are only added and removed on one thread, sampling into new entries can be done in parallel
+	struct PoseCache
+	{
+		struct Entry
+		{
+			LocalPose pose;
+			uint frame;
+		};
+
+		float buckets_per_second = 120.f;
+		std::map<std::pair<const AnimationClip*, int>, Entry> entries;
+		uint frame = 0;
+
+		inline float bucket_time(float time) const
+		{
+			return floor(time * buckets_per_second) / buckets_per_second;
+		}
+
+		// is_new is true if the pose needs to be sampled (at bucket_time(time))
+		Entry& get(const AnimationClip* clip, float time, bool& is_new)
+		{
+			auto [it, inserted] = entries.try_emplace({ clip, (int)floor(time * buckets_per_second) });
+			is_new = inserted;
+			it->second.frame = frame;
+			return it->second;
+		}
+
+		// drops the poses that are not used in the last frames
+		void new_frame(uint keep_frames = 2)
+		{
+			frame++;
+			std::erase_if(entries, [&](const auto& i) {
+				return frame - i.second.frame > keep_frames;
+			});
+		}
+
+		// call when a clip is destroyed
+		void remove(const AnimationClip* clip)
+		{
+			std::erase_if(entries, [&](const auto& i) {
+				return i.first.first == clip;
+			});
+		}
+	};
+}
@@ -1,5 +1,6 @@
 #include "../../../foundation/blueprint.h"
 #include "../../../foundation/typeinfo.h"
+#include "../../../foundation/frame_arena.h"
 #include "../../entity_private.h"
 #include "../../world_private.h"
 #include "../../components/node_private.h"
@@ -51,7 +52,7 @@ namespace flame
 			[](uint inputs_count, BlueprintAttribute* inputs, uint outputs_count, BlueprintAttribute* outputs) {
 				auto entity = *(EntityPtr*)inputs[0].data;
 				if (entity)
-					entity->name = *(std::string*)inputs[1].data;
+					entity->set_name(*(std::string*)inputs[1].data);
 			}
 		);
 
@@ -205,7 +206,7 @@ namespace flame
 					parent->add_child(e);
 				else
 					printf("A free entity is created! Please remember to destroy it\n");
-				e->name = *(std::string*)inputs[1].data;
+				e->set_name(*(std::string*)inputs[1].data);
 			}
 		);
 
@@ -455,13 +456,25 @@ namespace flame
 			},
 			[](uint inputs_count, BlueprintAttribute* inputs, uint outputs_count, BlueprintAttribute* outputs) {
 				auto parent = *(EntityPtr*)inputs[0].data;
-				auto name = *(std::string*)inputs[1].data;
+				auto& name = *(std::string*)inputs[1].data;
 				if (!name.empty())
 				{
-					if (parent)
-						*(EntityPtr*)outputs[0].data = parent->find_child_recursively(name);
+					// a name with '/' is a path
+					if (name.find('/') != std::string::npos)
+					{
+						if (parent)
+							*(EntityPtr*)outputs[0].data = parent->find_child_by_path(name);
+						else
+							*(EntityPtr*)outputs[0].data = World::instance()->find_entity_by_path(name);
+					}
 					else
-						*(EntityPtr*)outputs[0].data = World::instance()->root->find_child_recursively(name);
+					{
+						auto hash = sh(name.c_str());
+						if (parent)
+							*(EntityPtr*)outputs[0].data = parent->find_child_recursively_h(hash);
+						else
+							*(EntityPtr*)outputs[0].data = World::instance()->root->find_child_recursively_h(hash);
+					}
 				}
 				else
 					*(EntityPtr*)outputs[0].data = nullptr;
@@ -1330,7 +1343,7 @@ namespace flame
 				auto any_filter = *(uint*)inputs[2].data;
 				auto all_filter = *(uint*)inputs[3].data;
 				auto parent_search_times = *(uint*)inputs[4].data;
-				std::vector<std::pair<EntityPtr, cNodePtr>> res;
+				FrameVector<std::pair<EntityPtr, cNodePtr>> res;
 				sScene::instance()->octree->get_colliding(location, radius, res, any_filter, all_filter, parent_search_times);
 
 				if (res.empty())
@@ -1339,7 +1352,7 @@ namespace flame
 					*(EntityPtr*)outputs[0].data = res[0].first;
 				else
 				{
-					std::vector<std::pair<float, EntityPtr>> nodes_with_distance(res.size());
+					FrameVector<std::pair<float, EntityPtr>> nodes_with_distance(res.size());
 					for (auto i = 0; i < res.size(); i++)
 						nodes_with_distance[i] = std::make_pair(distance(res[i].second->global_pos(), location), res[i].first);
 					std::sort(nodes_with_distance.begin(), nodes_with_distance.end(), [](const auto& a, const auto& b) {
@@ -1389,12 +1402,12 @@ namespace flame
 				auto any_filter = *(uint*)inputs[2].data;
 				auto all_filter = *(uint*)inputs[3].data;
 				auto parent_search_times = *(uint*)inputs[4].data;
-				std::vector<std::pair<EntityPtr, cNodePtr>> res;
+				FrameVector<std::pair<EntityPtr, cNodePtr>> res;
 				sScene::instance()->octree->get_colliding(location, radius, res, any_filter, all_filter, parent_search_times);
 
 				*(EntityPtr*)outputs[0].data = nullptr;
 
-				std::vector<std::pair<float, EntityPtr>> nodes_with_distance(res.size());
+				FrameVector<std::pair<float, EntityPtr>> nodes_with_distance(res.size());
 				for (auto i = 0; i < res.size(); i++)
 					nodes_with_distance[i] = std::make_pair(distance(res[i].second->global_pos(), location), res[i].first);
 				std::sort(nodes_with_distance.begin(), nodes_with_distance.end(), [](const auto& a, const auto& b) {
@@ -1610,10 +1623,10 @@ namespace flame
 				auto any_filter = *(uint*)inputs[2].data;
 				auto all_filter = *(uint*)inputs[3].data;
 				auto parent_search_times = *(uint*)inputs[4].data;
-				std::vector<std::pair<EntityPtr, cNodePtr>> res;
+				FrameVector<std::pair<EntityPtr, cNodePtr>> res;
 				sScene::instance()->octree->get_colliding(location, radius, res, any_filter, all_filter, parent_search_times);
 
-				std::vector<std::pair<float, EntityPtr>> nodes_with_distance(res.size());
+				FrameVector<std::pair<float, EntityPtr>> nodes_with_distance(res.size());
 				for (auto i = 0; i < res.size(); i++)
 					nodes_with_distance[i] = std::make_pair(distance(res[i].second->global_pos(), location), res[i].first);
 				std::sort(nodes_with_distance.begin(), nodes_with_distance.end(), [](const auto& a, const auto& b) {
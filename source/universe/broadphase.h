@@ -0,0 +1,383 @@
+#pragma once
+
+#include "../foundation/foundation.h"
+
+#include <bit>
+#include <immintrin.h>
+
+namespace flame
+{
+	// the overlapping pairs of many spheres, found by one sort and sweep pass every frame
+	//  the space is cut into strips along the axis that the spheres spread the second most on, as wide as the largest sphere, so a sphere touches at most two strips
+	//  the spheres are sorted by strip and then by their min on the axis they spread the most on, and each strip is swept against itself and the next one
+	//  the order is kept between frames, so the insertion sort has little to do
+	//  the bodies are kept in arrays by field
+	//  a sphere may reach further than its radius (expand), so one may see the other and not the other way, each way is a contact of its own
+	//  the contacts persist between frames, so a contact is reported once when it begins (entered), every frame it lasts (stayed) and once when it ends (exited)
+	//  a reported contact is the slot that sees and the slot that is seen, (sensor << 32) | other
+	//  a pair is the two slots and the ways they see each other, (lo << 34) | (hi << 2) | ways, bit 1 is lo sees hi and bit 2 is hi sees lo, so slots are less than 1 << 30
+	struct SphereBroadphase
+	{
+		// by slot
+		std::vector<float> xs;
+		std::vector<float> ys;
+		std::vector<float> zs;
+		std::vector<float> radii;
+		std::vector<float> expands;
+		std::vector<void*> users; // null for a free slot
+		std::vector<uint> free_slots;
+
+		int sweep_axis = -1;
+		int strip_axis = -1;
+		float strip_width = 0.f;
+		uint added = 0; // since the last update, many new ones are sorted from scratch
+		std::vector<uint> order; // the used slots, sorted
+		// by the index in order, the floats have 3 more at the end, so 4 lanes can be loaded from the last one
+		std::vector<uint64> keys; // (strip << 32) | min on the sweep axis, both as bits that sort like the values
+		std::vector<float> sorted_mins;
+		std::vector<float> sorted_maxs;
+		std::vector<float> sorted_xs;
+		std::vector<float> sorted_ys;
+		std::vector<float> sorted_zs;
+		std::vector<float> sorted_radii;
+		std::vector<float> sorted_expands;
+		std::vector<uint> strip_begins; // into order, one more at the end
+		std::vector<std::vector<uint64>> strip_pairs;
+
+		std::vector<uint64> pairs; // sorted
+		std::vector<uint64> last_pairs;
+		std::vector<uint64> temp;
+		std::vector<uint64> entered;
+		std::vector<uint64> stayed;
+		std::vector<uint64> exited;
+
+		static inline uint pair_lo(uint64 pair) { return pair >> 34; }
+		static inline uint pair_hi(uint64 pair) { return (pair >> 2) & 0xffffffff; }
+		static inline uint contact_sensor(uint64 contact) { return contact >> 32; }
+		static inline uint contact_other(uint64 contact) { return contact & 0xffffffff; }
+		static inline uint64 make_contact(uint sensor, uint other) { return ((uint64)sensor << 32) | other; }
+
+		// ways: bit 1 is id0 sees id1, bit 2 is id1 sees id0
+		static inline uint64 make_pair(uint id0, uint id1, uint ways)
+		{
+			return id0 < id1 ? ((uint64)id0 << 34) | ((uint64)id1 << 2) | ways :
+				((uint64)id1 << 34) | ((uint64)id0 << 2) | ((ways & 1) << 1) | (ways >> 1);
+		}
+
+		// the contacts of the pair that are in ways
+		static inline void add_contacts(uint64 pair, uint ways, std::vector<uint64>& dst)
+		{
+			auto lo = pair_lo(pair), hi = pair_hi(pair);
+			if (ways & 1)
+				dst.push_back(make_contact(lo, hi));
+			if (ways & 2)
+				dst.push_back(make_contact(hi, lo));
+		}
+
+		// the bits of a float that sort like the float
+		static inline uint sortable_bits(float v)
+		{
+			auto bits = std::bit_cast<uint>(v);
+			return bits ^ ((bits & 0x80000000) ? 0xffffffff : 0x80000000);
+		}
+
+		uint add(void* user)
+		{
+			uint id;
+			if (!free_slots.empty())
+			{
+				id = free_slots.back();
+				free_slots.pop_back();
+			}
+			else
+			{
+				id = users.size();
+				xs.push_back(0.f);
+				ys.push_back(0.f);
+				zs.push_back(0.f);
+				radii.push_back(0.f);
+				expands.push_back(0.f);
+				users.push_back(nullptr);
+			}
+			xs[id] = ys[id] = zs[id] = radii[id] = expands[id] = 0.f;
+			users[id] = user;
+			order.push_back(id);
+			added++;
+			return id;
+		}
+
+		// the contacts of the others with the slot end, they are added to exited (which is cleared on the next update) for the caller to report now
+		//  the contacts of the slot itself end without an exit
+		void remove(uint id)
+		{
+			users[id] = nullptr;
+			free_slots.push_back(id);
+			std::erase(order, id);
+			std::erase_if(pairs, [&](uint64 p) {
+				if (pair_lo(p) == id)
+				{
+					add_contacts(p, (uint)p & 2, exited);
+					return true;
+				}
+				if (pair_hi(p) == id)
+				{
+					add_contacts(p, (uint)p & 1, exited);
+					return true;
+				}
+				return false;
+			});
+		}
+
+		// a sphere sees the others that are closer than radius + expand + their radius
+		inline void set(uint id, const vec3& pos, float radius, float expand = 0.f)
+		{
+			xs[id] = pos.x;
+			ys[id] = pos.y;
+			zs[id] = pos.z;
+			radii[id] = radius;
+			expands[id] = expand;
+		}
+
+		void update()
+		{
+			auto n = (uint)order.size();
+			last_pairs.swap(pairs);
+			pairs.clear();
+
+			if (n > 1)
+			{
+				// the sweep axis is the one with the largest variance, the strips go along the second
+				float sum[3] = { 0.f, 0.f, 0.f }, sum2[3] = { 0.f, 0.f, 0.f };
+				auto max_radius = 0.f;
+				for (auto id : order)
+				{
+					sum[0] += xs[id];
+					sum[1] += ys[id];
+					sum[2] += zs[id];
+					sum2[0] += xs[id] * xs[id];
+					sum2[1] += ys[id] * ys[id];
+					sum2[2] += zs[id] * zs[id];
+					max_radius = max(max_radius, radii[id] + expands[id]);
+				}
+				float variance[3];
+				for (auto i = 0; i < 3; i++)
+					variance[i] = sum2[i] / n - (sum[i] / n) * (sum[i] / n);
+				auto resort = added * 8 > n;
+				// they change only when others are clearly better, since the order is then sorted again
+				auto best = variance[0] >= variance[1] ? (variance[0] >= variance[2] ? 0 : 2) : (variance[1] >= variance[2] ? 1 : 2);
+				if (sweep_axis == -1 || (best != sweep_axis && variance[best] > variance[sweep_axis] * 1.5f))
+				{
+					sweep_axis = best;
+					strip_axis = -1;
+				}
+				auto second = variance[(sweep_axis + 1) % 3] >= variance[(sweep_axis + 2) % 3] ? (sweep_axis + 1) % 3 : (sweep_axis + 2) % 3;
+				if (strip_axis == -1 || (second != strip_axis && variance[second] > variance[strip_axis] * 1.5f))
+				{
+					strip_axis = second;
+					resort = true;
+				}
+				// a power of two, so it stays the same while the radii change a little
+				auto width = exp2(ceil(log2(max(max_radius * 2.f, 1e-3f))));
+				if (width != strip_width)
+				{
+					strip_width = width;
+					resort = true;
+				}
+				added = 0;
+
+				// the passes by sphere split across the workers
+				auto for_ranges = [n](uint count, const std::function<void(uint, uint)>& f) {
+					if (n >= 2048)
+						parallel_for(count, f, 1024);
+					else
+						f(0, count);
+				};
+
+				auto& sweep_ps = sweep_axis == 0 ? xs : (sweep_axis == 1 ? ys : zs);
+				auto& strip_ps = strip_axis == 0 ? xs : (strip_axis == 1 ? ys : zs);
+				keys.resize(n);
+				for_ranges(n, [&](uint begin, uint end) {
+					for (auto i = begin; i < end; i++)
+					{
+						auto id = order[i];
+						auto strip = (uint)(int)floor(strip_ps[id] / strip_width) ^ 0x80000000;
+						keys[i] = ((uint64)strip << 32) | sortable_bits(sweep_ps[id] - radii[id] - expands[id]);
+					}
+				});
+				if (resort)
+				{
+					std::vector<uint> sorted(n);
+					for (auto i = 0; i < n; i++)
+						sorted[i] = i;
+					std::sort(sorted.begin(), sorted.end(), [&](uint a, uint b) {
+						return keys[a] < keys[b];
+					});
+					std::vector<uint64> old_keys(keys);
+					std::vector<uint> old_order(order);
+					for (auto i = 0; i < n; i++)
+					{
+						keys[i] = old_keys[sorted[i]];
+						order[i] = old_order[sorted[i]];
+					}
+				}
+				else
+				{
+					// the order of the last frame is almost sorted, the chunks are sorted on their own first,
+					//  then the last pass only moves the few that cross a chunk
+					auto insertion_sort = [&](uint begin, uint end) {
+						for (auto i = begin + 1; i < end; i++)
+						{
+							auto key = keys[i];
+							if (keys[i - 1] <= key)
+								continue;
+							auto id = order[i];
+							auto j = i;
+							for (; j > begin && keys[j - 1] > key; j--)
+							{
+								keys[j] = keys[j - 1];
+								order[j] = order[j - 1];
+							}
+							keys[j] = key;
+							order[j] = id;
+						}
+					};
+					if (n >= 2048)
+					{
+						const auto chunk = 1024U;
+						parallel_for((n + chunk - 1) / chunk, [&](uint begin, uint end) {
+							for (auto c = begin; c < end; c++)
+								insertion_sort(c * chunk, min((c + 1) * chunk, n));
+						}, 1);
+					}
+					insertion_sort(0, n);
+				}
+
+				sorted_mins.resize(n + 3);
+				sorted_maxs.resize(n + 3);
+				sorted_xs.resize(n + 3);
+				sorted_ys.resize(n + 3);
+				sorted_zs.resize(n + 3);
+				sorted_radii.resize(n + 3);
+				sorted_expands.resize(n + 3);
+				for_ranges(n, [&](uint begin, uint end) {
+					for (auto i = begin; i < end; i++)
+					{
+						auto id = order[i];
+						auto reach = radii[id] + expands[id];
+						sorted_mins[i] = sweep_ps[id] - reach;
+						sorted_maxs[i] = sweep_ps[id] + reach;
+						sorted_xs[i] = xs[id];
+						sorted_ys[i] = ys[id];
+						sorted_zs[i] = zs[id];
+						sorted_radii[i] = radii[id];
+						sorted_expands[i] = expands[id];
+					}
+				});
+				strip_begins.clear();
+				for (auto i = 0; i < n; i++)
+				{
+					if (i == 0 || (keys[i] >> 32) != (keys[i - 1] >> 32))
+						strip_begins.push_back(i);
+				}
+				auto strips_count = (uint)strip_begins.size();
+				strip_begins.push_back(n);
+
+				// each strip against itself and the next one
+				if (strip_pairs.size() < strips_count)
+					strip_pairs.resize(strips_count);
+				auto sweep = [&](uint t) {
+					auto& dst = strip_pairs[t];
+					dst.clear();
+					auto begin = strip_begins[t], end = strip_begins[t + 1];
+					auto has_next = t + 1 < strips_count && (keys[end] >> 32) == (keys[begin] >> 32) + 1;
+					auto next_end = has_next ? strip_begins[t + 2] : end;
+					auto p_min = sorted_mins.data(), p_max = sorted_maxs.data();
+					auto ps_x = sorted_xs.data(), ps_y = sorted_ys.data(), ps_z = sorted_zs.data(), rs = sorted_radii.data(), es = sorted_expands.data();
+					auto lanes = _mm_setr_epi32(0, 1, 2, 3);
+					// i against the ones from j that begin before i ends, four at a time
+					auto test = [&](uint i, uint j, uint e) {
+						auto max_v = _mm_set1_ps(p_max[i]);
+						auto x = _mm_set1_ps(ps_x[i]), y = _mm_set1_ps(ps_y[i]), z = _mm_set1_ps(ps_z[i]);
+						auto r = _mm_set1_ps(rs[i]), reach = _mm_set1_ps(rs[i] + es[i]);
+						auto id0 = order[i];
+						while (j < e)
+						{
+							auto in = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(p_min + j), max_v),
+								_mm_castsi128_ps(_mm_cmplt_epi32(_mm_add_epi32(_mm_set1_epi32(j), lanes), _mm_set1_epi32(e))));
+							auto dx = _mm_sub_ps(x, _mm_loadu_ps(ps_x + j));
+							auto dy = _mm_sub_ps(y, _mm_loadu_ps(ps_y + j));
+							auto dz = _mm_sub_ps(z, _mm_loadu_ps(ps_z + j));
+							auto d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+							auto rj = _mm_loadu_ps(rs + j);
+							auto r0 = _mm_add_ps(reach, rj), r1 = _mm_add_ps(_mm_add_ps(r, rj), _mm_loadu_ps(es + j));
+							auto sees0 = _mm_movemask_ps(_mm_and_ps(in, _mm_cmplt_ps(d2, _mm_mul_ps(r0, r0))));
+							auto sees1 = _mm_movemask_ps(_mm_and_ps(in, _mm_cmplt_ps(d2, _mm_mul_ps(r1, r1))));
+							for (auto bits = sees0 | sees1; bits; bits &= bits - 1)
+							{
+								auto u = std::countr_zero((uint)bits);
+								dst.push_back(make_pair(id0, order[j + u], ((sees0 >> u) & 1) | (((sees1 >> u) & 1) << 1)));
+							}
+							if (_mm_movemask_ps(in) != 0xf)
+								break;
+							j += 4;
+						}
+					};
+					auto k = end;
+					for (auto i = begin; i < end; i++)
+					{
+						test(i, i + 1, end);
+						// the ones that end before this one begins cannot touch the ones after this one either
+						auto min_v = p_min[i];
+						while (k < next_end && p_max[k] <= min_v)
+							k++;
+						test(i, k, next_end);
+					}
+				};
+				if (n >= 2048)
+				{
+					parallel_for(strips_count, [&](uint begin, uint end) {
+						for (auto t = begin; t < end; t++)
+							sweep(t);
+					}, 4);
+				}
+				else
+				{
+					for (auto t = 0; t < strips_count; t++)
+						sweep(t);
+				}
+				for (auto t = 0; t < strips_count; t++)
+					pairs.insert(pairs.end(), strip_pairs[t].begin(), strip_pairs[t].end());
+				temp.resize(pairs.size());
+				radix_sort(pairs.data(), temp.data(), pairs.size());
+			}
+
+			// both are sorted by the slots, merge them, the ways of a pair in both may differ
+			entered.clear();
+			stayed.clear();
+			exited.clear();
+			auto i = 0, j = 0;
+			while (i < pairs.size() || j < last_pairs.size())
+			{
+				if (j == last_pairs.size() || (i < pairs.size() && (pairs[i] >> 2) < (last_pairs[j] >> 2)))
+				{
+					add_contacts(pairs[i], (uint)pairs[i] & 3, entered);
+					i++;
+				}
+				else if (i == pairs.size() || (last_pairs[j] >> 2) < (pairs[i] >> 2))
+				{
+					add_contacts(last_pairs[j], (uint)last_pairs[j] & 3, exited);
+					j++;
+				}
+				else
+				{
+					auto now = (uint)pairs[i] & 3, last = (uint)last_pairs[j] & 3;
+					add_contacts(pairs[i], now & ~last, entered);
+					add_contacts(pairs[i], now & last, stayed);
+					add_contacts(pairs[i], last & ~now, exited);
+					i++;
+					j++;
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "../foundation/foundation.h"
+
+#include <immintrin.h>
+
+namespace flame
+{
+	// bounding volume hierarchy over the triangles of a mesh, for ray casting on the CPU
+	//  built with binned SAH, the boxes of both children are tested with SSE while walking down
+	struct MeshBvh
+	{
+		struct Node
+		{
+			vec3 a;
+			uint first; // first triangle for leaves, left child for interior nodes (right child is first + 1)
+			vec3 b;
+			uint count; // 0 for interior nodes
+		};
+
+		std::vector<Node> nodes;
+		std::vector<uint> triangles; // original triangle ids in leaf order
+		std::vector<vec3> vertices; // three per triangle in leaf order, so a leaf is read linearly
+
+		static float half_area(const AABB& b)
+		{
+			auto d = b.b - b.a;
+			return d.x * d.y + d.y * d.z + d.z * d.x;
+		}
+
+		void build(const vec3* positions, const uint* indices, uint indices_count)
+		{
+			nodes.clear();
+			triangles.clear();
+			vertices.clear();
+
+			auto n_tris = indices_count / 3;
+			if (n_tris == 0)
+				return;
+
+			std::vector<AABB> tri_bounds(n_tris);
+			std::vector<vec3> centroids(n_tris);
+			triangles.resize(n_tris);
+			for (auto i = 0; i < n_tris; i++)
+			{
+				auto& bd = tri_bounds[i];
+				bd.reset();
+				bd.expand(positions[indices[i * 3 + 0]]);
+				bd.expand(positions[indices[i * 3 + 1]]);
+				bd.expand(positions[indices[i * 3 + 2]]);
+				centroids[i] = bd.center();
+				triangles[i] = i;
+			}
+
+			const auto BinsCount = 12;
+			const auto MaxLeafSize = 8U;
+			const auto MaxDepth = 60U; // keeps the traversal stack fixed
+
+			nodes.reserve(n_tris * 2);
+			auto& root = nodes.emplace_back();
+			root.first = 0;
+			root.count = n_tris;
+			std::vector<std::pair<uint, uint>> stack; // node index, depth
+			stack.emplace_back(0, 0);
+			while (!stack.empty())
+			{
+				auto [idx, depth] = stack.back();
+				stack.pop_back();
+
+				auto first = nodes[idx].first;
+				auto count = nodes[idx].count;
+				AABB bounds, centroid_bounds;
+				for (auto i = first; i < first + count; i++)
+				{
+					bounds.expand(tri_bounds[triangles[i]]);
+					centroid_bounds.expand(centroids[triangles[i]]);
+				}
+				nodes[idx].a = bounds.a;
+				nodes[idx].b = bounds.b;
+				if (count <= 2 || depth >= MaxDepth)
+					continue;
+
+				auto best_axis = -1;
+				auto best_split = 0;
+				auto best_cost = count * half_area(bounds);
+				for (auto axis = 0; axis < 3; axis++)
+				{
+					auto lo = centroid_bounds.a[axis];
+					auto ext = centroid_bounds.b[axis] - lo;
+					if (ext < 1e-6f)
+						continue;
+
+					AABB bin_bounds[BinsCount];
+					uint bin_counts[BinsCount] = {};
+					auto scale = BinsCount / ext;
+					for (auto i = first; i < first + count; i++)
+					{
+						auto t = triangles[i];
+						auto b = min((int)((centroids[t][axis] - lo) * scale), BinsCount - 1);
+						bin_counts[b]++;
+						bin_bounds[b].expand(tri_bounds[t]);
+					}
+
+					float right_areas[BinsCount];
+					uint right_counts[BinsCount];
+					AABB acc;
+					auto n = 0U;
+					for (auto b = BinsCount - 1; b > 0; b--)
+					{
+						acc.expand(bin_bounds[b]);
+						n += bin_counts[b];
+						right_counts[b] = n;
+						right_areas[b] = n ? half_area(acc) : 0.f;
+					}
+					acc.reset();
+					n = 0;
+					for (auto b = 0; b < BinsCount - 1; b++)
+					{
+						acc.expand(bin_bounds[b]);
+						n += bin_counts[b];
+						if (n == 0 || right_counts[b + 1] == 0)
+							continue;
+						auto cost = n * half_area(acc) + right_counts[b + 1] * right_areas[b + 1];
+						if (cost < best_cost)
+						{
+							best_cost = cost;
+							best_axis = axis;
+							best_split = b + 1;
+						}
+					}
+				}
+
+				auto mid = first;
+				if (best_axis != -1)
+				{
+					auto lo = centroid_bounds.a[best_axis];
+					auto scale = BinsCount / (centroid_bounds.b[best_axis] - lo);
+					mid = std::partition(triangles.begin() + first, triangles.begin() + first + count, [&](uint t) {
+						return min((int)((centroids[t][best_axis] - lo) * scale), BinsCount - 1) < best_split;
+					}) - triangles.begin();
+				}
+				else
+				{
+					if (count <= MaxLeafSize)
+						continue;
+					// splitting does not pay off but the leaf is too big, cut it at the median of the longest axis
+					auto ext = centroid_bounds.b - centroid_bounds.a;
+					auto axis = ext.x > ext.y ? (ext.x > ext.z ? 0 : 2) : (ext.y > ext.z ? 1 : 2);
+					mid = first + count / 2;
+					std::nth_element(triangles.begin() + first, triangles.begin() + mid, triangles.begin() + first + count, [&](uint a, uint b) {
+						return centroids[a][axis] < centroids[b][axis];
+					});
+				}
+				if (mid == first || mid == first + count)
+					continue;
+
+				auto left = (uint)nodes.size();
+				auto& l = nodes.emplace_back();
+				l.first = first;
+				l.count = mid - first;
+				auto& r = nodes.emplace_back();
+				r.first = mid;
+				r.count = first + count - mid;
+				nodes[idx].first = left;
+				nodes[idx].count = 0;
+				stack.emplace_back(left, depth + 1);
+				stack.emplace_back(left + 1, depth + 1);
+			}
+
+			vertices.resize(n_tris * 3);
+			for (auto i = 0; i < n_tris; i++)
+			{
+				auto t = triangles[i];
+				vertices[i * 3 + 0] = positions[indices[t * 3 + 0]];
+				vertices[i * 3 + 1] = positions[indices[t * 3 + 1]];
+				vertices[i * 3 + 2] = positions[indices[t * 3 + 2]];
+			}
+		}
+
+		// the ray is origin + dir * t, only hits closer than the passed in t are taken, t is updated to the closest hit
+		bool intersect(const vec3& origin, const vec3& dir, float& t, uint* out_triangle = nullptr) const
+		{
+			if (nodes.empty())
+				return false;
+
+			auto inv_dir = 1.f / dir;
+			auto o4 = _mm_setr_ps(origin.x, origin.y, origin.z, 0.f);
+			auto id4 = _mm_setr_ps(inv_dir.x, inv_dir.y, inv_dir.z, 0.f);
+			// the 4th lane of a node box is 'first' or 'count', mask it out so it enters at 0 and never exits
+			auto mask_xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+			auto far_w = _mm_setr_ps(0.f, 0.f, 0.f, 3.4e38f);
+			auto hit_box = [&](const Node& n, float& t_enter) {
+				auto t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&n.a.x), o4), id4);
+				auto t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&n.b.x), o4), id4);
+				auto tmin = _mm_and_ps(_mm_min_ps(t0, t1), mask_xyz);
+				auto tmax = _mm_or_ps(_mm_and_ps(_mm_max_ps(t0, t1), mask_xyz), far_w);
+				tmin = _mm_max_ps(tmin, _mm_shuffle_ps(tmin, tmin, _MM_SHUFFLE(1, 0, 3, 2)));
+				tmin = _mm_max_ps(tmin, _mm_shuffle_ps(tmin, tmin, _MM_SHUFFLE(2, 3, 0, 1)));
+				tmax = _mm_min_ps(tmax, _mm_shuffle_ps(tmax, tmax, _MM_SHUFFLE(1, 0, 3, 2)));
+				tmax = _mm_min_ps(tmax, _mm_shuffle_ps(tmax, tmax, _MM_SHUFFLE(2, 3, 0, 1)));
+				t_enter = _mm_cvtss_f32(tmin);
+				return t_enter <= min(_mm_cvtss_f32(tmax), t);
+			};
+
+			auto hit = false;
+			std::pair<uint, float> stack[64];
+			auto sp = 0;
+			float t_enter;
+			if (!hit_box(nodes[0], t_enter))
+				return false;
+			stack[sp++] = { 0, t_enter };
+			while (sp > 0)
+			{
+				auto [idx, t_node] = stack[--sp];
+				if (t_node > t)
+					continue;
+				auto& n = nodes[idx];
+				if (n.count > 0)
+				{
+					for (auto i = n.first; i < n.first + n.count; i++)
+					{
+						auto& v0 = vertices[i * 3 + 0];
+						auto e1 = vertices[i * 3 + 1] - v0;
+						auto e2 = vertices[i * 3 + 2] - v0;
+						auto p = cross(dir, e2);
+						auto det = dot(e1, p);
+						if (abs(det) < 1e-12f)
+							continue;
+						auto inv_det = 1.f / det;
+						auto s = origin - v0;
+						auto u = dot(s, p) * inv_det;
+						if (u < 0.f || u > 1.f)
+							continue;
+						auto q = cross(s, e1);
+						auto v = dot(dir, q) * inv_det;
+						if (v < 0.f || u + v > 1.f)
+							continue;
+						auto tt = dot(e2, q) * inv_det;
+						if (tt < 0.f || tt >= t)
+							continue;
+						t = tt;
+						hit = true;
+						if (out_triangle)
+							*out_triangle = triangles[i];
+					}
+					continue;
+				}
+
+				float t_l, t_r;
+				auto hit_l = hit_box(nodes[n.first], t_l);
+				auto hit_r = hit_box(nodes[n.first + 1], t_r);
+				// push the farther one first so the nearer one is walked first
+				if (hit_l && hit_r)
+				{
+					if (t_l < t_r)
+					{
+						stack[sp++] = { n.first + 1, t_r };
+						stack[sp++] = { n.first, t_l };
+					}
+					else
+					{
+						stack[sp++] = { n.first, t_l };
+						stack[sp++] = { n.first + 1, t_r };
+					}
+				}
+				else if (hit_l)
+					stack[sp++] = { n.first, t_l };
+				else if (hit_r)
+					stack[sp++] = { n.first + 1, t_r };
+			}
+			return hit;
+		}
+	};
+}
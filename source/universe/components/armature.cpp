@@ -15,19 +15,61 @@ namespace flame
 		return Path::get(sp.empty() ? L"" : sp.front());
 	}
 
+	struct SharedClip
+	{
+		AnimationClip clip;
+		uint ref = 0;
+	};
+	static std::map<std::pair<graphics::AnimationPtr, graphics::ModelPtr>, SharedClip> shared_clips;
+	static PoseCache pose_cache;
+	static std::vector<cArmaturePrivate*> playing_armatures;
+
+	static AnimationClip* get_clip(graphics::AnimationPtr animation, graphics::ModelPtr model)
+	{
+		auto& c = shared_clips[{ animation, model }];
+		if (c.ref == 0)
+		{
+			std::vector<std::string> bone_names(model->bones.size());
+			for (auto i = 0; i < bone_names.size(); i++)
+				bone_names[i] = model->bones[i].name;
+			c.clip.build(*animation, bone_names);
+		}
+		c.ref++;
+		return &c.clip;
+	}
+
+	static void release_clip(AnimationClip* clip)
+	{
+		for (auto it = shared_clips.begin(); it != shared_clips.end(); it++)
+		{
+			if (&it->second.clip == clip)
+			{
+				if (--it->second.ref == 0)
+				{
+					pose_cache.remove(clip);
+					shared_clips.erase(it);
+				}
+				break;
+			}
+		}
+	}
+
 	cArmaturePrivate::~cArmaturePrivate()
 	{
+		std::erase(playing_armatures, this);
 		if (auto name = parse_name(armature_name); !name.empty())
 			AssetManagemant::release(Path::get(name));
-		if (model)
-			graphics::Model::release(model);
 		for (auto& a : animations)
 		{
+			if (a.second.clip)
+				release_clip(a.second.clip);
 			if (!a.second.path.empty())
 				AssetManagemant::release(Path::get(a.second.path));
 			if (a.second.animation)
 				graphics::Animation::release(a.second.animation);
 		}
+		if (model)
+			graphics::Model::release(model);
 	}
 
 	void cArmaturePrivate::attach()
@@ -35,6 +77,7 @@ namespace flame
 		if (model)
 		{
 			bones.resize(model->bones.size());
+			pose.resize(bones.size());
 			for (auto i = 0; i < bones.size(); i++)
 			{
 				auto& src = model->bones[i];
@@ -46,6 +89,8 @@ namespace flame
 					dst.node = e->get_component<cNodeT>();
 					if (dst.node)
 					{
+						pose.positions[i] = vec4(dst.node->pos, 0.f);
+						pose.rotations[i] = dst.node->qut;
 						dst.offmat = src.offset_matrix;
 						dst.node->data_listeners.add([this, i](uint hash) {
 							if (hash == "transform"_h)
@@ -95,66 +140,7 @@ namespace flame
 						if (a.animation)
 						{
 							a.duration = a.animation->duration;
-
-							for (auto& ch : a.animation->channels)
-							{
-								auto find_bone = [&](std::string_view name) {
-									for (auto i = 0; i < bones.size(); i++)
-									{
-										if (bones[i].name == name)
-											return i;
-										auto sp = SUS::split(bones[i].name, ':');
-										if (sp.size() == 2 && sp[1] == name)
-											return i;
-									}
-									return -1;
-								};
-								auto id = find_bone(ch.node_name);
-								if (id == -1)
-								{
-									auto sp = SUS::split(ch.node_name, ':');
-									if (sp.size() == 2)
-										id = find_bone(sp[1]);
-								}
-								if (id != -1)
-								{
-									auto& t = a.tracks.emplace_back();
-									t.bone_idx = id;
-									t.positions.resize(ch.position_keys.size());
-									for (auto i = 0; i < t.positions.size(); i++)
-									{
-										t.positions[i].first = ch.position_keys[i].t;
-										t.positions[i].second = ch.position_keys[i].p;
-									}
-									if (!t.positions.empty() && t.positions.back().first < a.duration)
-									{
-										auto k = t.positions.front();
-										k.first = a.duration;
-										t.positions.push_back(k);
-									}
-									t.rotations.resize(ch.rotation_keys.size());
-									for (auto i = 0; i < t.rotations.size(); i++)
-									{
-										t.rotations[i].first = ch.rotation_keys[i].t;
-										t.rotations[i].second = ch.rotation_keys[i].q;
-									}
-									if (!t.rotations.empty() && t.rotations.back().first < a.duration)
-									{
-										auto k = t.rotations.front();
-										k.first = a.duration;
-										t.rotations.push_back(k);
-									}
-									//if (id == 0)
-									//{
-									//	if (!t.positions.empty())
-									//	{
-									//		auto first_xz = t.positions.front().second.xz();
-									//		for (auto i = 1; i < t.positions.size(); i++)
-									//			t.positions[i].second.xz = first_xz;
-									//	}
-									//}
-								}
-							}
+							a.clip = get_clip(a.animation, model);
 						}
 					}
 				}
@@ -171,6 +157,9 @@ namespace flame
 
 	void cArmaturePrivate::detach()
 	{
+		std::erase(playing_armatures, this);
+		request.animation = nullptr;
+		sampled = nullptr;
 		for (auto& b : bones)
 		{
 			if (b.node)
@@ -179,6 +168,8 @@ namespace flame
 		bones.clear();
 		for (auto& a : animations)
 		{
+			if (a.second.clip)
+				release_clip(a.second.clip);
 			if (!a.second.path.empty())
 				AssetManagemant::release(Path::get(a.second.path));
 			if (a.second.animation)
@@ -233,23 +224,19 @@ namespace flame
 		if (playing_name != 0)
 		{
 			auto& a = animations[playing_name];
-			if (transition_time >= 0.f)
+			// only record what to sample, the poses of all armatures are evaluated together in update_armatures
+			if (a.clip)
 			{
-				for (auto& t : a.tracks)
-				{
-					auto& b = bones[t.bone_idx];
-					if (!t.positions.empty())
-					{
-						b.pose.p = mix(b.pose.p, t.positions.front().second, transition_time / transition_duration);
-						b.node->set_pos(b.pose.p);
-					}
-					if (!t.rotations.empty())
-					{
-						b.pose.q = slerp(b.pose.q, t.rotations.front().second, transition_time / transition_duration);
-						b.node->set_qut(b.pose.q);
-					}
-				}
+				request.animation = &a;
+				request.time = transition_time >= 0.f ? 0.f : playing_time;
+				request.transition = transition_time >= 0.f ? transition_time / transition_duration : -1.f;
+				if (playing_armatures.empty() || playing_armatures.back() != this)
+					playing_armatures.push_back(this);
+			}
 
+			// the time goes on without a clip too, so the end and the loops still come on time
+			if (transition_time >= 0.f)
+			{
 				transition_time += delta_time * playing_speed;
 				if (transition_time >= transition_duration)
 				{
@@ -259,39 +246,6 @@ namespace flame
 			}
 			else
 			{
-				for (auto& t : a.tracks)
-				{
-					auto& b = bones[t.bone_idx];
-					if (!t.positions.empty())
-					{
-						auto rit = std::lower_bound(t.positions.begin(), t.positions.end(), playing_time, [](const auto& i, auto v) {
-							return i.first < v;
-						});
-						auto lit = rit;
-						if (lit != t.positions.begin())
-							lit--;
-						if (lit == rit)
-							b.pose.p = lit->second;
-						else
-							b.pose.p = mix(lit->second, rit->second, (playing_time - lit->first) / (rit->first - lit->first));
-						b.node->set_pos(b.pose.p);
-					}
-					if (!t.rotations.empty())
-					{
-						auto rit = std::lower_bound(t.rotations.begin(), t.rotations.end(), playing_time, [](const auto& i, auto v) {
-							return i.first < v;
-						});
-						auto lit = rit;
-						if (lit != t.rotations.begin())
-							lit--;
-						if (lit == rit)
-							b.pose.q = lit->second;
-						else
-							b.pose.q = slerp(lit->second, rit->second, (playing_time - lit->first) / (rit->first - lit->first));
-						b.node->set_qut(b.pose.q);
-					}
-				}
-
 				playing_time += delta_time * playing_speed;
 				if (playing_time >= a.duration)
 				{
@@ -301,10 +255,83 @@ namespace flame
 						stop();
 					}
 					else
-						playing_time = fmod(playing_time, a.duration);
+						playing_time = a.duration > 0.f ? fmod(playing_time, a.duration) : 0.f;
+				}
+			}
+		}
+	}
+
+	void update_armatures()
+	{
+		pose_cache.new_frame();
+		if (playing_armatures.empty())
+			return;
+
+		struct Job
+		{
+			const AnimationClip* clip;
+			float time;
+			AnimationCursor* cursor;
+			LocalPose* pose;
+		};
+		std::vector<Job> jobs;
+		for (auto a : playing_armatures)
+		{
+			auto ba = a->request.animation;
+			auto is_new = false;
+			auto& entry = pose_cache.get(ba->clip, a->request.time, is_new);
+			if (is_new)
+				jobs.push_back({ ba->clip, pose_cache.bucket_time(a->request.time), &ba->cursor, &entry.pose });
+			a->sampled = &entry.pose;
+		}
+
+		parallel_for(jobs.size(), [&](uint begin, uint end) {
+			for (auto i = begin; i < end; i++)
+			{
+				auto& j = jobs[i];
+				sample_clip(*j.clip, j.time, *j.cursor, *j.pose);
+			}
+		}, 4);
+
+		parallel_for(playing_armatures.size(), [&](uint begin, uint end) {
+			for (auto i = begin; i < end; i++)
+			{
+				auto a = playing_armatures[i];
+				auto& src = *a->sampled;
+				if (a->pose.positions.size() != src.positions.size())
+					continue;
+				if (a->request.transition >= 0.f)
+					blend_poses(a->transition_pose, src, a->request.transition, a->pose);
+				else
+				{
+					for (auto j = 0; j < src.animated.size(); j++)
+					{
+						if (src.animated[j])
+						{
+							a->pose.positions[j] = src.positions[j];
+							a->pose.rotations[j] = src.rotations[j];
+						}
+					}
 				}
 			}
+		}, 16);
+
+		// write back in one pass, bones are marked dirty without sending data changed of pos and qut
+		for (auto a : playing_armatures)
+		{
+			auto& src = *a->sampled;
+			for (auto j = 0; j < a->bones.size(); j++)
+			{
+				auto node = a->bones[j].node;
+				if (!node || j >= src.animated.size() || !src.animated[j])
+					continue;
+				node->pos = vec3(a->pose.positions[j]);
+				node->qut = a->pose.rotations[j];
+				node->mark_transform_dirty();
+			}
+			a->request.animation = nullptr;
 		}
+		playing_armatures.clear();
 	}
 
 	void cArmaturePrivate::set_armature_name(const std::filesystem::path& _armature_name)
@@ -383,6 +410,7 @@ namespace flame
 			{
 				transition_duration = _it->second * playing_speed;
 				transition_time = 0.f;
+				transition_pose = pose;
 			}
 		}
 
@@ -4,6 +4,7 @@
 #include "../../graphics/animation.h"
 #include "armature.h"
 #include "node_private.h"
+#include "../animation_runtime.h"
 
 namespace flame
 {
@@ -11,8 +12,6 @@ namespace flame
 	{
 		struct Pose
 		{
-			vec3 p = vec3(0);
-			quat q = quat(1, 0, 0, 0);
 			mat4 m = mat4(1.f);
 		};
 
@@ -24,22 +23,24 @@ namespace flame
 			Pose pose;
 		};
 
-		struct Track
-		{
-			uint bone_idx;
-			std::vector<std::pair<float, vec3>> positions;
-			std::vector<std::pair<float, quat>> rotations;
-		};
-
 		struct BoundAnimation
 		{
 			std::filesystem::path path;
 			graphics::AnimationPtr animation = nullptr;
-			float duration;
-			std::vector<Track> tracks;
+			float duration = 0.f;
+			AnimationClip* clip = nullptr; // shared by the armatures of the same model
+			AnimationCursor cursor;
 			std::unordered_map<uint, float> transitions;
 		};
 
+		// what to evaluate in update_armatures
+		struct Request
+		{
+			BoundAnimation* animation = nullptr;
+			float time;
+			float transition; // blend factor from transition_pose, or -1
+		};
+
 		bool dirty = true;
 		std::vector<Bone> bones;
 		std::unordered_map<cNodePtr, Bone*> bone_node_map;
@@ -47,6 +48,11 @@ namespace flame
 		float transition_time = -1.f;
 		float transition_duration = 0.f;
 
+		LocalPose pose; // local transforms of the bones
+		LocalPose transition_pose; // the pose when the transition started
+		const LocalPose* sampled = nullptr;
+		Request request;
+
 		~cArmaturePrivate();
 
 		void attach();
@@ -64,4 +70,8 @@ namespace flame
 		void play(uint name) override;
 		void stop() override;
 	};
+
+	// samples the animations of all armatures that are played in this frame, in parallel, instances of the same clip at about
+	//  the same time share one sampled pose, then writes the poses to the bone nodes
+	void update_armatures();
 }
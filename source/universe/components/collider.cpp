@@ -1,11 +1,10 @@
+#include "../../foundation/frame_arena.h"
 #include "../entity_private.h"
 #include "node_private.h"
 #include "bp_instance_private.h"
 #include "nav_agent_private.h"
 #include "nav_obstacle_private.h"
 #include "collider_private.h"
-#include "../octree.h"
-#include "../systems/scene_private.h"
 
 namespace flame
 {
@@ -23,39 +22,124 @@ namespace flame
 		return 0.f;
 	}
 
+	SphereBroadphase collider_broadphase;
+
+	// the entity that the collider reports, searched up from the other collider's entity like the octree queries do
+	//  the disabled ones are passed over, unless they are on the way out and get their exits
+	static EntityPtr find_target(cColliderPrivate* collider, EntityPtr e, bool leaving = false)
+	{
+		auto t = collider->parent_search_times;
+		while (e)
+		{
+			if ((e->global_enable || leaving) && (collider->any_filter & e->tag) != 0 && (collider->all_filter & e->tag) == collider->all_filter)
+				return e;
+			e = e->parent;
+			t--;
+			if (t == 0)
+				return nullptr;
+		}
+		return nullptr;
+	}
+
+	struct ColliderEvent
+	{
+		BlueprintInstanceGroup* cb;
+		uint sensor_id;
+		void* sensor;
+		uint other_id;
+		void* other; // null if it need not be there
+		EntityPtr target;
+	};
+
+	// events whose colliders went away in an earlier callback are skipped
+	static void call_events(const FrameVector<ColliderEvent>& events)
+	{
+		auto& bp = collider_broadphase;
+		for (auto& e : events)
+		{
+			if (bp.users[e.sensor_id] != e.sensor || (e.other && bp.users[e.other_id] != e.other))
+				continue;
+			auto c = (cColliderPrivate*)e.sensor;
+			voidptr inputs[1];
+			inputs[0] = (void*)&e.target;
+			c->bp_ins->call(e.cb, inputs, nullptr);
+		}
+	}
+
+	void cColliderPrivate::on_active()
+	{
+		broadphase_id = collider_broadphase.add(this);
+	}
+
+	void cColliderPrivate::on_inactive()
+	{
+		if (broadphase_id != ~0U)
+		{
+			auto& bp = collider_broadphase;
+			auto first = bp.exited.size();
+			bp.remove(broadphase_id);
+			broadphase_id = ~0U;
+
+			// the others that saw this one exit now, while the entity is still there to be the target
+			FrameVector<ColliderEvent> events;
+			for (auto i = first; i < bp.exited.size(); i++)
+			{
+				auto sensor_id = SphereBroadphase::contact_sensor(bp.exited[i]);
+				auto c = (cColliderPrivate*)bp.users[sensor_id];
+				if (!c->on_exit_cb || c->entity == entity)
+					continue;
+				if (auto target = find_target(c, entity, true); target)
+					events.push_back({ c->on_exit_cb, sensor_id, c, 0, nullptr, target });
+			}
+			call_events(events);
+		}
+	}
+
 	void cColliderPrivate::start()
 	{
 		if (auto bp_comp = entity->get_component<cBpInstanceT>(); bp_comp && bp_comp->bp_ins)
 		{
 			bp_ins = bp_comp->bp_ins;
 			on_enter_cb = bp_ins->find_group("collider_on_enter"_h);
+			on_stay_cb = bp_ins->find_group("collider_on_stay"_h);
 			on_exit_cb = bp_ins->find_group("collider_on_exit"_h);
 		}
 
-		radius = get_radius(entity) + radius_expand;
+		radius = get_radius(entity);
 	}
 
-	void cColliderPrivate::update()
+	void update_colliders()
 	{
-		if (radius > 0.f)
+		auto& bp = collider_broadphase;
+		for (auto id : bp.order)
 		{
-			auto pos = node->global_pos();
-			std::vector<std::pair<EntityPtr, cNodePtr>> res;
-			sScene::instance()->octree->get_colliding(pos, radius, res, any_filter, all_filter, parent_search_times);
-			for (auto& i : res)
+			auto c = (cColliderPrivate*)bp.users[id];
+			// not started yet, it takes part from the next frame
+			if (c->update_times > 0)
+				bp.set(id, c->node->global_pos(), c->radius, max(c->radius_expand, 0.f));
+			else
+				bp.set(id, c->node->global_pos(), 0.f);
+		}
+		bp.update();
+
+		// all events are collected first and then delivered, the callbacks may add or remove colliders
+		//  a contact goes to the collider that sees, the other is the one its filters are tested on
+		FrameVector<ColliderEvent> events;
+		auto add_events = [&](const std::vector<uint64>& contacts, BlueprintInstanceGroup* cColliderPrivate::* cb) {
+			for (auto ct : contacts)
 			{
-				auto r = get_radius(i.first);
-				if (distance(i.second->global_pos(), pos) < r + radius)
-				{
-					if (on_enter_cb)
-					{
-						voidptr inputs[1];
-						inputs[0] = &i.first;
-						bp_ins->call(on_enter_cb, inputs, nullptr);
-					}
-				}
+				auto sensor_id = SphereBroadphase::contact_sensor(ct), other_id = SphereBroadphase::contact_other(ct);
+				auto c0 = (cColliderPrivate*)bp.users[sensor_id], c1 = (cColliderPrivate*)bp.users[other_id];
+				if (!(c0->*cb) || c0->entity == c1->entity)
+					continue;
+				if (auto target = find_target(c0, c1->entity); target)
+					events.push_back({ c0->*cb, sensor_id, c0, other_id, c1, target });
 			}
-		}
+		};
+		add_events(bp.exited, &cColliderPrivate::on_exit_cb);
+		add_events(bp.entered, &cColliderPrivate::on_enter_cb);
+		add_events(bp.stayed, &cColliderPrivate::on_stay_cb);
+		call_events(events);
 	}
 
 	struct cColliderCreate : cCollider::Create
@@ -1,18 +1,26 @@
 #pragma once
 
 #include "collider.h"
+#include "../broadphase.h"
 
 namespace flame
 {
 	struct cColliderPrivate : cCollider
 	{
-		float radius;
+		float radius = 0.f; // of the entity, the broadphase adds radius_expand on its side only
+		uint broadphase_id = ~0U;
 		BlueprintInstancePtr bp_ins = nullptr;
 		BlueprintInstanceGroup* on_enter_cb = nullptr;
+		BlueprintInstanceGroup* on_stay_cb = nullptr;
 		BlueprintInstanceGroup* on_exit_cb = nullptr;
 
+		void on_active() override;
+		void on_inactive() override;
 		void start() override;
-		void update() override;
 	};
-}
 
+	extern SphereBroadphase collider_broadphase;
+
+	// the scene calls it every frame after the nodes are updated, it finds the overlaps of all colliders and then calls the blueprints
+	void update_colliders();
+}
@@ -62,6 +62,8 @@ namespace flame
 			return;
 		cast_shadow = _cast_shadow;
 
+		if (instance_id != -1)
+			sRenderer::instance()->set_dir_light_shadow_caster(instance_id, cast_shadow ? node : nullptr);
 		dirty = true;
 		node->mark_drawing_dirty();
 		data_changed("cast_shadow"_h);
@@ -70,10 +72,14 @@ namespace flame
 	void cDirectionalLightPrivate::on_active()
 	{
 		instance_id = sRenderer::instance()->register_light_instance(LightDirectional, -1);
+		if (instance_id != -1 && cast_shadow)
+			sRenderer::instance()->set_dir_light_shadow_caster(instance_id, node);
 	}
 
 	void cDirectionalLightPrivate::on_inactive()
 	{
+		if (instance_id != -1 && cast_shadow)
+			sRenderer::instance()->set_dir_light_shadow_caster(instance_id, nullptr);
 		sRenderer::instance()->register_light_instance(LightDirectional, instance_id);
 		instance_id = -1;
 	}
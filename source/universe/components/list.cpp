@@ -1,9 +1,27 @@
 #include "../universe_private.h"
 #include "../entity_private.h"
+#include "element_private.h"
+#include "scroll_view_private.h"
 #include "list_private.h"
 
 namespace flame
 {
+	cListPrivate::~cListPrivate()
+	{
+		stop_update();
+	}
+
+	void cListPrivate::on_active()
+	{
+		if (virtualized)
+			start_update();
+	}
+
+	void cListPrivate::on_inactive()
+	{
+		stop_update();
+	}
+
 	void cListPrivate::set_prefab_name(const std::filesystem::path& name)
 	{
 		if (prefab_name == name)
@@ -18,7 +36,7 @@ namespace flame
 		if (count == _count)
 			return;
 		count = _count;
-		refresh_items();
+		resize_items();
 		data_changed("count"_h);
 	}
 
@@ -31,28 +49,213 @@ namespace flame
 		data_changed("modifiers"_h);
 	}
 
+	void cListPrivate::set_virtualized(bool v)
+	{
+		if (virtualized == v)
+			return;
+		virtualized = v;
+		refresh_items();
+		if (virtualized && entity->global_enable)
+			start_update();
+		else
+			stop_update();
+		data_changed("virtualized"_h);
+	}
+
+	void cListPrivate::set_item_height(float h)
+	{
+		if (item_height == h)
+			return;
+		item_height = h;
+		if (virtualized)
+			resize_items();
+		data_changed("item_height"_h);
+	}
+
+	cListPrivate::Item* cListPrivate::create_item(EntityPtr prefab)
+	{
+		auto item = new Item;
+		auto e = prefab ? prefab->duplicate() : Entity::create();
+		if (!prefab_name.empty())
+		{
+			if (!prefab)
+				e->load(prefab_name);
+			for (auto& m : modifiers)
+				item->modifiers.emplace_back(new ModifierPrivate(m, e, { std::make_pair("i", &item->i) }));
+		}
+		e->tag = e->tag | TagNotSerialized;
+		entity->add_child(e);
+		item->e = e;
+		items.emplace_back(item);
+		return item;
+	}
+
+	void cListPrivate::bind_item(Item* item, uint index)
+	{
+		item->index = index;
+		item->i = index;
+		item->e->set_name("item" + str(index));
+		for (auto& m : item->modifiers)
+			m->update(true);
+		if (virtualized)
+		{
+			if (auto element = item->e->get_component<cElement>(); element)
+				element->set_y(index * item_height);
+			item->e->set_enable(true);
+		}
+	}
+
 	void cListPrivate::refresh_items()
 	{
-		for (auto e : items)
-			e->remove_from_parent();
+		for (auto& item : items)
+			item->e->remove_from_parent();
 		items.clear();
+		resize_items();
+	}
+
+	void cListPrivate::resize_items()
+	{
+		if (virtualized)
+		{
+			if (auto element = entity->get_component<cElement>(); element)
+				element->set_h(count * item_height);
+			update_virtual_items(true);
+			return;
+		}
 
-		for (auto i = 0; i < count; i++)
+		// only add or remove the difference
+		while (items.size() > count)
+		{
+			items.back()->e->remove_from_parent();
+			items.pop_back();
+		}
+		if (items.size() < count)
 		{
-			auto e = Entity::create();
-			e->name = "item" + str(i);
+			auto first = (uint)items.size();
+			// the prefab is loaded once, the items are copies of it
+			EntityPtr prefab = nullptr;
 			if (!prefab_name.empty())
 			{
-				e->load(prefab_name);
-				for (auto& m : modifiers)
+				prefab = Entity::create();
+				prefab->load(prefab_name);
+			}
+			while (items.size() < count)
+				create_item(prefab);
+			delete prefab;
+			bind_items(first, count);
+		}
+	}
+
+	void cListPrivate::bind_items(uint first, uint last)
+	{
+		for (auto i = first; i < last; i++)
+		{
+			auto item = items[i].get();
+			item->index = i;
+			item->i = i;
+			item->e->set_name("item" + str(i));
+		}
+
+		// the items share the compiled modifiers, so evaluate each modifier over all the new 'i's at once
+		auto n = last - first;
+		std::vector<float> is(n), values(n);
+		for (auto k = 0; k < n; k++)
+			is[k] = first + k;
+		auto& head = items[first];
+		for (auto j = 0; j < head->modifiers.size(); j++)
+		{
+			auto& hm = head->modifiers[j];
+			if (hm->expr && hm->is_numeric())
+			{
+				hm->expr->update_bindings();
+				hm->expr->get_values(n, is.data(), 1, values.data());
+				for (auto k = 0; k < n; k++)
 				{
-					ModifierPrivate mp(m, e, {}, { std::make_pair("i", (float)i) });
-					mp.update(true);
+					auto& m = items[first + k]->modifiers[j];
+					if (m->expr)
+						m->set_value(values[k]);
 				}
 			}
-			e->tag = e->tag | TagNotSerialized;
-			entity->add_child(e);
-			items.push_back(e);
+			else
+			{
+				for (auto i = first; i < last; i++)
+					items[i]->modifiers[j]->update(true);
+			}
+		}
+	}
+
+	void cListPrivate::update_virtual_items(bool force)
+	{
+		auto first = 0U;
+		auto last = count;
+		auto element = entity->get_component<cElement>();
+		cScrollViewPtr scroll_view = nullptr;
+		for (auto e = entity->parent; e && !scroll_view; e = e->parent)
+			scroll_view = e->get_component<cScrollView>();
+		if (element && scroll_view && scroll_view->e_content_viewport && item_height > 0.f)
+		{
+			if (auto viewport_element = scroll_view->e_content_viewport->get_component<cElement>(); viewport_element)
+			{
+				auto scl = element->global_scl().y;
+				auto top = (viewport_element->global_pos0().y - element->global_pos0().y) / scl;
+				auto bottom = (viewport_element->global_pos1().y - element->global_pos0().y) / scl;
+				first = clamp((int)floor(top / item_height), 0, (int)count);
+				last = clamp((int)ceil(bottom / item_height), (int)first, (int)count);
+			}
+		}
+		if (!force && shown_range == uvec2(first, last))
+			return;
+		shown_range = uvec2(first, last);
+
+		// free the items that went out of the range, then take them for the indices that are not shown yet
+		std::vector<bool> shown(last - first, false);
+		std::vector<Item*> free_items;
+		for (auto& item : items)
+		{
+			if (item->index != -1 && (uint)item->index >= first && (uint)item->index < last)
+				shown[item->index - first] = true;
+			else
+			{
+				if (item->index != -1)
+				{
+					item->index = -1;
+					item->e->set_enable(false);
+				}
+				free_items.push_back(item.get());
+			}
+		}
+		for (auto i = first; i < last; i++)
+		{
+			if (shown[i - first])
+				continue;
+			Item* item;
+			if (!free_items.empty())
+			{
+				item = free_items.back();
+				free_items.pop_back();
+			}
+			else
+				item = create_item();
+			bind_item(item, i);
+		}
+	}
+
+	void cListPrivate::start_update()
+	{
+		if (ev_update)
+			return;
+		ev_update = add_event([this]() {
+			update_virtual_items();
+			return true;
+		});
+	}
+
+	void cListPrivate::stop_update()
+	{
+		if (ev_update)
+		{
+			remove_event(ev_update);
+			ev_update = nullptr;
 		}
 	}
 
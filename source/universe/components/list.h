@@ -22,6 +22,17 @@ namespace flame
 		// Reflect
 		virtual void set_modifiers(const std::vector<Modifier>& modifiers) = 0;
 
+		// only the items that are inside the viewport of the parent scroll view are created, they are reused as it scrolls
+		//  items are placed by item_height, so do not put a layout on the list
+		// Reflect
+		bool virtualized = false;
+		// Reflect
+		virtual void set_virtualized(bool v) = 0;
+		// Reflect
+		float item_height = 20.f;
+		// Reflect
+		virtual void set_item_height(float h) = 0;
+
 		struct Create
 		{
 			virtual cListPtr operator()(EntityPtr) = 0;
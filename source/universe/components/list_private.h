@@ -1,18 +1,42 @@
 #pragma once
 
 #include "list.h"
+#include "../universe_private.h"
 
 namespace flame
 {
 	struct cListPrivate : cList
 	{
-		std::vector<EntityPtr> items;
+		struct Item
+		{
+			EntityPtr e = nullptr;
+			float i = 0.f; // bound to the modifiers as variable 'i', so an item can be moved to another index without compiling them again
+			std::vector<std::unique_ptr<ModifierPrivate>> modifiers;
+			int index = -1; // -1 for free items in the pool
+		};
+
+		std::vector<std::unique_ptr<Item>> items; // item i is items[i], or the pool when virtualized
+		void* ev_update = nullptr; // keeps checking the viewport while virtualized and active
+		uvec2 shown_range = uvec2(0); // first, last (exclusive)
+
+		~cListPrivate();
+		void on_active() override;
+		void on_inactive() override;
 
 		void set_prefab_name(const std::filesystem::path& name) override;
 		void set_count(uint count) override;
 
 		void set_modifiers(const std::vector<Modifier>& modifiers) override;
+		void set_virtualized(bool v) override;
+		void set_item_height(float h) override;
 
+		Item* create_item(EntityPtr prefab = nullptr); // a copy of prefab if it is given, or load the prefab
+		void bind_item(Item* item, uint index);
+		void bind_items(uint first, uint last); // non-virtualized items [first, last) that were just created
 		void refresh_items();
+		void resize_items();
+		void update_virtual_items(bool force = false);
+		void start_update();
+		void stop_update();
 	};
 }
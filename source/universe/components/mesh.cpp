@@ -4,6 +4,7 @@
 #include "../entity_private.h"
 #include "../world_private.h"
 #include "node_private.h"
+#include "camera_private.h"
 #include "mesh_private.h"
 #include "armature_private.h"
 #include "../draw_data.h"
@@ -60,6 +61,20 @@ namespace flame
 			if (mesh_res_id == -1 || instance_id == -1 || material_res_id == -1)
 				return;
 
+			auto lod = 0U;
+			if (lod_threshold > 0.f && !mesh->lods.empty() && draw_data.pass != PassInstance)
+			{
+				auto& m = node->transform;
+				auto scale = max(length(vec3(m[0])), max(length(vec3(m[1])), length(vec3(m[2]))));
+				if (draw_data.view_height > 0.f)
+					lod = mesh->select_lod(scale / draw_data.view_height, lod_threshold);
+				else if (camera)
+				{
+					auto dist = max(distance(camera->node->global_pos(), node->global_pos()), camera->zNear);
+					lod = mesh->select_lod(scale / (dist * 2.f * tan(radians(camera->fovy * 0.5f))), lod_threshold);
+				}
+			}
+
 			switch (draw_data.pass)
 			{
 			case PassInstance:
@@ -76,19 +91,19 @@ namespace flame
 				break;
 			case PassGBuffer:
 				if (enable_render && (draw_data.categories & CateMesh) && (material->render_queue == graphics::RenderQueue::Opaque || material->render_queue == graphics::RenderQueue::AlphaTest))
-					draw_data.meshes.emplace_back(instance_id, mesh_res_id, material_res_id);
+					draw_data.meshes.emplace_back(instance_id, mesh_res_id, material_res_id).lod = lod;
 				break;
 			case PassForward:
 				if (enable_render && (draw_data.categories & CateMesh) && material->render_queue == graphics::RenderQueue::Transparent)
-					draw_data.meshes.emplace_back(instance_id, mesh_res_id, material_res_id);
+					draw_data.meshes.emplace_back(instance_id, mesh_res_id, material_res_id).lod = lod;
 				break;
 			case PassOcculder:
 				if (enable_render && (draw_data.categories & CateMesh) && cast_shadow && material->render_queue != graphics::RenderQueue::Transparent)
-					draw_data.meshes.emplace_back(instance_id, mesh_res_id, material_res_id);
+					draw_data.meshes.emplace_back(instance_id, mesh_res_id, material_res_id).lod = lod;
 				break;
 			case PassPickUp:
 				if ((draw_data.categories & CateMesh))
-					draw_data.meshes.emplace_back(instance_id, mesh_res_id, material_res_id);
+					draw_data.meshes.emplace_back(instance_id, mesh_res_id, material_res_id).lod = lod;
 				break;
 			}
 		}, "mesh"_h);
@@ -231,6 +246,22 @@ namespace flame
 		data_changed("enable_render"_h);
 	}
 
+	void cMeshPrivate::set_occluder(bool v)
+	{
+		if (occluder == v)
+			return;
+		occluder = v;
+		data_changed("occluder"_h);
+	}
+
+	void cMeshPrivate::set_lod_threshold(float v)
+	{
+		if (lod_threshold == v)
+			return;
+		lod_threshold = v;
+		data_changed("lod_threshold"_h);
+	}
+
 	void cMeshPrivate::on_active()
 	{
 		parmature = entity->get_parent_component<cArmatureT>();
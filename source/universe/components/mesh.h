@@ -41,6 +41,18 @@ namespace flame
 		// Reflect
 		virtual void set_enable_render(bool v) = 0;
 
+		// rasterized into the CPU depth buffer to hide other nodes, when occlusion culling is on, use it on big and simple meshes
+		// Reflect
+		bool occluder = false;
+		// Reflect
+		virtual void set_occluder(bool v) = 0;
+
+		// the error of the lods allowed on screen, as a fraction of the screen height, 0 to always draw the mesh itself
+		// Reflect
+		float lod_threshold = 0.002f;
+		// Reflect
+		virtual void set_lod_threshold(float v) = 0;
+
 		graphics::MeshPtr mesh = nullptr;
 		graphics::MaterialPtr material = nullptr;
 		int mesh_res_id = -1;
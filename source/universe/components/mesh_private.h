@@ -18,6 +18,8 @@ namespace flame
 
 		void set_cast_shadow(bool v) override;
 		void set_enable_render(bool v) override;
+		void set_occluder(bool v) override;
+		void set_lod_threshold(float v) override;
 
 		void on_active() override;
 		void on_inactive() override;
@@ -1,3 +1,4 @@
+#include "../../foundation/frame_arena.h"
 #include "../world_private.h"
 #include "node_private.h"
 #include "../systems/renderer_private.h"
@@ -78,7 +79,7 @@ namespace flame
 
 	void cNodePrivate::update_transform_from_root()
 	{
-		std::vector<cNodePtr> nodes;
+		FrameVector<cNodePtr> nodes;
 		auto n = this;
 		while (n)
 		{
@@ -1,4 +1,5 @@
 #include "../../foundation/blueprint.h"
+#include "../../graphics/device.h"
 #include "../../graphics/model_ext.h"
 #include "node_private.h"
 #include "mesh_private.h"
@@ -17,12 +18,40 @@ namespace flame
 		}
 	}
 
+	void cProcedureMeshPrivate::update_mesh()
+	{
+		if (mesh->mesh_res_id != -1)
+		{
+			graphics::Queue::get()->wait_idle();
+			sRenderer::instance()->release_mesh_res(mesh->mesh_res_id);
+			mesh->mesh = nullptr;
+			mesh->mesh_res_id = -1;
+		}
+		if (!has_control_mesh)
+			return;
+
+		if (subdivision_levels > 0)
+		{
+			graphics::ControlMesh subdivided;
+			control_mesh.subdivide(subdivided, subdivision_levels, subdivision_loop);
+			subdivided.convert_to_mesh(converted_mesh);
+		}
+		else
+			control_mesh.convert_to_mesh(converted_mesh);
+		mesh->mesh = &converted_mesh;
+		mesh->mesh_res_id = sRenderer::instance()->get_mesh_res(&converted_mesh, -1);
+		mesh->color = control_mesh.color;
+		mesh->node->mark_transform_dirty();
+	}
+
 	void cProcedureMeshPrivate::set_blueprint_name(const std::filesystem::path& name)
 	{
 		if (blueprint_name == name)
 			return;
 		blueprint_name = name;
 
+		has_control_mesh = false;
+		control_mesh.reset();
 		if (!blueprint_name.empty())
 		{
 			if (auto bp = Blueprint::get(blueprint_name); bp)
@@ -37,20 +66,36 @@ namespace flame
 
 				if (pcontrol_mesh)
 				{
-					pcontrol_mesh->convert_to_mesh(converted_mesh);
-					assert(mesh->mesh_res_id == -1);
-					mesh->mesh = &converted_mesh;
-					mesh->mesh_res_id = sRenderer::instance()->get_mesh_res(&converted_mesh, -1);
-					mesh->color = pcontrol_mesh->color;
-					mesh->node->mark_transform_dirty();
-
-					mesh->set_material_name(L"default");
+					control_mesh = *pcontrol_mesh;
+					has_control_mesh = true;
 				}
 
 				delete ins;
 				Blueprint::release(bp);
 			}
 		}
+		update_mesh();
+		if (has_control_mesh)
+			mesh->set_material_name(L"default");
+	}
+
+	void cProcedureMeshPrivate::set_subdivision_levels(uint v)
+	{
+		if (subdivision_levels == v)
+			return;
+		subdivision_levels = v;
+		update_mesh();
+		data_changed("subdivision_levels"_h);
+	}
+
+	void cProcedureMeshPrivate::set_subdivision_loop(bool v)
+	{
+		if (subdivision_loop == v)
+			return;
+		subdivision_loop = v;
+		if (subdivision_levels > 0)
+			update_mesh();
+		data_changed("subdivision_loop"_h);
 	}
 
 	struct cProcedureMeshCreate : cProcedureMesh::Create
@@ -16,6 +16,18 @@ namespace flame
 		// Reflect
 		virtual void set_blueprint_name(const std::filesystem::path& name) = 0;
 
+		// subdivide the control mesh from the blueprint before converting, cheap enough to drag in the editor
+		// Reflect
+		uint subdivision_levels = 0;
+		// Reflect
+		virtual void set_subdivision_levels(uint v) = 0;
+
+		// Loop instead of Catmull-Clark
+		// Reflect
+		bool subdivision_loop = false;
+		// Reflect
+		virtual void set_subdivision_loop(bool v) = 0;
+
 		graphics::Mesh converted_mesh;
 
 		struct Create
@@ -6,8 +6,15 @@ namespace flame
 {
 	struct cProcedureMeshPrivate : cProcedureMesh
 	{
+		graphics::ControlMesh control_mesh; // the output of the blueprint
+		bool has_control_mesh = false;
+
 		~cProcedureMeshPrivate();
 
+		void update_mesh();
+
 		void set_blueprint_name(const std::filesystem::path& name) override;
+		void set_subdivision_levels(uint v) override;
+		void set_subdivision_loop(bool v) override;
 	};
 }
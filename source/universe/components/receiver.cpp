@@ -1,7 +1,138 @@
+#include "../entity_private.h"
+#include "element_private.h"
 #include "receiver_private.h"
 
 namespace flame
 {
+	ReceiverGrid receiver_grid;
+
+	static uint64 cell_key(int x, int y)
+	{
+		return ((uint64)(uint)y << 32) | (uint64)(uint)x;
+	}
+
+	void ReceiverGrid::add(cReceiverPrivate* r)
+	{
+		r->rect = Rect(r->element->global_pos0(), r->element->global_pos1());
+		r->cells = ivec4(ivec2(floor(r->rect.a / CellSize)), ivec2(floor(r->rect.b / CellSize)));
+		auto n = (r->cells.z - r->cells.x + 1) * (r->cells.w - r->cells.y + 1);
+		r->oversized = n <= 0 || n > MaxCells;
+		if (r->oversized)
+			oversized.push_back(r);
+		else
+		{
+			for (auto y = r->cells.y; y <= r->cells.w; y++)
+			{
+				for (auto x = r->cells.x; x <= r->cells.z; x++)
+					cells[cell_key(x, y)].push_back(r);
+			}
+		}
+		receivers.insert(r);
+		version++;
+	}
+
+	void ReceiverGrid::remove(cReceiverPrivate* r)
+	{
+		if (!receivers.erase(r))
+			return;
+		if (r->oversized)
+			std::erase(oversized, r);
+		else
+		{
+			for (auto y = r->cells.y; y <= r->cells.w; y++)
+			{
+				for (auto x = r->cells.x; x <= r->cells.z; x++)
+				{
+					auto it = cells.find(cell_key(x, y));
+					if (it != cells.end())
+					{
+						std::erase(it->second, r);
+						if (it->second.empty())
+							cells.erase(it);
+					}
+				}
+			}
+		}
+		version++;
+	}
+
+	void ReceiverGrid::update(cReceiverPrivate* r)
+	{
+		if (!receivers.contains(r))
+			return;
+		if (r->rect == Rect(r->element->global_pos0(), r->element->global_pos1()))
+			return;
+		remove(r);
+		add(r);
+	}
+
+	// true if a comes after b in a breadth first walk
+	static bool is_above(EntityPtr a, EntityPtr b)
+	{
+		if (a->depth != b->depth)
+			return a->depth > b->depth;
+		while (a->parent != b->parent)
+		{
+			a = a->parent;
+			b = b->parent;
+		}
+		return a->index > b->index;
+	}
+
+	cReceiverPtr ReceiverGrid::query(const vec2& p, EntityPtr root)
+	{
+		cReceiverPrivate* ret = nullptr;
+		auto check = [&](cReceiverPrivate* r) {
+			if (!r->rect.contains(p))
+				return;
+			auto e = r->entity;
+			if (e->depth < root->depth)
+				return;
+			if (ret && !is_above(e, ret->entity))
+				return;
+			auto pe = e;
+			while (pe && pe->depth > root->depth)
+				pe = pe->parent;
+			if (pe != root)
+				return;
+			ret = r;
+		};
+
+		auto c = ivec2(floor(p / CellSize));
+		if (auto it = cells.find(cell_key(c.x, c.y)); it != cells.end())
+		{
+			for (auto r : it->second)
+				check(r);
+		}
+		for (auto r : oversized)
+			check(r);
+		return ret;
+	}
+
+	cReceiverPrivate::~cReceiverPrivate()
+	{
+		element->data_listeners.remove("receiver"_h);
+		receiver_grid.remove(this);
+	}
+
+	void cReceiverPrivate::on_init()
+	{
+		element->data_listeners.add([this](uint hash) {
+			if (hash == "transform"_h)
+				receiver_grid.update(this);
+		}, "receiver"_h);
+	}
+
+	void cReceiverPrivate::on_active()
+	{
+		receiver_grid.add(this);
+	}
+
+	void cReceiverPrivate::on_inactive()
+	{
+		receiver_grid.remove(this);
+	}
+
 	struct cReceiverCreate : cReceiver::Create
 	{
 		cReceiverPtr operator()(EntityPtr) override
@@ -2,10 +2,40 @@
 
 #include "receiver.h"
 
+#include <unordered_set>
+
 namespace flame
 {
 	struct cReceiverPrivate : cReceiver
 	{
+		Rect rect; // global rect that is in the grid
+		ivec4 cells = ivec4(0); // cell range in the grid, x0, y0, x1, y1, end inclusive
+		bool oversized = false;
 
+		~cReceiverPrivate();
+		void on_init() override;
+		void on_active() override;
+		void on_inactive() override;
 	};
+
+	// a uniform grid of the active receivers' rects, so that finding the hovered one does not walk the whole UI
+	//  the receivers keep themselves in it as their elements' transforms change
+	struct ReceiverGrid
+	{
+		static constexpr float CellSize = 64.f;
+		static constexpr uint MaxCells = 1024; // bigger receivers go to the oversized list, which is always checked
+
+		std::unordered_map<uint64, std::vector<cReceiverPrivate*>> cells;
+		std::vector<cReceiverPrivate*> oversized;
+		std::unordered_set<cReceiverPtr> receivers;
+		uint version = 0; // increased on every change, nothing needs to be queried again while it and the mouse stay the same
+
+		void add(cReceiverPrivate* r);
+		void remove(cReceiverPrivate* r);
+		void update(cReceiverPrivate* r);
+		// the top most receiver under p (in breadth first order, like the drawing), among root and its descendants
+		cReceiverPtr query(const vec2& p, EntityPtr root);
+	};
+
+	extern ReceiverGrid receiver_grid;
 }
@@ -80,6 +80,7 @@ namespace flame
 		if (height_map != old_one)
 		{
 			dirty = true;
+			load_heights();
 			update_normal_map();
 			node->mark_transform_dirty();
 		}
@@ -200,6 +201,7 @@ namespace flame
 		node->drawers.remove("terrain"_h);
 		node->measurers.remove("terrain"_h);
 		node->data_listeners.remove("terrain"_h);
+		sRenderer::instance()->upload_callbacks.remove((uint)this);
 
 		graphics::Queue::get()->wait_idle();
 		if (material_res_id != -1)
@@ -226,6 +228,12 @@ namespace flame
 			delete normal_map;
 		if (tangent_map)
 			delete tangent_map;
+		if (nor_stag)
+			delete nor_stag;
+		if (tan_stag)
+			delete tan_stag;
+		if (hgt_stag)
+			delete hgt_stag;
 	}
 
 	void cTerrainPrivate::on_init()
@@ -280,80 +288,191 @@ namespace flame
 			if (hash == "enable"_h)
 				dirty = true;
 		}, "terrain"_h);
+		sRenderer::instance()->upload_callbacks.add([this](graphics::CommandBufferPtr cb) {
+			upload_maps(cb);
+		}, (uint)this);
 
 		node->mark_transform_dirty();
 	}
 
-	void cTerrainPrivate::update_normal_map()
+	static ivec4 merge_rect(const ivec4& a, const ivec4& b)
+	{
+		if (a.z <= a.x || a.w <= a.y)
+			return b;
+		if (b.z <= b.x || b.w <= b.y)
+			return a;
+		return ivec4(min(a.x, b.x), min(a.y, b.y), max(a.z, b.z), max(a.w, b.w));
+	}
+
+	void cTerrainPrivate::load_heights()
 	{
+		heightfield.size = uvec2(0);
+		heightfield.data.clear();
 		if (!height_map)
 			return;
 
-		graphics::Queue::get()->wait_idle();
+		auto sz = uvec2(height_map->extent);
+		heightfield.resize(sz);
+		for (auto y = 0; y < sz.y; y++)
+		{
+			for (auto x = 0; x < sz.x; x++)
+				heightfield.data[y * sz.x + x] = height_map->get_staging_pixel(x, y, 0, 0).x;
+		}
 
-		if (normal_map)
-			delete normal_map;
-		if (tangent_map)
-			delete tangent_map;
+		if (hgt_stag)
+		{
+			graphics::Queue::get()->wait_idle();
+			delete hgt_stag;
+			hgt_stag = nullptr;
+		}
+		switch (height_map->format)
+		{
+		case graphics::Format_R8_UNORM:
+		case graphics::Format_R16_UNORM:
+		case graphics::Format_R16_SFLOAT:
+		case graphics::Format_R32_SFLOAT:
+			hgt_stag = graphics::Buffer::create(height_map->pixel_size * sz.x * sz.y, graphics::BufferUsageTransferSrc, graphics::MemoryPropertyHost | graphics::MemoryPropertyCoherent);
+			hgt_stag->map();
+			break;
+		default:
+			printf("terrain: height map format is not supported for editing, edits are not uploaded\n");
+		}
+		upload_height_rect = ivec4(0);
+	}
 
-		auto sz0 = (ivec2)(blocks * tess_level);
-		auto sz1 = sz0 + 1;
+	void cTerrainPrivate::update_normal_map()
+	{
+		if (!height_map)
+			return;
 
-		normal_map = graphics::Image::create(graphics::Format_R8G8B8A8_UNORM, uvec3(sz0, 1), graphics::ImageUsageTransferSrc | graphics::ImageUsageTransferDst | graphics::ImageUsageSampled);
-		tangent_map = graphics::Image::create(graphics::Format_R8G8B8A8_UNORM, uvec3(sz0, 1), graphics::ImageUsageTransferSrc | graphics::ImageUsageTransferDst | graphics::ImageUsageSampled);
-		dirty = true;
+		if (heightfield.data.empty())
+			load_heights();
 
-		std::vector<float> heights;
-		heights.resize(sz1.x * sz1.y);
-		for (auto y = 0; y < sz1.y; y++)
+		auto sz = blocks * tess_level;
+		if (!normal_map || uvec2(normal_map->extent) != sz)
 		{
-			for (auto x = 0; x < sz1.x; x++)
-				heights[y * sz1.x + x] = height_map->linear_sample_staging_pixels(vec2((float)x / sz0.x, (float)y / sz0.y)).x;
+			// only a new size needs new images, and the old ones may still be in use
+			graphics::Queue::get()->wait_idle();
+
+			if (normal_map)
+				delete normal_map;
+			if (tangent_map)
+				delete tangent_map;
+			if (nor_stag)
+				delete nor_stag;
+			if (tan_stag)
+				delete tan_stag;
+
+			normal_map = graphics::Image::create(graphics::Format_R8G8B8A8_UNORM, uvec3(sz, 1), graphics::ImageUsageTransferSrc | graphics::ImageUsageTransferDst | graphics::ImageUsageSampled);
+			tangent_map = graphics::Image::create(graphics::Format_R8G8B8A8_UNORM, uvec3(sz, 1), graphics::ImageUsageTransferSrc | graphics::ImageUsageTransferDst | graphics::ImageUsageSampled);
+			nor_stag = graphics::Buffer::create(sizeof(cvec4) * sz.x * sz.y, graphics::BufferUsageTransferSrc, graphics::MemoryPropertyHost | graphics::MemoryPropertyCoherent);
+			nor_stag->map();
+			tan_stag = graphics::Buffer::create(sizeof(cvec4) * sz.x * sz.y, graphics::BufferUsageTransferSrc, graphics::MemoryPropertyHost | graphics::MemoryPropertyCoherent);
+			tan_stag->map();
+			dirty = true;
 		}
 
-		graphics::StagingBuffer nor_stag(sizeof(cvec4) * sz0.x * sz0.y);
-		graphics::StagingBuffer tan_stag(sizeof(cvec4) * sz0.x * sz0.y);
+		auto rect = ivec4(0, 0, sz);
+		compute_terrain_normals(heightfield, sz, extent.y / (extent.x / sz.x), rect, (cvec4*)nor_stag->mapped, (cvec4*)tan_stag->mapped);
+		upload_normal_rect = rect;
+	}
+
+	void cTerrainPrivate::update_heights(const ivec4& _rect)
+	{
+		if (!height_map || heightfield.data.empty() || !normal_map)
+			return;
 
-		auto nor_dat = (cvec4*)nor_stag->mapped;
-		auto tan_dat = (cvec4*)tan_stag->mapped;
+		auto rect = ivec4(max(_rect.x, 0), max(_rect.y, 0), min(_rect.z, (int)heightfield.size.x), min(_rect.w, (int)heightfield.size.y));
+		if (rect.z <= rect.x || rect.w <= rect.y)
+			return;
 
-		auto h = extent.y / (extent.x / sz0.x);
-		for (auto y = 0; y < sz0.y; y++)
+		if (hgt_stag)
 		{
-			for (auto x = 0; x < sz0.x; x++)
+			auto w = heightfield.size.x;
+			auto dst = (uchar*)hgt_stag->mapped;
+			auto pixel_size = height_map->pixel_size;
+			for (auto y = rect.y; y < rect.w; y++)
 			{
-				auto LT = heights[y * sz1.x + x];
-				auto RT = heights[y * sz1.x + x + 1];
-				auto LB = heights[(y + 1) * sz1.x + x];
-				auto RB = heights[(y + 1) * sz1.x + x + 1];
-
-				float hL = (LT + LB) * 0.5f * h;
-				float hR = (RT + RB) * 0.5f * h;
-				float hU = (LT + RT) * 0.5f * h;
-				float hD = (LB + RB) * 0.5f * h;
-
-				auto n = vec3(hL - hR, 2.f, hU - hD);
-				n = normalize(n);
-				n = (n + 1.f) * 0.5f;
-				*nor_dat++ = cvec4(n * 255.f, 255);
-
-				auto t = normalize(vec3(+1.f, hR, 0.f) - vec3(-1.f, hL, 0.f));
-				t = normalize(t);
-				t = (t + 1.f) * 0.5f;
-				*tan_dat++ = cvec4(t * 255.f, 255);
+				for (auto x = rect.x; x < rect.z; x++)
+				{
+					auto v = heightfield.data[y * w + x];
+					auto p = dst + (y * w + x) * pixel_size;
+					switch (height_map->format)
+					{
+					case graphics::Format_R8_UNORM:
+						*p = (uchar)(clamp(v, 0.f, 1.f) * 255.f);
+						break;
+					case graphics::Format_R16_UNORM:
+						*(ushort*)p = packUnorm1x16(v);
+						break;
+					case graphics::Format_R16_SFLOAT:
+						*(ushort*)p = packHalf1x16(v);
+						break;
+					case graphics::Format_R32_SFLOAT:
+						*(float*)p = v;
+						break;
+					}
+				}
 			}
+			upload_height_rect = merge_rect(upload_height_rect, rect);
 		}
 
-		graphics::InstanceCommandBuffer cb(nullptr);
-		graphics::BufferImageCopy cpy;
-		cpy.img_ext = uvec3(sz0, 1);
-		cb->image_barrier(normal_map, cpy.img_sub, graphics::ImageLayoutTransferDst);
-		cb->copy_buffer_to_image(nor_stag.get(), normal_map, { &cpy, 1 });
-		cb->image_barrier(normal_map, cpy.img_sub, graphics::ImageLayoutShaderReadOnly);
-		cb->image_barrier(tangent_map, cpy.img_sub, graphics::ImageLayoutTransferDst);
-		cb->copy_buffer_to_image(tan_stag.get(), tangent_map, { &cpy, 1 });
-		cb->image_barrier(tangent_map, cpy.img_sub, graphics::ImageLayoutShaderReadOnly);
-		cb.excute();
+		auto sz = blocks * tess_level;
+		auto nrect = heightfield_rect_to_normal_rect(heightfield, sz, rect);
+		compute_terrain_normals(heightfield, sz, extent.y / (extent.x / sz.x), nrect, (cvec4*)nor_stag->mapped, (cvec4*)tan_stag->mapped);
+		upload_normal_rect = merge_rect(upload_normal_rect, nrect);
+	}
+
+	void cTerrainPrivate::upload_maps(graphics::CommandBufferPtr cb)
+	{
+		// the staging buffers have the layout of the whole images, so a rect is copied row by row
+		auto upload = [&](graphics::ImagePtr img, graphics::BufferPtr stag, const ivec4& rect) {
+			std::vector<graphics::BufferImageCopy> cpies;
+			for (auto y = rect.y; y < rect.w; y++)
+			{
+				auto& cpy = cpies.emplace_back();
+				cpy.buf_off = (y * img->extent.x + rect.x) * img->pixel_size;
+				cpy.img_off = uvec3(rect.x, y, 0);
+				cpy.img_ext = uvec3(rect.z - rect.x, 1, 1);
+			}
+			cb->image_barrier(img, {}, graphics::ImageLayoutTransferDst);
+			cb->copy_buffer_to_image(stag, img, cpies);
+			cb->image_barrier(img, {}, graphics::ImageLayoutShaderReadOnly);
+		};
+
+		if (upload_normal_rect.z > upload_normal_rect.x && upload_normal_rect.w > upload_normal_rect.y && normal_map)
+		{
+			upload(normal_map, nor_stag, upload_normal_rect);
+			upload(tangent_map, tan_stag, upload_normal_rect);
+		}
+		if (upload_height_rect.z > upload_height_rect.x && upload_height_rect.w > upload_height_rect.y && height_map && hgt_stag)
+			upload(height_map, hgt_stag, upload_height_rect);
+		upload_normal_rect = ivec4(0);
+		upload_height_rect = ivec4(0);
+	}
+
+	float cTerrainPrivate::get_height(float x, float z)
+	{
+		if (heightfield.data.empty())
+			return 0.f;
+		auto pos = node->global_pos();
+		auto ext = extent * node->global_scl();
+		return pos.y + heightfield.sample(vec2((x - pos.x) / ext.x, (z - pos.z) / ext.z)) * ext.y;
+	}
+
+	bool cTerrainPrivate::raycast(const vec3& origin, const vec3& dir, float max_distance, vec3* out_pos)
+	{
+		if (heightfield.data.empty())
+			return false;
+		// in the unit space of the heightfield, the t of the ray stays the same
+		auto pos = node->global_pos();
+		auto ext = extent * node->global_scl();
+		auto t = heightfield.raycast((origin - pos) / ext, dir / ext, max_distance);
+		if (t < 0.f)
+			return false;
+		if (out_pos)
+			*out_pos = origin + dir * t;
+		return true;
 	}
 
 	void cTerrainPrivate::on_active()
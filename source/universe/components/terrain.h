@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../component.h"
+#include "../heightfield.h"
 
 namespace flame
 {
@@ -66,6 +67,20 @@ namespace flame
 		int instance_id = -1;
 		int grass_texture_id = -1;
 
+		// the heights of the height map kept on the cpu, for editing and queries
+		Heightfield heightfield;
+
+		// call after the heightfield is modified in rect (x0, y0, x1, y1, exclusive end, in texels),
+		//  the height, normal and tangent maps are updated in that rect at the next frame
+		// Reflect
+		virtual void update_heights(const ivec4& rect) = 0;
+		// the terrain height at world x, z, the terrain is assumed not rotated
+		// Reflect
+		virtual float get_height(float x, float z) = 0;
+		// dir does not need to be normalized, max_distance is in the length of dir
+		// Reflect
+		virtual bool raycast(const vec3& origin, const vec3& dir, float max_distance, vec3* out_pos = nullptr) = 0;
+
 		struct Create
 		{
 			virtual cTerrainPtr operator()(EntityPtr e) = 0;
@@ -8,6 +8,12 @@ namespace flame
 	{
 		bool dirty = true;
 
+		graphics::BufferPtr nor_stag = nullptr; // the whole normal map on the host, the changed rect is copied from it
+		graphics::BufferPtr tan_stag = nullptr;
+		graphics::BufferPtr hgt_stag = nullptr;
+		ivec4 upload_normal_rect = ivec4(0); // texels waiting to be uploaded
+		ivec4 upload_height_rect = ivec4(0);
+
 		void set_extent(const vec3& extent) override;
 		void set_blocks(const uvec2& blocks) override;
 		void set_tess_level(uint tess_level) override;
@@ -19,8 +25,14 @@ namespace flame
 		void set_grass_channel(uint channel) override;
 		void set_grass_texture_name(const std::filesystem::path& name) override;
 
+		void update_heights(const ivec4& rect) override;
+		float get_height(float x, float z) override;
+		bool raycast(const vec3& origin, const vec3& dir, float max_distance, vec3* out_pos) override;
+
 		~cTerrainPrivate();
+		void load_heights();
 		void update_normal_map();
+		void upload_maps(graphics::CommandBufferPtr cb);
 		void on_init() override;
 		void on_active() override;
 		void on_inactive() override;
@@ -3,10 +3,89 @@
 #include "tile_map_private.h"
 #include "node_private.h"
 #include "mesh_private.h"
+#include "../draw_data.h"
 #include "../systems/renderer_private.h"
 
 namespace flame
 {
+	cTileMapPrivate::~cTileMapPrivate()
+	{
+		node->drawers.remove("tile_map"_h);
+		node->measurers.remove("tile_map"_h);
+		node->data_listeners.remove("tile_map"_h);
+
+		clear_chunks();
+		for (auto& t : templates)
+			delete t.e;
+	}
+
+	void cTileMapPrivate::on_init()
+	{
+		node->drawers.add([this](DrawData& draw_data, cCameraPtr camera) {
+			if (!chunked || chunks.chunks.empty())
+				return;
+
+			if (draw_data.pass == PassInstance)
+			{
+				for (auto& c : chunks.chunks)
+				{
+					if (c.instances_dirty || transform_dirty)
+						update_chunk_instances(c);
+				}
+				transform_dirty = false;
+				return;
+			}
+			if (!(draw_data.categories & CateMesh))
+				return;
+
+			for (auto& c : chunks.chunks)
+			{
+				if (c.ins_id == -1)
+					continue;
+				if (camera && (draw_data.pass == PassGBuffer || draw_data.pass == PassForward) && !AABB_frustum_check(camera->frustum, AABB(c.bounds.get_points(node->transform))))
+					continue;
+				for (auto& b : c.batches)
+				{
+					auto mesh = templates[b.tmpl].parts[b.part].mesh;
+					if (mesh->mesh_res_id == -1 || mesh->material_res_id == -1)
+						continue;
+					auto queue = mesh->material->render_queue;
+					auto pass_ok = false;
+					switch (draw_data.pass)
+					{
+					case PassGBuffer:
+						pass_ok = queue == graphics::RenderQueue::Opaque || queue == graphics::RenderQueue::AlphaTest;
+						break;
+					case PassForward:
+						pass_ok = queue == graphics::RenderQueue::Transparent;
+						break;
+					case PassOcculder:
+						pass_ok = mesh->cast_shadow && queue != graphics::RenderQueue::Transparent;
+						break;
+					case PassPickUp:
+						pass_ok = true;
+						break;
+					}
+					if (!pass_ok)
+						continue;
+					// one instanced draw for the tiles of the chunk that use this part
+					draw_data.mesh_batches.emplace_back(c.ins_id + b.ins_off, b.count, mesh->mesh_res_id, mesh->material_res_id);
+				}
+			}
+		}, "tile_map"_h);
+		node->measurers.add([this](AABB& b) {
+			if (chunked && !chunks.chunks.empty())
+			{
+				auto pos = node->global_pos();
+				b.expand(AABB(pos, pos + extent * node->global_scl()));
+			}
+		}, "tile_map"_h);
+		node->data_listeners.add([this](uint hash) {
+			if (hash == "transform"_h)
+				transform_dirty = true;
+		}, "tile_map"_h);
+	}
+
 	void cTileMapPrivate::set_extent(const vec3& _extent)
 	{
 		if (extent == _extent)
@@ -156,6 +235,24 @@ namespace flame
 		}
 	}
 
+	void cTileMapPrivate::set_chunked(bool v)
+	{
+		if (chunked == v)
+			return;
+		chunked = v;
+
+		if (chunked)
+			entity->remove_all_children();
+		else
+			clear_chunks();
+		dirty = true;
+		dirty_tiles.clear();
+		update_tiles();
+
+		node->mark_transform_dirty();
+		data_changed("chunked"_h);
+	}
+
 	void cTileMapPrivate::on_active()
 	{
 		update_tiles();
@@ -164,7 +261,132 @@ namespace flame
 	void cTileMapPrivate::on_inactive()
 	{
 		dirty = true;
-		entity->remove_all_children();
+		dirty_tiles.clear();
+		if (chunked)
+			clear_chunks();
+		else
+			entity->remove_all_children();
+	}
+
+	uint cTileMapPrivate::get_template(const std::filesystem::path& path)
+	{
+		if (auto it = template_map.find(path); it != template_map.end())
+			return it->second;
+
+		auto& t = templates.emplace_back();
+		t.path = path;
+		t.e = Entity::create(path);
+		if (t.e)
+		{
+			// the meshes of the prefab with their transforms to the prefab's root
+			std::function<void(EntityPtr, const mat4&)> collect;
+			collect = [&](EntityPtr e, const mat4& parent) {
+				auto m = parent;
+				if (auto node = e->get_component<cNodeT>(); node)
+					m = m * translate(mat4(1.f), node->pos) * mat4(node->qut) * scale(mat4(1.f), node->scl);
+				if (auto mesh = e->get_component<cMeshT>(); mesh && mesh->mesh)
+					t.parts.push_back({ mesh, m });
+				for (auto& c : e->children)
+					collect(c.get(), m);
+			};
+			collect(t.e, mat4(1.f));
+		}
+		else
+			printf("cTileMap: cannot load tile: %s\n", path.string().c_str());
+		auto id = (uint)templates.size() - 1;
+		template_map[path] = id;
+		return id;
+	}
+
+	void cTileMapPrivate::clear_chunks()
+	{
+		for (auto& c : chunks.chunks)
+		{
+			if (c.ins_id != -1)
+				sRenderer::instance()->register_batch_instances(c.ins_id, c.ins_count);
+		}
+		chunks.chunks.clear();
+		chunks.count = uvec2(0);
+	}
+
+	void cTileMapPrivate::update_chunk_instances(TileChunks::Chunk& c)
+	{
+		c.instances_dirty = false;
+		if (c.ins_id == -1)
+			return;
+
+		auto gap_x = extent.x / blocks.x;
+		auto gap_y = extent.y / blocks.y;
+		auto gap_z = extent.z / blocks.z;
+		auto renderer = sRenderer::instance();
+		TileChunks::for_each_instance(c, [&](const TileChunks::Tile& tile, uint x, uint y, uint batch, uint off) {
+			auto& b = c.batches[batch];
+			auto tx = c.coord.x * TileChunks::ChunkSize + x;
+			auto ty = c.coord.y * TileChunks::ChunkSize + y;
+			auto m = node->transform * translate(mat4(1.f), vec3((tx + 0.5f) * gap_x, tile.height * gap_y, (ty + 0.5f) * gap_z)) *
+				mat4(angleAxis(radians(90.f * tile.rotation), vec3(0.f, 1.f, 0.f)));
+			renderer->set_batch_instance(c.ins_id + off, m * templates[b.tmpl].parts[b.part].local);
+		});
+	}
+
+	void cTileMapPrivate::update_chunks()
+	{
+		if (dirty_tiles.empty() || chunks.chunks.empty())
+		{
+			dirty_tiles.clear();
+			clear_chunks();
+			chunks.resize(uvec2(blocks.x, blocks.z));
+		}
+		else
+		{
+			for (auto& ij : dirty_tiles)
+				chunks.mark_dirty(ij);
+			dirty_tiles.clear();
+		}
+
+		auto gap_x = extent.x / blocks.x;
+		auto gap_y = extent.y / blocks.y;
+		auto gap_z = extent.z / blocks.z;
+		auto renderer = sRenderer::instance();
+		for (auto& ch : chunks.chunks)
+		{
+			if (!ch.dirty)
+				continue;
+
+			auto ins_count = TileChunks::build(ch, uvec2(blocks.x, blocks.z), [&](uint i, uint j, TileChunks::Tile& tile) {
+				auto a = samples[i + j * (blocks.x + 1)];
+				auto b = samples[i + (j + 1) * (blocks.x + 1)];
+				auto c = samples[i + 1 + (j + 1) * (blocks.x + 1)];
+				auto d = samples[i + 1 + j * (blocks.x + 1)];
+				auto base_lv = min(min(a.height, b.height), min(c.height, d.height));
+				a.height -= base_lv; b.height -= base_lv; c.height -= base_lv; d.height -= base_lv;
+				if (a.height > 1 || b.height > 1 || c.height > 1 || d.height > 1)
+					return;
+
+				auto name = form_name(a, b, c, d);
+				if (auto it = meshes.find(name); it != meshes.end())
+				{
+					tile.tmpl = get_template(it->second.path);
+					// flat tiles get a rotation by the position, so it stays the same when the chunk is rebuilt
+					tile.rotation = name == "0_0_0_0" ? (i * 73856093U ^ j * 19349663U) % 4 : it->second.rotation;
+					tile.height = base_lv;
+				}
+			}, [&](uint tmpl) {
+				return (uint)templates[tmpl].parts.size();
+			});
+
+			if (ins_count != ch.ins_count)
+			{
+				if (ch.ins_id != -1)
+					renderer->register_batch_instances(ch.ins_id, ch.ins_count);
+				ch.ins_id = ins_count > 0 ? renderer->register_batch_instances(-1, ins_count) : -1;
+				ch.ins_count = ch.ins_id != -1 ? ins_count : 0;
+				if (ins_count > 0 && ch.ins_id == -1)
+					printf("cTileMap: out of batch instances\n");
+			}
+			ch.bounds = AABB(vec3(ch.coord.x * TileChunks::ChunkSize * gap_x, 0.f, ch.coord.y * TileChunks::ChunkSize * gap_z),
+				vec3((ch.coord.x + 1) * TileChunks::ChunkSize * gap_x, (ch.max_height + 1) * gap_y, (ch.coord.y + 1) * TileChunks::ChunkSize * gap_z));
+		}
 	}
 
 	void cTileMapPrivate::update_tiles()
@@ -173,6 +395,13 @@ namespace flame
 			return;
 		dirty = false;
 
+		if (chunked)
+		{
+			samples.resize((blocks.x + 1) * (blocks.z + 1));
+			update_chunks();
+			return;
+		}
+
 		if (dirty_tiles.empty())
 		{
 			samples.resize((blocks.x + 1) * (blocks.z + 1));
@@ -182,7 +411,7 @@ namespace flame
 				for (auto i = 0; i < blocks.x * blocks.z; i++)
 				{
 					auto e = Entity::create();
-					e->name = std::format("{}, {}", i % blocks.x, i / blocks.x);
+					e->set_name(std::format("{}, {}", i % blocks.x, i / blocks.x));
 					e->tag = e->tag | TagNotSerialized;
 					e->add_component<cNode>();
 					entity->add_child(e);
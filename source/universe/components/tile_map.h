@@ -45,6 +45,12 @@ namespace flame
 		// Reflect
 		virtual void set_sample(uint idx, const Sample& v) = 0;
 
+		// draw the tiles as instances grouped in chunks, instead of creating an entity and loading a prefab for each tile
+		// Reflect
+		bool chunked = false;
+		// Reflect
+		virtual void set_chunked(bool v) = 0;
+
 		struct Create
 		{
 			virtual cTileMapPtr operator()(EntityPtr e) = 0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "tile_map.h"
+#include "../tile_chunks.h"
 
 namespace flame
 {
@@ -19,17 +20,44 @@ namespace flame
 			}
 		};
 
+		// a tile prefab that is loaded once in chunked mode, its meshes are drawn as batch instances for all tiles that use it
+		struct TileTemplate
+		{
+			struct Part
+			{
+				cMeshPtr mesh;
+				mat4 local; // to the tile
+			};
+
+			std::filesystem::path path;
+			EntityPtr e = nullptr;
+			std::vector<Part> parts;
+		};
+
 		std::map<std::string, Mesh> meshes;
 		bool dirty = true;
 		std::vector<uvec2> dirty_tiles;
 
+		std::vector<TileTemplate> templates;
+		std::map<std::filesystem::path, uint> template_map;
+		TileChunks chunks;
+		bool transform_dirty = true;
+
+		~cTileMapPrivate();
+		void on_init() override;
+
 		void set_extent(const vec3& extent) override;
 		void set_blocks(const uvec3& blocks) override;
 		void set_tiles_path(const std::filesystem::path& path) override;
 		void set_samples(const std::vector<Sample>& samples) override;
 		void set_sample(uint idx, const Sample& v) override;
+		void set_chunked(bool v) override;
 
 		void update_tiles();
+		uint get_template(const std::filesystem::path& path);
+		void clear_chunks();
+		void update_chunks();
+		void update_chunk_instances(TileChunks::Chunk& c);
 
 		void on_active() override;
 		void on_inactive() override;
@@ -13,6 +13,7 @@ namespace flame
 		extent = _extent;
 
 		dirty = true;
+		mesh_dirty = true;
 		node->mark_transform_dirty();
 		data_changed("extent"_h);
 	}
@@ -24,6 +25,7 @@ namespace flame
 		blocks = _blocks;
 
 		dirty = true;
+		mesh_dirty = true;
 		node->mark_transform_dirty();
 		data_changed("blocks"_h);
 	}
@@ -61,6 +63,7 @@ namespace flame
 		if (data_map != old_one)
 		{
 			dirty = true;
+			load_density();
 			update_height_and_normal_map();
 			node->mark_transform_dirty();
 		}
@@ -221,6 +224,56 @@ namespace flame
 		}
 	}
 
+	void cVolumePrivate::load_density()
+	{
+		density.size = uvec3(0);
+		density.data.clear();
+		mesh_dirty = true;
+		if (data_map_name.empty() || data_map_name.native().starts_with(L"0x"))
+			return;
+
+		graphics::Format format;
+		uvec3 ext;
+		std::vector<uchar> pixels;
+		if (!graphics::Image::load_pixels(data_map_name, format, ext, pixels))
+			return;
+		switch (format)
+		{
+		case graphics::Format_R8_UNORM:
+			density.from_unorm8(ext, pixels.data());
+			break;
+		case graphics::Format_R32_SFLOAT:
+			density.resize(ext);
+			memcpy(density.data.data(), pixels.data(), density.data.size() * sizeof(float));
+			break;
+		default:
+			printf("volume: data map format is not supported for cpu meshing\n");
+		}
+	}
+
+	void cVolumePrivate::update_density(const uvec3& min, const uvec3& max)
+	{
+		if (density.data.empty())
+			return;
+		// the corners sample one texel around
+		auto sz = vec3(density.size);
+		mesher.mark_dirty((vec3(min) - 1.f) / sz, (vec3(max) + 1.f) / sz);
+	}
+
+	graphics::MeshPtr cVolumePrivate::get_mesh()
+	{
+		if (density.data.empty())
+			return nullptr;
+		if (mesh_dirty || mesher.blocks != blocks || mesher.cells != mesh_cells || mesher.extent != extent)
+		{
+			mesher.init(blocks, mesh_cells, extent);
+			mesh_dirty = false;
+		}
+		if (mesher.update(density) > 0)
+			mesher.build_mesh(mesh);
+		return &mesh;
+	}
+
 	void cVolumePrivate::on_init()
 	{
 		node->drawers.add([this](DrawData& draw_data, cCameraPtr camera) {
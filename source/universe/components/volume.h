@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../component.h"
+#include "../marching_cubes.h"
 
 namespace flame
 {
@@ -46,6 +47,18 @@ namespace flame
 		int instance_id = -1;
 		int material_res_id = -1;
 
+		// the data map on the cpu, loaded from the data map file without a graphics device, for meshing on the cpu
+		DensityField density;
+		// cubes per block of the cpu mesh
+		uint mesh_cells = 32;
+
+		// call after density is modified in the texels [min, max), the blocks there are meshed again at the next get_mesh
+		// Reflect
+		virtual void update_density(const uvec3& min, const uvec3& max) = 0;
+		// the surface in local space, meshed on the cpu, null if there is no density
+		// Reflect
+		virtual graphics::MeshPtr get_mesh() = 0;
+
 		struct Create
 		{
 			virtual cVolumePtr operator()(EntityPtr e) = 0;
@@ -8,13 +8,21 @@ namespace flame
 	{
 		bool dirty = true;
 
+		MarchingCubesMesher mesher;
+		graphics::Mesh mesh;
+		bool mesh_dirty = true;
+
 		void set_extent(const vec3& extent) override;
 		void set_blocks(const uvec3& blocks) override;
 		void set_data_map_name(const std::filesystem::path& name) override;
 		void set_material_name(const std::filesystem::path& name) override;
 		void set_cast_shadow(bool v) override;
 
+		void update_density(const uvec3& min, const uvec3& max) override;
+		graphics::MeshPtr get_mesh() override;
+
 		~cVolumePrivate();
+		void load_density();
 		void update_height_and_normal_map();
 		void on_init() override;
 		void on_active() override;
@@ -1,5 +1,6 @@
 #include "../../xml.h"
 #include "../../foundation/typeinfo_serialize.h"
+#include "../../foundation/pack.h"
 #include "../world_private.h"
 #include "world_settings_private.h"
 
@@ -38,12 +39,12 @@ namespace flame
 		pugi::xml_document doc;
 		pugi::xml_node doc_root;
 		auto fn = Path::get(filename);
-		if (!std::filesystem::exists(fn))
+		if (!vfs_exists(fn))
 		{
 			wprintf(L"file does not exist: %s\n", filename.c_str());
 			return;
 		}
-		if (!doc.load_file(fn.c_str()) || (doc_root = doc.first_child()).name() != std::string("world"))
+		if (!vfs_load_xml(doc, fn) || (doc_root = doc.first_child()).name() != std::string("world"))
 		{
 			wprintf(L"file is wrong format: %s\n", filename.c_str());
 			return;
@@ -24,6 +24,7 @@ namespace flame
 		uint mesh_id;
 		uint mat_id;
 		cvec4 color;
+		uint lod = 0; // 0 is the mesh itself, see graphics::Mesh::select_lod
 
 		MeshDrawData(uint ins_id, uint mesh_id, uint mat_id, const cvec4& color = cvec4()) :
 			ins_id(ins_id),
@@ -34,6 +35,30 @@ namespace flame
 		}
 	};
 
+	// key to sort mesh draws: pipeline slot (12 bits) | material (16 bits) | mesh (17 bits) | lod (3 bits) | instance (16 bits)
+	//  so the draws of the same mesh, lod and material come with contiguous instances, and merge into one indirect command
+	inline uint64 mesh_draw_sort_key(uint pipeline_slot, const MeshDrawData& d)
+	{
+		return ((uint64)pipeline_slot << 52) | ((uint64)(d.mat_id & 0xffff) << 36) | ((uint64)(d.mesh_id & 0x1ffff) << 19) | ((uint64)(d.lod & 7) << 16) | (uint64)(d.ins_id & 0xffff);
+	}
+
+	// count instances from first of the batch instances (see sRenderer::register_batch_instances), drawn in one instanced draw
+	struct MeshBatchDrawData
+	{
+		uint first;
+		uint count;
+		uint mesh_id;
+		uint mat_id;
+
+		MeshBatchDrawData(uint first, uint count, uint mesh_id, uint mat_id) :
+			first(first),
+			count(count),
+			mesh_id(mesh_id),
+			mat_id(mat_id)
+		{
+		}
+	};
+
 	struct TerrainDrawData
 	{
 		uint ins_id;
@@ -139,12 +164,16 @@ namespace flame
 
 		std::vector<LightData>			lights;
 		std::vector<MeshDrawData>		meshes;
+		std::vector<MeshBatchDrawData>	mesh_batches;
 		std::vector<TerrainDrawData>	terrains; // or grass fields
 		std::vector<SdfDrawData>		sdfs;
 		std::vector<VolumeDrawData>		volumes; // or marching cubes
 		std::vector<ParticleDrawData>	particles;
 
 		bool graphics_debug; // could use this to request a capture
+		// set by orthographic views (the shadow cascades), how many world units their height covers
+		//  the drawers pick lods by it instead of by the camera when it is not 0
+		float view_height;
 
 		void reset(DrawPass _pass, uint _categories)
 		{
@@ -153,12 +182,14 @@ namespace flame
 
 			lights.clear();
 			meshes.clear();
+			mesh_batches.clear();
 			terrains.clear();
 			sdfs.clear();
 			volumes.clear();
 			particles.clear();
 
 			graphics_debug = false;
+			view_height = 0.f;
 		}
 	};
 }
@@ -1,6 +1,7 @@
 #include "../xml.h"
 #include "../foundation/typeinfo_serialize.h"
 #include "../foundation/system.h"
+#include "../foundation/pack.h"
 #include "entity_private.h"
 #include "world_private.h"
 
@@ -342,10 +343,13 @@ namespace flame
 		for (auto& c : e->components)
 			c->on_entity_added();
 
+		child_map_dirty = true;
 		if (depth != (ushort)-1)
 		{
-			e->forward_traversal([this](EntityPrivate* e) {
+			auto world = World::instance();
+			e->forward_traversal([world](EntityPrivate* e) {
 				e->depth = e->parent->depth + 1;
+				world->add_to_name_index(e);
 				if (e->global_enable)
 				{
 					e->message_listeners.call("active"_h, nullptr, nullptr);
@@ -373,8 +377,10 @@ namespace flame
 
 		if (depth != (ushort)-1)
 		{
-			e->backward_traversal([](EntityPrivate* e) {
+			auto world = World::instance();
+			e->backward_traversal([world](EntityPrivate* e) {
 				e->depth = (ushort)-1;
+				world->remove_from_name_index(e);
 				if (e->global_enable)
 				{
 					for (auto& c : e->components)
@@ -407,6 +413,7 @@ namespace flame
 		}
 
 		on_child_removed(e);
+		child_map_dirty = true;
 
 		if (!destroy)
 			it->release();
@@ -425,6 +432,110 @@ namespace flame
 				children[i].release();
 		}
 		children.clear();
+		child_map_dirty = true;
+	}
+
+	void EntityPrivate::set_name(const std::string& _name)
+	{
+		// the name may have been written directly (like by unserializing without the setter), then the hash is out of date
+		if (name == _name && name_hash == sh(_name.c_str()))
+			return;
+		auto in_world = depth != (ushort)-1;
+		if (in_world)
+			World::instance()->remove_from_name_index(this);
+		name = _name;
+		name_hash = sh(name.c_str());
+		if (in_world)
+			World::instance()->add_to_name_index(this);
+		if (parent)
+			parent->child_map_dirty = true;
+	}
+
+	EntityPtr EntityPrivate::find_child_h(uint _name_hash)
+	{
+		// not worth a map for a few children
+		if (children.size() < 16)
+		{
+			for (auto& c : children)
+			{
+				if (c->name_hash == _name_hash)
+					return c.get();
+			}
+			return nullptr;
+		}
+
+		if (child_map_dirty)
+		{
+			child_map.clear();
+			// keep the first child of a name, like find_child does
+			for (auto& c : children)
+				child_map.emplace(c->name_hash, c.get());
+			child_map_dirty = false;
+		}
+		auto it = child_map.find(_name_hash);
+		if (it != child_map.end())
+			return it->second;
+		return nullptr;
+	}
+
+	EntityPtr EntityPrivate::find_child_recursively_h(uint _name_hash)
+	{
+		if (depth == (ushort)-1)
+		{
+			// not in the world, so not indexed
+			for (auto& c : children)
+			{
+				if (c->name_hash == _name_hash)
+					return c.get();
+				if (auto res = c->find_child_recursively_h(_name_hash); res)
+					return res;
+			}
+			return nullptr;
+		}
+
+		// the first one in a depth first walk, same as find_child_recursively
+		auto precedes = [](EntityPtr a, EntityPtr b) {
+			while (b->depth > a->depth)
+				b = b->parent;
+			if (a == b)
+				return true;
+			while (a->depth > b->depth)
+				a = a->parent;
+			if (a == b)
+				return false;
+			while (a->parent != b->parent)
+			{
+				a = a->parent;
+				b = b->parent;
+			}
+			return a->index < b->index;
+		};
+		EntityPtr ret = nullptr;
+		for (auto e = (EntityPrivate*)World::instance()->find_entity(_name_hash); e; e = e->name_next)
+		{
+			if (e->depth <= depth)
+				continue;
+			auto p = e->parent;
+			while (p && p->depth > depth)
+				p = p->parent;
+			if (p == this && (!ret || precedes(e, ret)))
+				ret = e;
+		}
+		return ret;
+	}
+
+	EntityPtr EntityPrivate::find_child_by_path(std::string_view path)
+	{
+		EntityPtr ret = this;
+		for (auto& name : SUS::split(path, '/'))
+		{
+			if (name.empty())
+				continue;
+			ret = ret->find_child_h(sh(name));
+			if (!ret)
+				break;
+		}
+		return ret;
 	}
 
 	EntityPtr EntityPrivate::duplicate(EntityPtr dst)
@@ -432,7 +543,7 @@ namespace flame
 		if (!dst)
 		{
 			dst = Entity::create();
-			dst->name = name;
+			dst->set_name(name);
 			dst->tag = tag;
 			dst->set_enable(enable);
 		}
@@ -529,12 +640,12 @@ namespace flame
 		pugi::xml_node doc_root;
 
 		auto filename = Path::get(_filename);
-		if (!std::filesystem::exists(filename))
+		if (!vfs_exists(filename))
 		{
 			wprintf(L"prefab does not exist: %s\n", _filename.c_str());
 			return false;
 		}
-		if (!doc.load_file(filename.c_str()) || (doc_root = doc.first_child()).name() != std::string("prefab"))
+		if (!vfs_load_xml(doc, filename) || (doc_root = doc.first_child()).name() != std::string("prefab"))
 		{
 			wprintf(L"prefab is wrong format: %s\n", _filename.c_str());
 			return false;
@@ -633,6 +744,7 @@ namespace flame
 					else
 						e->file_id = e->instance_id;
 					unserialize_xml(src, e, spec);
+					e->set_name(e->name);
 				}
 
 				((EntityPtr)dst_o)->add_child(e);
@@ -647,6 +759,7 @@ namespace flame
 			file_id = instance_id;
 
 		unserialize_xml(doc_root, this, spec);
+		set_name(name);
 
 		return true;
 	}
@@ -659,12 +772,12 @@ namespace flame
 
 		if (only_root)
 		{
-			if (!std::filesystem::exists(filename))
+			if (!vfs_exists(filename))
 			{
 				wprintf(L"prefab does not exist: %s\n", _filename.c_str());
 				return false;
 			}
-			if (!doc.load_file(filename.c_str()) || (doc_root = doc.first_child()).name() != std::string("prefab"))
+			if (!vfs_load_xml(doc, filename) || (doc_root = doc.first_child()).name() != std::string("prefab"))
 			{
 				wprintf(L"prefab is wrong format: %s\n", _filename.c_str());
 				return false;
@@ -62,6 +62,10 @@ namespace flame
 
 		// Reflect
 		std::string name;
+		uint name_hash = 0; // sh(name), kept by set_name
+		// keeps the world name index and the parent's child map, use it instead of writing name once the entity is in the world
+		// Reflect
+		virtual void set_name(const std::string& name) = 0;
 		// Reflect
 		TagFlags tag = TagGeneral;
 		// Reflect
@@ -187,6 +191,14 @@ namespace flame
 			return nullptr;
 		}
 
+		// direct child by name hash, a hash map of the children is used when there are many
+		virtual EntityPtr find_child_h(uint name_hash) = 0;
+		// by name hash, uses the world name index when this entity is in the world instead of walking the subtree
+		//  when several descendants share the name, the first one in a depth first walk is returned
+		virtual EntityPtr find_child_recursively_h(uint name_hash) = 0;
+		// a path of child names relative to this entity, like "a/b/c"
+		virtual EntityPtr find_child_by_path(std::string_view path) = 0;
+
 		inline bool has_child(EntityPtr e) const
 		{
 			for (auto& cc : children)
@@ -13,11 +13,18 @@ namespace flame
 		uint created_location;
 #endif
 
+		// intrusive list of the entities that share the same name hash in the world, see WorldPrivate::name_index
+		EntityPrivate* name_prev = nullptr;
+		EntityPrivate* name_next = nullptr;
+		std::unordered_map<uint, EntityPtr> child_map;
+		bool child_map_dirty = true;
+
 		EntityPrivate();
 		~EntityPrivate();
 
 		void update_enable();
 		void set_enable(bool v) override;
+		void set_name(const std::string& name) override;
 
 		Component* add_component_h(uint hash) override;
 		bool remove_component_h(uint hash) override;
@@ -29,6 +36,10 @@ namespace flame
 		void remove_child(EntityPtr e, bool destroy = true) override;
 		void remove_all_children(bool destroy = true) override;
 
+		EntityPtr find_child_h(uint name_hash) override;
+		EntityPtr find_child_recursively_h(uint name_hash) override;
+		EntityPtr find_child_by_path(std::string_view path) override;
+
 		EntityPtr duplicate(EntityPtr dst = nullptr) override;
 
 		ModificationType parse_modification_target(const std::string& target, ModificationParsedData& out, voidptr& obj) override;
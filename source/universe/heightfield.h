@@ -0,0 +1,195 @@
+#pragma once
+
+#include "../foundation/foundation.h"
+
+#include <immintrin.h>
+
+namespace flame
+{
+	// heights in [0, 1] at the texel centers of a height map, sampled the same way as the sampler does (linear, clamp to edge)
+	struct Heightfield
+	{
+		uvec2 size = uvec2(0);
+		std::vector<float> data;
+
+		void resize(const uvec2& sz)
+		{
+			size = sz;
+			data.assign(sz.x * sz.y, 0.f);
+		}
+
+		inline float texel(int x, int y) const
+		{
+			x = clamp(x, 0, (int)size.x - 1);
+			y = clamp(y, 0, (int)size.y - 1);
+			return data[y * size.x + x];
+		}
+
+		inline float sample(const vec2& uv) const
+		{
+			auto coord = uv * vec2(size) - 0.5f;
+			auto coordi = ivec2(floor(coord));
+			auto coordf = coord - vec2(coordi);
+			return mix(
+				mix(texel(coordi.x, coordi.y), texel(coordi.x + 1, coordi.y), coordf.x),
+				mix(texel(coordi.x, coordi.y + 1), texel(coordi.x + 1, coordi.y + 1), coordf.x),
+				coordf.y);
+		}
+
+		// the ray is in the unit space of the field (xz is uv, y is height), returns the t of the first hit within [0, max_t] or -1
+		//  marches half a texel a step and then bisects the step that crosses the surface
+		float raycast(const vec3& origin, const vec3& dir, float max_t) const
+		{
+			if (data.empty())
+				return -1.f;
+
+			// clip to the unit box
+			auto t0 = 0.f, t1 = max_t;
+			for (auto i = 0; i < 3; i++)
+			{
+				if (abs(dir[i]) < 1e-8f)
+				{
+					if (origin[i] < 0.f || origin[i] > 1.f)
+						return -1.f;
+					continue;
+				}
+				auto ta = (0.f - origin[i]) / dir[i];
+				auto tb = (1.f - origin[i]) / dir[i];
+				if (ta > tb)
+					std::swap(ta, tb);
+				t0 = max(t0, ta);
+				t1 = min(t1, tb);
+			}
+			if (t0 > t1)
+				return -1.f;
+
+			auto above = [&](float t) {
+				auto p = origin + dir * t;
+				return p.y - sample(vec2(p.x, p.z));
+			};
+
+			auto f0 = above(t0);
+			if (f0 <= 0.f)
+				return t0;
+			auto horz = max(abs(dir.x), abs(dir.z));
+			auto dt = horz > 1e-8f ? 0.5f / (max(size.x, size.y) * horz) : t1 - t0;
+			dt = max(dt, 1e-6f);
+			for (auto t = t0; t < t1;)
+			{
+				auto tn = min(t + dt, t1);
+				if (above(tn) <= 0.f)
+				{
+					auto a = t, b = tn;
+					for (auto i = 0; i < 12; i++)
+					{
+						auto m = (a + b) * 0.5f;
+						if (above(m) <= 0.f)
+							b = m;
+						else
+							a = m;
+					}
+					return b;
+				}
+				t = tn;
+			}
+			return -1.f;
+		}
+	};
+
+	// the normal map texels (of size sz) that depend on the heightfield texels in rect (x0, y0, x1, y1, exclusive end)
+	inline ivec4 heightfield_rect_to_normal_rect(const Heightfield& hf, const uvec2& sz, const ivec4& rect)
+	{
+		auto scl = vec2(sz) / vec2(hf.size);
+		ivec4 ret;
+		ret.x = (int)floor((rect.x - 0.5f) * scl.x) - 1;
+		ret.y = (int)floor((rect.y - 0.5f) * scl.y) - 1;
+		ret.z = (int)ceil((rect.z + 0.5f) * scl.x) + 1;
+		ret.w = (int)ceil((rect.w + 0.5f) * scl.y) + 1;
+		ret.x = clamp(ret.x, 0, (int)sz.x);
+		ret.y = clamp(ret.y, 0, (int)sz.y);
+		ret.z = clamp(ret.z, 0, (int)sz.x);
+		ret.w = clamp(ret.w, 0, (int)sz.y);
+		return ret;
+	}
+
+	// writes the normal and tangent map texels in rect (x0, y0, x1, y1, exclusive end) of a terrain whose normal map is sz (blocks * tess_level),
+	//  normals and tangents are whole images of sz, h_scale is extent.y / (extent.x / sz.x)
+	//  four texels a time with SSE, the rows are done in parallel
+	inline void compute_terrain_normals(const Heightfield& hf, const uvec2& sz, float h_scale, const ivec4& rect, cvec4* normals, cvec4* tangents)
+	{
+		auto w = rect.z - rect.x;
+		auto h = rect.w - rect.y;
+		if (w <= 0 || h <= 0)
+			return;
+
+		auto vertex_row = [&](int y, float* dst) {
+			auto v = (float)y / sz.y;
+			for (auto x = 0; x <= w; x++)
+				dst[x] = hf.sample(vec2((float)(rect.x + x) / sz.x, v)) * h_scale;
+		};
+
+		parallel_for(h, [&](uint begin, uint end) {
+			std::vector<float> rows((w + 1) * 2 + 4);
+			auto top = rows.data();
+			auto bot = top + w + 1;
+			vertex_row(rect.y + begin, bot);
+			for (auto i = begin; i < end; i++)
+			{
+				auto y = rect.y + i;
+				std::swap(top, bot);
+				vertex_row(y + 1, bot);
+
+				auto nor_dst = normals + y * sz.x + rect.x;
+				auto tan_dst = tangents + y * sz.x + rect.x;
+				auto half = _mm_set1_ps(0.5f);
+				auto two = _mm_set1_ps(2.f);
+				auto four = _mm_set1_ps(4.f);
+				auto scale = _mm_set1_ps(255.f);
+				auto one = _mm_set1_ps(1.f);
+				auto alpha = _mm_set1_epi32(0xff000000);
+				auto encode = [&](__m128 x, __m128 y, __m128 z) {
+					auto r = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(x, one), half), scale));
+					auto g = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(y, one), half), scale));
+					auto b = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(z, one), half), scale));
+					return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), alpha));
+				};
+
+				auto x = 0;
+				for (; x + 4 <= w; x += 4)
+				{
+					auto LT = _mm_loadu_ps(top + x);
+					auto RT = _mm_loadu_ps(top + x + 1);
+					auto LB = _mm_loadu_ps(bot + x);
+					auto RB = _mm_loadu_ps(bot + x + 1);
+					auto hL = _mm_mul_ps(_mm_add_ps(LT, LB), half);
+					auto hR = _mm_mul_ps(_mm_add_ps(RT, RB), half);
+					auto hU = _mm_mul_ps(_mm_add_ps(LT, RT), half);
+					auto hD = _mm_mul_ps(_mm_add_ps(LB, RB), half);
+
+					// n = normalize(hL - hR, 2, hU - hD)
+					auto nx = _mm_sub_ps(hL, hR);
+					auto nz = _mm_sub_ps(hU, hD);
+					auto l = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), four), _mm_mul_ps(nz, nz)));
+					_mm_storeu_si128((__m128i*)(nor_dst + x), encode(_mm_div_ps(nx, l), _mm_div_ps(two, l), _mm_div_ps(nz, l)));
+
+					// t = normalize(2, hR - hL, 0)
+					auto ty = _mm_sub_ps(hR, hL);
+					l = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ty, ty), four));
+					_mm_storeu_si128((__m128i*)(tan_dst + x), encode(_mm_div_ps(two, l), _mm_div_ps(ty, l), _mm_setzero_ps()));
+				}
+				for (; x < w; x++)
+				{
+					auto hL = (top[x] + bot[x]) * 0.5f;
+					auto hR = (top[x + 1] + bot[x + 1]) * 0.5f;
+					auto hU = (top[x] + top[x + 1]) * 0.5f;
+					auto hD = (bot[x] + bot[x + 1]) * 0.5f;
+
+					auto n = normalize(vec3(hL - hR, 2.f, hU - hD));
+					nor_dst[x] = cvec4((n + 1.f) * 0.5f * 255.f, 255);
+					auto t = normalize(vec3(2.f, hR - hL, 0.f));
+					tan_dst[x] = cvec4((t + 1.f) * 0.5f * 255.f, 255);
+				}
+			}
+		}, 16);
+	}
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "../foundation/foundation.h"
+#include "../graphics/model.h"
+#include "systems/marching_cubes_lookup.h"
+
+namespace flame
+{
+	// the density of a volume in [-1, 1] on a grid, >= 0 is inside, sampled the same way as the data map (linear, clamp to edge)
+	struct DensityField
+	{
+		uvec3 size = uvec3(0);
+		std::vector<float> data;
+
+		void resize(const uvec3& sz, float v = -1.f)
+		{
+			size = sz;
+			data.assign(sz.x * sz.y * sz.z, v);
+		}
+
+		// from unorm8 texels, as v * 2 - 1 like the shaders do
+		void from_unorm8(const uvec3& sz, const uchar* src)
+		{
+			resize(sz);
+			for (auto i = 0; i < data.size(); i++)
+				data[i] = src[i] / 255.f * 2.f - 1.f;
+		}
+
+		inline float texel(int x, int y, int z) const
+		{
+			x = clamp(x, 0, (int)size.x - 1);
+			y = clamp(y, 0, (int)size.y - 1);
+			z = clamp(z, 0, (int)size.z - 1);
+			return data[(z * size.y + y) * size.x + x];
+		}
+
+		inline float sample(const vec3& uv) const
+		{
+			auto coord = uv * vec3(size) - 0.5f;
+			auto coordi = ivec3(floor(coord));
+			auto coordf = coord - vec3(coordi);
+			auto layer = [&](int z) {
+				return mix(
+					mix(texel(coordi.x, coordi.y, z), texel(coordi.x + 1, coordi.y, z), coordf.x),
+					mix(texel(coordi.x, coordi.y + 1, z), texel(coordi.x + 1, coordi.y + 1, z), coordf.x),
+					coordf.y);
+			};
+			return mix(layer(coordi.z), layer(coordi.z + 1), coordf.z);
+		}
+	};
+
+	// extracts the surface of a volume on the cpu with the same lookup table as the marching cubes shaders, each block of the volume is cells^3 cubes
+	//  blocks are meshed in parallel and after an edit only the dirty ones again, vertices on block borders are welded when the mesh is built
+	//  needs no graphics device
+	struct MarchingCubesMesher
+	{
+		struct Block
+		{
+			std::vector<vec3> positions; // volume local space (uv * extent)
+			std::vector<vec3> normals;
+			std::vector<uint> indices;
+			std::vector<uint64> keys; // the global edge of a vertex that is on the border of the block, or ~0
+			bool dirty = true;
+		};
+
+		uvec3 blocks = uvec3(0);
+		uint cells = 32; // the gpu uses 128
+		vec3 extent = vec3(1.f);
+		std::vector<Block> block_meshes;
+
+		void init(const uvec3& _blocks, uint _cells, const vec3& _extent)
+		{
+			blocks = _blocks;
+			cells = _cells;
+			extent = _extent;
+			block_meshes.clear();
+			block_meshes.resize(blocks.x * blocks.y * blocks.z);
+		}
+
+		void mark_all_dirty()
+		{
+			for (auto& b : block_meshes)
+				b.dirty = true;
+		}
+
+		// marks the blocks that touch the region [uv_min, uv_max] of the volume
+		void mark_dirty(const vec3& uv_min, const vec3& uv_max)
+		{
+			auto b0 = clamp(ivec3(floor(uv_min * vec3(blocks) - 1e-4f)), ivec3(0), ivec3(blocks) - 1);
+			auto b1 = clamp(ivec3(floor(uv_max * vec3(blocks) + 1e-4f)), ivec3(0), ivec3(blocks) - 1);
+			for (auto z = b0.z; z <= b1.z; z++)
+			{
+				for (auto y = b0.y; y <= b1.y; y++)
+				{
+					for (auto x = b0.x; x <= b1.x; x++)
+						block_meshes[(z * blocks.y + y) * blocks.x + x].dirty = true;
+				}
+			}
+		}
+
+		// meshes the dirty blocks, returns how many were meshed
+		uint update(const DensityField& field)
+		{
+			std::vector<uint> dirty_blocks;
+			for (auto i = 0; i < block_meshes.size(); i++)
+			{
+				if (block_meshes[i].dirty)
+					dirty_blocks.push_back(i);
+			}
+			if (dirty_blocks.empty())
+				return 0;
+
+			parallel_for(dirty_blocks.size(), [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+				{
+					auto idx = dirty_blocks[i];
+					auto b = uvec3(idx % blocks.x, (idx / blocks.x) % blocks.y, idx / (blocks.x * blocks.y));
+					mesh_block(field, b, block_meshes[idx]);
+					block_meshes[idx].dirty = false;
+				}
+			}, 1);
+			return dirty_blocks.size();
+		}
+
+		void mesh_block(const DensityField& field, const uvec3& b, Block& dst) const
+		{
+			dst.positions.clear();
+			dst.normals.clear();
+			dst.indices.clear();
+			dst.keys.clear();
+			if (field.data.empty())
+				return;
+
+			auto n = cells + 1;
+			auto total = uvec3(blocks * cells); // cubes of the whole volume
+			auto base = b * cells;
+			// corners are placed by their global lattice coords, so the neighbor block gets the same values and vertices on the border
+			auto corner_uv = [&](const uvec3& local) {
+				return vec3(base + local) / vec3(total);
+			};
+
+			std::vector<float> values(n * n * n);
+			for (auto z = 0; z < n; z++)
+			{
+				for (auto y = 0; y < n; y++)
+				{
+					for (auto x = 0; x < n; x++)
+						values[(z * n + y) * n + x] = field.sample(corner_uv(uvec3(x, y, z)));
+				}
+			}
+
+			std::vector<int> edge_vertices(n * n * n * 3, -1);
+			auto get_vertex = [&](const uvec3& c0, const uvec3& c1) {
+				auto lo = min(c0, c1);
+				auto hi = max(c0, c1);
+				auto axis = hi.x != lo.x ? 0 : (hi.y != lo.y ? 1 : 2);
+				auto& slot = edge_vertices[((lo.z * n + lo.y) * n + lo.x) * 3 + axis];
+				if (slot != -1)
+					return (uint)slot;
+
+				// always from the lower corner, so both blocks of a border edge compute the same vertex
+				auto v0 = values[(lo.z * n + lo.y) * n + lo.x];
+				auto v1 = values[(hi.z * n + hi.y) * n + hi.x];
+				auto uv = mix(corner_uv(lo), corner_uv(hi), v0 / (v0 - v1));
+				auto h = 0.5f / vec3(field.size);
+				auto grad = vec3(
+					field.sample(uv + vec3(h.x, 0.f, 0.f)) - field.sample(uv - vec3(h.x, 0.f, 0.f)),
+					field.sample(uv + vec3(0.f, h.y, 0.f)) - field.sample(uv - vec3(0.f, h.y, 0.f)),
+					field.sample(uv + vec3(0.f, 0.f, h.z)) - field.sample(uv - vec3(0.f, 0.f, h.z))) / (h * extent);
+				auto l = length(grad);
+
+				slot = dst.positions.size();
+				dst.positions.push_back(uv * extent);
+				dst.normals.push_back(l > 0.f ? -grad / l : vec3(0.f, 1.f, 0.f));
+				auto on_border = false;
+				for (auto i = 0; i < 3; i++)
+				{
+					if (i != axis && (lo[i] == 0 || lo[i] == cells))
+						on_border = true;
+				}
+				if (on_border)
+				{
+					auto g = uvec3(base) + lo;
+					dst.keys.push_back((((uint64)g.z * (total.y + 1) + g.y) * (total.x + 1) + g.x) * 3 + axis);
+				}
+				else
+					dst.keys.push_back(~0ULL);
+				return (uint)slot;
+			};
+
+			for (auto z = 0; z < cells; z++)
+			{
+				for (auto y = 0; y < cells; y++)
+				{
+					for (auto x = 0; x < cells; x++)
+					{
+						auto index = 0U;
+						for (auto i = 0; i < 8; i++)
+						{
+							if (values[((z + ((i >> 2) & 1)) * n + y + ((i >> 1) & 1)) * n + x + (i & 1)] >= 0.f)
+								index |= 1 << i;
+						}
+						if (index == 0 || index == 0xff)
+							continue;
+
+						auto& item = MarchingCubesLookup[index];
+						for (auto i = 0; i < item.TriangleCount * 3; i++)
+						{
+							auto edge = item.Vertices[i];
+							auto i0 = edge & 0x7;
+							auto i1 = edge >> 3;
+							dst.indices.push_back(get_vertex(
+								uvec3(x + (i0 & 1), y + ((i0 >> 1) & 1), z + ((i0 >> 2) & 1)),
+								uvec3(x + (i1 & 1), y + ((i1 >> 1) & 1), z + ((i1 >> 2) & 1))));
+						}
+					}
+				}
+			}
+		}
+
+		// the whole surface, vertices that blocks share on their borders become one
+		void build_mesh(graphics::Mesh& mesh) const
+		{
+			mesh.reset();
+			std::unordered_map<uint64, uint> welded;
+			std::vector<uint> remap;
+			for (auto& b : block_meshes)
+			{
+				remap.resize(b.positions.size());
+				for (auto i = 0; i < b.positions.size(); i++)
+				{
+					auto key = b.keys[i];
+					if (key != ~0ULL)
+					{
+						auto it = welded.find(key);
+						if (it != welded.end())
+						{
+							remap[i] = it->second;
+							continue;
+						}
+						welded.emplace(key, (uint)mesh.positions.size());
+					}
+					remap[i] = mesh.positions.size();
+					mesh.positions.push_back(b.positions[i]);
+					mesh.normals.push_back(b.normals[i]);
+					mesh.bounds.expand(b.positions[i]);
+				}
+				for (auto idx : b.indices)
+					mesh.indices.push_back(remap[idx]);
+			}
+		}
+	};
+}
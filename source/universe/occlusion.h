@@ -0,0 +1,249 @@
+#pragma once
+
+#include "../foundation/foundation.h"
+
+#include <immintrin.h>
+
+namespace flame
+{
+	// a small CPU depth buffer for occlusion culling, it is built from the tests/raster prototype:
+	//  rasterize a few designated occluders at low resolution, build a max-depth hierarchy from it and test bounds against that
+	//  nothing here touches the device, so it can be used (and tested) headless
+	struct OcclusionBuffer
+	{
+		struct Triangle
+		{
+			vec2 v[3];
+			float z0;
+			float dzdx;
+			float dzdy;
+			ivec4 rect; // x0, y0, x1, y1, in pixels, end exclusive
+		};
+
+		uvec2 size = uvec2(0);
+		mat4 proj_view;
+		std::vector<Triangle> triangles;
+		std::vector<uvec2> hiz_sizes;
+		std::vector<std::vector<float>> hiz; // level 0 is the depth buffer itself, each level keeps the max (farthest) depth of its 2x2 children
+
+		// size.x will be aligned to 4 to rasterize 4 pixels at once
+		void begin(const mat4& _proj_view, const uvec2& _size = uvec2(256, 128))
+		{
+			proj_view = _proj_view;
+			_size.x = (max(_size.x, 4U) + 3) & ~3U;
+			_size.y = max(_size.y, 1U);
+			if (size != _size)
+			{
+				size = _size;
+				hiz_sizes.clear();
+				hiz.clear();
+				auto sz = size;
+				for (;;)
+				{
+					hiz_sizes.push_back(sz);
+					hiz.emplace_back().resize(sz.x * sz.y);
+					if (sz.x == 1 && sz.y == 1)
+						break;
+					sz = max((sz + 1U) / 2U, uvec2(1));
+				}
+			}
+			std::fill(hiz[0].begin(), hiz[0].end(), 1.f);
+			triangles.clear();
+		}
+
+		void add_occluder(const vec3* positions, uint positions_count, const uint* indices, uint indices_count, const mat4& transform)
+		{
+			auto mvp = proj_view * transform;
+			std::vector<vec4> clip_positions(positions_count);
+			parallel_for(positions_count, [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+					clip_positions[i] = mvp * vec4(positions[i], 1.f);
+			}, 1024);
+
+			auto fsize = vec2(size);
+			for (auto i = 0; i + 2 < indices_count; i += 3)
+			{
+				vec4 cps[3] = { clip_positions[indices[i + 0]], clip_positions[indices[i + 1]], clip_positions[indices[i + 2]] };
+				// triangles that cross the near plane are skipped, losing an occluder is always safe
+				if (cps[0].w < 1e-4f || cps[1].w < 1e-4f || cps[2].w < 1e-4f)
+					continue;
+
+				Triangle t;
+				float zs[3];
+				for (auto j = 0; j < 3; j++)
+				{
+					auto ndc = vec3(cps[j]) / cps[j].w;
+					t.v[j] = (vec2(ndc) * 0.5f + 0.5f) * fsize;
+					zs[j] = ndc.z;
+				}
+
+				auto d1 = t.v[1] - t.v[0];
+				auto d2 = t.v[2] - t.v[0];
+				auto area = d1.x * d2.y - d2.x * d1.y;
+				if (abs(area) < 1e-6f)
+					continue;
+				if (area < 0.f)
+				{
+					std::swap(t.v[1], t.v[2]);
+					std::swap(zs[1], zs[2]);
+					std::swap(d1, d2);
+					area = -area;
+				}
+
+				t.rect.x = max((int)floor(min(t.v[0].x, min(t.v[1].x, t.v[2].x))), 0);
+				t.rect.y = max((int)floor(min(t.v[0].y, min(t.v[1].y, t.v[2].y))), 0);
+				t.rect.z = min((int)ceil(max(t.v[0].x, max(t.v[1].x, t.v[2].x))), (int)size.x);
+				t.rect.w = min((int)ceil(max(t.v[0].y, max(t.v[1].y, t.v[2].y))), (int)size.y);
+				if (t.rect.x >= t.rect.z || t.rect.y >= t.rect.w)
+					continue;
+				if (min(zs[0], min(zs[1], zs[2])) > 1.f)
+					continue;
+
+				auto dz1 = zs[1] - zs[0];
+				auto dz2 = zs[2] - zs[0];
+				t.z0 = zs[0];
+				t.dzdx = (dz1 * d2.y - dz2 * d1.y) / area;
+				t.dzdy = (dz2 * d1.x - dz1 * d2.x) / area;
+				triangles.push_back(t);
+			}
+		}
+
+		// rasterize the triangles in bands of rows, each band is owned by one thread, 4 pixels are done at once
+		void rasterize()
+		{
+			const auto band_height = 8U;
+			auto n_bands = (size.y + band_height - 1) / band_height;
+			auto& depth = hiz[0];
+			parallel_for(n_bands, [&](uint begin, uint end) {
+				for (auto band = begin; band < end; band++)
+				{
+					auto band_y0 = (int)(band * band_height);
+					auto band_y1 = min(band_y0 + (int)band_height, (int)size.y);
+					for (auto& t : triangles)
+					{
+						auto y0 = max(t.rect.y, band_y0);
+						auto y1 = min(t.rect.w, band_y1);
+						if (y0 >= y1)
+							continue;
+						auto x0 = t.rect.x & ~3;
+						auto x1 = t.rect.z;
+
+						float A[3], B[3], C[3];
+						for (auto k = 0; k < 3; k++)
+						{
+							auto& a = t.v[k];
+							auto& b = t.v[(k + 1) % 3];
+							A[k] = a.y - b.y;
+							B[k] = b.x - a.x;
+							C[k] = -(A[k] * a.x + B[k] * a.y);
+						}
+
+						auto zero = _mm_setzero_ps();
+						auto lane_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+						for (auto y = y0; y < y1; y++)
+						{
+							auto fy = y + 0.5f;
+							auto dst = depth.data() + y * size.x;
+							for (auto x = x0; x < x1; x += 4)
+							{
+								auto xs = _mm_add_ps(_mm_set1_ps((float)x), lane_offsets);
+								auto e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[0]), xs), _mm_set1_ps(B[0] * fy + C[0]));
+								auto e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[1]), xs), _mm_set1_ps(B[1] * fy + C[1]));
+								auto e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[2]), xs), _mm_set1_ps(B[2] * fy + C[2]));
+								auto inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+								if (_mm_movemask_ps(inside) == 0)
+									continue;
+
+								auto z = _mm_add_ps(_mm_set1_ps(t.z0 + (fy - t.v[0].y) * t.dzdy), _mm_mul_ps(_mm_sub_ps(xs, _mm_set1_ps(t.v[0].x)), _mm_set1_ps(t.dzdx)));
+								z = _mm_max_ps(z, zero);
+								auto old_z = _mm_loadu_ps(dst + x);
+								auto new_z = _mm_min_ps(old_z, z);
+								_mm_storeu_ps(dst + x, _mm_or_ps(_mm_and_ps(inside, new_z), _mm_andnot_ps(inside, old_z)));
+							}
+						}
+					}
+				}
+			}, 1);
+		}
+
+		void build_hiz()
+		{
+			for (auto lv = 1; lv < hiz.size(); lv++)
+			{
+				auto& src = hiz[lv - 1];
+				auto& dst = hiz[lv];
+				auto src_sz = hiz_sizes[lv - 1];
+				auto dst_sz = hiz_sizes[lv];
+				parallel_for(dst_sz.y, [&](uint begin, uint end) {
+					for (auto y = begin; y < end; y++)
+					{
+						auto sy0 = min(y * 2, src_sz.y - 1);
+						auto sy1 = min(y * 2 + 1, src_sz.y - 1);
+						for (auto x = 0; x < dst_sz.x; x++)
+						{
+							auto sx0 = min(x * 2, src_sz.x - 1);
+							auto sx1 = min(x * 2 + 1, src_sz.x - 1);
+							dst[y * dst_sz.x + x] = max(max(src[sy0 * src_sz.x + sx0], src[sy0 * src_sz.x + sx1]),
+								max(src[sy1 * src_sz.x + sx0], src[sy1 * src_sz.x + sx1]));
+						}
+					}
+				}, 16);
+			}
+		}
+
+		void end()
+		{
+			rasterize();
+			build_hiz();
+		}
+
+		// false only when the whole bounds is behind the occluders
+		bool is_visible(const AABB& bounds) const
+		{
+			if (triangles.empty())
+				return true;
+
+			vec3 points[8];
+			bounds.get_points(points);
+			auto rect_min = vec2(+10000.f);
+			auto rect_max = vec2(-10000.f);
+			auto z_min = 1.f;
+			for (auto& p : points)
+			{
+				auto c = proj_view * vec4(p, 1.f);
+				if (c.w < 1e-4f)
+					return true;
+				auto ndc = vec3(c) / c.w;
+				auto sp = (vec2(ndc) * 0.5f + 0.5f) * vec2(size);
+				rect_min = min(rect_min, sp);
+				rect_max = max(rect_max, sp);
+				z_min = min(z_min, ndc.z);
+			}
+			if (z_min <= 0.f)
+				return true;
+
+			auto x0 = max((int)floor(rect_min.x), 0);
+			auto y0 = max((int)floor(rect_min.y), 0);
+			auto x1 = min((int)ceil(rect_max.x), (int)size.x);
+			auto y1 = min((int)ceil(rect_max.y), (int)size.y);
+			if (x0 >= x1 || y0 >= y1)
+				return true;
+
+			// pick the level where the rect covers about 2x2 texels
+			auto lv = clamp((int)ceil(log2((float)max(x1 - x0, y1 - y0))) - 1, 0, (int)hiz.size() - 1);
+			auto& lv_data = hiz[lv];
+			auto lv_sz = hiz_sizes[lv];
+			auto ly1 = min((uint)(y1 - 1) >> lv, lv_sz.y - 1);
+			auto lx1 = min((uint)(x1 - 1) >> lv, lv_sz.x - 1);
+			for (auto y = (uint)y0 >> lv; y <= ly1; y++)
+			{
+				for (auto x = (uint)x0 >> lv; x <= lx1; x++)
+				{
+					if (lv_data[y * lv_sz.x + x] >= z_min)
+						return true;
+				}
+			}
+			return false;
+		}
+	};
+}
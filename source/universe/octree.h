@@ -1,3 +1,4 @@
+#include "../foundation/frame_arena.h"
 #include "entity.h"
 #include "components/node.h"
 
@@ -95,7 +96,8 @@ namespace flame
 			return false;
 		}
 
-		void get_colliding(const AABB& check_bounds, std::vector<std::pair<EntityPtr, cNodePtr>>& res, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
+		template<typename A>
+		void get_colliding(const AABB& check_bounds, std::vector<std::pair<EntityPtr, cNodePtr>, A>& res, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
 		{
 			if (!bounds.intersects(check_bounds))
 				return;
@@ -166,7 +168,8 @@ namespace flame
 			return false;
 		}
 
-		void get_colliding(const vec2& check_center, float check_radius, std::vector<std::pair<EntityPtr, cNodePtr>>& res, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
+		template<typename A>
+		void get_colliding(const vec2& check_center, float check_radius, std::vector<std::pair<EntityPtr, cNodePtr>, A>& res, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
 		{
 			if (!bounds.intersects(check_center, check_radius))
 				return;
@@ -237,7 +240,8 @@ namespace flame
 			return false;
 		}
 
-		void get_colliding(const vec3& check_center, float check_radius, std::vector<std::pair<EntityPtr, cNodePtr>>& res, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
+		template<typename A>
+		void get_colliding(const vec3& check_center, float check_radius, std::vector<std::pair<EntityPtr, cNodePtr>, A>& res, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
 		{
 			if (!bounds.intersects(check_center, check_radius))
 				return;
@@ -270,44 +274,43 @@ namespace flame
 				c->get_colliding(check_center, check_radius, res, any_filter, all_filter);
 		}
 
-		//bool is_colliding(const Ray& checkRay, float maxDistance = float.PositiveInfinity)
-		//{
-		//	float distance;
-		//	if (!bounds.IntersectRay(checkRay, out distance) || distance > maxDistance)
-		//		return false;
-
-		//	for (auto i = 0; i < objects.Count; i++)
-		//	{
-		//		if (objects[i].AABB.IntersectRay(checkRay, out distance) && distance <= maxDistance)
-		//			return true;
-		//	}
-
-		//	for (auto& c : children)
-		//	{
-		//		if (c->is_colliding(ref checkRay, maxDistance))
-		//			return true;
-		//	}
-
-		//	return false;
-		//}
-
-		//void get_colliding(ref Ray checkRay, List<T> result, float maxDistance = float.PositiveInfinity)
-		//{
-		//	float distance;
-		//	if (!bounds.IntersectRay(checkRay, out distance) || distance > maxDistance)
-		//		return;
-
-		//	for (auto i = 0; i < objects.Count; i++)
-		//	{
-		//		if (objects[i].AABB.IntersectRay(checkRay, out distance) && distance <= maxDistance)
-		//			result.add(objects[i].Obj);
-		//	}
-
-		//	for (auto& c : children)
-		//		c->get_colliding(ref checkRay, result, maxDistance);
-		//}
-
-		void get_within_frustum(const Frustum& frustum, std::vector<std::pair<EntityPtr, cNodePtr>>& res, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
+		// collect objects whose bounds are hit by the ray, with the entering distance, in no particular order
+		void get_colliding(const vec3& origin, const vec3& inv_dir, float max_t, std::vector<std::pair<float, cNodePtr>>& res, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
+		{
+			if (!bounds.intersects_ray(origin, inv_dir, max_t))
+				return;
+
+			for (auto obj : objects)
+			{
+				auto e = obj->entity;
+				auto t = parent_search_times;
+				while (e)
+				{
+					if (e->global_enable && (any_filter & e->tag) != 0 && (all_filter & e->tag) == all_filter)
+						break;
+					e = e->parent;
+					t--;
+					if (t == 0)
+					{
+						e = nullptr;
+						break;
+					}
+				}
+
+				if (e)
+				{
+					float dist;
+					if (obj->bounds.intersects_ray(origin, inv_dir, max_t, &dist))
+						res.emplace_back(dist, obj);
+				}
+			}
+
+			for (auto& c : children)
+				c->get_colliding(origin, inv_dir, max_t, res, any_filter, all_filter, parent_search_times);
+		}
+
+		template<typename A>
+		void get_within_frustum(const Frustum& frustum, std::vector<std::pair<EntityPtr, cNodePtr>, A>& res, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
 		{
 			if (!AABB_frustum_check(frustum, bounds))
 				return;
@@ -340,6 +343,84 @@ namespace flame
 				c->get_within_frustum(frustum, res, any_filter, all_filter);
 		}
 
+		// test against several frustums with only one walk of the tree, bit i of masks[n] is set when res[n] is inside frustums[i]
+		//  the cells are tested with the bits that are still alive from the parent, the objects are tested in parallel
+		//  the walk keeps its cells and candidates in the frame arena
+		template<typename A, typename B>
+		void get_within_frustums(const Frustum* frustums, uint frustums_count, std::vector<std::pair<EntityPtr, cNodePtr>, A>& res, std::vector<uint, B>& masks, uint any_filter = 0xffffffff, uint all_filter = 0, uint parent_search_times = 0)
+		{
+			assert(frustums_count <= 32);
+
+			struct Candidate
+			{
+				EntityPtr e;
+				cNodePtr n;
+				uint mask;
+			};
+			FrameVector<std::pair<OctNode*, uint>> stack;
+			FrameVector<Candidate> candidates;
+
+			stack.emplace_back(this, frustums_count == 32 ? 0xffffffff : (1U << frustums_count) - 1);
+			while (!stack.empty())
+			{
+				auto [oct, mask] = stack.back();
+				stack.pop_back();
+
+				for (auto i = 0; i < frustums_count; i++)
+				{
+					if ((mask & (1 << i)) && !AABB_frustum_check(frustums[i], oct->bounds))
+						mask &= ~(1 << i);
+				}
+				if (mask == 0)
+					continue;
+
+				for (auto obj : oct->objects)
+				{
+					auto e = obj->entity;
+					auto t = parent_search_times;
+					while (e)
+					{
+						if (e->global_enable && (any_filter & e->tag) != 0 && (all_filter & e->tag) == all_filter)
+							break;
+						e = e->parent;
+						t--;
+						if (t == 0)
+						{
+							e = nullptr;
+							break;
+						}
+					}
+
+					if (e)
+						candidates.push_back({ e, obj, mask });
+				}
+
+				for (auto it = oct->children.rbegin(); it != oct->children.rend(); it++)
+					stack.emplace_back(it->get(), mask);
+			}
+
+			parallel_for(candidates.size(), [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+				{
+					auto& c = candidates[i];
+					for (auto j = 0; j < frustums_count; j++)
+					{
+						if ((c.mask & (1 << j)) && !AABB_frustum_check(frustums[j], c.n->bounds))
+							c.mask &= ~(1 << j);
+					}
+				}
+			}, 256);
+
+			for (auto& c : candidates)
+			{
+				if (c.mask)
+				{
+					res.emplace_back(c.e, c.n);
+					masks.push_back(c.mask);
+				}
+			}
+		}
+
 		OctNode* shrink_if_possible()
 		{
 			if (length < 2.f || (objects.empty() && children.empty()))
@@ -60,33 +60,23 @@ namespace flame
 		if (auto first_element = sScene::instance()->first_element; first_element)
 		{
 			auto last_hovering = hovering_receiver;
-			auto last_hovering_valid = false;
 			auto last_active = active_receiver;
-			auto last_active_valid = false;
-			hovering_receiver = nullptr;
-
-			first_element->traversal_bfs([&](EntityPtr e, int depth) {
-				if (!e->global_enable)
-					return false;
-
-				if (auto receiver = e->get_component<cReceiverT>(); receiver)
-				{
-					if (receiver == last_hovering)
-						last_hovering_valid = true;
-					if (receiver == last_active)
-						last_active_valid = true;
-					if (receiver->element->contains(mpos))
-						hovering_receiver = receiver;
-				}
-
-				return true;
-			});
-
-			if (!last_hovering_valid)
+			if (!receiver_grid.receivers.contains(last_hovering))
 				last_hovering = nullptr;
-			if (!last_active_valid)
+			if (!receiver_grid.receivers.contains(last_active))
 				last_active = nullptr;
 
+			// nothing under the mouse can change while the mouse and the receivers stay the same
+			if (mpos != last_query_mpos || receiver_grid.version != last_query_version || first_element != last_query_root)
+			{
+				hovering_receiver = receiver_grid.query(mpos, first_element);
+				last_query_mpos = mpos;
+				last_query_version = receiver_grid.version;
+				last_query_root = first_element;
+			}
+			else
+				hovering_receiver = last_hovering;
+
 			if (last_hovering != hovering_receiver)
 			{
 				if (last_hovering)
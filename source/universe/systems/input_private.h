@@ -10,6 +10,9 @@ namespace flame
 		bool mbtn_temp[MouseButton_Count] = {};
 		vec2 mpos_temp = vec2(0.f);
 		bool kbtn_temp[KeyboardKey_Count] = {};
+		vec2 last_query_mpos = vec2(-1.f);
+		uint last_query_version = 0;
+		EntityPtr last_query_root = nullptr;
 
 		sInputPrivate();
 		~sInputPrivate();
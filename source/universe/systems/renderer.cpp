@@ -1,12 +1,16 @@
+#include "../../foundation/profiler.h"
+#include "../../foundation/frame_arena.h"
 #include "renderer_private.h"
 #include "scene_private.h"
 #include "input_private.h"
 #include "../octree.h"
+#include "../occlusion.h"
 #include "../draw_data.h"
 #include "../world_private.h"
 #include "../components/node_private.h"
 #include "../components/element_private.h"
 #include "../components/camera_private.h"
+#include "../components/mesh_private.h"
 
 #include "../../foundation/typeinfo_serialize.h"
 #include "../../foundation/window.h"
@@ -36,10 +40,13 @@ namespace flame
 	// Reses
 	std::vector<sRenderer::MatVar>	mat_vars;
 	std::vector<sRenderer::MeshRes>	mesh_reses;
+	uint							mesh_reses_version = 0; // increased when any mesh res changes, the batchers rebuild their commands then
+	std::unordered_map<graphics::MeshPtr, uint> mesh_res_map; // mesh -> index of mesh_reses
 	std::vector<sRenderer::TexRes>	tex_reses;
 	std::vector<sRenderer::MatRes>	mat_reses;
 	// Instances
-	graphics::SparseSlots	mesh_instances;
+	graphics::SparseRanges	mesh_instances; // ranges, see register_mesh_instances
+	graphics::SparseRanges	batch_instances; // ranges, see register_batch_instances
 	graphics::SparseSlots	armature_instances;
 	graphics::SparseSlots	terrain_instances;
 	graphics::SparseSlots	sdf_instances;
@@ -47,9 +54,11 @@ namespace flame
 	graphics::StorageBuffer buf_marching_cubes_loopup;
 	graphics::StorageBuffer buf_transform_feedback;
 	graphics::SparseSlots	dir_lights;
+	std::vector<std::pair<uint, cNodePtr>> dir_shadow_casters; // instance id and node
 	graphics::SparseSlots	pt_lights;
 	// Buffers
 	graphics::StorageBuffer						buf_instance;
+	graphics::StorageBuffer						buf_batch_instance;
 	graphics::StorageBuffer						buf_material;
 	graphics::StorageBuffer						buf_lighting;
 	graphics::StorageBuffer						buf_luma;
@@ -63,6 +72,24 @@ namespace flame
 	graphics::IndexBuffer	buf_idx_arm;
 	graphics::VertexBuffer	buf_particles;
 	graphics::VertexBuffer	buf_primitives;
+	// whether the vertex layouts match graphics::PackedVertex(Arm), then packed meshes are copied as a whole
+	bool					vtx_packed_layout = false;
+	bool					vtx_arm_packed_layout = false;
+	// Layouts, resolved once so the uploads do not look up members by hash
+	enum { VtxPos, VtxUv, VtxNor, VtxTan, VtxBids, VtxBwgts };
+	graphics::UdtWriter		vtx_writer;
+	graphics::UdtWriter		vtx_arm_writer;
+	enum { CamZNear, CamZFar, CamFovy, CamTanHfFovy, CamViewport, CamCoord, CamFront, CamRight, CamUp, CamLastView, CamView, CamViewInv,
+		CamProj, CamProjInv, CamProjView, CamProjViewInv, CamFrustumPlanes, CamTime };
+	graphics::UdtWriter		camera_writer;
+	enum { LitDirLights, LitPtLights, LitDirLightsList, LitPtLightsList, LitDirLightsCount, LitPtLightsCount, LitDirShadows };
+	graphics::UdtWriter		lighting_writer;
+	enum { DirLightDir, DirLightColor, DirLightShadowIndex };
+	graphics::UdtWriter		dir_light_writer;
+	enum { PtLightPos, PtLightColor };
+	graphics::UdtWriter		pt_light_writer;
+	enum { DirShadowSplits, DirShadowFar };
+	graphics::UdtWriter		dir_shadow_writer;
 	// Render Passes
 	graphics::RenderpassPtr rp_fwd = nullptr;
 	graphics::RenderpassPtr rp_fwd_clear = nullptr;
@@ -106,6 +133,7 @@ namespace flame
 	graphics::GraphicsPipelinePtr pl_MC_plain = nullptr;
 	graphics::GraphicsPipelinePtr pl_mesh_pickup = nullptr;
 	graphics::GraphicsPipelinePtr pl_mesh_arm_pickup = nullptr;
+	graphics::GraphicsPipelinePtr pl_mesh_batch_pickup = nullptr;
 	graphics::GraphicsPipelinePtr pl_terrain_pickup = nullptr;
 	graphics::GraphicsPipelinePtr pl_sdf_pickup = nullptr;
 	graphics::GraphicsPipelinePtr pl_MC_pickup = nullptr;
@@ -152,29 +180,53 @@ namespace flame
 
 	struct MeshBatcher
 	{
+		struct PipelineSlot
+		{
+			graphics::GraphicsPipelinePtr pl;
+			bool armature;
+			bool batched; // the low bits of the keys are indices of draw_data.mesh_batches
+		};
+
 		struct Batch
 		{
-			bool				armature;
-			std::vector<uint>	draw_indices;
+			uint				slot;
 			uint				sub_cmd_offset;
 			uint				sub_cmd_count;
 		};
 
 		graphics::IndirectBuffer buf_idr;
-		std::unordered_map<graphics::GraphicsPipelinePtr, Batch> batches;
-
+		std::vector<PipelineSlot> pipelines;
+		std::vector<int> pl_slots; // material id * 3 + (0: mesh, 1: armature, 2: batched) -> index of pipelines
+		std::vector<uint64> keys; // sorted, see mesh_draw_sort_key
+		std::vector<uint64> new_keys;
+		std::vector<uint64> temp_keys;
+		uint last_mesh_reses_version = 0;
+		std::vector<uvec2> batch_ranges; // first and count of the mesh batches, they are not in the keys
+		std::vector<uvec2> new_batch_ranges;
+		std::vector<Batch> batches;
+
+		void clear();
 		void collect(RenderMode render_mode, const DrawData& draw_data, graphics::CommandBufferPtr cb, uint mod2 = 0);
 		void draw(graphics::CommandBufferPtr cb);
 	};
 
+	struct ShadowView
+	{
+		vec3 c;
+		float hf_xlen;
+		float hf_ylen;
+		float z_min;
+		float z_max;
+		DrawData draw_data;
+	};
+
 	struct DirShadow
 	{
+		uint ins_id; // of the light
 		mat3 rot;
 		Frustum frustum;
-		std::vector<std::pair<EntityPtr, cNodePtr>> culled_nodes;
+		ShadowView views[DirShadowMaxLevels];
 		MeshBatcher batcher[DirShadowMaxLevels];
-		std::vector<TerrainDrawData> draw_terrains[DirShadowMaxLevels];
-		std::vector<VolumeDrawData> draw_MCs[DirShadowMaxLevels];
 	};
 
 	struct PointShadow
@@ -183,6 +235,10 @@ namespace flame
 	};
 
 	std::vector<std::pair<EntityPtr, cNodePtr>> camera_culled_nodes;
+	OcclusionBuffer occlusion_buffer;
+	std::vector<uchar> occlusion_visibilities;
+	std::vector<std::pair<EntityPtr, cNodePtr>> view_culled_nodes;
+	std::vector<uint> view_culled_masks; // bit 0 is the camera, then one bit for each level of each directional shadow
 	DrawData draw_data;
 	MeshBatcher gbuffer_batcher;
 	MeshBatcher transparent_batcher;
@@ -311,6 +367,9 @@ namespace flame
 		case "ARMATURE"_h:
 			defines.push_back("vert:ARMATURE");
 			break;
+		case "BATCHED"_h:
+			defines.push_back("vert:BATCHED");
+			break;
 		}
 		switch (modifier2)
 		{
@@ -360,33 +419,125 @@ namespace flame
 		return pl;
 	}
 
+	void MeshBatcher::clear()
+	{
+		pipelines.clear();
+		pl_slots.clear();
+		keys.clear();
+		batch_ranges.clear();
+		batches.clear();
+	}
+
 	void MeshBatcher::collect(RenderMode render_mode, const DrawData& draw_data, graphics::CommandBufferPtr cb, uint mod2)
 	{
-		for (auto i = 0; i < draw_data.meshes.size(); i++)
+		auto n_meshes = (uint)draw_data.meshes.size();
+		auto n_batches = (uint)min(draw_data.mesh_batches.size(), (size_t)0x10000);
+		auto n = n_meshes + n_batches;
+		// grows with the materials, the new ones have no pipelines yet
+		if (pl_slots.size() < mat_reses.size() * 3)
+			pl_slots.resize(mat_reses.size() * 3, -1);
+
+		// every range writes its own part of the keys, the pipelines are only looked up here, getting them may create them so that is done after
+		new_keys.resize(n);
+		std::atomic<bool> any_miss = false;
+		parallel_for(n_meshes, [&](uint begin, uint end) {
+			for (auto i = begin; i < end; i++)
+			{
+				auto& m = draw_data.meshes[i];
+				auto slot = pl_slots[m.mat_id * 3 + (mesh_reses[m.mesh_id].arm ? 1 : 0)];
+				if (slot == -1)
+				{
+					any_miss = true;
+					slot = 0;
+				}
+				new_keys[i] = mesh_draw_sort_key(slot, m);
+			}
+		}, 1024);
+		// a batch takes the place of an instance in the key by its index
+		new_batch_ranges.resize(n_batches);
+		for (auto i = 0; i < n_batches; i++)
 		{
-			auto& m = draw_data.meshes[i];
-			auto& mesh_r = mesh_reses[m.mesh_id];
-			auto& mat_r = mat_reses[m.mat_id];
-			auto pl = get_material_pipeline(render_mode, mat_r, "mesh"_h, mesh_r.arm ? "ARMATURE"_h : 0, mod2);
-			auto it = batches.find(pl);
-			if (it == batches.end())
+			auto& b = draw_data.mesh_batches[i];
+			auto slot = pl_slots[b.mat_id * 3 + 2];
+			if (slot == -1)
 			{
-				it = batches.emplace(pl, Batch()).first;
-				it->second.armature = mesh_r.arm;
+				any_miss = true;
+				slot = 0;
 			}
-			it->second.draw_indices.push_back(i);
+			new_keys[n_meshes + i] = mesh_draw_sort_key(slot, MeshDrawData(i, b.mesh_id, b.mat_id));
+			new_batch_ranges[i] = uvec2(b.first, b.count);
 		}
-
-		for (auto& b : batches)
+		if (any_miss)
 		{
-			b.second.sub_cmd_offset = buf_idr.top;
-			for (auto i : b.second.draw_indices)
+			auto get_slot = [&](uint mat_id, uint mesh_id, bool batched) {
+				auto& mesh_r = mesh_reses[mesh_id];
+				auto& slot = pl_slots[mat_id * 3 + (batched ? 2 : (mesh_r.arm ? 1 : 0))];
+				if (slot == -1)
+				{
+					auto pl = get_material_pipeline(render_mode, mat_reses[mat_id], "mesh"_h, batched ? "BATCHED"_h : (mesh_r.arm ? "ARMATURE"_h : 0), mod2);
+					auto it = std::find_if(pipelines.begin(), pipelines.end(), [&](const auto& ps) {
+						return ps.pl == pl && ps.armature == mesh_r.arm && ps.batched == batched;
+					});
+					slot = it - pipelines.begin();
+					if (it == pipelines.end())
+					{
+						assert(pipelines.size() < 4096);
+						pipelines.push_back({ pl, mesh_r.arm, batched });
+					}
+				}
+				return slot;
+			};
+			for (auto i = 0; i < n_meshes; i++)
 			{
 				auto& m = draw_data.meshes[i];
-				auto& mesh_r = mesh_reses[m.mesh_id];
-				buf_idr.add(mesh_r.idx_cnt, mesh_r.idx_off, mesh_r.vtx_off, 1, (m.mat_id << 16) + m.ins_id);
+				new_keys[i] = mesh_draw_sort_key(get_slot(m.mat_id, m.mesh_id, false), m);
+			}
+			for (auto i = 0; i < n_batches; i++)
+			{
+				auto& b = draw_data.mesh_batches[i];
+				new_keys[n_meshes + i] = mesh_draw_sort_key(get_slot(b.mat_id, b.mesh_id, true), MeshDrawData(i, b.mesh_id, b.mat_id));
 			}
-			b.second.sub_cmd_count = buf_idr.top - b.second.sub_cmd_offset;
+		}
+
+		temp_keys.resize(n);
+		radix_sort(new_keys.data(), temp_keys.data(), n);
+
+		// the indirect buffer still holds the commands of last time
+		if (new_keys == keys && new_batch_ranges == batch_ranges && last_mesh_reses_version == mesh_reses_version)
+			return;
+		keys.swap(new_keys);
+		batch_ranges.swap(new_batch_ranges);
+		last_mesh_reses_version = mesh_reses_version;
+
+		batches.clear();
+		for (auto k : keys)
+		{
+			auto slot = uint(k >> 52);
+			if (batches.empty() || batches.back().slot != slot)
+			{
+				auto& b = batches.emplace_back();
+				b.slot = slot;
+				b.sub_cmd_offset = buf_idr.top;
+			}
+			auto mat_id = uint(k >> 36) & 0xffff;
+			auto& mesh_r = mesh_reses[uint(k >> 19) & 0x1ffff];
+			auto lod = uint(k >> 16) & 7;
+			auto idx_cnt = mesh_r.idx_cnt;
+			auto idx_off = mesh_r.idx_off;
+			if (lod > 0 && !mesh_r.lods.empty())
+			{
+				auto& l = mesh_r.lods[min(lod, (uint)mesh_r.lods.size()) - 1];
+				idx_cnt = l.second;
+				idx_off = l.first;
+			}
+			if (pipelines[slot].batched)
+			{
+				auto& r = batch_ranges[uint(k & 0xffff)];
+				buf_idr.add(idx_cnt, idx_off, mesh_r.vtx_off, r.y, (mat_id << 24) + r.x);
+			}
+			else
+				buf_idr.add(idx_cnt, idx_off, mesh_r.vtx_off, 1, (mat_id << 16) + uint(k & 0xffff));
+			batches.back().sub_cmd_count = buf_idr.top - batches.back().sub_cmd_offset;
 		}
 		buf_idr.upload(cb);
 	}
@@ -395,9 +546,10 @@ namespace flame
 	{
 		for (auto& b : batches)
 		{
-			if (b.second.sub_cmd_count == 0)
+			auto& ps = pipelines[b.slot];
+			if (b.sub_cmd_count == 0 || !ps.pl)
 				continue;
-			if (!b.second.armature)
+			if (!ps.armature)
 			{
 				cb->bind_vertex_buffer(buf_vtx.buf.get(), 0);
 				cb->bind_index_buffer(buf_idx.buf.get(), graphics::IndiceTypeUint);
@@ -407,8 +559,8 @@ namespace flame
 				cb->bind_vertex_buffer(buf_vtx_arm.buf.get(), 0);
 				cb->bind_index_buffer(buf_idx_arm.buf.get(), graphics::IndiceTypeUint);
 			}
-			cb->bind_pipeline(b.first);
-			cb->draw_indexed_indirect(buf_idr.buf.get(), b.second.sub_cmd_offset, b.second.sub_cmd_count);
+			cb->bind_pipeline(ps.pl);
+			cb->draw_indexed_indirect(buf_idr.buf.get(), b.sub_cmd_offset, b.sub_cmd_count);
 		}
 	}
 
@@ -418,6 +570,12 @@ namespace flame
 
 		auto dsl_camera = graphics::DescriptorSetLayout::get(L"flame\\shaders\\camera.dsl");
 		buf_camera.create(graphics::BufferUsageUniform, dsl_camera->get_buf_ui("Camera"_h));
+		if (camera_writer.members.empty())
+		{
+			camera_writer.init(dsl_camera->get_buf_ui("Camera"_h), { "zNear"_h, "zFar"_h, "fovy"_h, "tan_hf_fovy"_h, "viewport"_h, "coord"_h,
+				"front"_h, "right"_h, "up"_h, "last_view"_h, "view"_h, "view_inv"_h, "proj"_h, "proj_inv"_h, "proj_view"_h, "proj_view_inv"_h,
+				"frustum_planes"_h, "time"_h });
+		}
 		ds_camera.reset(graphics::DescriptorSet::create(nullptr, dsl_camera));
 		ds_camera->set_buffer("Camera"_h, 0, buf_camera.buf.get());
 		ds_camera->update();
@@ -669,6 +827,12 @@ namespace flame
 		terrain_instances.init(buf_instance.child_type<TI_A>("terrains"_h)->extent);
 		sdf_instances.init(buf_instance.child_type<TI_A>("sdfs"_h)->extent);
 		volume_instances.init(buf_instance.child_type<TI_A>("volumes"_h)->extent);
+		buf_batch_instance.create(graphics::BufferUsageStorage, dsl_instance->get_buf_ui("BatchInstance"_h));
+		{
+			auto ti = buf_batch_instance.child_type<TI_A>("mats"_h);
+			assert(ti->size == ti->extent * sizeof(mat4));
+			batch_instances.init(ti->extent);
+		}
 		buf_marching_cubes_loopup.create(graphics::BufferUsageStorage, dsl_instance->get_buf_ui("MarchingCubesLookup"_h));
 		{
 			auto items = buf_marching_cubes_loopup.mark_dirty_c(0);
@@ -694,6 +858,7 @@ namespace flame
 		}
 		ds_instance->set_buffer("MarchingCubesLookup"_h, 0, buf_marching_cubes_loopup.buf.get());
 		ds_instance->set_buffer("TransformFeedback"_h, 0, buf_transform_feedback.buf.get());
+		ds_instance->set_buffer("BatchInstance"_h, 0, buf_batch_instance.buf.get());
 		ds_instance->update();
 
 		auto dsl_material = graphics::DescriptorSetLayout::get(L"flame\\shaders\\material.dsl");
@@ -730,6 +895,11 @@ namespace flame
 		buf_lighting.child("ssr_binary_search_steps"_h).as<uint>() = ssr_binary_search_steps;
 		buf_lighting.mark_dirty();
 		buf_lighting.upload(cb.get());
+		lighting_writer.init(dsl_lighting->get_buf_ui("Lighting"_h), { "dir_lights"_h, "pt_lights"_h, "dir_lights_list"_h, "pt_lights_list"_h,
+			"dir_lights_count"_h, "pt_lights_count"_h, "dir_shadows"_h });
+		dir_light_writer.init(lighting_writer.members[LitDirLights].ui, { "dir"_h, "color"_h, "shadow_index"_h });
+		pt_light_writer.init(lighting_writer.members[LitPtLights].ui, { "pos"_h, "color"_h });
+		dir_shadow_writer.init(lighting_writer.members[LitDirShadows].ui, { "splits"_h, "far"_h });
 		dir_lights.init(buf_lighting.child_type<TI_A>("dir_lights"_h)->extent);
 		pt_lights.init(buf_lighting.child_type<TI_A>("pt_lights"_h)->extent);
 		img_shadow_depth.reset(graphics::Image::create(dep_fmt, uvec3(ShadowMapSize, 1), graphics::ImageUsageAttachment));
@@ -787,6 +957,34 @@ namespace flame
 		buf_idx_arm.create(1024 * 128 * 6);
 		buf_particles.create(L"flame\\shaders\\particle.vi", {}, 1024 * 128);
 		buf_primitives.create(L"flame\\shaders\\plain\\plain3d.vi", {}, 1024 * 256);
+		{
+			auto match_layout = [](graphics::VertexBuffer& buf, uint size, std::initializer_list<std::pair<const char*, uint>> members) {
+				auto ui = buf.item_type->retrive_ui();
+				if (!ui || ui->size != size)
+					return false;
+				for (auto& m : members)
+				{
+					auto vi = ui->find_variable(m.first);
+					if (!vi || vi->offset != m.second)
+						return false;
+				}
+				return true;
+			};
+			vtx_packed_layout = match_layout(buf_vtx, sizeof(graphics::PackedVertex), {
+				{ "i_pos", offsetof(graphics::PackedVertex, pos) },
+				{ "i_uv", offsetof(graphics::PackedVertex, uv) },
+				{ "i_nor", offsetof(graphics::PackedVertex, nor) },
+				{ "i_tan", offsetof(graphics::PackedVertex, tan) } });
+			vtx_arm_packed_layout = match_layout(buf_vtx_arm, sizeof(graphics::PackedVertexArm), {
+				{ "i_pos", offsetof(graphics::PackedVertexArm, pos) },
+				{ "i_uv", offsetof(graphics::PackedVertexArm, uv) },
+				{ "i_nor", offsetof(graphics::PackedVertexArm, nor) },
+				{ "i_tan", offsetof(graphics::PackedVertexArm, tan) },
+				{ "i_bids", offsetof(graphics::PackedVertexArm, bids) },
+				{ "i_bwgts", offsetof(graphics::PackedVertexArm, bwgts) } });
+			vtx_writer.init(buf_vtx.item_type->retrive_ui(), { "i_pos"_h, "i_uv"_h, "i_nor"_h, "i_tan"_h });
+			vtx_arm_writer.init(buf_vtx_arm.item_type->retrive_ui(), { "i_pos"_h, "i_uv"_h, "i_nor"_h, "i_tan"_h, "i_bids"_h, "i_bwgts"_h });
+		}
 
 		mesh_reses.resize(1024 * 8);
 
@@ -853,6 +1051,10 @@ namespace flame
 			{ "rp=" + str(rp_col_dep),
 			  "vert:ARMATURE",
 			  "frag:PICKUP" });
+		pl_mesh_batch_pickup = graphics::GraphicsPipeline::get(L"flame\\shaders\\mesh\\mesh.pipeline",
+			{ "rp=" + str(rp_col_dep),
+			  "vert:BATCHED",
+			  "frag:PICKUP" });
 		pl_terrain_pickup = graphics::GraphicsPipeline::get(L"flame\\shaders\\terrain\\terrain.pipeline", { "rp=" + str(rp_col_dep), "frag:PICKUP" });
 		if (use_mesh_shader)
 		{
@@ -1296,6 +1498,20 @@ namespace flame
 		dirty = true;
 	}
 
+	void sRendererPrivate::set_occlusion_culling_enable(bool v)
+	{
+		if (occlusion_culling_enable == v)
+			return;
+		occlusion_culling_enable = v;
+	}
+
+	void sRendererPrivate::set_cpu_pick_up(bool v)
+	{
+		if (cpu_pick_up == v)
+			return;
+		cpu_pick_up = v;
+	}
+
 	int sRendererPrivate::get_mat_var(int id, const std::string& name)
 	{
 		if (id < 0)
@@ -1459,15 +1675,11 @@ namespace flame
 	{
 		if (id < 0)
 		{
-			for (auto i = 0; i < mesh_reses.size(); i++)
+			if (auto it = mesh_res_map.find(mesh); it != mesh_res_map.end())
 			{
-				auto& res = mesh_reses[i];
-				if (res.mesh == mesh)
-				{
-					if (id != -2)
-						res.ref++;
-					return i;
-				}
+				if (id != -2)
+					mesh_reses[it->second].ref++;
+				return it->second;
 			}
 			if (id == -2)
 				return -1;
@@ -1487,49 +1699,84 @@ namespace flame
 		}
 
 		auto& res = mesh_reses[id];
+		if (res.mesh)
+			mesh_res_map.erase(res.mesh);
 		res.mesh = mesh;
 		res.ref = 1;
+		res.generation++;
+		mesh_res_map[mesh] = id;
+		mesh_reses_version++;
 
 		res.vtx_cnt = mesh->positions.size();
 		res.idx_cnt = mesh->indices.size();
-		res.arm = !mesh->bone_ids.empty();
-		if (!res.arm)
+		res.arm = mesh->packed_vertices ? mesh->packed_armature : !mesh->bone_ids.empty();
+		// the indices of the lods go right after the mesh's, all use the same vertices
+		auto add_indices = [&](auto& buf) {
+			res.lods.clear();
+			res.idx_off = buf.add(nullptr, res.idx_cnt + mesh->lod_indices.size());
+			if (res.idx_off == -1)
+				return;
+			auto dst = (uint*)buf.stag->mapped + res.idx_off;
+			memcpy(dst, mesh->indices.data(), sizeof(uint) * res.idx_cnt);
+			memcpy(dst + res.idx_cnt, mesh->lod_indices.data(), sizeof(uint) * mesh->lod_indices.size());
+			for (auto& l : mesh->lods)
+				res.lods.emplace_back(res.idx_off + res.idx_cnt + l.index_offset, l.index_count);
+		};
+		if (mesh->packed_vertices && (res.arm ? vtx_arm_packed_layout : vtx_packed_layout))
 		{
-			res.vtx_off = buf_vtx.add(nullptr, res.vtx_cnt);
-			for (auto i = 0; i < res.vtx_cnt; i++)
+			// the packed stream is already in the buffer layout
+			if (!res.arm)
 			{
-				auto vtx = buf_vtx.item(res.vtx_off + i);
-				vtx.child("i_pos"_h).as<vec3>() = mesh->positions[i];
-				if (!mesh->uvs.empty())
-					vtx.child("i_uv"_h).as<vec2>() = mesh->uvs[i];
-				if (!mesh->normals.empty())
-					vtx.child("i_nor"_h).as<vec3>() = mesh->normals[i];
-				if (!mesh->tangents.empty())
-					vtx.child("i_tan"_h).as<vec3>() = mesh->tangents[i];
+				res.vtx_off = buf_vtx.add(mesh->packed_vertices, res.vtx_cnt);
+				add_indices(buf_idx);
 			}
+			else
+			{
+				res.vtx_off = buf_vtx_arm.add(mesh->packed_vertices, res.vtx_cnt);
+				add_indices(buf_idx_arm);
+			}
+			return id;
+		}
+		mesh->unpack();
 
-			res.idx_off = buf_idx.add(mesh->indices.data(), res.idx_cnt);
+		// interleave the streams by the resolved layout, big meshes are written in parallel
+		auto write_vertices = [&](graphics::VertexBuffer& buf, const graphics::UdtWriter& w) {
+			if (res.vtx_off == -1)
+				return;
+			auto dst = buf.data + res.vtx_off * w.size;
+			auto write = [&](uint begin, uint end) {
+				auto p = dst + begin * w.size;
+				auto n = end - begin;
+				auto write_stream = [&](uint idx, const auto& src) {
+					if (!src.empty() && w.has(idx))
+						graphics::write_stream(p + w.members[idx].offset, w.size, src.data() + begin, n);
+				};
+				write_stream(VtxPos, mesh->positions);
+				write_stream(VtxUv, mesh->uvs);
+				write_stream(VtxNor, mesh->normals);
+				write_stream(VtxTan, mesh->tangents);
+				if (res.arm)
+				{
+					write_stream(VtxBids, mesh->bone_ids);
+					write_stream(VtxBwgts, mesh->bone_weights);
+				}
+			};
+			if (res.vtx_cnt >= 65536)
+				parallel_for(res.vtx_cnt, write, 16384);
+			else
+				write(0, res.vtx_cnt);
+		};
+		if (!res.arm)
+		{
+			res.vtx_off = buf_vtx.add(nullptr, res.vtx_cnt);
+			write_vertices(buf_vtx, vtx_writer);
+			add_indices(buf_idx);
 		}
 		else
 		{
 			res.vtx_off = buf_vtx_arm.add(nullptr, res.vtx_cnt);
-			for (auto i = 0; i < res.vtx_cnt; i++)
-			{
-				auto vtx = buf_vtx_arm.item(res.vtx_off + i);
-				vtx.child("i_pos"_h).as<vec3>() = mesh->positions[i];
-				if (!mesh->uvs.empty())
-					vtx.child("i_uv"_h).as<vec2>() = mesh->uvs[i];
-				if (!mesh->normals.empty())
-					vtx.child("i_nor"_h).as<vec3>() = mesh->normals[i];
-				if (!mesh->tangents.empty())
-					vtx.child("i_tan"_h).as<vec3>() = mesh->tangents[i];
-				if (!mesh->bone_ids.empty())
-					vtx.child("i_bids"_h).as<ivec4>() = mesh->bone_ids[i];
-				if (!mesh->bone_weights.empty())
-					vtx.child("i_bwgts"_h).as<vec4>() = mesh->bone_weights[i];
-			}
-
-			res.idx_off = buf_idx_arm.add(mesh->indices.data(), res.idx_cnt);
+			write_vertices(buf_vtx_arm, vtx_arm_writer);
+			add_indices(buf_idx_arm);
 		}
 
 		return id;
@@ -1540,24 +1787,79 @@ namespace flame
 		auto& res = mesh_reses[id];
 		if (res.ref == 1)
 		{
+			auto idx_cnt = res.lods.empty() ? res.idx_cnt : res.lods.back().first + res.lods.back().second - res.idx_off;
 			if (!res.arm)
 			{
 				buf_vtx.release(res.vtx_off, res.vtx_cnt);
-				buf_idx.release(res.idx_off, res.idx_cnt);
+				buf_idx.release(res.idx_off, idx_cnt);
 			}
 			else
 			{
 				buf_vtx_arm.release(res.vtx_off, res.vtx_cnt);
-				buf_idx_arm.release(res.idx_off, res.idx_cnt);
+				buf_idx_arm.release(res.idx_off, idx_cnt);
 			}
+			res.lods.clear();
 
+			mesh_res_map.erase(res.mesh);
 			res.mesh = nullptr;
 			res.ref = 0;
+			res.generation++;
+			mesh_reses_version++;
 		}
 		else
 			res.ref--;
 	}
 
+	// compact the mesh buffers a part per frame once they are fragmented, and patch the offsets of the moved meshes
+	static void defragment_mesh_buffers()
+	{
+		const auto max_size = 1024U * 64U; // items moved per buffer per frame
+		static std::vector<graphics::SparseRanges::Move> moves;
+		static bool defragmenting[4] = { false, false, false, false };
+		auto defragment = [&](auto& buf, uint slot, bool arm, bool index) {
+			if (!defragmenting[slot])
+			{
+				if (buf.sparse_ranges.fragmentation() < 0.5f)
+					return;
+				defragmenting[slot] = true;
+			}
+			moves.clear();
+			if (buf.defragment(max_size, moves))
+				defragmenting[slot] = false;
+			if (moves.empty())
+				return;
+
+			std::unordered_map<uint, uint> new_offsets;
+			for (auto& m : moves)
+				new_offsets[m.src] = m.dst;
+			for (auto& res : mesh_reses)
+			{
+				if (!res.mesh || res.arm != arm)
+					continue;
+				if (!index)
+				{
+					if (auto it = new_offsets.find(res.vtx_off); it != new_offsets.end())
+						res.vtx_off = it->second;
+				}
+				else
+				{
+					if (auto it = new_offsets.find(res.idx_off); it != new_offsets.end())
+					{
+						auto delta = it->second - res.idx_off;
+						res.idx_off = it->second;
+						for (auto& l : res.lods)
+							l.first += delta;
+					}
+				}
+			}
+			mesh_reses_version++;
+		};
+		defragment(buf_vtx, 0, false, false);
+		defragment(buf_idx, 1, false, true);
+		defragment(buf_vtx_arm, 2, true, false);
+		defragment(buf_idx_arm, 3, true, true);
+	}
+
 	const sRenderer::MeshRes& sRendererPrivate::get_mesh_res_info(uint id)
 	{ 
 		return mesh_reses[id]; 
@@ -1655,40 +1957,13 @@ namespace flame
 			for (auto& pl : res.pls)
 				graphics::GraphicsPipeline::release(pl.second);
 
-			auto has_pl = [&](graphics::GraphicsPipelinePtr pl) {
-				for (auto& pair : res.pls)
-				{
-					if (pair.second == pl)
-						return true;
-				}
-				return false;
-			};
-			for (auto it = gbuffer_batcher.batches.begin(); it != gbuffer_batcher.batches.end();)
-			{
-				if (has_pl(it->first))
-					it = gbuffer_batcher.batches.erase(it);
-				else
-					it++;
-			}
-			for (auto it = transparent_batcher.batches.begin(); it != transparent_batcher.batches.end();)
-			{
-				if (has_pl(it->first))
-					it = transparent_batcher.batches.erase(it);
-				else
-					it++;
-			}
+			// the batchers look up the pipelines again
+			gbuffer_batcher.clear();
+			transparent_batcher.clear();
 			for (auto& s : dir_shadows)
 			{
 				for (auto& mb : s.batcher)
-				{
-					for (auto it = mb.batches.begin(); it != mb.batches.end();)
-					{
-						if (has_pl(it->first))
-							it = mb.batches.erase(it);
-						else
-							it++;
-					}
-				}
+					mb.clear();
 			}
 
 			res.pls.clear();
@@ -1812,28 +2087,52 @@ namespace flame
 
 	void sRendererPrivate::set_dir_light_instance(uint id, const vec3& dir, const vec3& color)
 	{
-		auto ins = buf_lighting.mark_dirty_ci("dir_lights"_h, id);
-		ins.child("dir"_h).as<vec3>() = dir;
-		ins.child("color"_h).as<vec3>() = color;
+		auto ins = buf_lighting.mark_dirty_wi(lighting_writer, LitDirLights, id);
+		dir_light_writer.as<vec3>(ins, DirLightDir) = dir;
+		dir_light_writer.as<vec3>(ins, DirLightColor) = color;
+	}
+
+	void sRendererPrivate::set_dir_light_shadow_caster(uint id, cNodePtr node)
+	{
+		auto it = std::find_if(dir_shadow_casters.begin(), dir_shadow_casters.end(), [id](const auto& c) {
+			return c.first == id;
+		});
+		if (node)
+		{
+			if (it == dir_shadow_casters.end())
+				dir_shadow_casters.emplace_back(id, node);
+			else
+				it->second = node;
+		}
+		else if (it != dir_shadow_casters.end())
+			dir_shadow_casters.erase(it);
 	}
 
 	void sRendererPrivate::set_pt_light_instance(uint id, const vec3& pos, const vec3& color, float range)
 	{
-		auto ins = buf_lighting.mark_dirty_ci("pt_lights"_h, id);
-		ins.child("pos"_h).as<vec3>() = pos;
-		ins.child("color"_h).as<vec3>() = color;
+		auto ins = buf_lighting.mark_dirty_wi(lighting_writer, LitPtLights, id);
+		pt_light_writer.as<vec3>(ins, PtLightPos) = pos;
+		pt_light_writer.as<vec3>(ins, PtLightColor) = color;
 	}
 
 	int sRendererPrivate::register_mesh_instance(int id)
+	{
+		return register_mesh_instances(id, 1);
+	}
+
+	int sRendererPrivate::register_mesh_instances(int id, uint count)
 	{
 		if (id == -1)
 		{
-			id = mesh_instances.get_free_item();
+			id = mesh_instances.get_free_space(count);
 			if (id != -1)
-				set_mesh_instance(id, mat4(1.f), mat3(1.f), cvec4(255));
+			{
+				for (auto i = 0; i < count; i++)
+					set_mesh_instance(id + i, mat4(1.f), mat3(1.f), cvec4(255));
+			}
 		}
 		else
-			mesh_instances.release_item(id);
+			mesh_instances.releases_space(id, count);
 		return id;
 	}
 
@@ -1845,6 +2144,22 @@ namespace flame
 		ins.child("col"_h).as<cvec4>() = col;
 	}
 
+	int sRendererPrivate::register_batch_instances(int id, uint count)
+	{
+		if (id == -1)
+			id = batch_instances.get_free_space(count);
+		else
+			batch_instances.releases_space(id, count);
+		return id;
+	}
+
+	void sRendererPrivate::set_batch_instance(uint id, const mat4& mat)
+	{
+		// mats is the only member, so the offset is the index
+		buf_batch_instance.mark_dirty(id * sizeof(mat4), sizeof(mat4));
+		((mat4*)buf_batch_instance.data)[id] = mat;
+	}
+
 	int sRendererPrivate::register_armature_instance(int id)
 	{
 		if (id == -1)
@@ -2075,16 +2390,53 @@ namespace flame
 		}
 	}
 
+	static void occlusion_cull(cCameraPtr camera, std::vector<std::pair<EntityPtr, cNodePtr>>& nodes)
+	{
+		occlusion_buffer.begin(camera->proj_view_mat);
+		occlusion_visibilities.resize(nodes.size());
+		for (auto i = 0; i < nodes.size(); i++)
+		{
+			occlusion_visibilities[i] = 0;
+			auto node = nodes[i].second;
+			if (auto mesh = node->entity->get_component<cMeshT>(); mesh)
+			{
+				if (mesh->occluder && mesh->mesh && !mesh->parmature)
+				{
+					auto m = mesh->mesh;
+					occlusion_buffer.add_occluder(m->positions.data(), m->positions.size(), m->indices.data(), m->indices.size(), node->transform);
+					occlusion_visibilities[i] = 1; // occluders are not tested against themselves
+				}
+			}
+		}
+		occlusion_buffer.end();
+
+		parallel_for(nodes.size(), [&](uint begin, uint end) {
+			for (auto i = begin; i < end; i++)
+			{
+				if (!occlusion_visibilities[i])
+					occlusion_visibilities[i] = occlusion_buffer.is_visible(nodes[i].second->bounds) ? 1 : 0;
+			}
+		}, 128);
+
+		auto n = 0;
+		for (auto i = 0; i < nodes.size(); i++)
+		{
+			if (occlusion_visibilities[i])
+				nodes[n++] = nodes[i];
+		}
+		nodes.resize(n);
+	}
+
 	void sRendererPrivate::render(int tar_idx, graphics::CommandBufferPtr cb)
 	{
 		if (mark_clear_pipelines)
 		{
-			gbuffer_batcher.batches.clear();
-			transparent_batcher.batches.clear();
+			gbuffer_batcher.clear();
+			transparent_batcher.clear();
 			for (auto& s : dir_shadows)
 			{
 				for (auto& mb : s.batcher)
-					mb.batches.clear();
+					mb.clear();
 			}
 			for (auto& res : mat_reses)
 			{
@@ -2111,6 +2463,7 @@ namespace flame
 			return;
 		}
 
+		FLAME_PROFILE_ZONE("Render");
 		hud_callbacks.call();
 
 		auto first = true;
@@ -2136,46 +2489,145 @@ namespace flame
 			camera->aspect = ext.x / ext.y;
 			camera->update_matrices();
 
-			camera_culled_nodes.clear();
-			sScene::instance()->octree->get_within_frustum(camera->frustum, camera_culled_nodes);
-
-			draw_data.reset(PassInstance, 0);
-			for (auto& n : camera_culled_nodes)
-				n.second->drawers.call<DrawData&, cCameraPtr>(draw_data, camera);
-
-			static auto sp_nearest = graphics::Sampler::get(graphics::FilterNearest, graphics::FilterNearest, false, graphics::AddressClampToEdge);
-
 			auto n_dir_lights = 0;
 			auto n_dir_shadows = 0;
 			auto n_pt_lights = 0;
 			auto n_pt_shadows = 0;
 
+			// view 0 is the camera, then the levels of the directional shadows, all are culled in one walk of the octree
+			Frustum view_frustums[1 + DirShadowMaxCount * DirShadowMaxLevels];
+			ShadowView* shadow_views[1 + DirShadowMaxCount * DirShadowMaxLevels];
+			auto n_views = 1U;
+			view_frustums[0] = camera->frustum;
+			shadow_views[0] = nullptr;
+			if (mode == RenderModeShaded && shadow_distance > 0.f)
+			{
+				auto zn = camera->zNear; auto zf = camera->zFar;
+				for (auto& c : dir_shadow_casters)
+				{
+					if (n_dir_shadows >= countof(dir_shadows))
+						break;
+					auto i = n_dir_shadows++;
+					auto& s = dir_shadows[i];
+					s.ins_id = c.first;
+					s.rot = mat3(c.second->g_qut);
+					s.rot[2] *= -1.f;
+					auto splits = vec4(zf);
+					for (auto lv = 0; lv < csm_levels; lv++)
+					{
+						auto n = lv / (float)csm_levels;
+						auto f = (lv + 1) / (float)csm_levels;
+						n = mix(zn, shadow_distance, n * n);
+						f = mix(zn, shadow_distance, f * f);
+						splits[lv] = f;
+
+						{
+							auto p = camera->proj_mat * vec4(0.f, 0.f, -n, 1.f);
+							n = p.z / p.w;
+						}
+						{
+							auto p = camera->proj_mat * vec4(0.f, 0.f, -f, 1.f);
+							f = p.z / p.w;
+						}
+						auto frustum_slice = Frustum::get_points(camera->proj_view_mat_inv, n, f);
+						if (csm_debug_capture_flag)
+						{
+							{
+								auto& prims = csm_debug_draws.emplace_back();
+								prims.type = PrimitiveQuadList;
+								prims.points = Frustum::points_to_quads(frustum_slice.data());
+								prims.color = cvec4(0, 127, 255, 190);
+								prims.depth_test = false;
+							}
+							{
+								auto& prims = csm_debug_draws.emplace_back();
+								prims.type = PrimitiveLineList;
+								prims.points = Frustum::points_to_lines(frustum_slice.data());
+								prims.color = cvec4(255, 255, 255, 255);
+								prims.depth_test = false;
+							}
+						}
+						auto b = AABB(frustum_slice, inverse(s.rot));
+						auto& v = s.views[lv];
+						v.hf_xlen = (b.b.x - b.a.x) * 0.5f;
+						v.hf_ylen = (b.b.y - b.a.y) * 0.5f;
+						v.c = s.rot * b.center();
+						v.z_min = 0.f;
+						v.z_max = 0.f;
+						v.draw_data.reset(PassOcculder, CateMesh | CateTerrain | CateMarchingCubes);
+
+						auto proj = orthoRH(-v.hf_xlen, +v.hf_xlen, -v.hf_ylen, +v.hf_ylen, 0.f, 20000.f);
+						proj[1][1] *= -1.f;
+						auto view = lookAt(v.c - s.rot[2] * 10000.f, v.c, s.rot[1]);
+						view_frustums[n_views] = Frustum(inverse(proj * view));
+						shadow_views[n_views] = &v;
+						n_views++;
+					}
+
+					auto shadow = buf_lighting.mark_dirty_wi(lighting_writer, LitDirShadows, i);
+					dir_shadow_writer.as<vec4>(shadow, DirShadowSplits) = splits;
+					dir_shadow_writer.as<float>(shadow, DirShadowFar) = shadow_distance;
+				}
+			}
+
+			{
+				FLAME_PROFILE_ZONE("Culling");
+				view_culled_nodes.clear();
+				view_culled_masks.clear();
+				sScene::instance()->octree->get_within_frustums(view_frustums, n_views, view_culled_nodes, view_culled_masks);
+
+				// every node gets its PassInstance once, whichever views it is in
+				camera_culled_nodes.clear();
+				draw_data.reset(PassInstance, 0);
+				for (auto k = 0; k < view_culled_nodes.size(); k++)
+				{
+					auto& n = view_culled_nodes[k];
+					n.second->drawers.call<DrawData&, cCameraPtr>(draw_data, camera);
+					if (view_culled_masks[k] & 1)
+						camera_culled_nodes.push_back(n);
+				}
+
+				// after PassInstance, so that the hidden nodes are still up to date for the shadow views
+				if (occlusion_culling_enable)
+					occlusion_cull(camera, camera_culled_nodes);
+			}
+
+			static auto sp_nearest = graphics::Sampler::get(graphics::FilterNearest, graphics::FilterNearest, false, graphics::AddressClampToEdge);
+
 			cb->begin_debug_label("Upload Buffers");
 			{
+				FLAME_PROFILE_ZONE("Upload Buffers");
+				if (first)
+				{
+					defragment_mesh_buffers();
+					upload_callbacks.call(cb);
+				}
 				buf_vtx.upload(cb);
 				buf_idx.upload(cb);
 				buf_vtx_arm.upload(cb);
 				buf_idx_arm.upload(cb);
 
 				auto& buf_camera = t->buf_camera;
-				buf_camera.child("zNear"_h).as<float>() = camera->zNear;
-				buf_camera.child("zFar"_h).as<float>() = camera->zFar;
-				buf_camera.child("fovy"_h).as<float>() = camera->fovy;
-				buf_camera.child("tan_hf_fovy"_h).as<float>() = tan(radians(camera->fovy * 0.5f));
-				buf_camera.child("viewport"_h).as<vec2>() = ext;
-				buf_camera.child("coord"_h).as<vec3>() = camera->node->global_pos();
-				buf_camera.child("front"_h).as<vec3>() = -camera->view_mat_inv[2];
-				buf_camera.child("right"_h).as<vec3>() = camera->view_mat_inv[0];
-				buf_camera.child("up"_h).as<vec3>() = camera->view_mat_inv[1];
-				buf_camera.child("last_view"_h).as<mat4>() = buf_camera.child("view"_h).as<mat4>();
-				buf_camera.child("view"_h).as<mat4>() = camera->view_mat;
-				buf_camera.child("view_inv"_h).as<mat4>() = camera->view_mat_inv;
-				buf_camera.child("proj"_h).as<mat4>() = camera->proj_mat;
-				buf_camera.child("proj_inv"_h).as<mat4>() = camera->proj_mat_inv;
-				buf_camera.child("proj_view"_h).as<mat4>() = camera->proj_view_mat;
-				buf_camera.child("proj_view_inv"_h).as<mat4>() = camera->proj_view_mat_inv;
-				memcpy(buf_camera.child("frustum_planes"_h).data, camera->frustum.planes, sizeof(vec4) * 6);
-				buf_camera.child("time"_h).as<float>() = total_time;
+				auto& w = camera_writer;
+				auto dst = buf_camera.data;
+				w.as<float>(dst, CamZNear) = camera->zNear;
+				w.as<float>(dst, CamZFar) = camera->zFar;
+				w.as<float>(dst, CamFovy) = camera->fovy;
+				w.as<float>(dst, CamTanHfFovy) = tan(radians(camera->fovy * 0.5f));
+				w.as<vec2>(dst, CamViewport) = ext;
+				w.as<vec3>(dst, CamCoord) = camera->node->global_pos();
+				w.as<vec3>(dst, CamFront) = -camera->view_mat_inv[2];
+				w.as<vec3>(dst, CamRight) = camera->view_mat_inv[0];
+				w.as<vec3>(dst, CamUp) = camera->view_mat_inv[1];
+				w.as<mat4>(dst, CamLastView) = w.as<mat4>(dst, CamView);
+				w.as<mat4>(dst, CamView) = camera->view_mat;
+				w.as<mat4>(dst, CamViewInv) = camera->view_mat_inv;
+				w.as<mat4>(dst, CamProj) = camera->proj_mat;
+				w.as<mat4>(dst, CamProjInv) = camera->proj_mat_inv;
+				w.as<mat4>(dst, CamProjView) = camera->proj_view_mat;
+				w.as<mat4>(dst, CamProjViewInv) = camera->proj_view_mat_inv;
+				memcpy(&w.as<vec4>(dst, CamFrustumPlanes), camera->frustum.planes, sizeof(vec4) * 6);
+				w.as<float>(dst, CamTime) = total_time;
 				buf_camera.mark_dirty();
 				buf_camera.upload(cb);
 
@@ -2196,27 +2648,30 @@ namespace flame
 								switch (l.type)
 								{
 								case LightDirectional:
-									buf_lighting.mark_dirty_ci("dir_lights_list"_h, n_dir_lights).as<uint>() = l.ins_id;
-									if (l.cast_shadow)
+									*(uint*)buf_lighting.mark_dirty_wi(lighting_writer, LitDirLightsList, n_dir_lights) = l.ins_id;
 									{
-										if (n_dir_shadows < countof(dir_shadows))
+										// the shadows were taken from the casters before culling
+										auto idx = -1;
+										if (l.cast_shadow)
 										{
-											auto idx = n_dir_shadows;
-											auto shadow_index = buf_lighting.child("dir_lights"_h).item(l.ins_id).child("shadow_index"_h);
-											shadow_index.as<int>() = idx;
-											buf_lighting.mark_dirty(shadow_index);
-
-											auto& rot = dir_shadows[idx].rot;
-											rot = mat3(n.second->g_qut);
-											rot[2] *= -1.f;
-
-											n_dir_shadows++;
+											for (auto j = 0; j < n_dir_shadows; j++)
+											{
+												if (dir_shadows[j].ins_id == l.ins_id)
+												{
+													idx = j;
+													break;
+												}
+											}
 										}
+										auto ins = lighting_writer.item(buf_lighting.data, LitDirLights, l.ins_id);
+										auto& m = dir_light_writer.members[DirLightShadowIndex];
+										dir_light_writer.as<int>(ins, DirLightShadowIndex) = idx;
+										buf_lighting.mark_dirty(uint(ins - buf_lighting.data) + m.offset, m.size);
 									}
 									n_dir_lights++;
 									break;
 								case LightPoint:
-									buf_lighting.mark_dirty_ci("pt_lights_list"_h, n_dir_lights).as<uint>() = l.ins_id;
+									*(uint*)buf_lighting.mark_dirty_wi(lighting_writer, LitPtLightsList, n_pt_lights) = l.ins_id;
 									if (l.cast_shadow)
 									{
 										if (n_pt_shadows < countof(pt_shadows))
@@ -2231,19 +2686,19 @@ namespace flame
 						}
 					}
 
-					buf_lighting.mark_dirty_c("dir_lights_count"_h).as<uint>() = n_dir_lights;
-					buf_lighting.mark_dirty_c("pt_lights_count"_h).as<uint>() = n_pt_lights;
+					buf_lighting.mark_dirty_w<uint>(lighting_writer, LitDirLightsCount) = n_dir_lights;
+					buf_lighting.mark_dirty_w<uint>(lighting_writer, LitPtLightsCount) = n_pt_lights;
 				}
 				else if (first && (mode == RenderModeCameraLight || mode == RenderModeSimple))
 				{
-					auto ins = buf_lighting.mark_dirty_ci("dir_lights"_h, camera_light_id);
-					ins.child("dir"_h).as<vec3>() = camera->view_mat_inv[2];
-					ins.child("color"_h).as<vec3>() = vec3(1.f);
-					ins.child("shadow_index"_h).as<int>() = -1;
-
-					buf_lighting.mark_dirty_ci("dir_lights_list"_h, 0).as<uint>() = camera_light_id;
-					buf_lighting.mark_dirty_c("dir_lights_count"_h).as<uint>() = 1;
-					buf_lighting.mark_dirty_c("pt_lights_count"_h).as<uint>() = 0;
+					auto ins = buf_lighting.mark_dirty_wi(lighting_writer, LitDirLights, camera_light_id);
+					dir_light_writer.as<vec3>(ins, DirLightDir) = camera->view_mat_inv[2];
+					dir_light_writer.as<vec3>(ins, DirLightColor) = vec3(1.f);
+					dir_light_writer.as<int>(ins, DirLightShadowIndex) = -1;
+
+					*(uint*)buf_lighting.mark_dirty_wi(lighting_writer, LitDirLightsList, 0) = camera_light_id;
+					buf_lighting.mark_dirty_w<uint>(lighting_writer, LitDirLightsCount) = 1;
+					buf_lighting.mark_dirty_w<uint>(lighting_writer, LitPtLightsCount) = 0;
 				}
 
 				buf_lighting.upload(cb);
@@ -2255,128 +2710,69 @@ namespace flame
 			{
 				cb->begin_debug_label("Occulder Pass");
 
-				for (auto i = 0; i < DirShadowMaxCount; i++)
+				if (shadow_distance > 0.f)
 				{
-					auto& s = dir_shadows[i];
-					for (auto j = 0; j < DirShadowMaxLevels; j++)
+					// call the drawers once for all cascades, and then hand the draws out by the visibility masks
+					draw_data.reset(PassOcculder, CateMesh | CateTerrain | CateMarchingCubes);
+					for (auto k = 0; k < view_culled_nodes.size(); k++)
 					{
-						for (auto& b : s.batcher[j].batches)
-							b.second.draw_indices.clear();
+						auto mask = view_culled_masks[k] & ~1U;
+						if (mask == 0)
+							continue;
+
+						auto node = view_culled_nodes[k].second;
+						auto n_mesh_draws = draw_data.meshes.size();
+						auto n_mesh_batch_draws = draw_data.mesh_batches.size();
+						auto n_terrain_draws = draw_data.terrains.size();
+						auto n_MC_draws = draw_data.volumes.size();
+						// the lods come from the finest cascade the node is in, the coarser ones get the same draws
+						draw_data.view_height = shadow_views[std::countr_zero(mask)]->hf_ylen * 2.f;
+						node->drawers.call<DrawData&, cCameraPtr>(draw_data, camera);
+						if (draw_data.meshes.size() == n_mesh_draws && draw_data.mesh_batches.size() == n_mesh_batch_draws && 
+							draw_data.terrains.size() == n_terrain_draws && draw_data.volumes.size() == n_MC_draws)
+							continue;
+
+						vec3 points[8];
+						node->bounds.get_points(points);
+						while (mask)
+						{
+							auto idx = std::countr_zero(mask);
+							mask &= mask - 1;
+
+							auto& v = *shadow_views[idx];
+							auto& dir = dir_shadows[(idx - 1) / csm_levels].rot[2];
+							for (auto& p : points)
+							{
+								auto d = dot(p - v.c, dir);
+								v.z_min = min(d, v.z_min);
+								v.z_max = max(d, v.z_max);
+							}
+							v.draw_data.meshes.insert(v.draw_data.meshes.end(), draw_data.meshes.begin() + n_mesh_draws, draw_data.meshes.end());
+							v.draw_data.mesh_batches.insert(v.draw_data.mesh_batches.end(), draw_data.mesh_batches.begin() + n_mesh_batch_draws, draw_data.mesh_batches.end());
+							v.draw_data.terrains.insert(v.draw_data.terrains.end(), draw_data.terrains.begin() + n_terrain_draws, draw_data.terrains.end());
+							v.draw_data.volumes.insert(v.draw_data.volumes.end(), draw_data.volumes.begin() + n_MC_draws, draw_data.volumes.end());
+						}
 					}
-				}
 
-				if (shadow_distance > 0.f)
-				{
-					auto zn = camera->zNear; auto zf = camera->zFar;
 					for (auto i = 0; i < n_dir_shadows; i++)
 					{
 						auto& s = dir_shadows[i];
-						auto splits = vec4(zf);
 						auto shadow = buf_lighting.mark_dirty_ci("dir_shadows"_h, i);
 						auto mats = (mat4*)shadow.child("mats"_h).data;
 						for (auto lv = 0; lv < csm_levels; lv++)
 						{
-							auto n = lv / (float)csm_levels;
-							auto f = (lv + 1) / (float)csm_levels;
-							n = mix(zn, shadow_distance, n * n);
-							f = mix(zn, shadow_distance, f * f);
-							splits[lv] = f;
-
-							{
-								auto p = camera->proj_mat * vec4(0.f, 0.f, -n, 1.f);
-								n = p.z / p.w;
-							}
-							{
-								auto p = camera->proj_mat * vec4(0.f, 0.f, -f, 1.f);
-								f = p.z / p.w;
-							}
-							auto frustum_slice = Frustum::get_points(camera->proj_view_mat_inv, n, f);
-							if (csm_debug_capture_flag)
-							{
-								{
-									auto& prims = csm_debug_draws.emplace_back();
-									prims.type = PrimitiveQuadList;
-									prims.points = Frustum::points_to_quads(frustum_slice.data());
-									prims.color = cvec4(0, 127, 255, 190);
-									prims.depth_test = false;
-								}
-								{
-									auto& prims = csm_debug_draws.emplace_back();
-									prims.type = PrimitiveLineList;
-									prims.points = Frustum::points_to_lines(frustum_slice.data());
-									prims.color = cvec4(255, 255, 255, 255);
-									prims.depth_test = false;
-								}
-							}
-							auto b = AABB(frustum_slice, inverse(s.rot));
-							auto hf_xlen = (b.b.x - b.a.x) * 0.5f;
-							auto hf_ylen = (b.b.y - b.a.y) * 0.5f;
-							auto hf_zlen = (b.b.z - b.a.z) * 0.5f;
-							auto c = s.rot * b.center();
-
-							auto proj = orthoRH(-hf_xlen, +hf_xlen, -hf_ylen, +hf_ylen, 0.f, 20000.f);
+							auto& v = s.views[lv];
+							s.batcher[lv].collect(mode, v.draw_data, cb, "DEPTH_ONLY"_h);
+
+							auto& c = v.c;
+							auto hf_xlen = v.hf_xlen;
+							auto hf_ylen = v.hf_ylen;
+							auto z_min = v.z_min;
+							auto z_max = v.z_max;
+							auto proj = orthoRH(-hf_xlen, +hf_xlen, -hf_ylen, +hf_ylen, 0.f, z_max - z_min);
 							proj[1][1] *= -1.f;
-							auto view = lookAt(c - s.rot[2] * 10000.f, c, s.rot[1]);
+							auto view = lookAt(c + s.rot[2] * z_min, c, s.rot[1]);
 							auto proj_view = proj * view;
-
-							s.culled_nodes.clear();
-							sScene::instance()->octree->get_within_frustum(inverse(proj_view), s.culled_nodes);
-							draw_data.reset(PassInstance, 0);
-							for (auto& n : s.culled_nodes)
-								n.second->drawers.call<DrawData&, cCameraPtr>(draw_data, camera);
-
-							auto z_min = 0.f;
-							auto z_max = 0.f;
-							auto n_mesh_draws = 0;
-							auto n_terrain_draws = 0;
-							auto n_MC_draws = 0;
-
-							draw_data.reset(PassOcculder, CateMesh | CateTerrain | CateMarchingCubes);
-							for (auto& n : s.culled_nodes)
-							{
-								n.second->drawers.call<DrawData&, cCameraPtr>(draw_data, camera);
-								if (draw_data.meshes.size() > n_mesh_draws)
-								{
-									for (auto& p : n.second->bounds.get_points())
-									{
-										auto d = dot(p - c, s.rot[2]);
-										z_min = min(d, z_min);
-										z_max = max(d, z_max);
-									}
-
-									n_mesh_draws = draw_data.meshes.size();
-								}
-								if (draw_data.terrains.size() > n_terrain_draws)
-								{
-									for (auto& p : n.second->bounds.get_points())
-									{
-										auto d = dot(p - c, s.rot[2]);
-										z_min = min(d, z_min);
-										z_max = max(d, z_max);
-									}
-
-									n_terrain_draws = draw_data.terrains.size();
-								}
-								if (draw_data.volumes.size() > n_MC_draws)
-								{
-									for (auto& p : n.second->bounds.get_points())
-									{
-										auto d = dot(p - c, s.rot[2]);
-										z_min = min(d, z_min);
-										z_max = max(d, z_max);
-									}
-
-									n_MC_draws = draw_data.volumes.size();
-								}
-							}
-							s.batcher[lv].collect(mode, draw_data, cb, "DEPTH_ONLY"_h);
-							s.draw_terrains[lv] = draw_data.terrains;
-							s.draw_MCs[lv] = draw_data.volumes;
-
-							proj = orthoRH(-hf_xlen, +hf_xlen, -hf_ylen, +hf_ylen, 0.f, z_max - z_min);
-							proj[1][1] *= -1.f;
-							view = lookAt(c + s.rot[2] * z_min, c, s.rot[1]);
-							proj_view = proj * view;
 							mats[lv] = proj_view;
 							s.frustum = Frustum(inverse(proj_view));
 							if (csm_debug_capture_flag)
@@ -2425,9 +2821,6 @@ namespace flame
 								}
 							}
 						}
-
-						shadow.child("splits"_h).as<vec4>() = splits;
-						shadow.child("far"_h).as<float>() = shadow_distance;
 					}
 
 					csm_debug_capture_flag = false;
@@ -2439,6 +2832,7 @@ namespace flame
 				}
 
 				buf_instance.upload(cb);
+				buf_batch_instance.upload(cb);
 
 				auto set_blur_args = [&](const vec2 img_size) {
 					t->prm_blur.pc.child("off"_h).as<int>() = -3;
@@ -2463,14 +2857,14 @@ namespace flame
 
 						s.batcher[lv].draw(cb);
 
-						for (auto& dt : s.draw_terrains[lv])
+						for (auto& dt : s.views[lv].draw_data.terrains)
 						{
 							cb->bind_pipeline(get_material_pipeline(mode, mat_reses[dt.mat_id], "terrain"_h, 0, "DEPTH_ONLY"_h));
 							t->prm_fwd.pc.mark_dirty_c("index"_h).as<uint>() = (dt.mat_id << 16) + dt.ins_id;
 							t->prm_fwd.push_constant(cb);
 							cb->draw(4, dt.blocks.x * dt.blocks.y, 0, 0);
 						}
-						for (auto& dv : s.draw_MCs[lv])
+						for (auto& dv : s.views[lv].draw_data.volumes)
 						{
 							cb->bind_pipeline(get_material_pipeline(mode, mat_reses[dv.mat_id], "marching_cubes"_h, 0, "DEPTH_ONLY"_h));
 							t->prm_fwd.pc.mark_dirty_c("index"_h).as<uint>() = (dv.mat_id << 16) + dv.ins_id;
@@ -2521,7 +2915,10 @@ namespace flame
 				cb->end_debug_label();
 			}
 			else
+			{
 				buf_instance.upload(cb);
+				buf_batch_instance.upload(cb);
+			}
 
 			cb->set_viewport_and_scissor(Rect(vec2(0), ext));
 
@@ -2530,8 +2927,6 @@ namespace flame
 				// deferred shading pass
 				cb->begin_debug_label("Deferred Shading");
 				{
-					for (auto& b : gbuffer_batcher.batches)
-						b.second.draw_indices.clear();
 					draw_data.reset(PassGBuffer, CateMesh | CateTerrain | CateSDF | CateMarchingCubes);
 					for (auto& n : camera_culled_nodes)
 					{
@@ -2631,8 +3026,6 @@ namespace flame
 					cb->draw(3, 1, 0, 0);
 					cb->end_renderpass();
 
-					for (auto& b : transparent_batcher.batches)
-						b.second.draw_indices.clear();
 					draw_data.reset(PassForward, CateMesh | CateGrassField | CateParticle);
 					for (auto& n : camera_culled_nodes)
 					{
@@ -2797,6 +3190,14 @@ namespace flame
 							cb->draw_indexed(mesh_res.idx_cnt, mesh_res.idx_off, mesh_res.vtx_off, 1, (m.mat_id << 16) + m.ins_id);
 						}
 					}
+					for (auto& b : draw_data.mesh_batches)
+					{
+						auto& mesh_res = mesh_reses[b.mesh_id];
+						cb->bind_vertex_buffer(buf_vtx.buf.get(), 0);
+						cb->bind_index_buffer(buf_idx.buf.get(), graphics::IndiceTypeUint);
+						cb->bind_pipeline(get_material_pipeline(mode, mat_reses[b.mat_id], "mesh"_h, "BATCHED"_h, "FORCE_FORWARD"_h));
+						cb->draw_indexed(mesh_res.idx_cnt, mesh_res.idx_off, mesh_res.vtx_off, b.count, (b.mat_id << 24) + b.first);
+					}
 
 					cb->end_renderpass();
 				}
@@ -3241,7 +3642,20 @@ namespace flame
 		if (screen_pos.x >= sz.x || screen_pos.y >= sz.y)
 			return nullptr;
 
-		std::vector<cNodePtr> nodes;
+		if (cpu_pick_up && !draw_callback)
+		{
+			auto ndc = (vec2(screen_pos) + 0.5f) / sz * 2.f - 1.f;
+			auto unproject = [&](float depth) {
+				auto p = camera->proj_mat_inv * vec4(ndc, depth, 1.f);
+				p /= p.w;
+				return vec3(camera->view_mat_inv * p);
+			};
+			auto p0 = unproject(0.f);
+			auto p1 = unproject(1.f);
+			return sScene::instance()->raycast(p0, p1 - p0, distance(p0, p1), out_pos);
+		}
+
+		FrameVector<cNodePtr> nodes;
 
 		graphics::InstanceCommandBuffer cb(fence_pickup);
 		cb->begin_debug_label("Pick Up");
@@ -3252,10 +3666,11 @@ namespace flame
 			prm_fwd.bind_dss(cb.get());
 
 			auto n_mesh_draws = 0;
+			auto n_mesh_batch_draws = 0;
 			auto n_terrain_draws = 0;
 			auto n_MC_draws = 0;
 			draw_data.reset(PassPickUp, CateMesh | CateTerrain | CateMarchingCubes);
-			std::vector<std::pair<EntityPtr, cNodePtr>> camera_culled_nodes; // collect here (again), because there may have changes between render() and pick_up()
+			FrameVector<std::pair<EntityPtr, cNodePtr>> camera_culled_nodes; // collect here (again), because there may have changes between render() and pick_up()
 			sScene::instance()->octree->get_within_frustum(camera->frustum, camera_culled_nodes);
 			for (auto& n : camera_culled_nodes)
 			{
@@ -3294,6 +3709,21 @@ namespace flame
 				}
 				n_mesh_draws = draw_data.meshes.size();
 
+				for (auto i = n_mesh_batch_draws; i < draw_data.mesh_batches.size(); i++)
+				{
+					auto& b = draw_data.mesh_batches[i];
+					auto& mesh_res = mesh_reses[b.mesh_id];
+					cb->bind_vertex_buffer(buf_vtx.buf.get(), 0);
+					cb->bind_index_buffer(buf_idx.buf.get(), graphics::IndiceTypeUint);
+					cb->bind_pipeline(pl_mesh_batch_pickup);
+					prm_fwd.pc.mark_dirty_c("i"_h).as<ivec4>() = ivec4((int)nodes.size() + 1, 0, 0, 0);
+					prm_fwd.push_constant(cb.get());
+					cb->draw_indexed(mesh_res.idx_cnt, mesh_res.idx_off, mesh_res.vtx_off, b.count, b.first);
+
+					nodes.push_back(n.second);
+				}
+				n_mesh_batch_draws = draw_data.mesh_batches.size();
+
 				for (auto i = n_terrain_draws; i < draw_data.terrains.size(); i++)
 				{
 					cb->bind_pipeline(pl_terrain_pickup);
@@ -86,7 +86,9 @@ namespace flame
 			uint vtx_cnt;
 			uint idx_off;
 			uint idx_cnt;
+			std::vector<std::pair<uint, uint>> lods; // index offset and count of each lod of the mesh, right after the mesh's indices
 			uint ref = 0;
+			uint generation = 0; // increased when the slot takes or releases a mesh, for the data others keep by the id
 		};
 
 		struct MatRes
@@ -259,6 +261,17 @@ namespace flame
 		float gamma = 1.5f;
 		// Reflect
 		virtual void set_gamma(float v) = 0;
+		// cull the nodes that are hidden behind the meshes marked as occluder, with a CPU depth buffer
+		// Reflect
+		bool occlusion_culling_enable = false;
+		// Reflect
+		virtual void set_occlusion_culling_enable(bool v) = 0;
+		// pick up by casting a ray on the CPU (see sScene::raycast) instead of rendering an id buffer and reading it back
+		//  only used when there is no custom draw callback
+		// Reflect
+		bool cpu_pick_up = false;
+		// Reflect
+		virtual void set_cpu_pick_up(bool v) = 0;
 
 		// Reflect
 		virtual int get_mat_var(int id, const std::string& name) = 0;
@@ -306,6 +319,9 @@ namespace flame
 		virtual int register_light_instance(LightType type, int id) = 0;
 		// Reflect
 		virtual void set_dir_light_instance(uint id, const vec3& dir, const vec3& color) = 0;
+		// the shadow views of the casters are known before culling, so they are culled with the camera in one walk, node == nullptr to remove it
+		// Reflect
+		virtual void set_dir_light_shadow_caster(uint id, cNodePtr node) = 0;
 		// Reflect
 		virtual void set_pt_light_instance(uint id, const vec3& pos, const vec3& color, float range) = 0;
 
@@ -314,6 +330,16 @@ namespace flame
 		virtual int register_mesh_instance(int id) = 0;
 		// Reflect
 		virtual void set_mesh_instance(uint id, const mat4& mat, const mat3& nor, const cvec4& col) = 0;
+		// count contiguous instances, so the draws of them merge into one instanced draw, id == -1 to register or to unregister the ones from id
+		// Reflect
+		virtual int register_mesh_instances(int id, uint count) = 0;
+
+		// count contiguous transforms that are drawn by MeshBatchDrawData in one instanced draw, it is not bounded by the mesh instances,
+		//  id == -1 to register or to unregister the ones from id
+		// Reflect
+		virtual int register_batch_instances(int id, uint count) = 0;
+		// Reflect
+		virtual void set_batch_instance(uint id, const mat4& mat) = 0;
 
 		// id == -1 to register or to unregister id
 		// Reflect
@@ -360,6 +386,8 @@ namespace flame
 		virtual graphics::ImagePtr get_image(uint name) = 0;
 
 		Listeners<void()> hud_callbacks;
+		// called once a frame with the frame's command buffer before anything is drawn, to record uploads without waiting for the queue
+		Listeners<void(graphics::CommandBufferPtr)> upload_callbacks;
 
 		virtual void hud_begin(const vec2& pos, const vec2& size = vec2(0.f) /* 0 size means auto layout */, const cvec4& col = cvec4(0, 0, 0, 255), const vec2& pivot = vec2(0.f),
 			const graphics::ImageDesc& image = {}, float image_scale = 1.f) = 0;
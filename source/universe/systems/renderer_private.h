@@ -160,6 +160,8 @@ namespace flame
 		void set_ssr_binary_search_steps(uint v) override;
 		void set_tone_mapping_enable(bool v) override;
 		void set_gamma(float v) override;
+		void set_occlusion_culling_enable(bool v) override;
+		void set_cpu_pick_up(bool v) override;
 
 		int get_mat_var(int id, const std::string& name) override;
 		void release_mat_var(uint id) override;
@@ -185,10 +187,14 @@ namespace flame
 
 		int register_light_instance(LightType type, int id) override;
 		void set_dir_light_instance(uint id, const vec3& dir, const vec3& color) override;
+		void set_dir_light_shadow_caster(uint id, cNodePtr node) override;
 		void set_pt_light_instance(uint id, const vec3& pos, const vec3& color, float range) override;
 
 		int register_mesh_instance(int id) override;
 		void set_mesh_instance(uint id, const mat4& mat, const mat3& nor, const cvec4& col) override;
+		int register_mesh_instances(int id, uint count) override;
+		int register_batch_instances(int id, uint count) override;
+		void set_batch_instance(uint id, const mat4& mat) override;
 
 		int register_armature_instance(int id) override;
 		void set_armature_instance(uint id, const mat4* mats, uint size) override;
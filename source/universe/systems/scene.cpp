@@ -1,3 +1,4 @@
+#include "../../foundation/profiler.h"
 #include "../../graphics/image.h"
 #include "../../graphics/model.h"
 #include "../entity_private.h"
@@ -6,11 +7,14 @@
 #include "../components/element_private.h"
 #include "../components/layout_private.h"
 #include "../components/mesh_private.h"
+#include "../components/armature_private.h"
 #include "../components/terrain_private.h"
 #include "../components/volume_private.h"
 #include "../components/nav_agent_private.h"
 #include "../components/nav_obstacle_private.h"
+#include "../components/collider_private.h"
 #include "../octree.h"
+#include "../bvh.h"
 #include "../draw_data.h"
 #include "scene_private.h"
 #include "renderer_private.h"
@@ -533,7 +537,7 @@ namespace flame
 					}
 					if (auto terrain = e->get_component<cTerrain>(); terrain)
 					{
-						if (auto height_map = terrain->height_map; height_map)
+						if (auto& heightfield = terrain->heightfield; !heightfield.data.empty())
 						{
 							auto blocks = terrain->blocks;
 							auto tess_level = terrain->tess_level;
@@ -550,7 +554,7 @@ namespace flame
 								for (auto x = 0; x < cx + 1; x++)
 								{
 									positions[pos_off + z * (cx + 1) + x] = mat * vec4(x * extent.x,
-										height_map->linear_sample_staging_pixels(vec2((float)x / cx, (float)z / cz)).x * extent.y,
+										heightfield.sample(vec2((float)x / cx, (float)z / cz)) * extent.y,
 										z * extent.z, 1.f);
 								}
 							}
@@ -589,6 +593,20 @@ namespace flame
 					}
 					if (auto volume = e->get_component<cVolume>(); volume && volume->marching_cubes)
 					{
+						// the cpu mesh when the density is there, it also works without a device
+						if (auto mesh = volume->get_mesh(); mesh)
+						{
+							auto pos_off = positions.size();
+							positions.resize(pos_off + mesh->positions.size());
+							for (auto i = 0; i < mesh->positions.size(); i++)
+								positions[pos_off + i] = mat * vec4(mesh->positions[i], 1.f);
+							auto idx_off = indices.size();
+							indices.resize(idx_off + mesh->indices.size());
+							for (auto i = 0; i < mesh->indices.size(); i++)
+								indices[idx_off + i] = pos_off + mesh->indices[i];
+							return;
+						}
+
 						graphics::Queue::get()->wait_idle();
 
 						auto volume_vretices = sRenderer::instance()->transform_feedback(e->get_component<cNodeT>());
@@ -1304,8 +1322,115 @@ namespace flame
 		}
 	}
 
+	// by the mesh res id, an entry is dropped once its slot releases the mesh or takes another one
+	struct MeshBvhCache
+	{
+		uint generation; // of the mesh res
+		// a mesh that is changed in place keeps its address, so the buffers are compared too
+		const vec3* positions_data;
+		uint positions_count;
+		uint indices_count;
+		MeshBvh bvh;
+	};
+	static std::unordered_map<uint, std::unique_ptr<MeshBvhCache>> mesh_bvhs;
+	static uint mesh_bvhs_swept_frame = 0;
+
+	static const MeshBvh& get_mesh_bvh(graphics::MeshPtr mesh, int mesh_res_id)
+	{
+		auto renderer = sRenderer::instance();
+		if (!renderer || mesh_res_id < 0)
+		{
+			// without a mesh res nothing tells when the mesh goes away, so it is not kept, one for each thread that raycasts
+			thread_local MeshBvh temp;
+			temp.build(mesh->positions.data(), mesh->indices.data(), mesh->indices.size());
+			return temp;
+		}
+
+		if (mesh_bvhs_swept_frame != frames)
+		{
+			mesh_bvhs_swept_frame = frames;
+			std::erase_if(mesh_bvhs, [&](const auto& i) {
+				return renderer->get_mesh_res_info(i.first).generation != i.second->generation;
+			});
+		}
+
+		auto generation = renderer->get_mesh_res_info(mesh_res_id).generation;
+		auto& c = mesh_bvhs[mesh_res_id];
+		if (!c || c->generation != generation || c->positions_data != mesh->positions.data() || c->positions_count != mesh->positions.size() || c->indices_count != mesh->indices.size())
+		{
+			if (!c)
+				c.reset(new MeshBvhCache);
+			c->generation = generation;
+			c->positions_data = mesh->positions.data();
+			c->positions_count = mesh->positions.size();
+			c->indices_count = mesh->indices.size();
+			c->bvh.build(mesh->positions.data(), mesh->indices.data(), mesh->indices.size());
+		}
+		return c->bvh;
+	}
+
+	cNodePtr sScenePrivate::raycast(const vec3& origin, const vec3& dir, float max_distance, vec3* out_pos, uint any_filter, uint all_filter)
+	{
+		auto len = length(dir);
+		if (len < 0.0001f)
+			return nullptr;
+		auto d = dir / len;
+
+		std::vector<std::pair<float, cNodePtr>> candidates;
+		octree->get_colliding(origin, 1.f / d, max_distance, candidates, any_filter, all_filter);
+		std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+			return a.first < b.first;
+		});
+
+		cNodePtr ret = nullptr;
+		auto t = max_distance;
+		for (auto& c : candidates)
+		{
+			// sorted by the entering distance, nothing after can be closer
+			if (c.first >= t)
+				break;
+			auto node = c.second;
+			auto e = node->entity;
+			if (e->tag & TagNotPickable)
+				continue;
+
+			if (auto mesh = e->get_component<cMeshPrivate>(); mesh && mesh->mesh)
+			{
+				if (!mesh->parmature)
+				{
+					// the direction is not normalized in local space, so t stays the same in both spaces
+					auto inv = inverse(node->transform);
+					auto local_o = vec3(inv * vec4(origin, 1.f));
+					auto local_d = vec3(inv * vec4(d, 0.f));
+					if (get_mesh_bvh(mesh->mesh, mesh->mesh_res_id).intersect(local_o, local_d, t))
+						ret = node;
+					continue;
+				}
+			}
+			else if (!e->get_component<cTerrain>())
+			{
+				auto volume = e->get_component<cVolume>();
+				if (!volume || !volume->marching_cubes)
+					continue;
+			}
+
+			t = c.first;
+			ret = node;
+		}
+
+		if (ret && out_pos)
+			*out_pos = origin + d * t;
+		return ret;
+	}
+
 	void sScenePrivate::update()
 	{
+		FLAME_PROFILE_ZONE("Scene Update");
+		{
+			FLAME_PROFILE_ZONE("Armatures");
+			update_armatures();
+		}
+
 		first_node = nullptr;
 		first_element = nullptr;
 
@@ -1326,11 +1451,21 @@ namespace flame
 		});
 
 		if (first_node)
+		{
+			FLAME_PROFILE_ZONE("Node Transforms");
 			update_node_transform(octree, first_node, false);
+		}
+
+		if (!collider_broadphase.order.empty())
+		{
+			FLAME_PROFILE_ZONE("Colliders");
+			update_colliders();
+		}
 
 		static auto last_target_extent = vec2(0.f);
 		if (first_element)
 		{
+			FLAME_PROFILE_ZONE("Element Transforms");
 			vec2 target_extent(0.f);
 			if (!sRenderer::instance()->render_tasks.empty())
 				target_extent = sRenderer::instance()->render_tasks.front()->target_extent();
@@ -1339,6 +1474,7 @@ namespace flame
 		}
 
 #ifdef USE_RECASTNAV
+		FLAME_PROFILE_ZONE("Navigation");
 		if (dt_crowd)
 		{
 			for (auto i = (int)nav_agents.size() - 1; i >= 0; i--)
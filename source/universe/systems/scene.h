@@ -32,6 +32,11 @@ namespace flame
 		// Reflect
 		virtual void draw_debug_primitives() = 0;
 
+		// cast a ray against the nodes on the CPU, static meshes are tested by their triangles, skinned meshes, terrains and volumes by their bounds
+		//  entities tagged TagNotPickable are skipped
+		// Reflect
+		virtual cNodePtr raycast(const vec3& origin, const vec3& dir, float max_distance = 1000.f, vec3* out_pos = nullptr, uint any_filter = 0xffffffff, uint all_filter = 0) = 0;
+
 		struct Instance
 		{
 			virtual sScenePtr operator()() = 0;
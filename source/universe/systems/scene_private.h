@@ -37,6 +37,7 @@ namespace flame
 		void navmesh_save(const std::filesystem::path& filename) override;
 		void navmesh_load(const std::filesystem::path& filename) override;
 		void draw_debug_primitives() override;
+		cNodePtr raycast(const vec3& origin, const vec3& dir, float max_distance, vec3* out_pos, uint any_filter, uint all_filter) override;
 
 		void update() override;
 	};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../foundation/foundation.h"
+
+namespace flame
+{
+	// the tiles of a tile map in square chunks, a chunk keeps the transforms of its tiles in one range of batch instances,
+	//  sorted by template and part, so each mesh of the chunk is one instanced draw
+	//  the draws grow with the chunks and the kinds of tiles, not with the tiles
+	struct TileChunks
+	{
+		static const uint ChunkSize = 16;
+
+		struct Tile
+		{
+			short tmpl = -1; // index of the templates of the owner
+			uchar rotation = 0;
+			ushort height = 0;
+		};
+
+		// count instances of a template part, from the chunk's first instance
+		struct Batch
+		{
+			uint tmpl;
+			uint part;
+			uint ins_off;
+			uint count;
+		};
+
+		struct Chunk
+		{
+			uvec2 coord;
+			std::vector<Tile> tiles; // ChunkSize x ChunkSize
+			int ins_id = -1;
+			uint ins_count = 0;
+			std::vector<Batch> batches;
+			uint max_height = 0;
+			AABB bounds; // local, set by the owner
+			bool dirty = true; // tiles changed
+			bool instances_dirty = true;
+		};
+
+		uvec2 count = uvec2(0);
+		std::vector<Chunk> chunks;
+
+		// all chunks become new and dirty, the owner releases the instances of the old ones first
+		void resize(const uvec2& blocks)
+		{
+			count = (blocks + ChunkSize - 1U) / ChunkSize;
+			chunks.clear();
+			chunks.resize(count.x * count.y);
+			for (auto y = 0; y < count.y; y++)
+			{
+				for (auto x = 0; x < count.x; x++)
+				{
+					auto& c = chunks[x + y * count.x];
+					c.coord = uvec2(x, y);
+					c.tiles.resize(ChunkSize * ChunkSize);
+				}
+			}
+		}
+
+		inline void mark_dirty(const uvec2& tile)
+		{
+			chunks[tile.x / ChunkSize + tile.y / ChunkSize * count.x].dirty = true;
+		}
+
+		// fill(i, j, tile) sets the tile at (i, j) of the map (blocks is x and z of the map), parts_count(tmpl) is the parts of a template,
+		//  then the batches are made
+		//  returns the instances the chunk needs
+		template<typename F, typename P>
+		static uint build(Chunk& c, const uvec2& blocks, const F& fill, const P& parts_count)
+		{
+			c.dirty = false;
+			c.max_height = 0;
+			std::vector<uint> template_counts;
+			for (auto y = 0; y < ChunkSize; y++)
+			{
+				for (auto x = 0; x < ChunkSize; x++)
+				{
+					auto& tile = c.tiles[x + y * ChunkSize];
+					tile = Tile();
+					auto i = c.coord.x * ChunkSize + x;
+					auto j = c.coord.y * ChunkSize + y;
+					if (i >= blocks.x || j >= blocks.y)
+						continue;
+					fill(i, j, tile);
+					if (tile.tmpl == -1)
+						continue;
+					if (template_counts.size() <= tile.tmpl)
+						template_counts.resize(tile.tmpl + 1);
+					template_counts[tile.tmpl]++;
+					c.max_height = max(c.max_height, (uint)tile.height);
+				}
+			}
+
+			c.batches.clear();
+			auto ins_count = 0U;
+			for (auto t = 0; t < template_counts.size(); t++)
+			{
+				if (template_counts[t] == 0)
+					continue;
+				auto n_parts = parts_count(t);
+				for (auto p = 0; p < n_parts; p++)
+				{
+					auto& b = c.batches.emplace_back();
+					b.tmpl = t;
+					b.part = p;
+					b.ins_off = ins_count;
+					b.count = template_counts[t];
+					ins_count += b.count;
+				}
+			}
+			c.instances_dirty = true;
+			return ins_count;
+		}
+
+		// calls f(tile, x, y, batch, off) for every instance of the chunk, x and y in the chunk, off from the chunk's first instance
+		template<typename F>
+		static void for_each_instance(const Chunk& c, const F& f)
+		{
+			auto cursors = std::vector<uint>(c.batches.size());
+			for (auto y = 0; y < ChunkSize; y++)
+			{
+				for (auto x = 0; x < ChunkSize; x++)
+				{
+					auto& tile = c.tiles[x + y * ChunkSize];
+					if (tile.tmpl == -1)
+						continue;
+					for (auto i = 0; i < c.batches.size(); i++)
+					{
+						auto& b = c.batches[i];
+						if (b.tmpl != tile.tmpl)
+							continue;
+						f(tile, x, y, i, b.ins_off + cursors[i]++);
+					}
+				}
+			}
+		}
+	};
+}
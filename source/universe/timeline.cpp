@@ -1,4 +1,5 @@
 #include "../xml.h"
+#include "../foundation/pack.h"
 #include "universe_private.h"
 #include "timeline_private.h"
 #include "entity_private.h"
@@ -6,6 +7,17 @@
 
 namespace flame
 {
+	TimelinePrivate::~TimelinePrivate()
+	{
+		if (ev)
+			remove_event(ev);
+		for (auto ins : instances)
+		{
+			ins->playing = false;
+			ins->timeline = nullptr;
+		}
+	}
+
 	void TimelinePrivate::save(const std::filesystem::path& _filename)
 	{
 		pugi::xml_document doc;
@@ -22,58 +34,157 @@ namespace flame
 			auto n_keyframes = n_track.append_child("keyframes");
 			for (auto& kf : t.keyframes)
 			{
-				auto n_keyframe = n_track.append_child("keyframe");
+				auto n_keyframe = n_keyframes.append_child("keyframe");
 				n_keyframe.append_attribute("time").set_value(kf.time);
 				n_keyframe.append_attribute("value").set_value(kf.value.c_str());
+				if (kf.incremental)
+					n_keyframe.append_attribute("incremental").set_value(true);
 			}
 		}
 
 		doc.save_file(filename.c_str());
 	}
 
-	void TimelineInstancePrivate::Track::update(float t)
+	void TimelinePrivate::compile()
 	{
-		if (attr)
+		compiled_tracks.clear();
+		duration = 0.f;
+		for (auto i = 0; i < tracks.size(); i++)
 		{
-			if (t > keyframes[current_keyframe].time)
+			auto& t = tracks[i];
+			if (t.keyframes.empty())
+				continue;
+
+			auto& ct = compiled_tracks.emplace_back();
+			ct.compile(i, t.keyframes);
+			duration = max(duration, ct.end_time);
+		}
+		std::stable_sort(compiled_tracks.begin(), compiled_tracks.end(), [](const auto& a, const auto& b) {
+			return a.start_time < b.start_time;
+		});
+		compiled = true;
+		dirty = false;
+
+		for (auto ins : instances)
+			ins->bind();
+	}
+
+	bool TimelinePrivate::update()
+	{
+		if (dirty)
+			compile();
+		for (auto i = 0; i < playing_instances.size();)
+		{
+			auto ins = playing_instances[i];
+			if (ins->update())
+				i++;
+			else
 			{
-				current_keyframe++;
-				if (current_keyframe >= keyframes.size())
-					current_keyframe = 0;
+				ins->playing = false;
+				playing_instances[i] = playing_instances.back();
+				playing_instances.pop_back();
 			}
+		}
+		if (playing_instances.empty())
+		{
+			ev = nullptr;
+			return false;
+		}
+		return true;
+	}
 
-			auto pdata = attr->get_value(obj, true);
-			auto ti = (TypeInfo_Data*)attr->type;
-			switch (ti->data_type)
-			{
-			case DataFloat:
+	struct SetterObject {};
+
+	template<typename V>
+	static void call_setter(void* addr, void* obj, V v)
+	{
+		((*(SetterObject*)obj).*(a2f<void(SetterObject::*)(V)>(addr)))(v);
+	}
+
+	static void write_value(TimelineInstancePrivate::Binding& b, const vec4& v)
+	{
+		char value[16];
+		if (b.component_index != 0xffffffff)
+		{
+			memcpy(value, b.data ? b.data : b.attr->get_value(b.obj, true), b.size);
+			if (b.target == TimelineInstancePrivate::TargetColor)
+				((uchar*)value)[b.component_index] = (uchar)clamp(v.x, 0.f, 255.f);
+			else
+				((float*)value)[b.component_index] = v.x;
+		}
+		else
+		{
+			switch (b.target)
 			{
-				float v;
-				if (keyframes.size() == 1)
-					v = keyframes[current_keyframe].value;
-				else
-				{
-					auto& k0 = keyframes[current_keyframe];
-					auto& k1 = keyframes[current_keyframe + 1];
-					v = mix(k0.value, k1.value, (t - k0.time) / (k1.time - k0.time));
-				}
-				((float*)pdata)[component_index] = v;
+			case TimelineInstancePrivate::TargetFloat:
+				*(float*)value = v.x;
+				break;
+			case TimelineInstancePrivate::TargetInt:
+				*(int*)value = (int)round(v.x);
+				break;
+			case TimelineInstancePrivate::TargetBool:
+				*(bool*)value = v.x != 0.f;
+				break;
+			case TimelineInstancePrivate::TargetColor:
+				*(cvec4*)value = cvec4(clamp(v, vec4(0.f), vec4(255.f)));
+				break;
+			default:
+				memcpy(value, &v, b.size);
 			}
+		}
+
+		if (b.setter)
+		{
+			switch (b.target)
+			{
+			case TimelineInstancePrivate::TargetFloat:
+				call_setter<float>(b.setter, b.obj, *(float*)value);
+				break;
+			case TimelineInstancePrivate::TargetInt:
+				call_setter<int>(b.setter, b.obj, *(int*)value);
+				break;
+			case TimelineInstancePrivate::TargetBool:
+				call_setter<bool>(b.setter, b.obj, *(bool*)value);
+				break;
+			case TimelineInstancePrivate::TargetVec2:
+				call_setter<const vec2&>(b.setter, b.obj, *(vec2*)value);
+				break;
+			case TimelineInstancePrivate::TargetVec3:
+				call_setter<const vec3&>(b.setter, b.obj, *(vec3*)value);
+				break;
+			case TimelineInstancePrivate::TargetVec4:
+				call_setter<const vec4&>(b.setter, b.obj, *(vec4*)value);
+				break;
+			case TimelineInstancePrivate::TargetColor:
+				call_setter<const cvec4&>(b.setter, b.obj, *(cvec4*)value);
+				break;
+			case TimelineInstancePrivate::TargetQuat:
+				call_setter<const quat&>(b.setter, b.obj, *(quat*)value);
 				break;
 			}
-			attr->set_value(obj, pdata);
 		}
+		else if (b.data)
+			memcpy(b.data, value, b.size);
+		else
+			b.attr->set_value(b.obj, value);
 	}
 
 	void TimelineInstancePrivate::play()
 	{
-		if (playing)
+		if (playing || !timeline)
 			return;
 		playing = true;
+		if (timeline->dirty)
+			timeline->compile();
 
-		ev = add_event([this]() {
-			return update();
-		});
+		timeline->playing_instances.push_back(this);
+		if (!timeline->ev)
+		{
+			auto tl = timeline;
+			tl->ev = add_event([tl]() {
+				return tl->update();
+			});
+		}
 	}
 
 	void TimelineInstancePrivate::stop()
@@ -82,47 +193,127 @@ namespace flame
 			return;
 		playing = false;
 
-		remove_event(ev);
+		std::erase(timeline->playing_instances, this);
+		if (timeline->playing_instances.empty() && timeline->ev)
+		{
+			remove_event(timeline->ev);
+			timeline->ev = nullptr;
+		}
+	}
+
+	TimelineInstancePrivate::TimelineInstancePrivate(TimelinePtr tl, EntityPtr e) :
+		timeline(tl),
+		entity(e)
+	{
+		timeline->instances.push_back(this);
+		if (!timeline->compiled || timeline->dirty)
+			timeline->compile();
+		else
+			bind();
 	}
 
-	TimelineInstancePrivate::TimelineInstancePrivate(TimelinePtr tl, EntityPtr e)
+	TimelineInstancePrivate::~TimelineInstancePrivate()
 	{
-		for (auto& t : tl->tracks)
+		if (timeline)
 		{
-			if (t.keyframes.empty())
+			stop();
+			std::erase(timeline->instances, this);
+		}
+	}
+
+	void TimelineInstancePrivate::bind()
+	{
+		bindings.clear();
+		bindings.resize(timeline->compiled_tracks.size());
+		for (auto i = 0; i < bindings.size(); i++)
+		{
+			auto& ct = timeline->compiled_tracks[i];
+			auto& b = bindings[i];
+
+			const Attribute* attr = nullptr;
+			void* obj = nullptr;
+			resolve_address(timeline->tracks[ct.index].address, entity, attr, obj, b.component_index);
+			if (!attr || !obj)
 				continue;
-			auto start_time = t.keyframes.front().time;
-			auto duration = t.keyframes.back().time - start_time;
 
-			auto it = std::lower_bound(tracks.begin(), tracks.end(), start_time, [](const auto& a, auto t) { 
-				return a.start_time < t; 
-			});
-			auto& et = *tracks.emplace(it);
-			et.start_time = start_time;
-			et.duration = duration;
-			resolve_address(t.address, e, et.attr, et.obj, et.component_index);
-			if (et.attr)
+			auto type = attr->type;
+			if (type == TypeInfo::get<quat>())
+				b.target = TargetQuat;
+			else if (type->tag == TagD)
 			{
-				if (et.attr->type->tag != TagD)
-					et.attr = nullptr;
+				auto ti = (TypeInfo_Data*)type;
+				if (ti->col_size == 1)
+				{
+					switch (ti->data_type)
+					{
+					case DataFloat:
+						b.target = ti->vec_size == 1 ? TargetFloat : (TargetType)(TargetVec2 + ti->vec_size - 2);
+						break;
+					case DataInt:
+						if (ti->vec_size == 1)
+							b.target = TargetInt;
+						break;
+					case DataBool:
+						b.target = TargetBool;
+						break;
+					case DataChar:
+						if (ti->vec_size == 4 && !ti->is_signed)
+							b.target = TargetColor;
+						break;
+					}
+				}
+			}
+			if (b.target == TargetNone)
+			{
+				printf("timeline: cannot animate %s, the type is not supported\n", timeline->tracks[ct.index].address.c_str());
+				continue;
+			}
+			if (b.target == TargetFloat || b.target == TargetInt || b.target == TargetBool)
+				b.component_index = 0xffffffff;
+
+			b.size = type->size;
+			b.obj = obj;
+			b.attr = attr;
+			if (auto off = attr->var_off(); off != -1)
+				b.data = (char*)obj + off;
+			if (attr->setter_idx != -1)
+			{
+				auto fi = &attr->ui->functions[attr->setter_idx];
+				// same as FunctionInfo::call, others go through the attribute
+				if (fi->voff != -1)
+				{
+					if (!fi->rva)
+						b.setter = (*(void***)obj)[fi->voff / 8];
+				}
+				else if (fi->rva)
+					b.setter = (char*)fi->library + fi->rva;
+				if (!b.setter)
+					b.data = nullptr;
+			}
+
+			if (std::find(ct.incrementals.begin(), ct.incrementals.end(), true) != ct.incrementals.end())
+			{
+				auto pdata = b.data ? b.data : attr->get_value(obj, true);
+				if (b.component_index != 0xffffffff)
+					b.base.x = b.target == TargetColor ? ((uchar*)pdata)[b.component_index] : ((float*)pdata)[b.component_index];
 				else
 				{
-					auto ti = (TypeInfo_Data*)et.attr->type;
-					for (auto& k : t.keyframes)
+					switch (b.target)
 					{
-						auto& ek = et.keyframes.emplace_back();
-						ek.time = k.time;
-						switch (ti->data_type)
-						{
-						case DataFloat:
-							ek.value = s2t<float>(k.value);
-							if (k.incremental)
-							{
-								auto pdata = et.attr->get_value(et.obj, true);
-								ek.value += ((float*)pdata)[et.component_index];
-							}
-							break;
-						}
+					case TargetFloat:
+						b.base.x = *(float*)pdata;
+						break;
+					case TargetInt:
+						b.base.x = *(int*)pdata;
+						break;
+					case TargetColor:
+						b.base = vec4(*(cvec4*)pdata);
+						break;
+					case TargetVec2:
+					case TargetVec3:
+					case TargetVec4:
+						memcpy(&b.base, pdata, b.size);
+						break;
 					}
 				}
 			}
@@ -131,26 +322,25 @@ namespace flame
 
 	bool TimelineInstancePrivate::update()
 	{
-		if (tracks.empty())
-		{
-			playing = false;
+		if (!timeline)
 			return false;
-		}
-		for (auto it = tracks.begin(); it != tracks.end();)
+		auto& compiled_tracks = timeline->compiled_tracks;
+		for (auto i = 0; i < compiled_tracks.size(); i++)
 		{
-			auto& t = *it;
-			if (time < t.start_time)
+			auto& ct = compiled_tracks[i];
+			if (time < ct.start_time)
 				break;
-			if (time < t.start_time + t.duration)
-			{
-				t.update(time);
-				++it;
-			}
-			else
-				it = tracks.erase(it);
+			auto& b = bindings[i];
+			if (b.finished || b.target == TargetNone)
+				continue;
+			// a large time step may jump over the end, the track still ends on its last value
+			if (time >= ct.end_time)
+				b.finished = true;
+			write_value(b, ct.sample(min(time, ct.end_time), b.cursor, b.base, b.target == TargetQuat && b.component_index == 0xffffffff));
 		}
+		auto done = time >= timeline->duration;
 		time += delta_time;
-		return true;
+		return !done;
 	}
 
 	struct TimelineCreate : Timeline::Create
@@ -170,12 +360,12 @@ namespace flame
 			pugi::xml_node doc_root;
 
 			auto filename = Path::get(_filename);
-			if (!std::filesystem::exists(filename))
+			if (!vfs_exists(filename))
 			{
 				wprintf(L"timeline does not exist: %s\n", _filename.c_str());
 				return nullptr;
 			}
-			if (!doc.load_file(filename.c_str()) || (doc_root = doc.first_child()).name() != std::string("timeline"))
+			if (!vfs_load_xml(doc, filename) || (doc_root = doc.first_child()).name() != std::string("timeline"))
 			{
 				wprintf(L"timeline is wrong format: %s\n", _filename.c_str());
 				return nullptr;
@@ -192,10 +382,12 @@ namespace flame
 					auto& kf = t.keyframes.emplace_back();
 					kf.time = n_keyframe.attribute("time").as_float();
 					kf.value = n_keyframe.attribute("value").as_string();
+					kf.incremental = n_keyframe.attribute("incremental").as_bool();
 				}
 			}
 
 			ret->filename = filename;
+			ret->compile();
 			return ret;
 		}
 	}Timeline_load;
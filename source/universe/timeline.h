@@ -32,10 +32,14 @@ namespace flame
 		std::vector<Track> tracks;
 
 		std::filesystem::path filename;
+		// set after editing tracks or keyframes, the timeline compiles again before its next frame or play
+		bool dirty = false;
 
 		virtual ~Timeline() {}
 
 		virtual void save(const std::filesystem::path& filename) = 0;
+		// parse the keyframes into the arrays the instances sample, load does it, editors can set dirty instead of calling it on every edit
+		virtual void compile() = 0;
 
 		struct Create
 		{
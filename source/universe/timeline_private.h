@@ -1,41 +1,68 @@
 #pragma once
 
-#include "timeline.h"
+#include "timeline_track.h"
 
 namespace flame
 {
+	struct TimelineInstancePrivate;
+
 	struct TimelinePrivate : Timeline
 	{
+		std::vector<CompiledTrack> compiled_tracks; // sorted by start time
+		float duration = 0.f;
+		bool compiled = false;
+
+		std::vector<TimelineInstancePrivate*> instances;
+		// playing instances are updated together in one event
+		std::vector<TimelineInstancePrivate*> playing_instances;
+		void* ev = nullptr;
+
+		~TimelinePrivate();
+
 		void save(const std::filesystem::path& filename) override;
+		void compile() override;
+		bool update();
 	};
 
 	struct TimelineInstancePrivate : TimelineInstance
 	{
-		struct Keyframe
+		enum TargetType
 		{
-			float time;
-			float value;
+			TargetNone,
+			TargetFloat,
+			TargetInt,
+			TargetBool,
+			TargetVec2,
+			TargetVec3,
+			TargetVec4,
+			TargetColor, // cvec4
+			TargetQuat
 		};
 
-		struct Track
+		// where a compiled track writes to, resolved once when the instance is created
+		struct Binding
 		{
-			float start_time;
-			float duration;
-			const Attribute* attr;
-			void* obj;
-			uint component_index;
-			std::vector<Keyframe> keyframes;
-			uint current_keyframe = 0;
-
-			void update(float t);
+			TargetType target = TargetNone;
+			uint size = 0; // of the target value
+			uint component_index = 0xffffffff; // the track only writes this component if not ~0
+			void* obj = nullptr;
+			void* data = nullptr; // the variable of the attribute, null if it only has a getter
+			void* setter = nullptr; // the function address, null if data is written directly
+			const Attribute* attr = nullptr; // for targets that only have a getter
+			vec4 base = vec4(0.f); // added to incremental keyframes
+			uint cursor = 0; // the last sampled keyframe, frames mostly stay on it or move to the next one
+			bool finished = false;
 		};
 
-		void* ev = nullptr;
+		TimelinePrivate* timeline;
+		EntityPtr entity;
+		std::vector<Binding> bindings; // one per compiled track
 		float time = 0.f;
-		std::list<Track> tracks;
 
 		TimelineInstancePrivate(TimelinePtr tl, EntityPtr e);
+		~TimelineInstancePrivate();
 
+		void bind();
 		void play() override;
 		void stop() override;
 		bool update();
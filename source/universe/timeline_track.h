@@ -0,0 +1,94 @@
+#pragma once
+
+#include "timeline.h"
+
+namespace flame
+{
+	// a track with its keyframes parsed into floats, keyframes have 'components' floats each
+	//  it does not know its target, so all instances of the timeline share it
+	struct CompiledTrack
+	{
+		uint index; // in tracks
+		float start_time;
+		float end_time;
+		uint components;
+		std::vector<float> times;
+		std::vector<float> values; // times.size() * components
+		std::vector<bool> incrementals;
+
+		// the track must have keyframes, hand edited keyframes may be out of order
+		void compile(uint _index, const std::vector<Keyframe>& keyframes)
+		{
+			index = _index;
+
+			std::vector<uint> order(keyframes.size());
+			for (auto j = 0; j < order.size(); j++)
+				order[j] = j;
+			std::stable_sort(order.begin(), order.end(), [&](uint a, uint b) {
+				return keyframes[a].time < keyframes[b].time;
+			});
+
+			std::vector<std::vector<std::string_view>> strs(order.size());
+			components = 1U;
+			for (auto j = 0; j < order.size(); j++)
+			{
+				strs[j] = SUS::split(keyframes[order[j]].value, ',');
+				components = max(components, (uint)strs[j].size());
+			}
+			components = min(components, 4U);
+
+			times.resize(order.size());
+			values.assign(order.size() * components, 0.f);
+			incrementals.resize(order.size());
+			for (auto j = 0; j < order.size(); j++)
+			{
+				auto& kf = keyframes[order[j]];
+				times[j] = kf.time;
+				incrementals[j] = kf.incremental;
+				for (auto k = 0; k < min(components, (uint)strs[j].size()); k++)
+				{
+					auto str = SUS::get_trimed(strs[j][k]);
+					values[j * components + k] = str == "true" ? 1.f : s2t<float>(str);
+				}
+			}
+			start_time = times.front();
+			end_time = times.back();
+		}
+
+		// cursor is the last sampled keyframe of the caller, frames mostly stay on it or move to the next one
+		//  base is added to incremental keyframes, the four components are slerped if as_quat
+		vec4 sample(float t, uint& cursor, const vec4& base, bool as_quat) const
+		{
+			auto n = (uint)times.size();
+			auto k = cursor;
+			if (!(k < n && times[k] <= t && (k + 1 >= n || t < times[k + 1])))
+			{
+				if (k + 2 < n && times[k + 1] <= t && t < times[k + 2])
+					k++;
+				else
+					k = max((int)(std::upper_bound(times.begin(), times.end(), t) - times.begin()) - 1, 0);
+			}
+			cursor = k;
+
+			auto key_value = [&](uint i) {
+				vec4 ret(0.f);
+				for (auto j = 0; j < components; j++)
+					ret[j] = values[i * components + j];
+				if (incrementals[i])
+					ret += base;
+				return ret;
+			};
+			if (k + 1 >= n || t <= times[k])
+				return key_value(t < times[k] ? 0 : k);
+			auto f = (t - times[k]) / (times[k + 1] - times[k]);
+			auto v0 = key_value(k);
+			auto v1 = key_value(k + 1);
+			if (as_quat)
+			{
+				auto q = slerp(*(quat*)&v0, *(quat*)&v1, f);
+				return *(vec4*)&q;
+			}
+			return mix(v0, v1, f);
+		}
+	};
+}
@@ -29,6 +29,36 @@ namespace flame
 		}
 	}
 
+	bool ModifierPrivate::is_numeric() const
+	{
+		if (!attr || attr->type->tag != TagD)
+			return false;
+		auto dt = ((TypeInfo_Data*)attr->type)->data_type;
+		return dt == DataBool || dt == DataInt || dt == DataFloat;
+	}
+
+	void ModifierPrivate::set_value(float v)
+	{
+		switch (((TypeInfo_Data*)attr->type)->data_type)
+		{
+		case DataBool:
+		{
+			auto value = (bool)(int)v;
+			attr->set_value(obj, &value);
+		}
+			break;
+		case DataInt:
+		{
+			auto value = (int)v;
+			attr->set_value(obj, &value);
+		}
+			break;
+		case DataFloat:
+			attr->set_value(obj, &v);
+			break;
+		}
+	}
+
 	void ModifierPrivate::update(bool first_time)
 	{
 		if (attr)
@@ -38,39 +68,18 @@ namespace flame
 				auto changed = expr->update_bindings();
 				if (!first_time && !changed)
 					return;
-				switch (attr->type->tag)
+				if (is_numeric())
+					set_value(expr->get_value());
+				else if (attr->type->tag == TagD)
 				{
-				case TagD:
-				{
-					auto ti = (TypeInfo_Data*)attr->type;
-					switch (ti->data_type)
-					{
-					case DataBool:
-					{
-						auto value = (bool)(int)expr->get_value();
-						attr->set_value(obj, &value);
-					}
-						break;
-					case DataInt:
+					switch (((TypeInfo_Data*)attr->type)->data_type)
 					{
-						auto value = (int)expr->get_value();
-						attr->set_value(obj, &value);
-					}
-						break;
-					case DataFloat:
-					{
-						auto value = expr->get_value();
-						attr->set_value(obj, &value);
-					}
-						break;
 					case DataString:
 					case DataWString:
 						attr->unserialize(obj, expr->get_string_value());
 						break;
 					}
 				}
-					break;
-				}
 			}
 		}
 	}
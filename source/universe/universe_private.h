@@ -8,11 +8,13 @@ namespace flame
 	{
 		const Attribute* attr = nullptr;
 		void* obj = nullptr;
-		std::unique_ptr<Expression> expr = nullptr;
+		std::unique_ptr<Expression> expr = nullptr; // compiled expressions are cached by text, so creating many of the same is cheap
 
 		ModifierPrivate(const Modifier& m, EntityPtr e, 
 			const std::vector<std::pair<const char*, float*>>& extra_variables = {}, 
 			const std::vector<std::pair<const char*, float>>& extra_consts = {});
+		bool is_numeric() const;
+		void set_value(float v); // only for numeric attributes
 		void update(bool first_time);
 	};
 }
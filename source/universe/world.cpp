@@ -1,3 +1,5 @@
+#include "../foundation/profiler.h"
+#include "../foundation/frame_arena.h"
 #include "entity_private.h"
 #include "world_private.h"
 
@@ -82,14 +84,16 @@ namespace flame
 
 	void WorldPrivate::update()
 	{
+		FLAME_PROFILE_ZONE("World Update");
 		if (update_components)
 		{
-			std::deque<EntityPtr> es;
+			FLAME_PROFILE_ZONE("Components");
+			// breadth first, the vector is the queue
+			FrameVector<EntityPtr> es;
 			es.push_back(root.get());
-			while (!es.empty())
+			for (auto i = 0; i < es.size(); i++)
 			{
-				auto e = es.front();
-				es.pop_front();
+				auto e = es[i];
 				if (e->global_enable)
 				{
 					for (auto& c : e->components)
@@ -108,6 +112,7 @@ namespace flame
 		}
 		if (update_systems)
 		{
+			FLAME_PROFILE_ZONE("Systems");
 			for (auto& s : systems)
 			{
 				if (!s->enable)
@@ -120,6 +125,61 @@ namespace flame
 		}
 	}
 
+	void WorldPrivate::add_to_name_index(EntityPrivate* e)
+	{
+		e->name_hash = sh(e->name.c_str()); // the name may be written directly before the entity came into the world
+		path_cache.clear();
+		if (e->name.empty())
+			return;
+		auto& head = name_index[e->name_hash];
+		e->name_prev = nullptr;
+		e->name_next = head;
+		if (head)
+			head->name_prev = e;
+		head = e;
+	}
+
+	void WorldPrivate::remove_from_name_index(EntityPrivate* e)
+	{
+		path_cache.clear();
+		if (e->name_prev)
+			e->name_prev->name_next = e->name_next;
+		else
+		{
+			auto it = name_index.find(e->name_hash);
+			if (it != name_index.end() && it->second == e)
+			{
+				if (e->name_next)
+					it->second = e->name_next;
+				else
+					name_index.erase(it);
+			}
+		}
+		if (e->name_next)
+			e->name_next->name_prev = e->name_prev;
+		e->name_prev = nullptr;
+		e->name_next = nullptr;
+	}
+
+	EntityPtr WorldPrivate::find_entity(uint name_hash)
+	{
+		auto it = name_index.find(name_hash);
+		if (it != name_index.end())
+			return it->second;
+		return nullptr;
+	}
+
+	EntityPtr WorldPrivate::find_entity_by_path(std::string_view path)
+	{
+		auto hash = sh(path);
+		auto it = path_cache.find(hash);
+		if (it != path_cache.end())
+			return it->second;
+		auto ret = root->find_child_by_path(path);
+		path_cache.emplace(hash, ret);
+		return ret;
+	}
+
 	static WorldPtr _instance = nullptr;
 
 	struct WorldInstance : World::Instance
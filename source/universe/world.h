@@ -40,6 +40,12 @@ namespace flame
 
 		virtual void update() = 0;
 
+		// find an entity in the world by the hash of its name, the world keeps a name index so the tree is not walked
+		//  when several entities share the name, any of them can be returned
+		virtual EntityPtr find_entity(uint name_hash) = 0;
+		// a path of names from the root, like "a/b/c", results are cached by the hash of the path until the tree changes
+		virtual EntityPtr find_entity_by_path(std::string_view path) = 0;
+
 		struct Instance
 		{
 			virtual WorldPtr operator()() = 0;
@@ -8,11 +8,20 @@ namespace flame
 {
 	struct WorldPrivate : World
 	{
+		std::unordered_map<uint, EntityPrivate*> name_index; // name hash -> head of the entities with it
+		std::unordered_map<uint, EntityPtr> path_cache;
+
 		WorldPrivate();
 
+		void add_to_name_index(EntityPrivate* e);
+		void remove_from_name_index(EntityPrivate* e);
+
 		System* add_system(uint hash) override;
 		void remove_system(uint hash, bool destroy) override;
 
 		void update() override;
+
+		EntityPtr find_entity(uint name_hash) override;
+		EntityPtr find_entity_by_path(std::string_view path) override;
 	};
 }
@@ -0,0 +1,142 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/universe/animation_runtime.h>
+
+using namespace flame;
+
+bool pose_equal(const LocalPose& a, const LocalPose& b, float eps = 1e-4f)
+{
+	if (a.positions.size() != b.positions.size())
+		return false;
+	for (auto i = 0; i < a.positions.size(); i++)
+	{
+		if (a.animated[i] != b.animated[i])
+			return false;
+		if (distance(a.positions[i], b.positions[i]) > eps)
+			return false;
+		// q and -q are the same rotation, keys that are close are lerped by slerp so they are not exactly unit length
+		if (abs(abs(dot(a.rotations[i], b.rotations[i])) - dot(a.rotations[i], a.rotations[i])) > eps)
+			return false;
+	}
+	return true;
+}
+
+int main()
+{
+	// a synthetic clip of 60 bones, 4 seconds, a key every 1/30 s
+	const auto bones_count = 60U;
+	AnimationClip clip;
+	clip.duration = 4.f;
+	clip.bones_count = bones_count;
+	for (auto i = 0; i < bones_count; i++)
+	{
+		auto& t = clip.tracks.emplace_back();
+		t.bone_idx = i;
+		for (auto k = 0; k <= 120; k++)
+		{
+			auto time = k / 30.f;
+			t.position_times.push_back(time);
+			t.positions.push_back(vec3(sin(time + i), cos(time * 2.f), i * 0.1f));
+			t.rotation_times.push_back(time);
+			t.rotations.push_back(angleAxis(time * 1.3f + i, normalize(vec3(1.f, i % 3, 0.5f))));
+		}
+	}
+
+	// 500 instances, in 8 groups that play at the same time, each advances 1/60 s a frame
+	const auto instances_count = 500U;
+	const auto frames = 240U;
+	std::vector<float> times(instances_count);
+	std::vector<AnimationCursor> cursors(instances_count);
+	std::vector<LocalPose> poses(instances_count);
+	for (auto i = 0; i < instances_count; i++)
+	{
+		times[i] = (i % 8) * 0.5f;
+		poses[i].resize(bones_count);
+	}
+	auto freq = (double)performance_frequency();
+	auto bones_per_second = [&](uint64 ticks) {
+		return (double)bones_count * instances_count * frames / (ticks / freq);
+	};
+
+	// every instance samples its own pose
+	auto t0 = performance_counter();
+	for (auto f = 0; f < frames; f++)
+	{
+		parallel_for(instances_count, [&](uint begin, uint end) {
+			for (auto i = begin; i < end; i++)
+				sample_clip(clip, fmod(times[i] + f / 60.f, clip.duration), cursors[i], poses[i]);
+		}, 16);
+	}
+	printf("sample per instance: %.1f M bones/s\n", bones_per_second(performance_counter() - t0) / 1000000.0);
+
+	// instances share the poses in the cache, then blend into their own poses
+	PoseCache cache;
+	std::vector<const LocalPose*> sampled(instances_count);
+	AnimationCursor cache_cursor;
+	t0 = performance_counter();
+	for (auto f = 0; f < frames; f++)
+	{
+		cache.new_frame();
+		std::vector<std::pair<float, LocalPose*>> jobs;
+		for (auto i = 0; i < instances_count; i++)
+		{
+			auto time = fmod(times[i] + f / 60.f, clip.duration);
+			auto is_new = false;
+			auto& entry = cache.get(&clip, time, is_new);
+			if (is_new)
+				jobs.emplace_back(cache.bucket_time(time), &entry.pose);
+			sampled[i] = &entry.pose;
+		}
+		for (auto& j : jobs)
+			sample_clip(clip, j.first, cache_cursor, *j.second);
+		parallel_for(instances_count, [&](uint begin, uint end) {
+			for (auto i = begin; i < end; i++)
+				blend_poses(poses[i], *sampled[i], 0.5f, poses[i]);
+		}, 16);
+	}
+	printf("cached sample + blend: %.1f M bones/s, %d cached poses\n", bones_per_second(performance_counter() - t0) / 1000000.0, (int)cache.entries.size());
+
+	{
+		auto time = 1.2345f;
+		auto is_new = false;
+		auto& entry = cache.get(&clip, time, is_new);
+		if (is_new)
+			sample_clip(clip, cache.bucket_time(time), cache_cursor, entry.pose);
+		LocalPose ref;
+		AnimationCursor cursor;
+		sample_clip(clip, cache.bucket_time(time), cursor, ref);
+		printf("cached pose: %s\n", pose_equal(entry.pose, ref) ? "OK" : "FAILED");
+	}
+
+	{
+		// cursors that walk forward give the same keys as a binary search
+		LocalPose a, b;
+		AnimationCursor cursor;
+		auto ok = true;
+		for (auto time = 0.f; time < clip.duration; time += 0.007f)
+		{
+			AnimationCursor fresh;
+			sample_clip(clip, time, cursor, a);
+			sample_clip(clip, time, fresh, b);
+			ok = ok && pose_equal(a, b);
+		}
+		printf("cursor sampling: %s\n", ok ? "OK" : "FAILED");
+	}
+
+	{
+		LocalPose a, b, c;
+		AnimationCursor cursor;
+		sample_clip(clip, 0.3f, cursor, a);
+		sample_clip(clip, 2.1f, cursor, b);
+		blend_poses(a, b, 0.f, c);
+		auto ok = pose_equal(a, c);
+		blend_poses(a, b, 1.f, c);
+		ok = ok && pose_equal(b, c);
+		blend_poses(a, b, 0.5f, c);
+		for (auto i = 0; i < bones_count; i++)
+			ok = ok && abs(length(c.rotations[i]) - 1.f) < 1e-4f && distance(vec3(c.positions[i]), mix(vec3(a.positions[i]), vec3(b.positions[i]), 0.5f)) < 1e-4f;
+		printf("blend: %s\n", ok ? "OK" : "FAILED");
+	}
+
+	return 0;
+}
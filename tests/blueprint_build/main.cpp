@@ -0,0 +1,95 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/foundation/blueprint.h>
+
+using namespace flame;
+
+int main()
+{
+	// many groups of long chains, an edit touches only one of them
+	const auto groups_count = 20;
+	const auto chain_length = 200;
+	auto bp = Blueprint::create(true);
+	auto speed = (float*)bp->add_variable(nullptr, "speed", TypeInfo::get<float>());
+	*speed = 2.f;
+	std::vector<BlueprintGroupPtr> groups;
+	std::vector<BlueprintNodePtr> first_nodes;
+	for (auto i = 0; i < groups_count; i++)
+	{
+		auto g = bp->add_group("group" + str(i));
+		BlueprintNodePtr last = nullptr;
+		for (auto j = 0; j < chain_length; j++)
+		{
+			auto n = bp->add_node(g, nullptr, "Scale", BlueprintNodeFlagNone, "", {
+					{ .name = "In", .name_hash = "In"_h, .allowed_types = { TypeInfo::get<float>() }, .default_value = "1" }
+				}, {
+					{ .name = "Out", .name_hash = "Out"_h, .allowed_types = { TypeInfo::get<float>() } }
+				}, [](uint inputs_count, BlueprintAttribute* inputs, uint outputs_count, BlueprintAttribute* outputs) {
+					*(float*)outputs[0].data = *(float*)inputs[0].data * 2.f;
+				});
+			if (last)
+				bp->add_link(last->outputs[0].get(), n->inputs[0].get());
+			else
+				first_nodes.push_back(n);
+			last = n;
+		}
+		groups.push_back(g);
+	}
+
+	auto freq = (double)performance_frequency();
+	frames++;
+	auto t0 = performance_counter();
+	auto ins = BlueprintInstance::create(bp);
+	auto full_time = (performance_counter() - t0) / freq * 1000.0;
+
+	auto& g0 = ins->groups["group0"_h];
+	auto& g5 = ins->groups["group5"_h];
+	auto g5_node = g5.node_map[first_nodes[5]->object_id];
+	auto g5_updated = g5.structure_updated_frame;
+	auto g0_input_id = first_nodes[0]->inputs[0]->object_id;
+	auto g0_input = g0.slot_datas[g0_input_id].attribute.data;
+	*(float*)g0_input = 7.f;
+	g0.slot_datas[g0_input_id].changed_frame = frames;
+
+	// a structure change in group0
+	frames++;
+	bp->add_node(groups[0], nullptr, "Scale", BlueprintNodeFlagNone, "", {}, {}, nullptr);
+	t0 = performance_counter();
+	ins->build();
+	auto incremental_time = (performance_counter() - t0) / freq * 1000.0;
+	printf("build: full %.3f ms, one group %.3f ms (group build time %.3f ms)\n", full_time, incremental_time, g0.build_time);
+	printf("other groups untouched: %s\n", g5.structure_updated_frame == g5_updated && g5.node_map[first_nodes[5]->object_id] == g5_node ? "OK" : "FAILED");
+	printf("slot data reused: %s\n", g0.slot_datas[g0_input_id].attribute.data == g0_input && *(float*)g0_input == 7.f ? "OK" : "FAILED");
+	printf("group build time: %s\n", g0.build_time > 0.f && g0.node_map.size() == chain_length + 1 ? "OK" : "FAILED");
+
+	// a new variable rebuilds no group and keeps the data of the others
+	auto speed_data = ins->variables["speed"_h].data;
+	*(float*)speed_data = 5.f;
+	frames++;
+	bp->add_variable(nullptr, "health", TypeInfo::get<int>());
+	ins->build();
+	auto rebuilt = false;
+	for (auto& g : ins->groups)
+	{
+		if (g.second.structure_updated_frame == frames)
+			rebuilt = true;
+	}
+	printf("variables reused: %s\n", !rebuilt && ins->variables["speed"_h].data == speed_data && *(float*)speed_data == 5.f &&
+		ins->variables.contains("health"_h) ? "OK" : "FAILED");
+
+	// a data change only copies the changed input
+	frames++;
+	auto input = first_nodes[3]->inputs[0].get();
+	*(float*)input->data = 3.f;
+	input->data_changed_frame = frames;
+	groups[3]->data_changed_frame = frames;
+	bp->dirty_frame = frames;
+	ins->build();
+	auto& g3 = ins->groups["group3"_h];
+	printf("data update: %s\n", *(float*)g3.slot_datas[input->object_id].attribute.data == 3.f && g3.structure_updated_frame != frames ? "OK" : "FAILED");
+
+	BlueprintInstance::destroy(ins);
+	Blueprint::destroy(bp);
+
+	return 0;
+}
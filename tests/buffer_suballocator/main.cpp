@@ -0,0 +1,133 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/graphics/extension.h>
+
+using namespace flame;
+using namespace graphics;
+
+struct Allocation
+{
+	uint off;
+	uint size;
+	uint tag;
+};
+
+// every allocation fills its range with its tag, so overlaps and lost data show up
+bool check(const SparseRanges& sr, const std::vector<Allocation>& allocs, const std::vector<uint>& memory)
+{
+	for (auto& a : allocs)
+	{
+		if (a.off + a.size > sr.capacity)
+			return false;
+		for (auto i = 0; i < a.size; i++)
+		{
+			if (memory[a.off + i] != a.tag)
+				return false;
+		}
+	}
+	auto free_space = 0U;
+	for (auto id = sr.first_block; id != -1; id = sr.blocks[id].next_phys)
+	{
+		if (sr.blocks[id].free)
+			free_space += sr.blocks[id].size;
+	}
+	return free_space + sr.used == sr.capacity;
+}
+
+int main()
+{
+	const auto capacity = 1024U * 1024U * 16U;
+	SparseRanges sr;
+	sr.init(capacity);
+	std::vector<uint> memory(capacity);
+	std::vector<Allocation> allocs;
+	auto tag = 0U;
+	auto freq = (double)performance_frequency();
+
+	// streaming meshes: random sizes, random releases, the buffer stays about 70% full
+	std::mt19937 rng(0);
+	auto rand_size = [&]() {
+		return std::uniform_int_distribution<uint>(1, 4) (rng) == 1 ? std::uniform_int_distribution<uint>(10000, 200000)(rng) : std::uniform_int_distribution<uint>(16, 4000)(rng);
+	};
+	const auto ops = 1000000U;
+	auto failed = 0U;
+	auto t0 = performance_counter();
+	for (auto i = 0; i < ops; i++)
+	{
+		if (sr.used < capacity * 0.7f || allocs.empty())
+		{
+			auto size = rand_size();
+			auto off = sr.get_free_space(size);
+			if (off != -1)
+				allocs.push_back({ (uint)off, size, ++tag });
+			else
+				failed++;
+		}
+		else
+		{
+			auto idx = std::uniform_int_distribution<uint>(0, allocs.size() - 1)(rng);
+			sr.releases_space(allocs[idx].off, allocs[idx].size);
+			allocs[idx] = allocs.back();
+			allocs.pop_back();
+		}
+	}
+	auto dt = (performance_counter() - t0) / freq;
+	printf("%d operations: %.1f ns/op, %d failed, fragmentation %.3f, %d blocks\n", ops, dt * 1000000000.0 / ops, failed, sr.fragmentation(), (int)sr.blocks.size() - (int)sr.unused_blocks.size());
+
+	// fill the memory by the allocations, then compact it a part at a time, applying the moves like the buffers do
+	std::fill(memory.begin(), memory.end(), 0);
+	for (auto& a : allocs)
+		std::fill(memory.begin() + a.off, memory.begin() + a.off + a.size, a.tag);
+	printf("allocations: %s\n", check(sr, allocs, memory) ? "OK" : "FAILED");
+
+	auto largest_before = sr.largest_free_space();
+	std::vector<SparseRanges::Move> moves;
+	auto steps = 0;
+	auto moved = 0ULL;
+	t0 = performance_counter();
+	while (true)
+	{
+		moves.clear();
+		auto done = sr.defragment(1024 * 256, moves);
+		std::unordered_map<uint, uint> new_offsets;
+		for (auto& m : moves)
+		{
+			memmove(memory.data() + m.dst, memory.data() + m.src, m.size * sizeof(uint));
+			new_offsets[m.src] = m.dst;
+			moved += m.size;
+		}
+		for (auto& a : allocs)
+		{
+			if (auto it = new_offsets.find(a.off); it != new_offsets.end())
+				a.off = it->second;
+		}
+		steps++;
+		if (done)
+			break;
+	}
+	dt = (performance_counter() - t0) / freq;
+	printf("defragment: %d steps, %lld items moved, %.3f ms, largest free %d -> %d\n", steps, moved, dt * 1000.0, largest_before, sr.largest_free_space());
+	printf("defragmented: %s\n", check(sr, allocs, memory) && sr.fragmentation() == 0.f && sr.largest_free_space() == capacity - sr.used ? "OK" : "FAILED");
+
+	// growing keeps the allocations and the new space is usable
+	auto big = capacity - sr.used + 1000;
+	auto off = sr.get_free_space(big);
+	auto ok = off == -1;
+	sr.grow(capacity * 2);
+	memory.resize(capacity * 2);
+	off = sr.get_free_space(big);
+	ok = ok && off != -1;
+	if (off != -1)
+	{
+		allocs.push_back({ (uint)off, big, ++tag });
+		std::fill(memory.begin() + off, memory.begin() + off + big, tag);
+	}
+	printf("grow: %s\n", ok && check(sr, allocs, memory) ? "OK" : "FAILED");
+
+	// releasing everything merges back to one range
+	for (auto& a : allocs)
+		sr.releases_space(a.off, a.size);
+	printf("release all: %s\n", sr.used == 0 && sr.largest_free_space() == sr.capacity ? "OK" : "FAILED");
+
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/universe/broadphase.h>
+
+using namespace flame;
+
+bool has(const std::vector<uint64>& v, uint64 contact)
+{
+	return std::find(v.begin(), v.end(), contact) != v.end();
+}
+
+int main()
+{
+	// a sphere passes through another one
+	{
+		SphereBroadphase bp;
+		auto a = bp.add(nullptr);
+		auto b = bp.add(nullptr);
+		auto a_sees_b = SphereBroadphase::make_contact(a, b);
+		auto b_sees_a = SphereBroadphase::make_contact(b, a);
+		std::string log;
+		for (auto i = 0; i < 7; i++)
+		{
+			bp.set(a, vec3(0.f), 1.f);
+			bp.set(b, vec3(-4.f + i * 1.5f, 0.f, 0.f), 1.f);
+			bp.update();
+			if (has(bp.entered, a_sees_b) && has(bp.entered, b_sees_a))
+				log += "E";
+			else if (has(bp.stayed, a_sees_b) && has(bp.stayed, b_sees_a))
+				log += "S";
+			else if (has(bp.exited, a_sees_b) && has(bp.exited, b_sees_a))
+				log += "X";
+			else
+				log += "-";
+		}
+		printf("enter, stay, exit: %s %s\n", log.c_str(), log == "--ESX--" ? "OK" : "FAILED");
+
+		// one reaches further, it sees the other first and stops seeing it last
+		log.clear();
+		for (auto i = 0; i < 7; i++)
+		{
+			bp.set(a, vec3(0.f), 1.f, 1.5f);
+			bp.set(b, vec3(-4.f + i * 1.5f, 0.f, 0.f), 1.f);
+			bp.update();
+			log += has(bp.entered, a_sees_b) ? "E" : (has(bp.stayed, a_sees_b) ? "S" : (has(bp.exited, a_sees_b) ? "X" : "-"));
+			log += has(bp.entered, b_sees_a) ? "E" : (has(bp.stayed, b_sees_a) ? "S" : (has(bp.exited, b_sees_a) ? "X" : "-"));
+		}
+		printf("expand: %s %s\n", log.c_str(), log == "--E-SESSSXX---" ? "OK" : "FAILED");
+
+		// a removed sphere ends the contacts of the others with it at once, its own end without an exit
+		bp.set(a, vec3(0.f), 1.f);
+		bp.set(b, vec3(0.f), 1.f);
+		bp.update();
+		bp.remove(b);
+		auto ok = bp.exited.size() == 1 && bp.exited[0] == a_sees_b && bp.pairs.empty();
+		bp.update();
+		printf("remove: %s\n", ok && bp.exited.empty() && bp.pairs.empty() ? "OK" : "FAILED");
+	}
+
+	// many spheres that move, against all pairs tested one by one
+	{
+		const auto n = 10000;
+		SphereBroadphase bp;
+		std::vector<vec3> positions(n), velocities(n);
+		std::vector<float> radii(n), expands(n);
+		srand(1);
+		auto rnd = []() {
+			return rand() / (float)RAND_MAX;
+		};
+		for (auto i = 0; i < n; i++)
+		{
+			bp.add(nullptr);
+			positions[i] = vec3(rnd() * 300.f, 0.f, rnd() * 300.f);
+			velocities[i] = vec3(rnd() - 0.5f, 0.f, rnd() - 0.5f);
+			radii[i] = 0.5f + rnd();
+			expands[i] = rnd() < 0.2f ? 0.5f : 0.f;
+		}
+
+		auto freq = (double)performance_frequency();
+		auto total_time = 0.0;
+		auto ok = true;
+		std::vector<uint64> last_ref, ref;
+		const auto frames_count = 20;
+		for (auto f = 0; f < frames_count; f++)
+		{
+			for (auto i = 0; i < n; i++)
+			{
+				positions[i] += velocities[i];
+				bp.set(i, positions[i], radii[i], expands[i]);
+			}
+			auto t0 = performance_counter();
+			bp.update();
+			// the first one sorts from scratch
+			if (f > 0)
+				total_time += (performance_counter() - t0) / freq * 1000.0;
+
+			last_ref.swap(ref);
+			ref.clear();
+			for (auto i = 0; i < n; i++)
+			{
+				for (auto j = i + 1; j < n; j++)
+				{
+					auto d = distance(positions[i], positions[j]);
+					if (d < radii[i] + expands[i] + radii[j])
+						ref.push_back(SphereBroadphase::make_contact(i, j));
+					if (d < radii[j] + expands[j] + radii[i])
+						ref.push_back(SphereBroadphase::make_contact(j, i));
+				}
+			}
+			std::sort(ref.begin(), ref.end());
+			std::vector<uint64> contacts;
+			for (auto p : bp.pairs)
+				SphereBroadphase::add_contacts(p, p & 3, contacts);
+			std::sort(contacts.begin(), contacts.end());
+			ok = ok && contacts == ref;
+			if (f > 0)
+			{
+				auto entered = 0, exited = 0;
+				for (auto p : ref)
+				{
+					if (!std::binary_search(last_ref.begin(), last_ref.end(), p))
+						entered++;
+				}
+				for (auto p : last_ref)
+				{
+					if (!std::binary_search(ref.begin(), ref.end(), p))
+						exited++;
+				}
+				ok = ok && bp.entered.size() == entered && bp.exited.size() == exited && bp.stayed.size() + entered == ref.size();
+			}
+		}
+		// the budget of the whole pass
+		auto time = total_time / (frames_count - 1);
+		printf("%d spheres: %d contacts, %.3f ms per frame, %s\n", n, (int)ref.size(), time, ok && time < 1.0 ? "OK" : "FAILED");
+	}
+
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/graphics/model_ext.h>
+
+using namespace flame;
+using namespace graphics;
+
+int main()
+{
+	auto freq = (double)performance_frequency();
+
+	// a cube subdivided to about 100k quads as the control mesh, then one more level of each
+	ControlMesh cube;
+	cube.init_as_cube(vec3(1.f));
+	ControlMesh control;
+	cube.subdivide(control, 7);
+	printf("control mesh: %d vertices, %d faces\n", (int)control.vertices.size(), (int)control.faces.size());
+
+	for (auto loop = 0; loop < 2; loop++)
+	{
+		ControlMesh out;
+		auto t0 = performance_counter();
+		control.subdivide(out, 1, loop);
+		auto ms = (performance_counter() - t0) / freq * 1000.0;
+
+		// it stays closed and convex around the center: no border edges, V - E + F = 2 and all normals point out
+		ControlMeshTopology topo;
+		topo.build(out);
+		auto ok = std::find(topo.he_twin.begin(), topo.he_twin.end(), -1) == topo.he_twin.end();
+		ok = ok && (int)out.vertices.size() - (int)topo.edge_he.size() + (int)out.faces.size() == 2;
+		for (auto& f : out.faces)
+		{
+			auto c = vec3(0.f);
+			for (auto& k : f.corners)
+				c += out.vertices[k.vertex_id];
+			if (dot(c, f.normal) <= 0.f)
+				ok = false;
+		}
+		printf("%s: %d faces, %.2f ms, %s\n", loop ? "loop" : "catmull-clark", (int)out.faces.size(), ms, ok ? "OK" : "FAILED");
+	}
+
+	// catmull-clark of a cube goes to a rounded box with radius about 0.42 to 0.43
+	auto r_min = 1.f, r_max = 0.f;
+	for (auto& v : control.vertices)
+	{
+		r_min = min(r_min, length(v));
+		r_max = max(r_max, length(v));
+	}
+	printf("limit surface radius %.3f..%.3f: %s\n", r_min, r_max, r_min > 0.41f && r_max < 0.44f ? "OK" : "FAILED");
+
+	return 0;
+}
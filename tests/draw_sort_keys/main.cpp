@@ -0,0 +1,63 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/universe/draw_data.h>
+
+using namespace flame;
+
+int main()
+{
+	// synthetic draws: 200k instances over 500 meshes and 64 materials, 16 pipelines
+	DrawData draw_data;
+	draw_data.reset(PassGBuffer, CateMesh);
+	const auto n = 200000U;
+	for (auto i = 0; i < n; i++)
+		draw_data.meshes.emplace_back(i & 0xffff, linearRand(0, 499), linearRand(0, 63));
+	std::vector<int> pl_slots(64);
+	for (auto& s : pl_slots)
+		s = linearRand(0, 15);
+
+	std::vector<uint64> keys(n), temp(n), ref(n);
+	auto freq = (double)performance_frequency();
+	const auto rounds = 20;
+
+	auto t0 = performance_counter();
+	for (auto r = 0; r < rounds; r++)
+	{
+		parallel_for(n, [&](uint begin, uint end) {
+			for (auto i = begin; i < end; i++)
+			{
+				auto& m = draw_data.meshes[i];
+				keys[i] = mesh_draw_sort_key(pl_slots[m.mat_id], m);
+			}
+		}, 1024);
+	}
+	printf("key generation: %.3f ms\n", (performance_counter() - t0) / freq * 1000.0 / rounds);
+
+	ref = keys;
+	t0 = performance_counter();
+	std::sort(ref.begin(), ref.end());
+	printf("std::sort: %.3f ms\n", (performance_counter() - t0) / freq * 1000.0);
+
+	auto sorted = keys;
+	t0 = performance_counter();
+	for (auto r = 0; r < rounds; r++)
+	{
+		sorted = keys;
+		radix_sort(sorted.data(), temp.data(), n);
+	}
+	printf("radix_sort: %.3f ms\n", (performance_counter() - t0) / freq * 1000.0 / rounds);
+
+	auto ok = sorted == ref;
+	printf("compare with std::sort: %s\n", ok ? "OK" : "FAILED");
+
+	// count the indirect commands after merging contiguous instances, like IndirectBuffer::add does
+	auto n_cmds = 0;
+	for (auto i = 0; i < n; i++)
+	{
+		if (i == 0 || (sorted[i] >> 16) != (sorted[i - 1] >> 16) || (sorted[i] & 0xffff) != (sorted[i - 1] & 0xffff) + 1)
+			n_cmds++;
+	}
+	printf("%d draws -> %d indirect commands\n", n, n_cmds);
+
+	return ok ? 0 : 1;
+}
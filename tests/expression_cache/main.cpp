@@ -0,0 +1,53 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+
+using namespace flame;
+
+int main()
+{
+	const auto text = "sin(i * 0.1) * 50 + cos(i * 0.05) * offset + i * 20";
+	auto freq = (double)performance_frequency();
+
+	// the first one parses and compiles, the rest only look up the cache and bind their own 'i'
+	const auto n = 1000U;
+	std::vector<float> is(n);
+	std::vector<std::unique_ptr<Expression>> exprs(n);
+	auto t0 = performance_counter();
+	for (auto k = 0; k < n; k++)
+	{
+		is[k] = k;
+		auto e = Expression::create(text);
+		e->set_variable("i", &is[k]);
+		e->set_const_value("offset", 3.f);
+		if (!e->compile())
+		{
+			printf("compile failed\n");
+			return 1;
+		}
+		exprs[k].reset(e);
+		if (k == 0)
+			printf("compile (miss): %.3f ms\n", (performance_counter() - t0) / freq * 1000.0);
+	}
+	printf("compile (%d hits): %.3f ms\n", n - 1, (performance_counter() - t0) / freq * 1000.0);
+
+	const auto rounds = 200;
+	std::vector<float> ref(n), out(n);
+	t0 = performance_counter();
+	for (auto r = 0; r < rounds; r++)
+	{
+		for (auto k = 0; k < n; k++)
+			ref[k] = exprs[k]->get_value();
+	}
+	auto dt = (performance_counter() - t0) / freq;
+	printf("get_value: %.2f M evals/s\n", n * rounds / dt / 1000000.0);
+
+	t0 = performance_counter();
+	for (auto r = 0; r < rounds; r++)
+		exprs[0]->get_values(n, is.data(), 1, out.data());
+	dt = (performance_counter() - t0) / freq;
+	printf("get_values: %.2f M evals/s\n", n * rounds / dt / 1000000.0);
+
+	auto ok = out == ref;
+	printf("compare with get_value: %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/foundation/frame_arena.h>
+
+using namespace flame;
+
+// the heap allocations of this module
+static std::atomic<uint64> news = 0;
+
+void* operator new(size_t size)
+{
+	news++;
+	if (auto p = malloc(size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+struct alignas(64) Aligned
+{
+	float v[16];
+};
+
+// what a frame of a scene does, containers that grow with the content and go away
+uint frame_work(uint frame, uint scale)
+{
+	auto sum = 0U;
+	FrameVector<uint> queue;
+	queue.push_back(0);
+	for (auto i = 0; i < queue.size() && queue.size() < scale; i++)
+	{
+		for (auto j = 1; j <= 3; j++)
+			queue.push_back(queue[i] * 3 + j);
+		FrameVector<std::pair<uint, float>> res;
+		for (auto j = 0; j < (queue[i] + frame) % 8; j++)
+			res.emplace_back(j, (float)j);
+		sum += res.size();
+	}
+	FrameDeque<uint> dq;
+	for (auto i = 0; i < scale / 4; i++)
+		dq.push_back(i);
+	while (!dq.empty())
+	{
+		sum += dq.front();
+		dq.pop_front();
+	}
+	return sum;
+}
+
+int main()
+{
+	auto ok = true;
+
+	// alignment, and a scoped container gives its memory back
+	frame_arena_new_frame();
+	{
+		FrameVector<Aligned> v(3);
+		ok = ok && ((uint64)v.data() & 63) == 0;
+		auto top = frame_arena()->top;
+		{
+			FrameVector<char> tmp(100);
+		}
+		ok = ok && frame_arena()->top == top;
+	}
+	printf("alignment and scoped free: %s\n", ok ? "OK" : "FAILED");
+
+	// the first frames grow the arena, then it fits and nothing comes from the heap
+	const auto warm_frames = 3, frames_count = 100;
+	for (auto i = 0; i < warm_frames; i++)
+	{
+		frame_arena_new_frame();
+		frame_work(i, 100000);
+	}
+	auto stats0 = get_frame_arena_stats();
+	auto news0 = news.load();
+	auto freq = (double)performance_frequency();
+	auto t0 = performance_counter();
+	for (auto i = 0; i < frames_count; i++)
+	{
+		frame_arena_new_frame();
+		frame_work(i, 100000);
+	}
+	auto arena_time = (performance_counter() - t0) / freq * 1000.0 / frames_count;
+	auto stats1 = get_frame_arena_stats();
+	auto news1 = news.load();
+	printf("steady state: %llu allocations per frame, %llu heap allocations, %llu news, %.3f ms per frame, %s\n",
+		(stats1.allocations - stats0.allocations) / frames_count, stats1.heap_allocations - stats0.heap_allocations, news1 - news0, arena_time,
+		stats1.heap_allocations == stats0.heap_allocations && news1 == news0 ? "OK" : "FAILED");
+
+	// the same work on the heap
+	{
+		t0 = performance_counter();
+		auto sum = 0U;
+		for (auto i = 0; i < frames_count; i++)
+		{
+			std::vector<uint> queue;
+			queue.push_back(0);
+			for (auto j = 0; j < queue.size() && queue.size() < 100000; j++)
+			{
+				for (auto k = 1; k <= 3; k++)
+					queue.push_back(queue[j] * 3 + k);
+				std::vector<std::pair<uint, float>> res;
+				for (auto k = 0; k < (queue[j] + i) % 8; k++)
+					res.emplace_back(k, (float)k);
+				sum += res.size();
+			}
+		}
+		printf("heap: %.3f ms per frame (%u)\n", (performance_counter() - t0) / freq * 1000.0 / frames_count, sum);
+	}
+
+	// the workers have their own arenas, they are reset between jobs when a frame began
+	//  how much a worker takes in a frame depends on the jobs it gets, so it settles after a few frames
+	std::vector<uint> ref(64), sums(64);
+	for (auto j = 0; j < 64; j++)
+		ref[j] = frame_work(j, 10000);
+	auto run_frame = [&]() {
+		frame_arena_new_frame();
+		parallel_for(64, [&](uint begin, uint end) {
+			for (auto j = begin; j < end; j++)
+				sums[j] = frame_work(j, 10000);
+		}, 1);
+	};
+	for (auto i = 0; i < warm_frames * 4; i++)
+		run_frame();
+	stats0 = get_frame_arena_stats();
+	ok = true;
+	for (auto i = 0; i < frames_count; i++)
+	{
+		run_frame();
+		ok = ok && sums == ref;
+	}
+	stats1 = get_frame_arena_stats();
+	printf("workers: %llu heap allocations in %d frames, %llu KB reserved, %s\n", stats1.heap_allocations - stats0.heap_allocations, frames_count,
+		stats1.reserved_bytes / 1024, ok && stats1.heap_allocations - stats0.heap_allocations < frames_count ? "OK" : "FAILED");
+
+	return 0;
+}
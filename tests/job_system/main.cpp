@@ -0,0 +1,162 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+
+using namespace flame;
+
+// some math per item so the work is bound by compute, not memory
+float work_item(uint i)
+{
+	auto v = (float)i;
+	for (auto k = 0; k < 64; k++)
+		v = sin(v) * 0.5f + cos(v * 0.25f);
+	return v;
+}
+
+int main()
+{
+	auto freq = (double)performance_frequency();
+	auto workers = (int)job_workers_count();
+	printf("workers: %d\n", workers);
+
+	// speedup of parallel_for vs the number of workers, the calling thread is one more
+	const auto n = 1 << 18;
+	std::vector<float> ref(n), out(n);
+	for (auto i = 0; i < n; i++)
+		ref[i] = work_item(i);
+	std::vector<int> workers_counts = { -1 }; // -1 is a plain loop
+	for (auto w = 0; w < workers; w = max(w * 2, 1))
+		workers_counts.push_back(w);
+	workers_counts.push_back(workers);
+	auto base_time = 0.0;
+	auto ok = true;
+	for (auto w : workers_counts)
+	{
+		set_job_workers_limit(max(w, 0));
+		get_job_stats(true);
+		auto t0 = performance_counter();
+		if (w == -1)
+		{
+			for (auto i = 0; i < n; i++)
+				out[i] = work_item(i);
+		}
+		else
+		{
+			parallel_for(n, [&](uint begin, uint end) {
+				for (auto i = begin; i < end; i++)
+					out[i] = work_item(i);
+			}, 1024);
+		}
+		auto time = (performance_counter() - t0) / freq * 1000.0;
+		ok = ok && out == ref;
+		std::fill(out.begin(), out.end(), 0.f);
+		if (w == -1)
+		{
+			base_time = time;
+			printf("  loop: %.3f ms\n", time);
+			continue;
+		}
+
+		auto stats = get_job_stats();
+		std::string utilization;
+		for (auto i = 0; i <= w; i++)
+			utilization += " " + str((int)(stats[i].utilization * 100.f)) + "%";
+		printf("  %d threads: %.3f ms, speedup %.2f, utilization%s\n", w + 1, time, base_time / time, utilization.c_str());
+	}
+	set_job_workers_limit(workers);
+	printf("parallel_for: %s\n", ok ? "OK" : "FAILED");
+
+	// a diamond graph, d is the continuation of b and c
+	std::atomic<uint> order = 0;
+	uint a_order, b_order, c_order, d_order;
+	auto a = create_job([&]() { a_order = order++; });
+	auto b = create_job([&]() { b_order = order++; });
+	auto c = create_job([&]() { c_order = order++; });
+	auto d = create_job([&]() { d_order = order++; });
+	add_job_dependency(b, a);
+	add_job_dependency(c, a);
+	add_job_dependency(d, b);
+	add_job_dependency(d, c);
+	submit_job(d);
+	submit_job(c);
+	submit_job(b);
+	submit_job(a);
+	wait_job(d);
+	printf("graph: %s\n", a_order < b_order && a_order < c_order && b_order < d_order && c_order < d_order ? "OK" : "FAILED");
+	for (auto j : { a, b, c, d })
+		release_job(j);
+
+	// jobs that wait on other jobs and go wide inside, the waits run other jobs so nothing blocks
+	std::vector<Job*> outer;
+	std::atomic<uint> sum = 0;
+	for (auto i = 0; i < 64; i++)
+	{
+		auto j = create_job([&]() {
+			std::atomic<uint> local = 0;
+			parallel_for(1000, [&](uint begin, uint end) {
+				local += end - begin;
+			}, 10);
+			auto inner = create_job([&]() { local += 1; });
+			submit_job(inner);
+			wait_job(inner);
+			release_job(inner);
+			sum += local;
+		});
+		submit_job(j);
+		outer.push_back(j);
+	}
+	for (auto j : outer)
+	{
+		wait_job(j);
+		release_job(j);
+	}
+	printf("nested waits: %s\n", sum == 64 * 1001 ? "OK" : "FAILED");
+
+	// a job for the main thread that a worker submits, it runs in process_events
+	std::thread::id main_id = std::this_thread::get_id(), ran_on;
+	Job* main_job = nullptr;
+	auto spawner = create_job([&]() {
+		main_job = create_job([&]() { ran_on = std::this_thread::get_id(); }, JobFlagMainThread);
+		submit_job(main_job);
+	});
+	submit_job(spawner);
+	wait_job(spawner);
+	release_job(spawner);
+	while (!is_job_done(main_job))
+		process_events();
+	release_job(main_job);
+	printf("main thread job: %s\n", ran_on == main_id ? "OK" : "FAILED");
+
+	// many small jobs in chains
+	const auto chains = 100, chain_length = 100;
+	std::vector<uint> counters(chains, 0);
+	std::vector<Job*> chain_jobs;
+	auto t0 = performance_counter();
+	for (auto i = 0; i < chains; i++)
+	{
+		Job* last = nullptr;
+		for (auto j = 0; j < chain_length; j++)
+		{
+			auto job = create_job([&counters, i, j]() {
+				// a chain runs in order, so the counter is at j when the job runs
+				if (counters[i] == j)
+					counters[i]++;
+			});
+			if (last)
+				add_job_dependency(job, last);
+			submit_job(job);
+			chain_jobs.push_back(job);
+			last = job;
+		}
+	}
+	for (auto j : chain_jobs)
+	{
+		wait_job(j);
+		release_job(j);
+	}
+	ok = true;
+	for (auto c : counters)
+		ok = ok && c == chain_length;
+	printf("chains: %d jobs in %.3f ms, %s\n", chains * chain_length, (performance_counter() - t0) / freq * 1000.0, ok ? "OK" : "FAILED");
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/universe/bvh.h>
+
+using namespace flame;
+
+// reference: test every triangle
+bool brute_force(const std::vector<vec3>& positions, const std::vector<uint>& indices, const vec3& o, const vec3& d, float& t)
+{
+	auto hit = false;
+	for (auto i = 0; i + 2 < indices.size(); i += 3)
+	{
+		auto& v0 = positions[indices[i]];
+		auto e1 = positions[indices[i + 1]] - v0;
+		auto e2 = positions[indices[i + 2]] - v0;
+		auto p = cross(d, e2);
+		auto det = dot(e1, p);
+		if (abs(det) < 1e-12f)
+			continue;
+		auto s = o - v0;
+		auto u = dot(s, p) / det;
+		if (u < 0.f || u > 1.f)
+			continue;
+		auto q = cross(s, e1);
+		auto v = dot(d, q) / det;
+		if (v < 0.f || u + v > 1.f)
+			continue;
+		auto tt = dot(e2, q) / det;
+		if (tt < 0.f || tt >= t)
+			continue;
+		t = tt;
+		hit = true;
+	}
+	return hit;
+}
+
+int main()
+{
+	// a bumpy 256x256 grid, about 130k triangles
+	std::vector<vec3> positions;
+	std::vector<uint> indices;
+	const auto n = 256;
+	for (auto y = 0; y <= n; y++)
+	{
+		for (auto x = 0; x <= n; x++)
+			positions.push_back(vec3(x * 0.1f, sin(x * 0.3f) * cos(y * 0.2f), y * 0.1f));
+	}
+	for (auto y = 0; y < n; y++)
+	{
+		for (auto x = 0; x < n; x++)
+		{
+			auto i = y * (n + 1) + x;
+			uint quad[] = { (uint)i, (uint)i + n + 1, (uint)i + 1, (uint)i + 1, (uint)i + n + 1, (uint)i + n + 2 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	auto freq = (double)performance_frequency();
+	auto t0 = performance_counter();
+	MeshBvh bvh;
+	bvh.build(positions.data(), indices.data(), indices.size());
+	printf("build: %d triangles, %d nodes, %.2f ms\n", (int)indices.size() / 3, (int)bvh.nodes.size(), (performance_counter() - t0) / freq * 1000.0);
+
+	std::vector<std::pair<vec3, vec3>> rays(200);
+	for (auto& r : rays)
+	{
+		r.first = vec3(linearRand(0.f, n * 0.1f), 5.f, linearRand(0.f, n * 0.1f));
+		r.second = normalize(vec3(linearRand(-0.5f, 0.5f), -1.f, linearRand(-0.5f, 0.5f)));
+	}
+
+	auto mismatches = 0;
+	for (auto& r : rays)
+	{
+		auto t_ref = 1000.f, t = 1000.f;
+		auto hit_ref = brute_force(positions, indices, r.first, r.second, t_ref);
+		auto hit = bvh.intersect(r.first, r.second, t);
+		if (hit != hit_ref || (hit && abs(t - t_ref) > 1e-4f))
+			mismatches++;
+	}
+	printf("compare with brute force: %s (%d mismatches)\n", mismatches == 0 ? "OK" : "FAILED", mismatches);
+
+	const auto rounds = 1000;
+	t0 = performance_counter();
+	auto hits = 0;
+	for (auto i = 0; i < rounds; i++)
+	{
+		for (auto& r : rays)
+		{
+			auto t = 1000.f;
+			if (bvh.intersect(r.first, r.second, t))
+				hits++;
+		}
+	}
+	auto ms = (performance_counter() - t0) / freq * 1000.0;
+	printf("bvh: %d rays, %.3f us per ray (%d hits)\n", rounds * (int)rays.size(), ms * 1000.0 / (rounds * rays.size()), hits);
+
+	t0 = performance_counter();
+	for (auto& r : rays)
+	{
+		auto t = 1000.f;
+		brute_force(positions, indices, r.first, r.second, t);
+	}
+	ms = (performance_counter() - t0) / freq * 1000.0;
+	printf("brute force: %d rays, %.3f us per ray\n", (int)rays.size(), ms * 1000.0 / rays.size());
+
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/graphics/model.h>
+#include <flame/graphics/model_ext.h>
+
+using namespace flame;
+using namespace graphics;
+
+// a bumpy closed tube, the uvs wrap around so there is a seam where it closes
+void make_tube(Mesh& mesh, uint nx, uint ny, float phase)
+{
+	for (auto y = 0; y <= ny; y++)
+	{
+		for (auto x = 0; x <= nx; x++)
+		{
+			auto a = (x % nx) * 2.f * pi<float>() / nx;
+			auto r = 1.f + 0.1f * sin(y * 0.3f + phase);
+			mesh.positions.push_back(vec3(cos(a) * r, y * 0.05f, sin(a) * r));
+			mesh.uvs.push_back(vec2((float)x / nx, (float)y / ny));
+		}
+	}
+	for (auto y = 0; y < ny; y++)
+	{
+		for (auto x = 0; x < nx; x++)
+		{
+			auto i = y * (nx + 1) + x;
+			uint quad[] = { i, i + nx + 1, i + 1, i + 1, i + nx + 1, i + nx + 2 };
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	}
+	mesh.calc_bounds();
+}
+
+int main()
+{
+	auto model = Model::create();
+	const auto n_meshes = 8;
+	for (auto i = 0; i < n_meshes; i++)
+	{
+		auto& mesh = model->meshes.emplace_back();
+		mesh.model = model;
+		make_tube(mesh, 256, 128, i * 0.7f);
+	}
+	auto total_tris = 0U;
+	for (auto& m : model->meshes)
+		total_tris += m.indices.size() / 3;
+
+	auto freq = (double)performance_frequency();
+	auto t0 = performance_counter();
+	build_mesh_lods(model->meshes[0], 4);
+	auto single_time = (performance_counter() - t0) / freq;
+	printf("one mesh: %.2f ms, %.2f M triangles/s\n", single_time * 1000.0, model->meshes[0].indices.size() / 3 / single_time / 1000000.0);
+
+	t0 = performance_counter();
+	build_model_lods(model, 4);
+	auto parallel_time = (performance_counter() - t0) / freq;
+	printf("%d meshes in parallel: %.2f ms, %.2f M triangles/s\n", n_meshes, parallel_time * 1000.0, total_tris / parallel_time / 1000000.0);
+
+	// every level must be smaller with a larger error, and keep the seam closed: the x = 0 and x = nx columns are used together
+	auto ok = true;
+	for (auto& m : model->meshes)
+	{
+		auto last_count = (uint)m.indices.size();
+		auto last_error = 0.f;
+		for (auto& lod : m.lods)
+		{
+			if (lod.index_count >= last_count || lod.error < last_error)
+				ok = false;
+			last_count = lod.index_count;
+			last_error = lod.error;
+
+			std::vector<bool> used(m.positions.size(), false);
+			for (auto i = 0; i < lod.index_count; i++)
+			{
+				auto v = m.lod_indices[lod.index_offset + i];
+				if (v >= m.positions.size())
+					ok = false;
+				else
+					used[v] = true;
+			}
+			for (auto y = 0; y <= 128; y++)
+			{
+				if (used[y * 257] != used[y * 257 + 256])
+					ok = false;
+			}
+		}
+	}
+	printf("lods: %d levels, %s\n", (int)model->meshes[0].lods.size(), ok ? "OK" : "FAILED");
+	for (auto& lod : model->meshes[0].lods)
+		printf("  %d triangles, error %f\n", lod.index_count / 3, lod.error);
+
+	auto& m = model->meshes[0];
+	auto lod_near = m.select_lod(1.f / 2.f, 0.002f);
+	auto lod_far = m.select_lod(1.f / 200.f, 0.002f);
+	printf("select lod: %d near, %d far, %s\n", lod_near, lod_far, lod_near <= lod_far ? "OK" : "FAILED");
+
+	ControlMesh cm;
+	cm.init_as_cube(vec3(1.f));
+	ControlMesh sub;
+	for (auto i = 0; i < 4; i++)
+	{
+		cm.subdivide_CatmullClark(sub);
+		cm = sub;
+	}
+	auto faces_before = (uint)cm.faces.size();
+	cm.decimate(0.25f);
+	printf("control mesh decimate: %d quads -> %d triangles, %s\n", faces_before, (int)cm.faces.size(),
+		cm.faces.size() <= faces_before && !cm.faces.empty() ? "OK" : "FAILED");
+
+	delete model;
+	return 0;
+}
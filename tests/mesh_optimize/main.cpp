@@ -0,0 +1,114 @@
+#include <flame/foundation/foundation.h>
+#include <flame/graphics/model.h>
+#include <flame/graphics/model_ext.h>
+
+using namespace flame;
+using namespace graphics;
+
+std::vector<uvec3> sorted_triangles(const Mesh& mesh)
+{
+	std::vector<uvec3> ret;
+	for (auto i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		// compare by positions since vertices are reordered, rotate so the smallest position hash comes first
+		uint k[3];
+		for (auto j = 0; j < 3; j++)
+		{
+			auto& p = mesh.positions[mesh.indices[i + j]];
+			k[j] = (uint)(p.x * 1000.f) * 100000 + (uint)(p.z * 1000.f);
+		}
+		auto m = k[0] < k[1] ? (k[0] < k[2] ? 0 : 2) : (k[1] < k[2] ? 1 : 2);
+		ret.push_back(uvec3(k[m], k[(m + 1) % 3], k[(m + 2) % 3]));
+	}
+	std::sort(ret.begin(), ret.end(), [](const uvec3& a, const uvec3& b) {
+		return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+	});
+	return ret;
+}
+
+int main()
+{
+	// a 200x200 grid with its triangles shuffled, which is about the worst order for the vertex cache
+	auto model = Model::create();
+	auto& mesh = model->meshes.emplace_back();
+	mesh.model = model;
+	const auto n = 200;
+	for (auto y = 0; y <= n; y++)
+	{
+		for (auto x = 0; x <= n; x++)
+		{
+			mesh.positions.push_back(vec3(x * 0.1f, sin(x * 0.3f) * cos(y * 0.2f), y * 0.1f));
+			mesh.uvs.push_back(vec2(x, y) / (float)n);
+			mesh.normals.push_back(vec3(0.f, 1.f, 0.f));
+			mesh.tangents.push_back(vec3(1.f, 0.f, 0.f));
+		}
+	}
+	std::vector<uvec3> tris;
+	for (auto y = 0; y < n; y++)
+	{
+		for (auto x = 0; x < n; x++)
+		{
+			auto i = (uint)(y * (n + 1) + x);
+			tris.push_back(uvec3(i, i + n + 1, i + 1));
+			tris.push_back(uvec3(i + 1, i + n + 1, i + n + 2));
+		}
+	}
+	std::shuffle(tris.begin(), tris.end(), std::mt19937(0));
+	for (auto& t : tris)
+	{
+		mesh.indices.push_back(t.x);
+		mesh.indices.push_back(t.y);
+		mesh.indices.push_back(t.z);
+	}
+	for (auto& p : mesh.positions)
+		mesh.bounds.expand(p);
+	model->bounds = mesh.bounds;
+
+	auto ref = sorted_triangles(mesh);
+	auto acmr_before = get_mesh_acmr(mesh);
+	optimize_mesh(mesh);
+	auto acmr_after = get_mesh_acmr(mesh);
+	printf("acmr: %.3f -> %.3f: %s\n", acmr_before, acmr_after, acmr_after < acmr_before * 0.5f ? "OK" : "FAILED");
+	printf("triangles kept: %s\n", sorted_triangles(mesh) == ref ? "OK" : "FAILED");
+
+	build_meshlets(mesh);
+	auto meshlets_ok = true;
+	auto meshlet_tris = 0U;
+	for (auto& m : mesh.meshlets)
+	{
+		if (m.vertex_count > 64 || m.triangle_count > 124)
+			meshlets_ok = false;
+		for (auto i = 0; i < m.triangle_count * 3; i++)
+		{
+			if (mesh.meshlet_triangles[m.triangle_offset + i] >= m.vertex_count)
+				meshlets_ok = false;
+		}
+		for (auto i = 0; i < m.vertex_count; i++)
+		{
+			if (distance(mesh.positions[mesh.meshlet_vertices[m.vertex_offset + i]], m.center) > m.radius + 1e-4f)
+				meshlets_ok = false;
+		}
+		meshlet_tris += m.triangle_count;
+	}
+	printf("meshlets: %d, %s\n", (int)mesh.meshlets.size(), meshlets_ok && meshlet_tris * 3 == mesh.indices.size() ? "OK" : "FAILED");
+
+	auto filename = std::filesystem::temp_directory_path() / L"flame_mesh_optimize.fmodp";
+	model->save_packed(filename);
+	auto loaded = Model::get(filename);
+	auto same = loaded && loaded->meshes.size() == 1;
+	if (same)
+	{
+		auto& m = loaded->meshes[0];
+		same = m.positions == mesh.positions && m.indices == mesh.indices && m.meshlets.size() == mesh.meshlets.size() &&
+			m.meshlet_triangles == mesh.meshlet_triangles && m.packed_vertices;
+		m.unpack();
+		same = same && m.uvs == mesh.uvs && m.normals == mesh.normals;
+	}
+	printf("packed round trip: %s\n", same ? "OK" : "FAILED");
+	if (loaded)
+		Model::release(loaded);
+	delete model;
+	std::filesystem::remove(filename);
+
+	return 0;
+}
@@ -0,0 +1,82 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/universe/occlusion.h>
+
+using namespace flame;
+
+int main()
+{
+	auto proj = perspective(radians(45.f), 2.f, 1.f, 1000.f);
+	proj[1][1] *= -1.f;
+	auto view = lookAt(vec3(0.f, 0.f, 10.f), vec3(0.f), vec3(0.f, 1.f, 0.f));
+	auto proj_view = proj * view;
+
+	// a 20x20 wall at z = 0
+	vec3 wall_positions[] = { vec3(-10.f, -10.f, 0.f), vec3(10.f, -10.f, 0.f), vec3(10.f, 10.f, 0.f), vec3(-10.f, 10.f, 0.f) };
+	uint wall_indices[] = { 0, 1, 2, 0, 2, 3 };
+
+	OcclusionBuffer ob;
+	ob.begin(proj_view);
+	ob.add_occluder(wall_positions, countof(wall_positions), wall_indices, countof(wall_indices), mat4(1.f));
+	ob.end();
+
+	auto check = [&](const char* name, const AABB& b, bool expected) {
+		auto visible = ob.is_visible(b);
+		printf("%s: %s %s\n", name, visible ? "visible" : "occluded", visible == expected ? "OK" : "FAILED");
+	};
+	check("box behind the wall", AABB(vec3(-1.f, -1.f, -5.f), vec3(1.f, 1.f, -3.f)), false);
+	check("box in front of the wall", AABB(vec3(-1.f, -1.f, 3.f), vec3(1.f, 1.f, 5.f)), true);
+	check("box crossing the wall", AABB(vec3(-1.f, -1.f, -1.f), vec3(1.f, 1.f, 1.f)), true);
+	check("box beside the wall", AABB(vec3(30.f, -1.f, -50.f), vec3(32.f, 1.f, -48.f)), true);
+	check("box behind the camera", AABB(vec3(-1.f, -1.f, 11.f), vec3(1.f, 1.f, 12.f)), true);
+
+	// benchmark: a grid of 64x64 quads as occluders and 100k boxes behind them
+	std::vector<vec3> positions;
+	std::vector<uint> indices;
+	for (auto y = 0; y < 64; y++)
+	{
+		for (auto x = 0; x < 64; x++)
+		{
+			auto base = (uint)positions.size();
+			auto p = vec3(x * 0.5f - 16.f, y * 0.5f - 16.f, 0.f);
+			positions.push_back(p);
+			positions.push_back(p + vec3(0.5f, 0.f, 0.f));
+			positions.push_back(p + vec3(0.5f, 0.5f, 0.f));
+			positions.push_back(p + vec3(0.f, 0.5f, 0.f));
+			uint quad[] = { base + 0, base + 1, base + 2, base + 0, base + 2, base + 3 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+	std::vector<AABB> boxes(100000);
+	for (auto i = 0; i < boxes.size(); i++)
+	{
+		auto c = vec3(linearRand(-15.f, 15.f), linearRand(-15.f, 15.f), linearRand(-100.f, -1.f));
+		boxes[i] = AABB(c - 0.25f, c + 0.25f);
+	}
+
+	const auto rounds = 100;
+	auto freq = (double)performance_frequency();
+	auto t0 = performance_counter();
+	for (auto i = 0; i < rounds; i++)
+	{
+		ob.begin(proj_view);
+		ob.add_occluder(positions.data(), positions.size(), indices.data(), indices.size(), mat4(1.f));
+		ob.end();
+	}
+	auto t1 = performance_counter();
+	auto n_visible = 0;
+	for (auto i = 0; i < rounds; i++)
+	{
+		n_visible = 0;
+		for (auto& b : boxes)
+		{
+			if (ob.is_visible(b))
+				n_visible++;
+		}
+	}
+	auto t2 = performance_counter();
+	printf("rasterize %d triangles: %.3f ms\n", (int)ob.triangles.size(), (t1 - t0) / freq * 1000.0 / rounds);
+	printf("test %d boxes: %.3f ms, %d visible\n", (int)boxes.size(), (t2 - t1) / freq * 1000.0 / rounds, n_visible);
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/foundation/pack.h>
+
+using namespace flame;
+
+int main()
+{
+	// many small prefab-like files, the usual case of a scene load
+	auto dir = std::filesystem::temp_directory_path() / L"flame_pack_load";
+	std::filesystem::remove_all(dir);
+	const auto n = 2000U;
+	std::vector<std::filesystem::path> files(n);
+	for (auto i = 0; i < n; i++)
+	{
+		files[i] = dir / (L"d" + wstr(i % 20)) / (L"f" + wstr(i) + L".prefab");
+		std::filesystem::create_directories(files[i].parent_path());
+		std::ofstream file(files[i]);
+		file << "<prefab name=\"f" << i << "\">\n";
+		for (auto j = 0; j < 20 + i % 50; j++)
+			file << "  <node pos=\"" << j << ",0,0\" eul=\"0,0,0\" scl=\"1,1,1\"/>\n";
+		file << "</prefab>\n";
+	}
+	auto pack_filename = std::filesystem::temp_directory_path() / L"flame_pack_load.pak";
+	auto freq = (double)performance_frequency();
+
+	auto t0 = performance_counter();
+	Pack::create(pack_filename, dir);
+	printf("pack: %.3f ms\n", (performance_counter() - t0) / freq * 1000.0);
+
+	// loose files: exists + open + read, like Path::combine and a load do
+	std::vector<std::string> loose(n);
+	t0 = performance_counter();
+	for (auto i = 0; i < n; i++)
+	{
+		if (vfs_exists(files[i]))
+			vfs_read(files[i], loose[i]);
+	}
+	printf("loose: %.3f ms\n", (performance_counter() - t0) / freq * 1000.0);
+
+	t0 = performance_counter();
+	auto pack = Pack::mount(pack_filename, dir);
+	printf("mount: %.3f ms\n", (performance_counter() - t0) / freq * 1000.0);
+	if (!pack)
+		return 1;
+
+	std::vector<std::string> packed(n);
+	t0 = performance_counter();
+	for (auto i = 0; i < n; i++)
+	{
+		if (vfs_exists(files[i]))
+			vfs_read(files[i], packed[i]);
+	}
+	printf("packed: %.3f ms\n", (performance_counter() - t0) / freq * 1000.0);
+
+	auto ok = packed == loose;
+	printf("compare with loose files: %s\n", ok ? "OK" : "FAILED");
+	printf("note: the os file cache is warm here, clear it before running for a real cold load\n");
+
+	Pack::unmount(pack);
+	std::filesystem::remove(pack_filename);
+	std::filesystem::remove_all(dir);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/foundation/profiler.h>
+
+using namespace flame;
+
+const ProfilerCapture::Thread* find_thread(const ProfilerCapture& capture, uint id)
+{
+	for (auto& t : capture.threads)
+	{
+		if (t.id == id)
+			return &t;
+	}
+	return nullptr;
+}
+
+int main()
+{
+	profiler_enabled = true;
+	auto self = profiler_thread();
+	profiler_set_thread_name("Main");
+
+	// nested zones, children are inside their parents and one deeper
+	profiler_new_frame();
+	{
+		ProfilerScope a("A");
+		{
+			ProfilerScope b("B");
+			ProfilerScope c("C");
+		}
+		ProfilerScope d("D");
+	}
+	profiler_new_frame();
+	auto capture = profiler_capture(1);
+	auto t = find_thread(capture, self->id);
+	auto ok = t && t->name == "Main" && t->zones.size() == 4;
+	if (ok)
+	{
+		auto& z = t->zones;
+		ok = std::string(z[0].name) == "A" && z[0].depth == 0 &&
+			std::string(z[1].name) == "B" && z[1].depth == 1 &&
+			std::string(z[2].name) == "C" && z[2].depth == 2 &&
+			std::string(z[3].name) == "D" && z[3].depth == 1 &&
+			z[1].begin >= z[0].begin && z[1].end <= z[0].end &&
+			z[2].begin >= z[1].begin && z[2].end <= z[1].end &&
+			z[3].begin >= z[1].end && z[3].end <= z[0].end;
+	}
+	printf("nesting: %s\n", ok ? "OK" : "FAILED");
+
+	// zones are not recorded while it is off
+	profiler_enabled = false;
+	auto written = self->written.load();
+	{
+		ProfilerScope a("Off");
+	}
+	printf("disabled: %s\n", self->written.load() == written ? "OK" : "FAILED");
+	profiler_enabled = true;
+
+	// the ring keeps the newest zones
+	const auto zones_count = 1000000;
+	auto freq = (double)performance_frequency();
+	auto t0 = performance_counter();
+	for (auto i = 0; i < zones_count; i++)
+		ProfilerScope z("Loop");
+	auto ns = (performance_counter() - t0) / freq * 1000000000.0 / zones_count;
+	capture = profiler_capture(0);
+	t = find_thread(capture, self->id);
+	ok = t && !t->zones.empty() && t->zones.size() < zones_count && std::string(t->zones.back().name) == "Loop";
+	if (ok)
+	{
+		for (auto i = 1; i < t->zones.size(); i++)
+			ok = ok && t->zones[i].begin >= t->zones[i - 1].begin;
+	}
+	printf("ring: %s\n", ok ? "OK" : "FAILED");
+	printf("overhead: %.1f ns per zone, %s\n", ns, ns < 50.0 ? "OK" : "FAILED");
+
+	// jobs are zones on the threads that run them
+	std::vector<Job*> jobs;
+	for (auto i = 0; i < 16; i++)
+	{
+		auto j = create_job([]() {
+			ProfilerScope z("Work");
+			auto v = 0.f;
+			for (auto k = 0; k < 10000; k++)
+				v += sin((float)k);
+			static volatile float sink;
+			sink = v;
+		});
+		submit_job(j);
+		jobs.push_back(j);
+	}
+	for (auto j : jobs)
+	{
+		wait_job(j);
+		release_job(j);
+	}
+	capture = profiler_capture(0);
+	auto work_zones = 0;
+	ok = true;
+	for (auto& t : capture.threads)
+	{
+		for (auto i = 0; i < t.zones.size(); i++)
+		{
+			if (std::string(t.zones[i].name) == "Work")
+			{
+				work_zones++;
+				// a job zone is the parent, if it is compiled in
+				ok = ok && (t.zones[i].depth == 0 || (i > 0 && t.zones[i - 1].depth == t.zones[i].depth - 1));
+			}
+		}
+	}
+	printf("jobs: %s\n", ok && work_zones == 16 ? "OK" : "FAILED");
+
+	// a trace that chrome://tracing opens
+	auto filename = std::filesystem::temp_directory_path() / "flame_profiler_zones.json";
+	ok = profiler_export_chrome_trace(profiler_capture(0), filename);
+	if (ok)
+	{
+		std::ifstream file(filename);
+		std::string head(15, '\0');
+		file.read(head.data(), head.size());
+		ok = head == "{\"traceEvents\":";
+		file.close();
+		std::filesystem::remove(filename);
+	}
+	printf("export: %s\n", ok ? "OK" : "FAILED");
+
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/foundation/sheet.h>
+
+using namespace flame;
+
+int main()
+{
+	// a game data like sheet, ids are unique and shuffled, levels have many duplicates
+	const auto n = 50000U;
+	auto sheet = Sheet::create();
+	sheet->name = "items";
+	sheet->insert_column("id", TypeInfo::get<uint>());
+	sheet->insert_column("name", TypeInfo::get<std::string>());
+	sheet->insert_column("level", TypeInfo::get<int>());
+	sheet->insert_column("weight", TypeInfo::get<float>(), -1, "1.5");
+	std::vector<uint> ids(n);
+	for (auto i = 0; i < n; i++)
+		ids[i] = i * 7 + 3;
+	std::shuffle(ids.begin(), ids.end(), std::mt19937(0));
+	sheet->reserve_rows(n);
+	for (auto i = 0; i < n; i++)
+	{
+		sheet->insert_row();
+		*(uint*)sheet->get_data(i, 0) = ids[i];
+		*(std::string*)sheet->get_data(i, 1) = "item" + str(ids[i]);
+		*(int*)sheet->get_data(i, 2) = ids[i] % 100;
+	}
+	sheet->set_column_index(0, SheetIndexHash);
+	sheet->set_column_index(1, SheetIndexHash);
+	sheet->set_column_index(2, SheetIndexSorted);
+
+	auto freq = (double)performance_frequency();
+	const auto queries = 100000U;
+	auto ok = true;
+	auto t0 = performance_counter();
+	for (auto i = 0; i < queries; i++)
+	{
+		auto id = ids[(i * 31) % n];
+		auto row = sheet->find_row(0, &id);
+		if (row == -1 || *(uint*)sheet->get_data(row, 0) != id)
+			ok = false;
+	}
+	printf("hash lookups: %.3f ms, %s\n", (performance_counter() - t0) / freq * 1000.0, ok ? "OK" : "FAILED");
+	auto missing = 1U;
+	std::string name = "item" + str(ids[123]);
+	printf("string lookup: %s\n", sheet->find_row(0, &missing) == -1 && sheet->find_row(1, &name) == 123 ? "OK" : "FAILED");
+
+	auto lo = 10, hi = 19;
+	uint first;
+	auto count = sheet->find_range(2, &lo, &hi, first);
+	auto expected = 0U;
+	for (auto i = 0; i < n; i++)
+	{
+		auto level = *(int*)sheet->get_data(i, 2);
+		if (level >= lo && level <= hi)
+			expected++;
+	}
+	ok = count == expected;
+	for (auto i = 0; i < count; i++)
+	{
+		auto level = *(int*)sheet->get_data(sheet->get_sorted_row(2, first + i), 2);
+		if (level < lo || level > hi)
+			ok = false;
+	}
+	printf("range: %d rows, %s\n", count, ok ? "OK" : "FAILED");
+
+	// the indices follow edits
+	auto new_id = 1U;
+	sheet->set_data(5, 0, &new_id);
+	sheet->remove_row(0);
+	printf("edits: %s\n", sheet->find_row(0, &new_id) == 4 && sheet->find_row(0, &ids[0]) == -1 ? "OK" : "FAILED");
+
+	// nans in a sorted column go after all numbers and can still be found
+	for (auto i = 0; i < n; i += 10)
+		*(float*)sheet->get_data(i, 3) = i % 20 == 0 ? NAN : (float)(i % 7);
+	sheet->set_column_index(3, SheetIndexSorted);
+	auto nan = NAN;
+	auto nan_row = sheet->find_row(3, &nan);
+	ok = nan_row != -1 && isnan(*(float*)sheet->get_data(nan_row, 3));
+	for (auto i = 1; i < sheet->rows_count; i++)
+	{
+		auto a = *(float*)sheet->get_data(sheet->get_sorted_row(3, i - 1), 3);
+		auto b = *(float*)sheet->get_data(sheet->get_sorted_row(3, i), 3);
+		if (isnan(a) ? !isnan(b) : (!isnan(b) && b < a))
+			ok = false;
+	}
+	printf("nan order: %s\n", ok ? "OK" : "FAILED");
+
+	auto filename = std::filesystem::temp_directory_path() / L"flame_sheet_query.sht";
+	sheet->save(filename, true);
+	t0 = performance_counter();
+	auto loaded = Sheet::get(filename);
+	printf("binary load: %.3f ms\n", (performance_counter() - t0) / freq * 1000.0);
+	auto same = loaded && loaded->rows_count == sheet->rows_count && loaded->columns.size() == sheet->columns.size() && loaded->name == "items";
+	for (auto i = 0; same && i < sheet->rows_count; i++)
+	{
+		for (auto j = 0; j < sheet->columns.size(); j++)
+		{
+			if (!sheet->columns[j].type->compare(loaded->get_data(i, j), sheet->get_data(i, j)))
+				same = false;
+		}
+	}
+	same = same && loaded->columns[2].index_type == SheetIndexSorted && !loaded->columns[2].index_dirty;
+	printf("binary round trip: %s\n", same ? "OK" : "FAILED");
+	if (loaded)
+		Sheet::release(loaded);
+	delete sheet;
+	std::filesystem::remove(filename);
+
+	return 0;
+}
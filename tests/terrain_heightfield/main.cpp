@@ -0,0 +1,124 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/universe/heightfield.h>
+
+using namespace flame;
+
+// the per texel computation that terrain used before, as the reference
+void reference_normals(const Heightfield& hf, const uvec2& sz, float h_scale, std::vector<cvec4>& normals, std::vector<cvec4>& tangents)
+{
+	auto sz1 = sz + 1U;
+	std::vector<float> heights(sz1.x * sz1.y);
+	for (auto y = 0; y < sz1.y; y++)
+	{
+		for (auto x = 0; x < sz1.x; x++)
+			heights[y * sz1.x + x] = hf.sample(vec2((float)x / sz.x, (float)y / sz.y)) * h_scale;
+	}
+	normals.resize(sz.x * sz.y);
+	tangents.resize(sz.x * sz.y);
+	for (auto y = 0; y < sz.y; y++)
+	{
+		for (auto x = 0; x < sz.x; x++)
+		{
+			auto LT = heights[y * sz1.x + x];
+			auto RT = heights[y * sz1.x + x + 1];
+			auto LB = heights[(y + 1) * sz1.x + x];
+			auto RB = heights[(y + 1) * sz1.x + x + 1];
+			auto hL = (LT + LB) * 0.5f;
+			auto hR = (RT + RB) * 0.5f;
+			auto hU = (LT + RT) * 0.5f;
+			auto hD = (LB + RB) * 0.5f;
+			auto n = normalize(vec3(hL - hR, 2.f, hU - hD));
+			normals[y * sz.x + x] = cvec4((n + 1.f) * 0.5f * 255.f, 255);
+			auto t = normalize(vec3(2.f, hR - hL, 0.f));
+			tangents[y * sz.x + x] = cvec4((t + 1.f) * 0.5f * 255.f, 255);
+		}
+	}
+}
+
+bool maps_equal(const std::vector<cvec4>& a, const std::vector<cvec4>& b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (auto i = 0; i < a.size(); i++)
+	{
+		for (auto j = 0; j < 4; j++)
+		{
+			if (abs((int)a[i][j] - (int)b[i][j]) > 1)
+				return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	// a 512x512 height map under a terrain of 64x64 blocks with tess level 16
+	Heightfield hf;
+	hf.resize(uvec2(512));
+	for (auto y = 0; y < hf.size.y; y++)
+	{
+		for (auto x = 0; x < hf.size.x; x++)
+			hf.data[y * hf.size.x + x] = 0.5f + sin(x * 0.05f) * cos(y * 0.03f) * 0.4f;
+	}
+	auto sz = uvec2(64 * 16);
+	auto h_scale = 128.f / (256.f / sz.x);
+
+	std::vector<cvec4> ref_nor, ref_tan;
+	auto t0 = performance_counter();
+	reference_normals(hf, sz, h_scale, ref_nor, ref_tan);
+	auto ref_time = (performance_counter() - t0) / (double)performance_frequency();
+
+	std::vector<cvec4> nor(sz.x * sz.y), tan(sz.x * sz.y);
+	t0 = performance_counter();
+	compute_terrain_normals(hf, sz, h_scale, ivec4(0, 0, sz), nor.data(), tan.data());
+	auto full_time = (performance_counter() - t0) / (double)performance_frequency();
+	printf("full map: %.2f ms, reference %.2f ms\n", full_time * 1000.0, ref_time * 1000.0);
+	printf("normals: %s\n", maps_equal(nor, ref_nor) && maps_equal(tan, ref_tan) ? "OK" : "FAILED");
+
+	// a brush stroke, only the normals around it are computed again
+	auto rect = ivec4(200, 300, 232, 332);
+	for (auto y = rect.y; y < rect.w; y++)
+	{
+		for (auto x = rect.x; x < rect.z; x++)
+			hf.data[y * hf.size.x + x] += 0.1f;
+	}
+	auto nrect = heightfield_rect_to_normal_rect(hf, sz, rect);
+	t0 = performance_counter();
+	compute_terrain_normals(hf, sz, h_scale, nrect, nor.data(), tan.data());
+	auto rect_time = (performance_counter() - t0) / (double)performance_frequency();
+	reference_normals(hf, sz, h_scale, ref_nor, ref_tan);
+	printf("brush rect %dx%d: %.3f ms\n", nrect.z - nrect.x, nrect.w - nrect.y, rect_time * 1000.0);
+	printf("incremental: %s\n", maps_equal(nor, ref_nor) && maps_equal(tan, ref_tan) ? "OK" : "FAILED");
+
+	{
+		auto ok = true;
+		Heightfield flat;
+		flat.resize(uvec2(64));
+		std::fill(flat.data.begin(), flat.data.end(), 0.5f);
+		auto t = flat.raycast(vec3(0.3f, 2.f, 0.4f), vec3(0.f, -1.f, 0.f), 10.f);
+		if (abs(t - 1.5f) > 1e-3f)
+			ok = false;
+		if (flat.raycast(vec3(0.3f, 2.f, 0.4f), vec3(0.f, 1.f, 0.f), 10.f) >= 0.f)
+			ok = false;
+		if (flat.raycast(vec3(0.3f, 2.f, 0.4f), vec3(0.f, -1.f, 0.f), 1.f) >= 0.f)
+			ok = false;
+
+		std::mt19937 rng(0);
+		std::uniform_real_distribution<float> dist(0.f, 1.f);
+		for (auto i = 0; i < 1000; i++)
+		{
+			auto o = vec3(dist(rng), 1.2f, dist(rng));
+			auto d = normalize(vec3(dist(rng) - 0.5f, -1.f, dist(rng) - 0.5f));
+			auto t = hf.raycast(o, d, 10.f);
+			if (t < 0.f)
+				continue;
+			auto p = o + d * t;
+			if (abs(p.y - hf.sample(vec2(p.x, p.z))) > 1e-3f)
+				ok = false;
+		}
+		printf("raycast: %s\n", ok ? "OK" : "FAILED");
+	}
+
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/universe/tile_chunks.h>
+#include <flame/universe/draw_data.h>
+
+using namespace flame;
+
+// the size of BatchInstance::mats in instance.dsl, the old limit was the 65536 mesh instances
+const auto BatchInstancesCapacity = 262144U;
+const auto MeshInstancesCapacity = 65536U;
+
+// 8 kinds of tiles, the odd ones have two meshes
+const auto TemplatesCount = 8U;
+uint parts_count(uint tmpl)
+{
+	return tmpl % 2 + 1;
+}
+
+uint tile_kind(uint i, uint j, uint seed)
+{
+	return (i * 73856093U ^ j * 19349663U ^ seed * 83492791U) % (TemplatesCount + 1);
+}
+
+struct Map
+{
+	uvec2 blocks;
+	uint seed = 0;
+	TileChunks chunks;
+	uint next_ins = 0; // the chunks take their ranges one after another
+
+	void build(bool full)
+	{
+		if (full)
+		{
+			chunks.resize(blocks);
+			next_ins = 0;
+		}
+		for (auto& c : chunks.chunks)
+		{
+			if (!c.dirty)
+				continue;
+			auto n = TileChunks::build(c, blocks, [&](uint i, uint j, TileChunks::Tile& tile) {
+				auto k = tile_kind(i, j, seed);
+				if (k < TemplatesCount)
+				{
+					tile.tmpl = k;
+					tile.height = (i + j) % 3;
+				}
+			}, parts_count);
+			if (n != c.ins_count)
+			{
+				c.ins_id = n > 0 ? next_ins : -1;
+				c.ins_count = n;
+				next_ins += n;
+			}
+		}
+	}
+
+	// what the drawer of cTileMap gives for a pass, one draw for each batch of each chunk
+	void draw(DrawData& draw_data)
+	{
+		for (auto& c : chunks.chunks)
+		{
+			if (c.ins_id == -1)
+				continue;
+			for (auto& b : c.batches)
+				draw_data.mesh_batches.emplace_back(c.ins_id + b.ins_off, b.count, b.tmpl * 2 + b.part, 0);
+		}
+	}
+};
+
+// every tile part has exactly one instance, in the batch of its template part
+bool check(Map& map)
+{
+	auto tiles_parts = 0U;
+	for (auto j = 0; j < map.blocks.y; j++)
+	{
+		for (auto i = 0; i < map.blocks.x; i++)
+		{
+			auto k = tile_kind(i, j, map.seed);
+			if (k < TemplatesCount)
+				tiles_parts += parts_count(k);
+		}
+	}
+	auto instances = 0U;
+	for (auto& c : map.chunks.chunks)
+	{
+		std::vector<uint> used(c.ins_count);
+		auto ok = true;
+		TileChunks::for_each_instance(c, [&](const TileChunks::Tile& tile, uint x, uint y, uint batch, uint off) {
+			auto& b = c.batches[batch];
+			auto i = c.coord.x * TileChunks::ChunkSize + x;
+			auto j = c.coord.y * TileChunks::ChunkSize + y;
+			if (off >= c.ins_count || off < b.ins_off || off >= b.ins_off + b.count || b.tmpl != tile_kind(i, j, map.seed))
+				ok = false;
+			else
+				used[off]++;
+		});
+		if (!ok)
+			return false;
+		for (auto u : used)
+		{
+			if (u != 1)
+				return false;
+		}
+		instances += c.ins_count;
+	}
+	return instances == tiles_parts;
+}
+
+int main()
+{
+	Map map;
+	map.blocks = uvec2(256, 256);
+
+	auto t0 = performance_counter();
+	map.build(true);
+	auto build_time = (performance_counter() - t0) / (double)performance_frequency();
+
+	DrawData draw_data;
+	draw_data.reset(PassGBuffer, CateMesh);
+	map.draw(draw_data);
+	auto tiles = map.blocks.x * map.blocks.y;
+	auto max_draws = (uint)map.chunks.chunks.size() * (TemplatesCount + TemplatesCount / 2);
+	printf("%dx%d tiles: %d chunks, %d instances, %d draws, %.2f ms\n", map.blocks.x, map.blocks.y, (int)map.chunks.chunks.size(), map.next_ins, (int)draw_data.mesh_batches.size(), build_time * 1000.0);
+	printf("instances: %s\n", check(map) && map.next_ins > MeshInstancesCapacity && map.next_ins <= BatchInstancesCapacity ? "OK" : "FAILED");
+	auto drawn = 0U;
+	for (auto& d : draw_data.mesh_batches)
+		drawn += d.count;
+	printf("draws: %s\n", draw_data.mesh_batches.size() <= max_draws && draw_data.mesh_batches.size() * 16 < tiles && drawn == map.next_ins ? "OK" : "FAILED");
+
+	// a changed tile rebuilds only its chunk
+	map.chunks.mark_dirty(uvec2(100, 37));
+	auto dirty = 0;
+	for (auto& c : map.chunks.chunks)
+		dirty += c.dirty ? 1 : 0;
+	auto& c = map.chunks.chunks[100 / TileChunks::ChunkSize + 37 / TileChunks::ChunkSize * map.chunks.count.x];
+	auto ins_id = c.ins_id;
+	map.build(false);
+	printf("edit: %s\n", dirty == 1 && !c.dirty && c.ins_id == ins_id && check(map) ? "OK" : "FAILED");
+
+	return 0;
+}
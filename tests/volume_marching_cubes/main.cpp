@@ -0,0 +1,99 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/system.h>
+#include <flame/universe/marching_cubes.h>
+
+using namespace flame;
+
+// every edge of a closed surface is used by two triangles, which only holds if the vertices of the blocks are welded
+bool is_closed(const graphics::Mesh& mesh)
+{
+	std::unordered_map<uint64, int> edges;
+	for (auto i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		for (auto j = 0; j < 3; j++)
+		{
+			uint64 a = mesh.indices[i + j];
+			uint64 b = mesh.indices[i + (j + 1) % 3];
+			if (a == b)
+				continue;
+			edges[a < b ? (a << 32) | b : (b << 32) | a]++;
+		}
+	}
+	for (auto& e : edges)
+	{
+		if (e.second != 2)
+			return false;
+	}
+	return !edges.empty();
+}
+
+void fill_spheres(DensityField& field, const std::vector<std::pair<vec3, float>>& spheres)
+{
+	for (auto z = 0; z < field.size.z; z++)
+	{
+		for (auto y = 0; y < field.size.y; y++)
+		{
+			for (auto x = 0; x < field.size.x; x++)
+			{
+				auto uv = (vec3(x, y, z) + 0.5f) / vec3(field.size);
+				auto v = -1.f;
+				for (auto& s : spheres)
+					v = max(v, clamp((s.second - distance(uv, s.first)) * 8.f, -1.f, 1.f));
+				field.data[(z * field.size.y + y) * field.size.x + x] = v;
+			}
+		}
+	}
+}
+
+int main()
+{
+	// a 128x64x128 density with a sphere that crosses the borders of 4x2x4 blocks
+	DensityField field;
+	field.resize(uvec3(128, 64, 128));
+	std::vector<std::pair<vec3, float>> spheres;
+	spheres.emplace_back(vec3(0.5f, 0.5f, 0.5f), 0.3f);
+	fill_spheres(field, spheres);
+
+	MarchingCubesMesher mesher;
+	mesher.init(uvec3(4, 2, 4), 32, vec3(64.f, 32.f, 64.f));
+	auto t0 = performance_counter();
+	auto n = mesher.update(field);
+	auto full_time = (performance_counter() - t0) / (double)performance_frequency();
+	graphics::Mesh mesh;
+	mesher.build_mesh(mesh);
+	printf("full: %d blocks, %.2f ms, %d vertices, %d triangles\n", n, full_time * 1000.0, (int)mesh.positions.size(), (int)mesh.indices.size() / 3);
+	printf("welded: %s\n", is_closed(mesh) ? "OK" : "FAILED");
+
+	{
+		auto ok = !mesh.positions.empty();
+		for (auto i = 0; i < mesh.positions.size(); i++)
+		{
+			auto uv = mesh.positions[i] / mesher.extent;
+			if (abs(field.sample(uv)) > 0.05f)
+				ok = false;
+			// normals point out of the sphere
+			if (dot(mesh.normals[i], normalize(uv - spheres[0].first)) < 0.f)
+				ok = false;
+		}
+		printf("on surface: %s\n", ok ? "OK" : "FAILED");
+	}
+
+	// an edit of a small region only meshes the blocks around it again, and gives the same mesh as meshing everything
+	spheres.emplace_back(vec3(0.8f, 0.5f, 0.2f), 0.08f);
+	fill_spheres(field, spheres);
+	mesher.mark_dirty(vec3(0.7f, 0.4f, 0.1f), vec3(0.9f, 0.6f, 0.3f));
+	t0 = performance_counter();
+	n = mesher.update(field);
+	auto edit_time = (performance_counter() - t0) / (double)performance_frequency();
+	mesher.build_mesh(mesh);
+
+	MarchingCubesMesher ref_mesher;
+	ref_mesher.init(mesher.blocks, mesher.cells, mesher.extent);
+	ref_mesher.update(field);
+	graphics::Mesh ref;
+	ref_mesher.build_mesh(ref);
+	printf("edit: %d blocks, %.2f ms\n", n, edit_time * 1000.0);
+	printf("incremental: %s\n", n < mesher.block_meshes.size() && mesh.positions == ref.positions && mesh.indices == ref.indices && is_closed(mesh) ? "OK" : "FAILED");
+
+	return 0;
+}
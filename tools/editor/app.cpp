@@ -641,7 +641,7 @@ void App::init()
 	auto root = world->root.get();
 	root->add_component<cNode>();
 	e_editor = Entity::create();
-	e_editor->name = "[Editor]";
+	e_editor->set_name("[Editor]");
 	e_editor->add_component<cNode>();
 	e_editor->add_component<cCamera>();
 	root->add_child(e_editor);
@@ -2286,17 +2286,17 @@ void App::new_prefab(const std::filesystem::path& path, uint type)
 	case "general_3d_scene"_h:
 		e->add_component<cNode>();
 		auto e_camera = Entity::create();
-		e_camera->name = "Camera";
+		e_camera->set_name("Camera");
 		e_camera->add_component<cNode>();
 		e_camera->add_component<cCamera>();
 		e->add_child(e_camera);
 		auto e_light = Entity::create();
-		e_light->name = "Directional Light";
+		e_light->set_name("Directional Light");
 		e_light->add_component<cNode>()->set_eul(vec3(45.f, -60.f, 0.f));
 		e_light->add_component<cDirectionalLight>();
 		e->add_child(e_light);
 		auto e_plane = Entity::create();
-		e_plane->name = "Plane";
+		e_plane->set_name("Plane");
 		e_plane->tag = e_plane->tag;
 		e_plane->add_component<cNode>();
 		e_plane->add_component<cMesh>()->set_mesh_and_material(L"standard_plane", L"default");
@@ -2513,6 +2513,8 @@ void App::timeline_stop_record()
 KeyframePtr App::get_keyframe(const std::string& address, bool toggle)
 {
 	auto current_time = timeline_current_frame / 60.f;
+	// the caller writes the value of the returned keyframe, the timeline compiles on its next frame
+	opened_timeline->dirty = true;
 	auto it = std::find_if(opened_timeline->tracks.begin(), opened_timeline->tracks.end(), [&](const auto& i) {
 		return i.address == address;
 	});
@@ -2619,7 +2621,7 @@ bool App::cmd_new_entities(std::vector<EntityPtr>&& ts, uint type)
 	for (auto t : ts)
 	{
 		auto e = Entity::create();
-		e->name = "entity";
+		e->set_name("entity");
 		switch (type)
 		{
 		case "empty"_h:
@@ -893,6 +893,8 @@ void BlueprintView::on_draw()
 			blueprint_window.debugger->debugging->name == group_name_hash ?
 			blueprint_window.debugger->debugging : nullptr;
 		auto& instance_group = debugging_group ? *debugging_group : blueprint_instance->groups[group_name_hash];
+		ImGui::SameLine();
+		ImGui::Text("Build: %.3f ms", instance_group.build_time);
 
 		if (ImGui::BeginTable("bp_editor", 2, ImGuiTableFlags_Resizable))
 		{
@@ -313,7 +313,7 @@ void HierarchyView::on_draw()
 				ImGui::SetKeyboardFocusHere();
 			if (ImGui::InputText("##rename", &rename_string, ImGuiInputTextFlags_AutoSelectAll))
 			{
-				e->name = rename_string;
+				e->set_name(rename_string);
 				if (auto ins = get_root_prefab_instance(e); ins)
 					ins->mark_modification(e->file_id.to_string() + "|name");
 				if (!app.e_playing)
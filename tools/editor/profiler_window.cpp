@@ -0,0 +1,119 @@
+#include "profiler_window.h"
+
+ProfilerWindow profiler_window;
+
+ProfilerView::ProfilerView() :
+	ProfilerView(profiler_window.views.empty() ? "Profiler" : "Profiler##" + str(rand()))
+{
+}
+
+ProfilerView::ProfilerView(const std::string& name) :
+	View(&profiler_window, name)
+{
+}
+
+void ProfilerView::on_draw()
+{
+	bool opened = true;
+	ImGui::SetNextWindowSize(vec2(800, 400), ImGuiCond_FirstUseEver);
+	ImGui::Begin(name.c_str(), &opened);
+	imgui_window = ImGui::GetCurrentWindow();
+
+#ifndef USE_PROFILER
+	ImGui::TextUnformatted("the profiler zones are compiled out, build with USE_PROFILER");
+#endif
+	ImGui::Checkbox("Enable", &profiler_enabled);
+	ImGui::SameLine();
+	ImGui::Checkbox("Pause", &paused);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(100.f);
+	ImGui::SliderInt("Frames", &frames_count, 1, 16);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(100.f);
+	ImGui::SliderFloat("Zoom", &zoom, 1.f, 64.f, "%.1f", ImGuiSliderFlags_Logarithmic);
+	ImGui::SameLine();
+	if (ImGui::Button("Export"))
+	{
+		auto filename = (app.project_path.empty() ? std::filesystem::current_path() : app.project_path) / L"trace.json";
+		if (profiler_export_chrome_trace(capture, filename))
+			printf("profiler: trace saved to %s\n", filename.string().c_str());
+	}
+
+	if (profiler_enabled && !paused)
+		capture = profiler_capture(frames_count);
+
+	auto range = capture.end > capture.begin ? (double)(capture.end - capture.begin) : 0.0;
+	ImGui::Text("%.3f ms", range / capture.ticks_per_us / 1000.0);
+	// since the last draw, that is a frame
+	auto stats = get_frame_arena_stats();
+	ImGui::SameLine();
+	ImGui::Text("Frame Arena: %llu allocations, %llu heap allocations, %llu KB reserved", stats.allocations - arena_stats.allocations,
+		stats.heap_allocations - arena_stats.heap_allocations, stats.reserved_bytes / 1024);
+	arena_stats = stats;
+
+	// every thread is a flame graph, the children of a zone are under it
+	ImGui::BeginChild("##graph", ImVec2(0.f, 0.f), false, ImGuiWindowFlags_HorizontalScrollbar);
+	if (range > 0.0)
+	{
+		const auto row_height = 18.f;
+		auto dl = ImGui::GetWindowDrawList();
+		auto width = (ImGui::GetContentRegionAvail().x - 4.f) * zoom;
+		for (auto& t : capture.threads)
+		{
+			if (t.zones.empty())
+				continue;
+			auto max_depth = 0U;
+			for (auto& z : t.zones)
+				max_depth = max(max_depth, z.depth);
+
+			ImGui::TextUnformatted(t.name.c_str());
+			auto p0 = (vec2)ImGui::GetCursorScreenPos();
+			ImGui::InvisibleButton(("##thread" + str(t.id)).c_str(), ImVec2(width, (max_depth + 1) * row_height));
+			auto hovered = ImGui::IsItemHovered();
+			auto mpos = (vec2)ImGui::GetMousePos();
+			for (auto& z : t.zones)
+			{
+				auto x0 = p0.x + float((z.begin - capture.begin) / range * width);
+				auto x1 = p0.x + float((z.end - capture.begin) / range * width);
+				if (x1 - x0 < 1.f)
+					x1 = x0 + 1.f;
+				auto y0 = p0.y + z.depth * row_height;
+				auto y1 = y0 + row_height - 1.f;
+				auto hash = sh(z.name);
+				auto color = ImColor(0.4f + (hash & 0xff) / 255.f * 0.4f, 0.4f + ((hash >> 8) & 0xff) / 255.f * 0.4f, 0.3f + ((hash >> 16) & 0xff) / 255.f * 0.2f);
+				dl->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), color);
+				auto text_size = ImGui::CalcTextSize(z.name);
+				if (x1 - x0 > text_size.x + 4.f)
+				{
+					dl->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+					dl->AddText(ImVec2(x0 + 2.f, y0 + 1.f), ImColor(0, 0, 0), z.name);
+					dl->PopClipRect();
+				}
+				if (hovered && mpos.x >= x0 && mpos.x < x1 && mpos.y >= y0 && mpos.y < y1)
+					ImGui::SetTooltip("%s\n%.3f ms", z.name, (z.end - z.begin) / capture.ticks_per_us / 1000.0);
+			}
+		}
+	}
+	ImGui::EndChild();
+
+	ImGui::End();
+	if (!opened)
+		delete this;
+}
+
+ProfilerWindow::ProfilerWindow() :
+	Window("Profiler")
+{
+}
+
+View* ProfilerWindow::open_view(bool new_instance)
+{
+	if (new_instance || views.empty())
+		return new ProfilerView;
+	return nullptr;
+}
+
+View* ProfilerWindow::open_view(const std::string& name)
+{
+	return new ProfilerView(name);
+}
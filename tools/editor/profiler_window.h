@@ -0,0 +1,28 @@
+#pragma once
+
+#include "app.h"
+
+#include <flame/foundation/profiler.h>
+#include <flame/foundation/frame_arena.h>
+
+struct ProfilerView : View
+{
+	bool paused = false;
+	int frames_count = 1;
+	float zoom = 1.f;
+	ProfilerCapture capture;
+	FrameArenaStats arena_stats;
+
+	ProfilerView();
+	ProfilerView(const std::string& name);
+	void on_draw() override;
+};
+
+struct ProfilerWindow : Window
+{
+	ProfilerWindow();
+	View* open_view(bool new_instance) override;
+	View* open_view(const std::string& name) override;
+};
+
+extern ProfilerWindow profiler_window;
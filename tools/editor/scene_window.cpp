@@ -2,6 +2,7 @@
 #include "selection.h"
 #include "history.h"
 #include "tile_map_editing.h"
+#include "terrain_editing.h"
 
 #include <flame/universe/draw_data.h>
 #include <flame/universe/components/node.h>
@@ -1138,6 +1139,7 @@ void SceneView::on_draw()
 			auto e = selection.as_entity();
 			if (auto terrain = e->get_component<cTerrain>(); terrain)
 			{
+				terrain_editing();
 			}
 			if (auto tile_map = e->get_component<cTileMap>(); tile_map)
 			{
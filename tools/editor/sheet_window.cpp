@@ -131,6 +131,7 @@ void SheetView::on_draw()
 				int column_idx = 0;
 				std::vector<std::string> new_names;
 				std::vector<TypeInfo*> new_types;
+				std::vector<int> new_index_types;
 
 				static void open(SheetView* view)
 				{
@@ -145,6 +146,9 @@ void SheetView::on_draw()
 					dialog->new_types.resize(sheet->columns.size());
 					for (auto i = 0; i < sheet->columns.size(); i++)
 						dialog->new_types[i] = sheet->columns[i].type;
+					dialog->new_index_types.resize(sheet->columns.size());
+					for (auto i = 0; i < sheet->columns.size(); i++)
+						dialog->new_index_types[i] = sheet->columns[i].index_type;
 					Dialog::open(dialog);
 				}
 
@@ -171,6 +175,7 @@ void SheetView::on_draw()
 									new_types[column_idx] = type;
 								ImGui::EndCombo();
 							}
+							ImGui::Combo("Index", &new_index_types[column_idx], "None\0Hash\0Sorted\0");
 							ImGui::EndGroup();
 						}
 
@@ -191,6 +196,11 @@ void SheetView::on_draw()
 
 									changed = true;
 								}
+								if (sheet->columns[i].index_type != new_index_types[i])
+								{
+									sheet->set_column_index(i, (SheetIndexType)new_index_types[i]);
+									changed = true;
+								}
 							}
 							if (changed)
 								view->unsaved = true;
@@ -437,14 +447,13 @@ void SheetView::on_draw()
 				return changed;
 			};
 
-			if (vertical_mode && sheet->rows.size() <= 1)
+			if (vertical_mode && sheet->rows_count == 1)
 			{
 				if (ImGui::BeginTable("##main", 2, ImGuiTableFlags_Resizable | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollX | ImGuiTableFlags_NoSavedSettings, ImVec2(0.f, -30.f)))
 				{
 					ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthFixed, 200.f);
 					ImGui::TableSetupColumn("Value", ImGuiTableColumnFlags_WidthFixed, 200.f);
 
-					auto& row = sheet->rows[0];
 					for (auto i = 0; i < sheet->columns.size(); i++)
 					{
 						ImGui::TableNextRow();
@@ -456,10 +465,13 @@ void SheetView::on_draw()
 
 						ImGui::PushID(i);
 						auto type = column.type;
-						auto data = row.datas[i];
+						auto data = sheet->get_data(0, i);
 						auto changed = manipulate_data(type, data);
 						if (changed)
+						{
+							sheet->mark_column_changed(i);
 							unsaved = true;
+						}
 						ImGui::PopID();
 					}
 					ImGui::EndTable();
@@ -485,10 +497,8 @@ void SheetView::on_draw()
 						column.width = ImGui::GetContentRegionAvail().x;
 					}
 
-					for (auto i = 0; i < sheet->rows.size(); i++)
+					for (auto i = 0; i < sheet->rows_count; i++)
 					{
-						auto& row = sheet->rows[i];
-
 						ImGui::TableNextRow();
 
 						ImGui::PushID(i);
@@ -497,10 +507,13 @@ void SheetView::on_draw()
 							ImGui::TableSetColumnIndex(j);
 							ImGui::PushID(j);
 							auto type = sheet->columns[j].type;
-							auto data = row.datas[j];
+							auto data = sheet->get_data(i, j);
 							auto changed = manipulate_data(type, data);
 							if (changed)
+							{
+								sheet->mark_column_changed(j);
 								unsaved = true;
+							}
 							ImGui::PopID();
 						}
 
@@ -521,16 +534,16 @@ void SheetView::on_draw()
 							{
 								if (i > 0)
 								{
-									std::swap(sheet->rows[i], sheet->rows[i - 1]);
+									sheet->swap_rows(i, i - 1);
 									unsaved = true;
 								}
 							}
 							ImGui::SameLine();
 							if (ImGui::Button(graphics::font_icon_str("arrow-down"_h).c_str()))
 							{
-								if (i < sheet->rows.size() - 1)
+								if (i + 1 < sheet->rows_count)
 								{
-									std::swap(sheet->rows[i], sheet->rows[i + 1]);
+									sheet->swap_rows(i, i + 1);
 									unsaved = true;
 								}
 							}
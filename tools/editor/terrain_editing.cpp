@@ -0,0 +1,69 @@
+#include "app.h"
+#include "selection.h"
+#include "scene_window.h"
+#include "terrain_editing.h"
+
+#include <flame/universe/components/node.h>
+#include <flame/universe/components/terrain.h>
+
+void terrain_editing()
+{
+	auto fv = scene_window.first_view();
+	if (!fv)
+		return;
+
+	auto& io = ImGui::GetIO();
+
+	auto terrain = selection.as_entity()->get_component<cTerrain>();
+	auto& hf = terrain->heightfield;
+	if (hf.data.empty())
+		return;
+
+	auto extent = terrain->extent * terrain->node->global_scl();
+	auto radius = extent.x / 32.f;
+	auto strength = 0.1f; // of the full height per second
+
+	auto center = fv->hovering_pos;
+	vec3 pts[33];
+	for (auto i = 0; i < 33; i++)
+	{
+		auto a = i / 32.f * 2.f * pi<float>();
+		auto p = center + vec3(cos(a), 0.f, sin(a)) * radius;
+		p.y = terrain->get_height(p.x, p.z) + 0.1f;
+		pts[i] = p;
+	}
+	sRenderer::instance()->draw_primitives(PrimitiveLineStrip, pts, 33, cvec4(255, 128, 255, 255));
+
+	switch (fv->tool)
+	{
+	case ToolTerrainUp:
+	case ToolTerrainDown:
+		if (io.MouseDown[ImGuiMouseButton_Left])
+		{
+			auto pos = terrain->node->global_pos();
+			auto texel_sz = vec2(extent.x, extent.z) / vec2(hf.size);
+			auto c = (vec2(center.x, center.z) - vec2(pos.x, pos.z)) / texel_sz - 0.5f;
+			auto r = radius / texel_sz;
+			auto rect = ivec4(max((int)floor(c.x - r.x), 0), max((int)floor(c.y - r.y), 0),
+				min((int)ceil(c.x + r.x) + 1, (int)hf.size.x), min((int)ceil(c.y + r.y) + 1, (int)hf.size.y));
+			if (rect.z <= rect.x || rect.w <= rect.y)
+				break;
+
+			auto d = strength * io.DeltaTime * (fv->tool == ToolTerrainUp ? 1.f : -1.f);
+			for (auto y = rect.y; y < rect.w; y++)
+			{
+				for (auto x = rect.x; x < rect.z; x++)
+				{
+					auto l = length((vec2(x, y) - c) / r);
+					if (l >= 1.f)
+						continue;
+					auto& h = hf.data[y * hf.size.x + x];
+					h = clamp(h + d * (1.f - l * l), 0.f, 1.f);
+				}
+			}
+			terrain->update_heights(rect);
+			app.prefab_unsaved = true;
+		}
+		break;
+	}
+}
@@ -76,6 +76,7 @@ void TimelineView::on_draw()
 				if (ImGui::MenuItem("Remove"))
 				{
 					app.opened_timeline->tracks.erase(app.opened_timeline->tracks.begin() + i);
+					app.opened_timeline->dirty = true;
 					for (auto it = selected_keyframes.begin(); it != selected_keyframes.end();)
 					{
 						if (it->first == i)
@@ -263,6 +264,7 @@ void TimelineView::on_draw()
 								pair.second = it - t.keyframes.begin();
 								t.keyframes.insert(it, kf);
 							}
+							app.opened_timeline->dirty = true;
 						}
 					}
 				}
@@ -291,6 +293,8 @@ void TimelineView::on_draw()
 					if (track.keyframes.empty())
 						app.opened_timeline->tracks.erase(app.opened_timeline->tracks.begin() + pair.first);
 				}
+				if (!selected_keyframes.empty())
+					app.opened_timeline->dirty = true;
 				selected_keyframes.clear();
 			}
 		}
@@ -1,28 +1,92 @@
 #include <flame/foundation/foundation.h>
 #include <flame/graphics/model.h>
+#include <flame/graphics/model_ext.h>
 
 using namespace flame;
 using namespace graphics;
 
+bool build_meshlets_enabled = false;
+uint lod_levels = 0;
+
+void convert(const std::filesystem::path& input, const std::filesystem::path& output)
+{
+	auto model = Model::get(input);
+	if (!model)
+	{
+		printf("model_converter: cannot load %s\n", input.string().c_str());
+		return;
+	}
+
+	for (auto& mesh : model->meshes)
+	{
+		auto acmr_before = get_mesh_acmr(mesh);
+		optimize_mesh(mesh);
+		if (build_meshlets_enabled)
+			build_meshlets(mesh);
+		printf("  mesh: %d vertices, %d triangles, acmr %.3f -> %.3f, %d meshlets\n", (int)mesh.positions.size(), (int)mesh.indices.size() / 3,
+			acmr_before, get_mesh_acmr(mesh), (int)mesh.meshlets.size());
+	}
+	if (lod_levels > 0)
+	{
+		build_model_lods(model, lod_levels);
+		for (auto& mesh : model->meshes)
+		{
+			for (auto& lod : mesh.lods)
+				printf("  lod: %d triangles, error %f\n", lod.index_count / 3, lod.error);
+		}
+	}
+	model->save_packed(output);
+	printf("converted %s -> %s\n", input.string().c_str(), output.string().c_str());
+	Model::release(model);
+}
+
 int main(int argc, char** args)
 {
-	std::filesystem::path input;
-	vec3 scaling = vec3(1.f);
-	if (argc >= 2)
+	auto ap = parse_args(argc, args);
+	auto input = std::filesystem::path(ap.get_item("-i"));
+	if (input.empty())
 	{
-		input = args[1];
+		printf("usage: model_converter -i filename [-o filename] [-meshlets] [-lods n] [-scaling s]\n"
+			"-i: a .fmod model, or any scene format assimp reads, the scene is imported first and all its models are converted\n"
+			"-o: the output .fmodp path, default is the input with .fmodp extension, only for a single model\n"
+			"-meshlets: also build meshlets\n"
+			"-lods: build n levels of lods, each has half the triangles of the last\n"
+			"-scaling: scaling when importing a scene\n");
+		return 0;
+	}
+	build_meshlets_enabled = ap.has("-meshlets");
+	if (auto s = ap.get_item("-lods"); !s.empty())
+		lod_levels = s2t<uint>(s);
 
-		for (auto i = 2; i < argc; i++)
+	auto ext = input.extension();
+	if (ext == L".fmod" || ext == L".fmodb")
+	{
+		std::filesystem::path output = ap.get_item("-o");
+		if (output.empty())
 		{
-			if (std::string(args[i]) == "-scaling")
+			output = input;
+			output.replace_extension(L".fmodp");
+		}
+		convert(input, output);
+	}
+	else
+	{
+		auto scaling = 1.f;
+		if (auto s = ap.get_item("-scaling"); !s.empty())
+			scaling = s2t<float>(s);
+		import_scene(input, L"", vec3(0.f), scaling);
+		auto models_path = input.parent_path() / L"models";
+		if (!std::filesystem::exists(models_path))
+			return 1;
+		for (auto& it : std::filesystem::directory_iterator(models_path))
+		{
+			if (it.path().extension() == L".fmod")
 			{
-				scaling = s2t<3, float>(args[i + 1]);
-				i++;
+				auto output = it.path();
+				output.replace_extension(L".fmodp");
+				convert(it.path(), output);
 			}
 		}
-
-		Model::convert(input, vec3(0.f), scaling, false, true);
-		printf("converted\n");
 	}
 	return 0;
 }
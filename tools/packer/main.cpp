@@ -0,0 +1,46 @@
+#include <flame/foundation/foundation.h>
+#include <flame/foundation/pack.h>
+
+using namespace flame;
+
+int main(int argc, char** args)
+{
+	auto ap = parse_args(argc, args);
+	auto input = ap.get_item("-i");
+	auto output = ap.get_item("-o");
+	if (input.empty() || output.empty())
+		goto show_usage;
+
+	goto process;
+
+show_usage:
+	printf("usage: packer -i directory -o filename [-raw] [-align n]\n"
+		"-i: specify the directory to pack, paths in the pack are relative to it\n"
+		"-o: specify the output pack path\n"
+		"-raw: store all files uncompressed\n"
+		"-align: alignment of the entries, default 16\n");
+	return 0;
+
+process:
+	auto alignment = 16U;
+	if (auto a = ap.get_item("-align"); !a.empty())
+		alignment = s2t<uint>(a);
+	if (!Pack::create(output, input, !ap.has("-raw"), alignment))
+		return 1;
+
+	// mount it back to report and verify
+	auto pack = Pack::mount(output, input);
+	if (!pack)
+		return 1;
+	uint64 size = 0, stored_size = 0;
+	for (auto i = 0; i < pack->header.entries_count; i++)
+	{
+		auto& e = pack->entries[i];
+		size += e.size;
+		stored_size += e.stored_size;
+	}
+	printf("packed %d files, %lld -> %lld bytes\n", pack->header.entries_count, size, stored_size);
+	Pack::unmount(pack);
+
+	return 0;
+}